@@ -118,6 +118,10 @@ SUBSCRIBE(SBEventNotificationsAuthorization) {
 
 #pragma mark SBEventRegionEnter
 SUBSCRIBE(SBEventRegionEnter) {
+    if (!event.beacon) {
+        // a geo region, the list shows beacons only
+        return;
+    }
     [beacons setValue:event.beacon forKey:event.beacon.fullUUID];
     [self.tableView reloadData];
     //
@@ -125,14 +129,19 @@ SUBSCRIBE(SBEventRegionEnter) {
 
 #pragma mark SBEventRegionExit
 SUBSCRIBE(SBEventRegionExit) {
+    if (!event.beacon) {
+        return;
+    }
     [beacons setValue:nil forKey:event.beacon.fullUUID];
     //    NSLog(@"Exit region: %@ (M:%i m:%i)", [NSString hyphenateUUIDString:event.beacon.uuid], event.beacon.major, event.beacon.minor);
     [self.tableView reloadData];
 }
 
-#pragma mark SBEventRangedBeacon
-SUBSCRIBE(SBEventRangedBeacon) {
-    [beacons setValue:event.beacon forKey:event.beacon.fullUUID];
+#pragma mark SBEventRangedBeacons
+SUBSCRIBE(SBEventRangedBeacons) {
+    for (SBEventRangedBeacon *ranged in event.beacons) {
+        [beacons setValue:ranged.beacon forKey:ranged.beacon.fullUUID];
+    }
 }
 
 #pragma mark SBEventPerformAction
@@ -105,6 +105,17 @@
  */
 - (NSArray*)devices;
 
+/**
+ *  Discovered and updated peripherals are published as one `SBEventDevicesUpdated` per interval, default 1 second
+ */
+@property (nonatomic) NSTimeInterval batchInterval;
+
+/**
+ *  Also publish `SBEventDeviceDiscovered` for every advertisement (not only for new peripherals)
+ *  and `SBEventDeviceUpdated` for every update, default NO
+ */
+@property (nonatomic) BOOL publishesDeviceEvents;
+
 /**
  *  Cancels a connection to (or disconnects) a peripheral
  *
@@ -31,6 +31,8 @@
 
 #import "SBSettings.h"
 
+#import "SBEventCoalescer.h"
+
 #import <tolo/Tolo.h>
 
 @interface SBBluetooth() {
@@ -38,6 +40,8 @@
     CBPeripheralManager *peripheralManager;
     
     NSMutableDictionary *devices;
+    // peripheral identifier -> CBPeripheral
+    SBEventCoalescer *updatedDevices;
     
     SBBluetoothStatus oldStatus;
 }
@@ -68,10 +72,25 @@ static dispatch_once_t once;
     self = [super init];
     if (self) {
         devices = [NSMutableDictionary new];
+        updatedDevices = [[SBEventCoalescer alloc] initWithInterval:kSBDefaultBatchInterval handler:^(NSArray *values) {
+            SB_PUBLISH((({
+                SBEventDevicesUpdated *event = [SBEventDevicesUpdated new];
+                event.peripherals = values;
+                event;
+            })));
+        }];
     }
     return self;
 }
 
+- (NSTimeInterval)batchInterval {
+    return updatedDevices.interval;
+}
+
+- (void)setBatchInterval:(NSTimeInterval)batchInterval {
+    updatedDevices.interval = batchInterval;
+}
+
 
 #pragma mark - External methods
 
@@ -161,7 +180,7 @@ static dispatch_once_t once;
 - (void)centralManager:(CBCentralManager *)central didConnectPeripheral:(CBPeripheral *)peripheral {
     [self updatePeripheral:peripheral];
     //
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventDeviceConnected *event = [SBEventDeviceConnected new];
         event.peripheral = peripheral;
         event;
@@ -173,7 +192,7 @@ static dispatch_once_t once;
 - (void)centralManager:(CBCentralManager *)central didDisconnectPeripheral:(CBPeripheral *)peripheral error:(NSError *)error {
     [self updatePeripheral:peripheral];
     //
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventDeviceDisconnected *event = [SBEventDeviceDisconnected new];
         event.error = error;
         event.peripheral = peripheral;
@@ -184,7 +203,7 @@ static dispatch_once_t once;
 - (void)centralManager:(CBCentralManager *)central didFailToConnectPeripheral:(CBPeripheral *)peripheral error:(NSError *)error {
     [self updatePeripheral:peripheral];
     //
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventDeviceDisconnected *event = [SBEventDeviceDisconnected new];
         event.error = error;
         event.peripheral = peripheral;
@@ -193,19 +212,22 @@ static dispatch_once_t once;
 }
 
 - (void)centralManager:(CBCentralManager *)central didDiscoverPeripheral:(CBPeripheral *)peripheral advertisementData:(NSDictionary<NSString *,id> *)advertisementData RSSI:(NSNumber *)RSSI {
-    if (![devices objectForKey:peripheral.identifier.UUIDString]) {
+    BOOL discovered = ![devices objectForKey:peripheral.identifier.UUIDString];
+    if (discovered) {
         peripheral.firstSeen = [NSDate date];
         peripheral.delegate = self;
         [devices setObject:peripheral forKey:peripheral.identifier.UUIDString];
     }
     peripheral.rssi = RSSI;
     peripheral.advertisementData = advertisementData;
-    //
-    PUBLISH((({
-        SBEventDeviceDiscovered *event = [SBEventDeviceDiscovered new];
-        event.peripheral = peripheral;
-        event;
-    })));
+    // scanning allows duplicates, repeated advertisements only go into the batch unless asked for
+    if (discovered || self.publishesDeviceEvents) {
+        SB_PUBLISH((({
+            SBEventDeviceDiscovered *event = [SBEventDeviceDiscovered new];
+            event.peripheral = peripheral;
+            event;
+        })));
+    }
     //
     [self updatePeripheral:peripheral];
 }
@@ -216,7 +238,7 @@ static dispatch_once_t once;
         return;
     }
     oldStatus = newStatus;
-    PUBLISH(({
+    SB_PUBLISH(({
         SBEventBluetoothAuthorization *event = [SBEventBluetoothAuthorization new];
         event.bluetoothAuthorization = oldStatus;
         event;
@@ -228,7 +250,7 @@ static dispatch_once_t once;
 - (void)peripheral:(CBPeripheral *)peripheral didDiscoverServices:(NSError *)error {
     [self updatePeripheral:peripheral];
     //
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventServicesUpdated *event = [SBEventServicesUpdated new];
         event.error = error;
         event.peripheral = peripheral;
@@ -244,7 +266,7 @@ static dispatch_once_t once;
 - (void)peripheral:(CBPeripheral *)peripheral didDiscoverIncludedServicesForService:(CBService *)service error:(NSError *)error {
     [self updatePeripheral:peripheral];
     //
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventServicesUpdated *event = [SBEventServicesUpdated new];
         event.error = error;
         event.peripheral = peripheral;
@@ -257,7 +279,7 @@ static dispatch_once_t once;
 - (void)peripheral:(CBPeripheral *)peripheral didDiscoverCharacteristicsForService:(CBService *)service error:(NSError *)error {
     [self updatePeripheral:peripheral];
     //
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventCharacteristicsUpdate *event = [SBEventCharacteristicsUpdate new];
         event.error = error;
         event.peripheral = peripheral;
@@ -282,7 +304,7 @@ static dispatch_once_t once;
 - (void)peripheral:(CBPeripheral *)peripheral didUpdateValueForCharacteristic:(CBCharacteristic *)characteristic error:(NSError *)error {
     [self updatePeripheral:peripheral];
     
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventCharacteristicsUpdate *event = [SBEventCharacteristicsUpdate new];
         event.peripheral = peripheral;
         event.characteristic = characteristic;
@@ -299,7 +321,7 @@ static dispatch_once_t once;
 - (void)peripheral:(CBPeripheral *)peripheral didWriteValueForCharacteristic:(CBCharacteristic *)characteristic error:(NSError *)error {
     [self updatePeripheral:peripheral];
     
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventCharacteristicWrite *event = [SBEventCharacteristicWrite new];
         event.peripheral = peripheral;
         event.characteristic = characteristic;
@@ -348,7 +370,7 @@ static dispatch_once_t once;
 }
 
 - (void)peripheralManagerDidStartAdvertising:(nonnull CBPeripheralManager *)peripheral error:(nullable NSError *)error {
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventBluetoothEmulation *event = [SBEventBluetoothEmulation new];
         event.error = error;
         event;
@@ -392,11 +414,14 @@ static dispatch_once_t once;
     peripheral.lastSeen = [NSDate date];
     [devices setObject:peripheral forKey:peripheral.identifier.UUIDString];
     //
-    PUBLISH((({
-        SBEventDeviceUpdated *event = [SBEventDeviceUpdated new];
-        event.peripheral = peripheral;
-        event;
-    })));
+    [updatedDevices coalesceValue:peripheral forKey:peripheral.identifier];
+    if (self.publishesDeviceEvents) {
+        SB_PUBLISH((({
+            SBEventDeviceUpdated *event = [SBEventDeviceUpdated new];
+            event.peripheral = peripheral;
+            event;
+        })));
+    }
 }
 
 - (NSArray *)defaultServices {
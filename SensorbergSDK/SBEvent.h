@@ -74,14 +74,41 @@
 @property (nonatomic) int rssi;
 @property (nonatomic) CLProximity proximity;
 @property (nonatomic) CLLocationAccuracy accuracy;
+/**
+    Smoothed rssi, outliers rejected; 0 until the beacon has been measured
+ */
+@property (nonatomic) double filteredRssi;
+/**
+    Proximity from the smoothed rssi, it only changes once a threshold is clearly crossed
+ */
+@property (nonatomic) CLProximity filteredProximity;
+/**
+    Distance estimate in meters from the smoothed rssi, -1 until the beacon has been measured
+ */
+@property (nonatomic) CLLocationAccuracy filteredAccuracy;
+@end
+
+/**
+    Event fired once per batch interval with the latest SBEventRangedBeacon of every beacon ranged during that interval
+ */
+@interface SBEventRangedBeacons : SBEvent
+@property (strong, nonatomic) NSArray <SBEventRangedBeacon *> *beacons;
 @end
 
 @interface SBEventRegionEnter : SBEventRangedBeacon
 @property (strong, nonatomic) CLLocation *location;
+/**
+    The geohash of a geo region, `beacon` is nil then
+ */
+@property (strong, nonatomic) NSString *geohash;
 @end
 
 @interface SBEventRegionExit : SBEventRangedBeacon
 @property (strong, nonatomic) CLLocation *location;
+/**
+    The geohash of a geo region, `beacon` is nil then
+ */
+@property (strong, nonatomic) NSString *geohash;
 @end
 
 #pragma mark - Authorization events
@@ -121,6 +148,13 @@
 @property (strong, nonatomic) CBPeripheral *peripheral;
 @end
 
+/**
+    Event fired once per batch interval with every CBPeripheral discovered or updated during that interval, each listed once
+ */
+@interface SBEventDevicesUpdated : SBEvent
+@property (strong, nonatomic) NSArray <CBPeripheral *> *peripherals;
+@end
+
 /**
     Event fired when a CBPeripheral has disconnected
  */
@@ -73,6 +73,8 @@ emptyImplementation(SBEventStatusUpdate)
 
 emptyImplementation(SBEventRangedBeacon)
 
+emptyImplementation(SBEventRangedBeacons)
+
 emptyImplementation(SBEventRegionEnter)
 
 emptyImplementation(SBEventRegionExit)
@@ -93,6 +95,8 @@ emptyImplementation(SBEventDeviceDiscovered)
 
 emptyImplementation(SBEventDeviceUpdated)
 
+emptyImplementation(SBEventDevicesUpdated)
+
 emptyImplementation(SBEventDeviceDisconnected)
 
 emptyImplementation(SBEventDeviceConnected)
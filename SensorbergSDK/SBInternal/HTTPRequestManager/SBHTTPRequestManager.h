@@ -32,10 +32,39 @@ typedef NS_ENUM(NSInteger, SBNetworkReachability) {
     SBNetworkReachabilityViaWiFi    = 2,
 };
 
+@class SBHTTPValidatorCache;
+
+// Connection reuse counters, collected from the task metrics (iOS 10 and later).
+@interface SBHTTPConnectionMetrics : NSObject <NSCopying>
+@property (nonatomic, readonly) NSUInteger requestCount;
+// requests sent over an already open connection
+@property (nonatomic, readonly) NSUInteger reusedConnectionCount;
+// requests that opened a connection (TCP and TLS handshake)
+@property (nonatomic, readonly) NSUInteger openedConnectionCount;
+// requests answered from the URL cache
+@property (nonatomic, readonly) NSUInteger localCacheCount;
+// requests sent over HTTP/2
+@property (nonatomic, readonly) NSUInteger multiplexedCount;
+// total time spent connecting, in seconds
+@property (nonatomic, readonly) NSTimeInterval handshakeDuration;
+// total time of the requests, in seconds
+@property (nonatomic, readonly) NSTimeInterval fetchDuration;
+@end
+
 @interface SBHTTPRequestManager : NSObject
 
 @property (nonatomic, strong, readonly) NSOperationQueue * _Nonnull operationQueue;
 
+// Requests run concurrently (pings first, analytics POSTs last) on long lived sessions, one per cache policy,
+// so connections are reused and HTTP/2 requests to the resolver share one connection.
+//
+// Configuration the sessions are created from (the cache policy is set per session).
+// Defaults to the default session configuration, tests can add protocol classes here. Setting it replaces the sessions.
+@property (nonatomic, copy) NSURLSessionConfiguration * _Nonnull sessionConfiguration;
+
+// ETag / Last-Modified store used by conditional requests, defaults to the shared cache.
+@property (nonatomic, strong) SBHTTPValidatorCache * _Nonnull validatorCache;
+
 // Please Subscribe @SBNetworkReachabilityChangedEvent
 @property (readonly, nonatomic, assign) SBNetworkReachability reachabilityStatus;
 @property (readonly, nonatomic, assign, getter = isReachable) BOOL reachable;
@@ -47,9 +76,28 @@ typedef NS_ENUM(NSInteger, SBNetworkReachability) {
               useCache:(BOOL)useCache
             completion:(nonnull void (^)(NSData * __nullable data, NSError * __nullable error))completionHandler;
 
+// `priority` orders the request in the queue and on the connection (e.g. NSOperationQueuePriorityVeryHigh for pings)
+- (void)getDataFromURL:(nonnull NSURL *)URL
+          headerFields:(nullable NSDictionary *)header
+              useCache:(BOOL)useCache
+              priority:(NSOperationQueuePriority)priority
+            completion:(nonnull void (^)(NSData * __nullable data, NSError * __nullable error))completionHandler;
+
+// GET that sends the stored validators of the URL (unless `revalidate` is NO) and stores the new ones.
+// On a 304 `data` is the stored body and `notModified` is YES.
+- (void)conditionalGetDataFromURL:(nonnull NSURL *)URL
+                     headerFields:(nullable NSDictionary *)header
+                       revalidate:(BOOL)revalidate
+                       completion:(nonnull void (^)(NSData * __nullable data, BOOL notModified, NSError * __nullable error))completionHandler;
+
 - (void)postData:(nullable NSData *)data
              URL:(nonnull NSURL *)URL
     headerFields:(nonnull NSDictionary *)header
       completion:(nonnull void (^)(NSData * __nullable data, NSError * __nullable error))completionHandler;
 
+// Snapshot of the connection reuse counters since launch (or the last reset)
+- (SBHTTPConnectionMetrics * _Nonnull)connectionMetrics;
+
+- (void)resetConnectionMetrics;
+
 @end
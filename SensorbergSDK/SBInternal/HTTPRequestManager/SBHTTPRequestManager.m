@@ -23,7 +23,10 @@
 //  THE SOFTWARE.
 //
 
+#import "SensorbergSDK.h"
+
 #import "SBHTTPRequestManager.h"
+#import "SBHTTPValidatorCache.h"
 #import "SBEvent.h"
 
 #import <tolo/Tolo.h>
@@ -39,6 +42,9 @@
 
 #pragma mark - Constants
 
+// requests running at the same time, the sessions multiplex them over their connections
+static NSInteger const kSBHTTPMaxConcurrentRequests = 4;
+
 typedef void (^SBNetworkReachabilityStatusBlock)(SBNetworkReachability status);
 
 static const void * SBNetworkReachabilityRetainCallback(const void *info) {
@@ -90,25 +96,27 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
 
 @interface SBInternalSBHTTPRequestOperation : NSOperation
 @property (nonnull, nonatomic, strong) NSURLRequest *request;
-@property (nonatomic, assign) BOOL useCache;
-@property (nullable, nonatomic, strong) NSURLSession *session;
-@property (nullable, nonatomic, copy) void (^completion)(NSData * __nullable data, NSError * __nullable error);
+@property (nonnull, nonatomic, strong) NSURLSession *session;
+@property (nullable, nonatomic, strong) NSURLSessionDataTask *task;
+@property (nullable, nonatomic, copy) void (^completion)(NSData * __nullable data, NSHTTPURLResponse * __nullable response, NSError * __nullable error);
 
-- (instancetype)initWithURLRequest:(NSURLRequest *)request useCache:(BOOL)cache
-                        completion:(nonnull void (^)(NSData * __nullable data, NSError * __nullable error))completionHandler;
+- (instancetype)initWithURLRequest:(NSURLRequest *)request
+                           session:(NSURLSession *)session
+                        completion:(nonnull void (^)(NSData * __nullable data, NSHTTPURLResponse * __nullable response, NSError * __nullable error))completionHandler;
 @end
 
 @implementation SBInternalSBHTTPRequestOperation
 @synthesize finished = _isFinished;
 @synthesize executing = _isExecuting;
 
-- (instancetype)initWithURLRequest:(NSURLRequest *)request useCache:(BOOL)cache
-                        completion:(nonnull void (^)(NSData * __nullable data, NSError * __nullable error))completionHandler
+- (instancetype)initWithURLRequest:(NSURLRequest *)request
+                           session:(NSURLSession *)session
+                        completion:(nonnull void (^)(NSData * __nullable data, NSHTTPURLResponse * __nullable response, NSError * __nullable error))completionHandler
 {
     if (self = [super init])
     {
         _request = request;
-        _useCache = cache;
+        _session = session;
         _completion = completionHandler;
     }
     
@@ -117,47 +125,50 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
 
 - (void)main
 {
-    NSURLSessionConfiguration *configuration = [[NSURLSessionConfiguration defaultSessionConfiguration] copy];
-    if (self.useCache)
-    {
-        configuration.requestCachePolicy = NSURLRequestReturnCacheDataElseLoad;
-    }
-    else
-    {
-        configuration.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
-    }
-    
-    self.session = [NSURLSession sessionWithConfiguration:configuration];
-    
-    NSURLSessionDataTask *task = [self.session dataTaskWithRequest:self.request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+    // the session is shared, so its connections (and TLS sessions) are reused across requests
+    self.task = [self.session dataTaskWithRequest:self.request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
         if (self.completion)
         {
-            if (!error && [response respondsToSelector:@selector(statusCode)])
+            NSHTTPURLResponse *httpResponse = nil;
+            if ([response isKindOfClass:[NSHTTPURLResponse class]])
             {
-                NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
-                if (httpResponse.statusCode >= 400)
+                httpResponse = (NSHTTPURLResponse *)response;
+                if (!error && httpResponse.statusCode >= 400)
                 {
                     error = [NSError errorWithDomain:NSURLErrorDomain code:httpResponse.statusCode userInfo:@{@"reason" : [NSHTTPURLResponse localizedStringForStatusCode:httpResponse.statusCode]}];
                 }
             }
             
-            self.completion(data, error);
+            self.completion(data, httpResponse, error);
         }
         [self finish];
     }];
-    [task resume];
+    self.task.priority = [SBInternalSBHTTPRequestOperation taskPriorityForQueuePriority:self.queuePriority];
+    [self.task resume];
+}
+
++ (float)taskPriorityForQueuePriority:(NSOperationQueuePriority)priority
+{
+    if (priority > NSOperationQueuePriorityNormal)
+    {
+        return NSURLSessionTaskPriorityHigh;
+    }
+    if (priority < NSOperationQueuePriorityNormal)
+    {
+        return NSURLSessionTaskPriorityLow;
+    }
+    return NSURLSessionTaskPriorityDefault;
 }
 
 - (void)cancel
 {
     [super cancel];
-    [self.session invalidateAndCancel];
+    [self.task cancel];
 }
 
 - (void)finish
 {
-    [self.session finishTasksAndInvalidate];
-    self.session = nil;
+    self.task = nil;
     [self willChangeValueForKey:@"isFinished"];
     [self willChangeValueForKey:@"isExecuting"];
     _isExecuting = NO;
@@ -168,6 +179,54 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
 
 @end
 
+#pragma mark - SBHTTPConnectionMetrics
+
+@interface SBHTTPConnectionMetrics ()
+@property (nonatomic, readwrite) NSUInteger requestCount;
+@property (nonatomic, readwrite) NSUInteger reusedConnectionCount;
+@property (nonatomic, readwrite) NSUInteger openedConnectionCount;
+@property (nonatomic, readwrite) NSUInteger localCacheCount;
+@property (nonatomic, readwrite) NSUInteger multiplexedCount;
+@property (nonatomic, readwrite) NSTimeInterval handshakeDuration;
+@property (nonatomic, readwrite) NSTimeInterval fetchDuration;
+- (void)reset;
+@end
+
+@implementation SBHTTPConnectionMetrics
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    SBHTTPConnectionMetrics *copy = [[SBHTTPConnectionMetrics allocWithZone:zone] init];
+    copy.requestCount = self.requestCount;
+    copy.reusedConnectionCount = self.reusedConnectionCount;
+    copy.openedConnectionCount = self.openedConnectionCount;
+    copy.localCacheCount = self.localCacheCount;
+    copy.multiplexedCount = self.multiplexedCount;
+    copy.handshakeDuration = self.handshakeDuration;
+    copy.fetchDuration = self.fetchDuration;
+    return copy;
+}
+
+- (void)reset
+{
+    self.requestCount = 0;
+    self.reusedConnectionCount = 0;
+    self.openedConnectionCount = 0;
+    self.localCacheCount = 0;
+    self.multiplexedCount = 0;
+    self.handshakeDuration = 0;
+    self.fetchDuration = 0;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %lu requests, %lu reused, %lu new (%.3fs handshakes), %lu h2, %lu cached>", NSStringFromClass([self class]),
+            (unsigned long)self.requestCount, (unsigned long)self.reusedConnectionCount, (unsigned long)self.openedConnectionCount,
+            self.handshakeDuration, (unsigned long)self.multiplexedCount, (unsigned long)self.localCacheCount];
+}
+
+@end
+
 #pragma mark - SBHTTPRequestManager
 #pragma mark - Internal
 
@@ -176,7 +235,33 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
 @property (nonatomic, strong) NSOperationQueue * _Nonnull operationQueue;
 @property (readwrite, nonatomic, assign) SBNetworkReachability reachabilityStatus;
 @property (readwrite, nonatomic, strong) id networkReachability;
-@property (nonatomic, strong) NSURLSession *session;
+// cache policy -> long lived session, rebuilt when the configuration changes
+@property (nonatomic, strong) NSMutableDictionary <NSNumber *, NSURLSession *> *sessions;
+@property (nonatomic, strong) NSOperationQueue *sessionQueue;
+// counted in place, guarded by metricsLock
+@property (nonatomic, strong, readonly) SBHTTPConnectionMetrics *metrics;
+@property (nonatomic, strong, readonly) NSObject *metricsLock;
+
+- (void)collectMetrics:(id)taskMetrics;
+
+@end
+
+#pragma mark - SBInternalSBHTTPSessionDelegate
+
+// sessions retain their delegate until invalidated, this keeps them from retaining the manager
+@interface SBInternalSBHTTPSessionDelegate : NSObject <NSURLSessionTaskDelegate>
+@property (nonatomic, weak) SBHTTPRequestManager *manager;
+@end
+
+@implementation SBInternalSBHTTPSessionDelegate
+
+#if __IPHONE_OS_VERSION_MAX_ALLOWED >= 100000
+// iOS 10 and later, not called on older systems
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didFinishCollectingMetrics:(NSURLSessionTaskMetrics *)metrics
+{
+    [self.manager collectMetrics:metrics];
+}
+#endif
 
 @end
 
@@ -206,7 +291,7 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
 {
     if (self = [super init])
     {
-        REGISTER();
+        SB_REGISTER();
         struct sockaddr_in address;
         bzero(&address, sizeof(address));
         address.sin_len = sizeof(address);
@@ -217,7 +302,18 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
         _reachabilityStatus = SBNetworkReachabilityUnknown;
         
         _operationQueue = [[NSOperationQueue alloc] init];
-        _operationQueue.maxConcurrentOperationCount = 1;
+        _operationQueue.maxConcurrentOperationCount = kSBHTTPMaxConcurrentRequests;
+        
+        // session callbacks (completions and metrics), serial
+        _sessionQueue = [[NSOperationQueue alloc] init];
+        _sessionQueue.maxConcurrentOperationCount = 1;
+        
+        _sessions = [NSMutableDictionary new];
+        _metrics = [SBHTTPConnectionMetrics new];
+        _metricsLock = [NSObject new];
+        
+        _sessionConfiguration = [NSURLSessionConfiguration defaultSessionConfiguration];
+        _validatorCache = [SBHTTPValidatorCache sharedCache];
         
         [self startMonitoring];
     }
@@ -227,8 +323,9 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
 
 - (void)dealloc
 {
-    UNREGISTER();
+    SB_UNREGISTER();
     [self stopMonitoring];
+    [self invalidateSessions];
 }
 
 #pragma mark - Public Interfaces
@@ -237,11 +334,21 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
           headerFields:(nullable NSDictionary *)header
               useCache:(BOOL)useCache
             completion:(void (^)(NSData * __nullable data, NSError * __nullable error))completionHandler;
+{
+    [self getDataFromURL:URL headerFields:header useCache:useCache priority:NSOperationQueuePriorityNormal completion:completionHandler];
+}
+
+- (void)getDataFromURL:(nonnull NSURL *)URL
+          headerFields:(nullable NSDictionary *)header
+              useCache:(BOOL)useCache
+              priority:(NSOperationQueuePriority)priority
+            completion:(void (^)(NSData * __nullable data, NSError * __nullable error))completionHandler;
 {
     NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:URL];
     URLRequest.HTTPMethod = @"GET";
     [self setHeaderFields:header forURLRequest:URLRequest];
-    SBInternalSBHTTPRequestOperation *networkRequestOperation = [[SBInternalSBHTTPRequestOperation alloc] initWithURLRequest:URLRequest useCache:useCache completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    NSURLSession *session = [self sessionForCachePolicy:useCache ? NSURLRequestReturnCacheDataElseLoad : NSURLRequestReloadIgnoringLocalCacheData];
+    SBInternalSBHTTPRequestOperation *networkRequestOperation = [[SBInternalSBHTTPRequestOperation alloc] initWithURLRequest:URLRequest session:session completion:^(NSData * _Nullable data, NSHTTPURLResponse * _Nullable response, NSError * _Nullable error) {
         if (completionHandler)
         {
             dispatch_async(dispatch_get_main_queue(), ^{
@@ -249,6 +356,47 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
             });
         }
     }];
+    networkRequestOperation.queuePriority = priority;
+    [self.operationQueue addOperation:networkRequestOperation];
+}
+
+- (void)conditionalGetDataFromURL:(nonnull NSURL *)URL
+                     headerFields:(nullable NSDictionary *)header
+                       revalidate:(BOOL)revalidate
+                       completion:(nonnull void (^)(NSData * __nullable data, BOOL notModified, NSError * __nullable error))completionHandler
+{
+    NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:URL];
+    URLRequest.HTTPMethod = @"GET";
+    [self setHeaderFields:header forURLRequest:URLRequest];
+    SBHTTPValidatorCache *validatorCache = self.validatorCache;
+    BOOL conditional = revalidate && [validatorCache addValidatorsToRequest:URLRequest];
+    // the URL cache would answer the 304 itself, the validators are handled here
+    NSURLSession *session = [self sessionForCachePolicy:NSURLRequestReloadIgnoringLocalCacheData];
+    SBInternalSBHTTPRequestOperation *networkRequestOperation = [[SBInternalSBHTTPRequestOperation alloc] initWithURLRequest:URLRequest session:session completion:^(NSData * _Nullable data, NSHTTPURLResponse * _Nullable response, NSError * _Nullable error) {
+        BOOL notModified = NO;
+        if (!error && response.statusCode == 304)
+        {
+            data = conditional ? [validatorCache cachedDataForURL:URL] : nil;
+            if (!data)
+            {
+                // the stored body went away, ask for the full response
+                [self conditionalGetDataFromURL:URL headerFields:header revalidate:NO completion:completionHandler];
+                return;
+            }
+            notModified = YES;
+        }
+        else if (!error && response)
+        {
+            [validatorCache storeResponse:response data:data];
+        }
+        //
+        if (completionHandler)
+        {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completionHandler(data, notModified, error);
+            });
+        }
+    }];
     [self.operationQueue addOperation:networkRequestOperation];
 }
 
@@ -260,7 +408,8 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
     URLRequest.HTTPMethod = @"POST";
     URLRequest.HTTPBody = data;
     [self setHeaderFields:header forURLRequest:URLRequest];
-    SBInternalSBHTTPRequestOperation *networkRequestOperation = [[SBInternalSBHTTPRequestOperation alloc] initWithURLRequest:URLRequest useCache:NO completion:^(NSData * _Nullable responseData, NSError * _Nullable error) {
+    NSURLSession *session = [self sessionForCachePolicy:NSURLRequestReloadIgnoringLocalCacheData];
+    SBInternalSBHTTPRequestOperation *networkRequestOperation = [[SBInternalSBHTTPRequestOperation alloc] initWithURLRequest:URLRequest session:session completion:^(NSData * _Nullable responseData, NSHTTPURLResponse * _Nullable response, NSError * _Nullable error) {
         if (completionHandler)
         {
             dispatch_async(dispatch_get_main_queue(), ^{
@@ -268,18 +417,53 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
             });
         }
     }];
-    
+    // analytics can wait, pings and layouts should not queue behind them
+    networkRequestOperation.queuePriority = NSOperationQueuePriorityLow;
     [self.operationQueue addOperation:networkRequestOperation];
 }
 
 #pragma mark - Private Interfaces
 
-- (void)cleanURLSession
+- (void)setSessionConfiguration:(NSURLSessionConfiguration *)sessionConfiguration
 {
-    [self.operationQueue addOperationWithBlock:^{
-        [self.session finishTasksAndInvalidate];
-        self.session = nil;
-    }];
+    @synchronized (self.sessions)
+    {
+        _sessionConfiguration = [sessionConfiguration copy];
+    }
+    [self invalidateSessions];
+}
+
+- (NSURLSession *)sessionForCachePolicy:(NSURLRequestCachePolicy)cachePolicy
+{
+    @synchronized (self.sessions)
+    {
+        NSURLSession *session = self.sessions[@(cachePolicy)];
+        if (!session)
+        {
+            NSURLSessionConfiguration *configuration = [_sessionConfiguration copy];
+            configuration.requestCachePolicy = cachePolicy;
+            SBInternalSBHTTPSessionDelegate *delegate = [SBInternalSBHTTPSessionDelegate new];
+            delegate.manager = self;
+            session = [NSURLSession sessionWithConfiguration:configuration delegate:delegate delegateQueue:self.sessionQueue];
+            self.sessions[@(cachePolicy)] = session;
+        }
+        return session;
+    }
+}
+
+- (void)invalidateSessions
+{
+    NSArray *sessions;
+    @synchronized (self.sessions)
+    {
+        sessions = self.sessions.allValues;
+        [self.sessions removeAllObjects];
+    }
+    // running requests complete on the old sessions
+    for (NSURLSession *session in sessions)
+    {
+        [session finishTasksAndInvalidate];
+    }
 }
 
 - (void)setHeaderFields:(nonnull NSDictionary *)header forURLRequest:(nonnull NSMutableURLRequest *)URLRequest
@@ -296,6 +480,62 @@ static void SBNetworkReachabilityCallback(SCNetworkReachabilityRef __unused targ
     }
 }
 
+#pragma mark - Connection metrics
+
+- (SBHTTPConnectionMetrics *)connectionMetrics
+{
+    @synchronized (self.metricsLock)
+    {
+        return [self.metrics copy];
+    }
+}
+
+- (void)resetConnectionMetrics
+{
+    @synchronized (self.metricsLock)
+    {
+        [self.metrics reset];
+    }
+}
+
+- (void)collectMetrics:(id)taskMetrics
+{
+#if __IPHONE_OS_VERSION_MAX_ALLOWED >= 100000
+    NSURLSessionTaskTransactionMetrics *transaction = [(NSURLSessionTaskMetrics *)taskMetrics transactionMetrics].lastObject;
+    if (!transaction)
+    {
+        return;
+    }
+    @synchronized (self.metricsLock)
+    {
+        SBHTTPConnectionMetrics *metrics = self.metrics;
+        metrics.requestCount++;
+        if (transaction.resourceFetchType == NSURLSessionTaskMetricsResourceFetchTypeLocalCache)
+        {
+            metrics.localCacheCount++;
+        }
+        else if (transaction.isReusedConnection)
+        {
+            metrics.reusedConnectionCount++;
+        }
+        else
+        {
+            metrics.openedConnectionCount++;
+            if (transaction.connectStartDate && transaction.connectEndDate)
+            {
+                // includes the TLS handshake
+                metrics.handshakeDuration += [transaction.connectEndDate timeIntervalSinceDate:transaction.connectStartDate];
+            }
+        }
+        if ([transaction.networkProtocolName isEqualToString:@"h2"])
+        {
+            metrics.multiplexedCount++;
+        }
+        metrics.fetchDuration += [(NSURLSessionTaskMetrics *)taskMetrics taskInterval].duration;
+    }
+#endif
+}
+
 #pragma mark - Network Reachability
 
 - (BOOL)isReachable
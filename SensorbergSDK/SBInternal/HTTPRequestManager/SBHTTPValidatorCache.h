@@ -0,0 +1,59 @@
+//
+//  SBHTTPValidatorCache.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Persists the ETag / Last-Modified validators of GET responses together with their bodies, keyed by the full URL
+ *  (the query carries the target attributes). Lets a request be sent conditionally and a 304 be answered from disk.
+ *  Thread safe.
+ */
+@interface SBHTTPValidatorCache : NSObject
+
++ (instancetype _Nonnull)sharedCache;
+
+- (instancetype _Nonnull)initWithDirectory:(NSString * _Nonnull)directory;
+
+/**
+ *  Adds If-None-Match / If-Modified-Since when a validated body is stored for the request's URL
+ *
+ *  @return YES if the request became conditional
+ */
+- (BOOL)addValidatorsToRequest:(NSMutableURLRequest * _Nonnull)request;
+
+/**
+ *  Stores the body with the response's validators, or forgets the URL if the response has none
+ */
+- (void)storeResponse:(NSHTTPURLResponse * _Nonnull)response data:(NSData * _Nullable)data;
+
+/**
+ *  The stored body for the URL, nil if there is none
+ */
+- (NSData * _Nullable)cachedDataForURL:(NSURL * _Nonnull)URL;
+
+- (void)removeAllValidators;
+
+@end
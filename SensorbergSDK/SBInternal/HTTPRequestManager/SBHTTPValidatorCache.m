@@ -0,0 +1,177 @@
+//
+//  SBHTTPValidatorCache.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBHTTPValidatorCache.h"
+
+static NSString * const kSBValidatorIndexFile   = @"validators.plist";
+
+static NSString * const kSBValidatorETag         = @"etag";
+static NSString * const kSBValidatorLastModified = @"lastModified";
+static NSString * const kSBValidatorFile         = @"file";
+
+@interface SBHTTPValidatorCache () {
+    NSString *directory;
+    // URL -> {etag, lastModified, file}
+    NSMutableDictionary <NSString *, NSDictionary *> *validators;
+}
+
+@end
+
+@implementation SBHTTPValidatorCache
+
++ (instancetype)sharedCache {
+    static dispatch_once_t once;
+    static SBHTTPValidatorCache *_sharedCache = nil;
+    
+    dispatch_once(&once, ^{
+        NSString *caches = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+        _sharedCache = [[SBHTTPValidatorCache alloc] initWithDirectory:[[caches stringByAppendingPathComponent:@"com.sensorberg.sdk"] stringByAppendingPathComponent:@"validators"]];
+    });
+    
+    return _sharedCache;
+}
+
+- (instancetype)initWithDirectory:(NSString *)path {
+    self = [super init];
+    if (self) {
+        directory = [path copy];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        //
+        NSDictionary *stored = [NSDictionary dictionaryWithContentsOfFile:[directory stringByAppendingPathComponent:kSBValidatorIndexFile]];
+        validators = [stored isKindOfClass:[NSDictionary class]] ? [stored mutableCopy] : [NSMutableDictionary new];
+    }
+    return self;
+}
+
+#pragma mark - Public
+
+- (BOOL)addValidatorsToRequest:(NSMutableURLRequest *)request {
+    NSDictionary *entry;
+    @synchronized (self) {
+        entry = validators[request.URL.absoluteString];
+    }
+    if (!entry || ![[NSFileManager defaultManager] fileExistsAtPath:[directory stringByAppendingPathComponent:entry[kSBValidatorFile]]]) {
+        return NO;
+    }
+    //
+    if (entry[kSBValidatorETag]) {
+        [request setValue:entry[kSBValidatorETag] forHTTPHeaderField:@"If-None-Match"];
+    }
+    if (entry[kSBValidatorLastModified]) {
+        [request setValue:entry[kSBValidatorLastModified] forHTTPHeaderField:@"If-Modified-Since"];
+    }
+    return YES;
+}
+
+- (void)storeResponse:(NSHTTPURLResponse *)response data:(NSData *)data {
+    NSString *key = response.URL.absoluteString;
+    if (!key) {
+        return;
+    }
+    NSString *etag = [self headerField:@"ETag" inResponse:response];
+    NSString *lastModified = [self headerField:@"Last-Modified" inResponse:response];
+    //
+    @synchronized (self) {
+        NSString *file = [self fileNameForKey:key];
+        NSString *path = [directory stringByAppendingPathComponent:file];
+        if ((!etag && !lastModified) || !data) {
+            if (validators[key]) {
+                [validators removeObjectForKey:key];
+                [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+                [self writeIndex];
+            }
+            return;
+        }
+        //
+        if (![data writeToFile:path options:NSDataWritingAtomic error:nil]) {
+            [validators removeObjectForKey:key];
+            [self writeIndex];
+            return;
+        }
+        // another URL hashing to the same file would now get this body on a 304
+        for (NSString *other in validators.allKeys) {
+            if (![other isEqualToString:key] && [validators[other][kSBValidatorFile] isEqualToString:file]) {
+                [validators removeObjectForKey:other];
+            }
+        }
+        NSMutableDictionary *entry = [NSMutableDictionary dictionaryWithObject:file forKey:kSBValidatorFile];
+        entry[kSBValidatorETag] = etag;
+        entry[kSBValidatorLastModified] = lastModified;
+        validators[key] = entry;
+        [self writeIndex];
+    }
+}
+
+- (NSData *)cachedDataForURL:(NSURL *)URL {
+    NSDictionary *entry;
+    @synchronized (self) {
+        entry = validators[URL.absoluteString];
+    }
+    if (!entry) {
+        return nil;
+    }
+    return [NSData dataWithContentsOfFile:[directory stringByAppendingPathComponent:entry[kSBValidatorFile]]];
+}
+
+- (void)removeAllValidators {
+    @synchronized (self) {
+        for (NSDictionary *entry in validators.allValues) {
+            [[NSFileManager defaultManager] removeItemAtPath:[directory stringByAppendingPathComponent:entry[kSBValidatorFile]] error:nil];
+        }
+        [validators removeAllObjects];
+        [self writeIndex];
+    }
+}
+
+#pragma mark - Private
+
+- (NSString *)headerField:(NSString *)name inResponse:(NSHTTPURLResponse *)response {
+    // header names are case insensitive, allHeaderFields is not
+    for (NSString *field in response.allHeaderFields) {
+        if ([field caseInsensitiveCompare:name] == NSOrderedSame) {
+            NSString *value = response.allHeaderFields[field];
+            return value.length ? value : nil;
+        }
+    }
+    return nil;
+}
+
+- (NSString *)fileNameForKey:(NSString *)key {
+    // FNV-1a of the URL
+    uint64_t hash = 14695981039346656037ULL;
+    const char *bytes = key.UTF8String;
+    for (size_t i = 0; bytes[i]; i++) {
+        hash ^= (uint8_t)bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return [NSString stringWithFormat:@"%016llx.body", hash];
+}
+
+- (void)writeIndex {
+    [validators writeToFile:[directory stringByAppendingPathComponent:kSBValidatorIndexFile] atomically:YES];
+}
+
+@end
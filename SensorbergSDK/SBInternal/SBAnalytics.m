@@ -36,14 +36,19 @@
 
 #import "SBSettings.h"
 
+#import "SBAnalyticsJournal.h"
+#import "SBJSONWriter.h"
+
 #pragma mark - Constants
 
 NSString * const kSBEvents = @"events";
 NSString * const kSBActions = @"actions";
 NSString * const kSBConversions = @"conversions";
 
+// with asynchronous event delivery the handlers run on the bus' internal queue,
+// the record sets are guarded by @synchronized(self)
 @interface SBAnalytics () {
-    NSUserDefaults *defaults;
+    SBAnalyticsJournal *journal;
     //
     NSMutableSet <SBMMonitorEvent> *events;
     //
@@ -62,54 +67,102 @@ NSString * const kSBConversions = @"conversions";
 {
     self = [super init];
     if (self) {
-        defaults = [[NSUserDefaults alloc] initWithSuiteName:kSBIdentifier];
-        //
-        NSArray *keyedEvents = [defaults objectForKey:kSBEvents];
-        NSSet *monitorEventSet = [NSSet setWithArray:keyedEvents];
         events = [NSMutableSet <SBMMonitorEvent> new];
-        for (NSString *json in monitorEventSet) {
-            NSError *error;
-            SBMMonitorEvent *event = [[SBMMonitorEvent alloc] initWithString:json error:&error];
-            if (!error && !isNull(event)) {
-                [events addObject:event];
-            }
-        }
-        //
-        NSArray *keyedActions = [defaults objectForKey:kSBActions];
-        NSSet *actionEventSet = [NSSet setWithArray:keyedActions];
         actions = [NSMutableSet <SBMReportAction> new];
-        for (NSString *json in actionEventSet) {
-            NSError *error;
-            SBMReportAction *action = [[SBMReportAction alloc] initWithString:json error:&error];
-            if (!error && !isNull(action)) {
-                [actions addObject:action];
-            }
-        }
-        
-        NSArray *keyedConversions = [defaults objectForKey:kSBConversions];
-        NSSet *conversionEventSet = [NSSet setWithArray:keyedConversions];
         conversions = [NSMutableSet <SBMReportConversion> new];
-        for (NSString *json in conversionEventSet) {
-            NSError *error;
-            SBMReportConversion *conversion = [[SBMReportConversion alloc] initWithString:json error:&error];
-            if (!error && !isNull(conversion)) {
-                [conversions addObject:conversion];
+        //
+        journal = [[SBAnalyticsJournal alloc] initWithPath:[SBAnalyticsJournal defaultPath]];
+        for (JSONModel *record in journal.records) {
+            if ([record isKindOfClass:[SBMMonitorEvent class]]) {
+                [events addObject:record];
+            } else if ([record isKindOfClass:[SBMReportAction class]]) {
+                [actions addObject:record];
+            } else if ([record isKindOfClass:[SBMReportConversion class]]) {
+                [conversions addObject:record];
             }
         }
+        //
+        [self migrateUserDefaults];
     }
     return self;
 }
 
+// the history used to be kept in NSUserDefaults, move it into the journal once
+- (void)migrateUserDefaults {
+    NSUserDefaults *defaults = [[NSUserDefaults alloc] initWithSuiteName:kSBIdentifier];
+    //
+    NSArray *keyedEvents = [defaults objectForKey:kSBEvents];
+    NSArray *keyedActions = [defaults objectForKey:kSBActions];
+    NSArray *keyedConversions = [defaults objectForKey:kSBConversions];
+    if (!keyedEvents && !keyedActions && !keyedConversions) {
+        return;
+    }
+    //
+    // a launch that died between the journal sync and removing the keys below imported them already
+    SBJSONWriter *writer = [SBJSONWriter new];
+    NSMutableSet <NSData *> *journaled = [NSMutableSet new];
+    for (JSONModel *record in journal.records) {
+        [writer reset];
+        if ([writer writeRecord:record]) {
+            [journaled addObject:[writer data]];
+        }
+    }
+    BOOL (^isJournaled)(JSONModel *) = ^BOOL(JSONModel *record) {
+        [writer reset];
+        return [writer writeRecord:record] && [journaled containsObject:[writer data]];
+    };
+    //
+    for (NSString *json in [NSSet setWithArray:keyedEvents]) {
+        NSError *error;
+        SBMMonitorEvent *event = [[SBMMonitorEvent alloc] initWithString:json error:&error];
+        if (!error && !isNull(event) && !isJournaled(event)) {
+            [events addObject:event];
+            [journal appendRecord:event];
+        }
+    }
+    //
+    for (NSString *json in [NSSet setWithArray:keyedActions]) {
+        NSError *error;
+        SBMReportAction *action = [[SBMReportAction alloc] initWithString:json error:&error];
+        if (!error && !isNull(action) && !isJournaled(action)) {
+            [actions addObject:action];
+            [journal appendRecord:action];
+        }
+    }
+    //
+    for (NSString *json in [NSSet setWithArray:keyedConversions]) {
+        NSError *error;
+        SBMReportConversion *conversion = [[SBMReportConversion alloc] initWithString:json error:&error];
+        if (!error && !isNull(conversion) && !isJournaled(conversion)) {
+            [conversions addObject:conversion];
+            [journal appendRecord:conversion];
+        }
+    }
+    //
+    [journal synchronize];
+    //
+    [defaults removeObjectForKey:kSBEvents];
+    [defaults removeObjectForKey:kSBActions];
+    [defaults removeObjectForKey:kSBConversions];
+    [defaults synchronize];
+}
+
 - (NSArray <SBMMonitorEvent> *)events {
-    return (NSArray <SBMMonitorEvent> *)[NSArray arrayWithArray:events.allObjects];
+    @synchronized (self) {
+        return (NSArray <SBMMonitorEvent> *)[NSArray arrayWithArray:events.allObjects];
+    }
 }
 
 - (NSArray <SBMReportAction> *)actions {
-    return (NSArray <SBMReportAction> *)[NSArray arrayWithArray:actions.allObjects];
+    @synchronized (self) {
+        return (NSArray <SBMReportAction> *)[NSArray arrayWithArray:actions.allObjects];
+    }
 }
 
 - (NSArray <SBMReportConversion> *)conversions {
-    return (NSArray <SBMReportConversion> *)[NSArray arrayWithArray:conversions.allObjects];
+    @synchronized (self) {
+        return (NSArray <SBMReportConversion> *)[NSArray arrayWithArray:conversions.allObjects];
+    }
 }
 
 #pragma mark - Location events
@@ -117,12 +170,15 @@ NSString * const kSBConversions = @"conversions";
 SUBSCRIBE(SBEventRegionEnter) {
     //
     SBMMonitorEvent *enter = [SBMMonitorEvent new];
-    enter.pid = event.beacon.fullUUID;
+    enter.pid = event.beacon ? event.beacon.fullUUID : event.geohash;
     enter.dt = [NSDate date];
     enter.trigger = 1;
     enter.location = [GeoHash hashForLatitude:event.location.coordinate.latitude longitude:event.location.coordinate.longitude length:9];
     //
-    [events addObject:enter];
+    @synchronized (self) {
+        [events addObject:enter];
+        [journal appendRecord:enter];
+    }
     //
     [self updateHistory];
 }
@@ -130,12 +186,15 @@ SUBSCRIBE(SBEventRegionEnter) {
 SUBSCRIBE(SBEventRegionExit) {
     //
     SBMMonitorEvent *exit = [SBMMonitorEvent new];
-    exit.pid = event.beacon.fullUUID;
+    exit.pid = event.beacon ? event.beacon.fullUUID : event.geohash;
     exit.dt = [NSDate date];
     exit.trigger = 2;
     exit.location = [GeoHash hashForLatitude:event.location.coordinate.latitude longitude:event.location.coordinate.longitude length:9];
     //
-    [events addObject:exit];
+    @synchronized (self) {
+        [events addObject:exit];
+        [journal appendRecord:exit];
+    }
     //
     [self updateHistory];
 }
@@ -150,12 +209,15 @@ SUBSCRIBE(SBEventPerformAction) {
     }
     report.trigger = event.campaign.trigger;
     report.pid = event.campaign.beacon.fullUUID;
-    if (currentLocation) {
-        report.location = [GeoHash hashForLatitude:currentLocation.coordinate.latitude longitude:currentLocation.coordinate.longitude length:9];
+    @synchronized (self) {
+        if (currentLocation) {
+            report.location = [GeoHash hashForLatitude:currentLocation.coordinate.latitude longitude:currentLocation.coordinate.longitude length:9];
+        }
+        //
+        [actions addObject:report];
+        [journal appendRecord:report];
     }
     //
-    [actions addObject:report];
-    //
     [self updateHistory];
     //
 }
@@ -170,12 +232,15 @@ SUBSCRIBE(SBEventInternalAction) {
     }
     report.trigger = event.campaign.trigger;
     report.pid = event.campaign.beacon.fullUUID;
-    if (currentLocation) {
-        report.location = [GeoHash hashForLatitude:currentLocation.coordinate.latitude longitude:currentLocation.coordinate.longitude length:9];
+    @synchronized (self) {
+        if (currentLocation) {
+            report.location = [GeoHash hashForLatitude:currentLocation.coordinate.latitude longitude:currentLocation.coordinate.longitude length:9];
+        }
+        //
+        [actions addObject:report];
+        [journal appendRecord:report];
     }
     //
-    [actions addObject:report];
-    //
     [self updateHistory];
     //
 }
@@ -190,7 +255,10 @@ SUBSCRIBE(SBEventReportConversion) {
     conversion.type = event.conversionType;
     conversion.location = [GeoHash hashForLatitude:event.gps.coordinate.latitude longitude:event.gps.coordinate.longitude length:9];
     //
-    [conversions addObject:conversion];
+    @synchronized (self) {
+        [conversions addObject:conversion];
+        [journal appendRecord:conversion];
+    }
     //
     [self updateHistory];
 }
@@ -199,65 +267,51 @@ SUBSCRIBE(SBEventLocationUpdated) {
     if (event.error) {
         return;
     }
-    currentLocation = event.location;
+    @synchronized (self) {
+        currentLocation = event.location;
+    }
 }
 
 #pragma mark - Resolver events
 
 SUBSCRIBE(SBEventPostLayout) {
     if (isNull(event.error)) {
-        for (SBMMonitorEvent *monitor in event.postData.events)
-        {
-            [events removeObject:monitor];
-        }
-        
-        for (SBMReportAction *action in event.postData.actions)
-        {
-            [actions removeObject:action];
-        }
-        
-        for (SBMReportConversion *conversion in event.postData.conversions)
-        {
-            [conversions removeObject:conversion];
+        @synchronized (self) {
+            for (SBMMonitorEvent *monitor in event.postData.events)
+            {
+                [events removeObject:monitor];
+            }
+            
+            for (SBMReportAction *action in event.postData.actions)
+            {
+                [actions removeObject:action];
+            }
+            
+            for (SBMReportConversion *conversion in event.postData.conversions)
+            {
+                [conversions removeObject:conversion];
+            }
+            //
+            [journal removeRecords:event.postData.events];
+            [journal removeRecords:event.postData.actions];
+            [journal removeRecords:event.postData.conversions];
         }
         //
         [self updateHistory];
     }
 }
 
+#pragma mark - Application lifecycle
+
+SUBSCRIBE(SBEventApplicationDidEnterBackground) {
+    [journal synchronize];
+}
+
+#pragma mark - History
+
 - (void)updateHistory {
-    NSMutableSet *keyedEvents = [NSMutableSet new];
-    NSLock *mutableSetLock = [[NSLock alloc] init];
-    [events.allObjects enumerateObjectsWithOptions:NSEnumerationConcurrent usingBlock:^(id  _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-        NSString *jsonString = [obj toJSONString];
-        [mutableSetLock lock];
-        [keyedEvents addObject:jsonString];
-        [mutableSetLock unlock];
-    }];
-    //
-    NSMutableSet *keyedActions = [NSMutableSet new];
-    [actions.allObjects enumerateObjectsWithOptions:NSEnumerationConcurrent usingBlock:^(id  _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-        NSString *jsonString = [obj toJSONString];
-        [mutableSetLock lock];
-        [keyedEvents addObject:jsonString];
-        [mutableSetLock unlock];
-    }];
-    //
-    NSMutableSet *keyedConversions = [NSMutableSet new];
-    [conversions.allObjects enumerateObjectsWithOptions:NSEnumerationConcurrent usingBlock:^(id  _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-        NSString *jsonString = [obj toJSONString];
-        [mutableSetLock lock];
-        [keyedEvents addObject:jsonString];
-        [mutableSetLock unlock];
-    }];
-    //
-    [defaults setObject:keyedEvents.allObjects forKey:kSBEvents];
-    [defaults setObject:keyedActions.allObjects forKey:kSBActions];
-    [defaults setObject:keyedConversions.allObjects forKey:kSBConversions];
-    //
-    [defaults synchronize];
-    //
-    PUBLISH([SBEventReportHistory new]);
+    // the records are already journaled, just let the manager decide whether to post them
+    SB_PUBLISH([SBEventReportHistory new]);
 }
 
 @end
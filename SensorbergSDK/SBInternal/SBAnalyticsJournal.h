@@ -0,0 +1,73 @@
+//
+//  SBAnalyticsJournal.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import <JSONModel/JSONModel.h>
+
+/**
+ *  Append-only store for the analytics history (SBMMonitorEvent, SBMReportAction and SBMReportConversion).
+ *
+ *  Every record is length prefixed and checksummed; a torn record at the end of the file
+ *  (crash while writing) is truncated on the next start. Removals are appended as tombstones
+ *  and the file is compacted once the dead records outweigh the live ones.
+ *  Writes are done on a private serial queue and fsync'ed in bounded batches.
+ */
+@interface SBAnalyticsJournal : NSObject
+
+/**
+ *  Default location of the journal, in Application Support
+ */
++ (NSString *)defaultPath;
+
+/**
+ *  Opens (or creates) the journal at `path` and replays it with a single sequential read.
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+@property (nonatomic, readonly, copy) NSString *path;
+
+/**
+ *  The live records, in the order they were appended
+ */
+- (NSArray <JSONModel *> *)records;
+
+/**
+ *  Appends a record. Only SBMMonitorEvent, SBMReportAction and SBMReportConversion are supported.
+ */
+- (void)appendRecord:(JSONModel *)record;
+
+/**
+ *  Removes previously appended (or replayed) records, matched by identity.
+ */
+- (void)removeRecords:(NSArray <JSONModel *> *)records;
+
+/**
+ *  Blocks until all appended records are written and fsync'ed.
+ */
+- (void)synchronize;
+
+@end
@@ -0,0 +1,429 @@
+//
+//  SBAnalyticsJournal.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBAnalyticsJournal.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+#import <libkern/OSByteOrder.h>
+
+#import "SensorbergSDK.h"
+#import "SBUtility.h"
+
+#import "SBInternalModels.h"
+
+#pragma mark - Constants
+
+// fsync after this many unsynced records ...
+static NSUInteger const kSBJournalSyncBatch = 64;
+// ... or at the latest after this many seconds
+static NSTimeInterval const kSBJournalSyncInterval = 2.0f;
+// don't bother compacting less than this
+static uint64_t const kSBJournalCompactionMinimum = 64 * 1024;
+
+/**
+ *  Record layout (little endian):
+ *  uint32 payload length | uint32 crc32 of kind, id and payload | uint8 kind | uint64 record id | payload
+ */
+static size_t const kSBJournalHeaderLength = 17;
+static size_t const kSBJournalChecksumOffset = 8;
+
+typedef NS_ENUM(uint8_t, SBJournalRecordKind) {
+    // payload is a list of uint64 record ids
+    kSBJournalRecordRemove = 0,
+    kSBJournalRecordMonitorEvent = 1,
+    kSBJournalRecordReportAction = 2,
+    kSBJournalRecordReportConversion = 3,
+};
+
+#pragma mark - Helpers
+
+static Class SBJournalClassForKind(SBJournalRecordKind kind) {
+    switch (kind) {
+        case kSBJournalRecordMonitorEvent:
+            return [SBMMonitorEvent class];
+        case kSBJournalRecordReportAction:
+            return [SBMReportAction class];
+        case kSBJournalRecordReportConversion:
+            return [SBMReportConversion class];
+        default:
+            return nil;
+    }
+}
+
+static SBJournalRecordKind SBJournalKindForRecord(JSONModel *record) {
+    if ([record isKindOfClass:[SBMMonitorEvent class]]) {
+        return kSBJournalRecordMonitorEvent;
+    }
+    if ([record isKindOfClass:[SBMReportAction class]]) {
+        return kSBJournalRecordReportAction;
+    }
+    if ([record isKindOfClass:[SBMReportConversion class]]) {
+        return kSBJournalRecordReportConversion;
+    }
+    return kSBJournalRecordRemove;
+}
+
+static BOOL SBWriteAll(int fd, const uint8_t *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return YES;
+}
+
+#pragma mark - SBAnalyticsJournal
+
+@interface SBAnalyticsJournal () {
+    dispatch_queue_t queue;
+    // caller side, guarded by @synchronized(self)
+    NSMapTable <JSONModel *, NSNumber *> *recordIDs;
+    NSMutableDictionary <NSNumber *, JSONModel *> *liveRecords;
+    uint64_t nextRecordID;
+    // file side, only touched on queue
+    int fd;
+    uint64_t fileLength;
+    uint64_t liveLength;
+    NSMutableDictionary <NSNumber *, NSValue *> *recordRanges;
+    NSUInteger unsyncedRecords;
+    BOOL syncScheduled;
+}
+
+@end
+
+@implementation SBAnalyticsJournal
+
++ (NSString *)defaultPath {
+    NSString *directory = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) firstObject];
+    return [[directory stringByAppendingPathComponent:kSBIdentifier] stringByAppendingPathComponent:@"analytics.journal"];
+}
+
+- (instancetype)init {
+    return [self initWithPath:[SBAnalyticsJournal defaultPath]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (self) {
+        _path = [path copy];
+        queue = dispatch_queue_create("com.sensorberg.sdk.analytics.journal", DISPATCH_QUEUE_SERIAL);
+        recordIDs = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                          valueOptions:NSPointerFunctionsStrongMemory];
+        liveRecords = [NSMutableDictionary new];
+        recordRanges = [NSMutableDictionary new];
+        nextRecordID = 1;
+        //
+        [[NSFileManager defaultManager] createDirectoryAtPath:[_path stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+        [self replay];
+        //
+        fd = open(_path.fileSystemRepresentation, O_RDWR | O_APPEND | O_CREAT, 0600);
+        if (fd < 0) {
+            SBLog(@"💀 Can't open analytics journal: %s", strerror(errno));
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+#pragma mark - Public
+
+- (NSArray <JSONModel *> *)records {
+    @synchronized (self) {
+        NSArray *sortedIDs = [liveRecords.allKeys sortedArrayUsingSelector:@selector(compare:)];
+        return [liveRecords objectsForKeys:sortedIDs notFoundMarker:[NSNull null]];
+    }
+}
+
+- (void)appendRecord:(JSONModel *)record {
+    SBJournalRecordKind kind = SBJournalKindForRecord(record);
+    if (kind == kSBJournalRecordRemove) {
+        SBLog(@"💀 Can't journal %@", NSStringFromClass(record.class));
+        return;
+    }
+    //
+    NSData *payload = [record toJSONData];
+    if (!payload) {
+        return;
+    }
+    //
+    uint64_t recordID;
+    @synchronized (self) {
+        if ([recordIDs objectForKey:record]) {
+            return;
+        }
+        recordID = nextRecordID++;
+        [recordIDs setObject:@(recordID) forKey:record];
+        liveRecords[@(recordID)] = record;
+    }
+    //
+    dispatch_async(queue, ^{
+        NSRange range = [self writeRecordWithKind:kind recordID:recordID payload:payload];
+        if (range.length) {
+            recordRanges[@(recordID)] = [NSValue valueWithRange:range];
+            liveLength += range.length;
+        }
+    });
+}
+
+- (void)removeRecords:(NSArray <JSONModel *> *)records {
+    NSMutableData *payload = [NSMutableData dataWithCapacity:records.count * sizeof(uint64_t)];
+    @synchronized (self) {
+        for (JSONModel *record in records) {
+            NSNumber *recordID = [recordIDs objectForKey:record];
+            if (!recordID) {
+                continue;
+            }
+            [recordIDs removeObjectForKey:record];
+            [liveRecords removeObjectForKey:recordID];
+            //
+            uint64_t value = OSSwapHostToLittleInt64(recordID.unsignedLongLongValue);
+            [payload appendBytes:&value length:sizeof(value)];
+        }
+    }
+    if (!payload.length) {
+        return;
+    }
+    //
+    dispatch_async(queue, ^{
+        const uint8_t *bytes = payload.bytes;
+        for (NSUInteger offset = 0; offset < payload.length; offset += sizeof(uint64_t)) {
+            NSNumber *recordID = @(OSReadLittleInt64(bytes, offset));
+            NSValue *range = recordRanges[recordID];
+            if (range) {
+                liveLength -= range.rangeValue.length;
+                [recordRanges removeObjectForKey:recordID];
+            }
+        }
+        //
+        if (!recordRanges.count) {
+            [self truncate];
+        } else {
+            [self writeRecordWithKind:kSBJournalRecordRemove recordID:0 payload:payload];
+            [self compactIfNeeded];
+        }
+    });
+}
+
+- (void)synchronize {
+    dispatch_sync(queue, ^{
+        [self sync];
+    });
+}
+
+#pragma mark - Replay
+
+- (void)replay {
+    NSData *data = [NSData dataWithContentsOfFile:self.path options:NSDataReadingMappedIfSafe error:nil];
+    const uint8_t *bytes = data.bytes;
+    NSUInteger length = data.length;
+    NSUInteger offset = 0;
+    //
+    while (offset + kSBJournalHeaderLength <= length) {
+        uint32_t payloadLength = OSReadLittleInt32(bytes, offset);
+        if (payloadLength > length - offset - kSBJournalHeaderLength) {
+            break;
+        }
+        uint32_t checksum = OSReadLittleInt32(bytes, offset + 4);
+        if (checksum != SBCRC32(bytes + offset + kSBJournalChecksumOffset, kSBJournalHeaderLength - kSBJournalChecksumOffset + payloadLength)) {
+            break;
+        }
+        //
+        SBJournalRecordKind kind = bytes[offset + 8];
+        uint64_t recordID = OSReadLittleInt64(bytes, offset + 9);
+        const uint8_t *payload = bytes + offset + kSBJournalHeaderLength;
+        NSUInteger recordLength = kSBJournalHeaderLength + payloadLength;
+        //
+        if (kind == kSBJournalRecordRemove) {
+            for (NSUInteger i = 0; i + sizeof(uint64_t) <= payloadLength; i += sizeof(uint64_t)) {
+                NSNumber *removedID = @(OSReadLittleInt64(payload, i));
+                NSValue *range = recordRanges[removedID];
+                if (range) {
+                    liveLength -= range.rangeValue.length;
+                    [recordRanges removeObjectForKey:removedID];
+                    JSONModel *removed = liveRecords[removedID];
+                    if (removed) {
+                        [recordIDs removeObjectForKey:removed];
+                        [liveRecords removeObjectForKey:removedID];
+                    }
+                }
+            }
+        } else {
+            Class recordClass = SBJournalClassForKind(kind);
+            NSError *error;
+            JSONModel *record = [[recordClass alloc] initWithData:[NSData dataWithBytes:payload length:payloadLength] error:&error];
+            if (record && !error) {
+                liveRecords[@(recordID)] = record;
+                [recordIDs setObject:@(recordID) forKey:record];
+                recordRanges[@(recordID)] = [NSValue valueWithRange:NSMakeRange(offset, recordLength)];
+                liveLength += recordLength;
+            }
+            nextRecordID = MAX(nextRecordID, recordID + 1);
+        }
+        offset += recordLength;
+    }
+    //
+    fileLength = offset;
+    if (offset < length) {
+        // torn or corrupt tail, most likely a crash while appending
+        SBLog(@"💀 Truncating analytics journal from %lu to %lu bytes", (unsigned long)length, (unsigned long)offset);
+        truncate(self.path.fileSystemRepresentation, (off_t)offset);
+    }
+}
+
+#pragma mark - File (on queue)
+
+- (NSRange)writeRecordWithKind:(SBJournalRecordKind)kind recordID:(uint64_t)recordID payload:(NSData *)payload {
+    if (fd < 0) {
+        return NSMakeRange(0, 0);
+    }
+    //
+    NSUInteger recordLength = kSBJournalHeaderLength + payload.length;
+    NSMutableData *record = [NSMutableData dataWithLength:kSBJournalHeaderLength];
+    uint8_t *header = record.mutableBytes;
+    OSWriteLittleInt32(header, 0, (uint32_t)payload.length);
+    header[8] = kind;
+    OSWriteLittleInt64(header, 9, recordID);
+    [record appendData:payload];
+    //
+    uint8_t *bytes = record.mutableBytes;
+    OSWriteLittleInt32(bytes, 4, SBCRC32(bytes + kSBJournalChecksumOffset, recordLength - kSBJournalChecksumOffset));
+    //
+    if (!SBWriteAll(fd, bytes, recordLength)) {
+        SBLog(@"💀 Can't write analytics journal: %s", strerror(errno));
+        // drop whatever made it to disk, replay would stop there anyway
+        ftruncate(fd, (off_t)fileLength);
+        return NSMakeRange(0, 0);
+    }
+    //
+    NSRange range = NSMakeRange((NSUInteger)fileLength, recordLength);
+    fileLength += recordLength;
+    [self recordWritten];
+    return range;
+}
+
+- (void)recordWritten {
+    unsyncedRecords++;
+    if (unsyncedRecords >= kSBJournalSyncBatch) {
+        [self sync];
+        return;
+    }
+    //
+    if (!syncScheduled) {
+        syncScheduled = YES;
+        __weak __typeof(self) weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kSBJournalSyncInterval * NSEC_PER_SEC)), queue, ^{
+            [weakSelf sync];
+        });
+    }
+}
+
+- (void)sync {
+    syncScheduled = NO;
+    if (!unsyncedRecords || fd < 0) {
+        return;
+    }
+    fsync(fd);
+    unsyncedRecords = 0;
+}
+
+- (void)truncate {
+    if (fd < 0) {
+        return;
+    }
+    ftruncate(fd, 0);
+    fileLength = 0;
+    liveLength = 0;
+    unsyncedRecords++;
+    [self sync];
+}
+
+- (void)compactIfNeeded {
+    uint64_t deadLength = fileLength - liveLength;
+    if (deadLength < kSBJournalCompactionMinimum || deadLength < liveLength) {
+        return;
+    }
+    [self compact];
+}
+
+- (void)compact {
+    NSString *compactPath = [self.path stringByAppendingPathExtension:@"compact"];
+    int compactFd = open(compactPath.fileSystemRepresentation, O_RDWR | O_APPEND | O_CREAT | O_TRUNC, 0600);
+    if (compactFd < 0) {
+        return;
+    }
+    //
+    NSArray *recordIDsByOffset = [recordRanges keysSortedByValueUsingComparator:^NSComparisonResult(NSValue *range1, NSValue *range2) {
+        return range1.rangeValue.location < range2.rangeValue.location ? NSOrderedAscending : NSOrderedDescending;
+    }];
+    //
+    NSMutableDictionary *compactRanges = [NSMutableDictionary dictionaryWithCapacity:recordRanges.count];
+    NSMutableData *buffer = [NSMutableData new];
+    uint64_t compactLength = 0;
+    for (NSNumber *recordID in recordIDsByOffset) {
+        NSRange range = [recordRanges[recordID] rangeValue];
+        buffer.length = range.length;
+        if (pread(fd, buffer.mutableBytes, range.length, (off_t)range.location) != (ssize_t)range.length ||
+            !SBWriteAll(compactFd, buffer.bytes, range.length)) {
+            close(compactFd);
+            unlink(compactPath.fileSystemRepresentation);
+            return;
+        }
+        compactRanges[recordID] = [NSValue valueWithRange:NSMakeRange((NSUInteger)compactLength, range.length)];
+        compactLength += range.length;
+    }
+    //
+    if (fsync(compactFd) != 0 || rename(compactPath.fileSystemRepresentation, self.path.fileSystemRepresentation) != 0) {
+        close(compactFd);
+        unlink(compactPath.fileSystemRepresentation);
+        return;
+    }
+    //
+    close(fd);
+    fd = compactFd;
+    fileLength = compactLength;
+    liveLength = compactLength;
+    recordRanges = compactRanges;
+    unsyncedRecords = 0;
+    SBLog(@"Compacted analytics journal to %llu bytes", compactLength);
+}
+
+@end
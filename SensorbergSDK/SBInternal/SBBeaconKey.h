@@ -0,0 +1,90 @@
+//
+//  SBBeaconKey.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import "SBModel.h"
+
+/**
+ *  Packed binary beacon identity: 16 bytes of proximity UUID plus major and minor.
+ *  Hashing and comparing it never touches a string.
+ */
+typedef struct {
+    uint8_t uuid[16];
+    uint16_t major;
+    uint16_t minor;
+} SBBeaconKey;
+
+static inline BOOL SBBeaconKeyEqual(const SBBeaconKey *key1, const SBBeaconKey *key2) {
+    return memcmp(key1, key2, sizeof(SBBeaconKey)) == 0;
+}
+
+/**
+ *  FNV-1a over the packed key
+ */
+NSUInteger SBBeaconKeyHash(const SBBeaconKey *key);
+
+/**
+ *  Parses 32 hex characters (upper or lower case) into 16 bytes.
+ *
+ *  @return NO if the string is not exactly 32 hex characters
+ */
+BOOL SBBeaconKeyParseUUID(NSString *uuid, uint8_t bytes[16]);
+
+/**
+ *  Parses a full UUID (32 hex characters UUID, 5 digits major, 5 digits minor; hyphens are ignored).
+ *
+ *  @return NO if the string is not a valid full UUID or major/minor do not fit 16 bits
+ */
+BOOL SBBeaconKeyParseFullUUID(NSString *fullUUID, SBBeaconKey *key);
+
+/**
+ *  SBBeaconKeyParseFullUUID on `length` ASCII characters, e.g. straight from the JSON of a layout
+ */
+BOOL SBBeaconKeyParseFullUUIDBytes(const char *bytes, size_t length, SBBeaconKey *key);
+
+/**
+ *  The 32 character lowercase hex form of the proximity UUID
+ */
+NSString *SBBeaconKeyUUIDString(const SBBeaconKey *key);
+
+/**
+ *  The 42 character full UUID, as used in the resolver JSON
+ */
+NSString *SBBeaconKeyFullUUIDString(const SBBeaconKey *key);
+
+@interface SBMBeacon (SBBeaconKey)
+
+- (instancetype)initWithBeaconKey:(SBBeaconKey)key;
+
+/**
+ *  Fills `key` with the packed identity of the beacon.
+ *
+ *  @return NO if the beacon has no valid UUID or major/minor are out of range
+ */
+- (BOOL)getBeaconKey:(SBBeaconKey *)key;
+
+@end
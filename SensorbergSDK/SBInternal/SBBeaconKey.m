@@ -0,0 +1,166 @@
+//
+//  SBBeaconKey.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBBeaconKey.h"
+
+static const char kSBHexDigits[] = "0123456789abcdef";
+
+static inline int SBHexDigitValue(unichar c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static BOOL SBParseHexBytes(const unichar *characters, uint8_t *bytes, NSUInteger count) {
+    for (NSUInteger i = 0; i < count; i++) {
+        int high = SBHexDigitValue(characters[2 * i]);
+        int low = SBHexDigitValue(characters[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return NO;
+        }
+        bytes[i] = (uint8_t)((high << 4) | low);
+    }
+    return YES;
+}
+
+static BOOL SBParseDecimal(const unichar *characters, NSUInteger count, uint16_t *value) {
+    uint32_t result = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (characters[i] < '0' || characters[i] > '9') {
+            return NO;
+        }
+        result = result * 10 + (characters[i] - '0');
+    }
+    if (result > UINT16_MAX) {
+        return NO;
+    }
+    *value = (uint16_t)result;
+    return YES;
+}
+
+NSUInteger SBBeaconKeyHash(const SBBeaconKey *key) {
+    const uint8_t *bytes = (const uint8_t *)key;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(SBBeaconKey); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+BOOL SBBeaconKeyParseUUID(NSString *uuid, uint8_t bytes[16]) {
+    if (uuid.length != 32) {
+        return NO;
+    }
+    unichar characters[32];
+    [uuid getCharacters:characters range:NSMakeRange(0, 32)];
+    return SBParseHexBytes(characters, bytes, 16);
+}
+
+// hyphens are ignored, `length` is at most 46
+static BOOL SBParseFullUUIDCharacters(const unichar *buffer, NSUInteger length, SBBeaconKey *key) {
+    unichar characters[42];
+    NSUInteger count = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+        if (buffer[i] == '-') {
+            continue;
+        }
+        if (count == 42) {
+            return NO;
+        }
+        characters[count++] = buffer[i];
+    }
+    if (count != 42) {
+        return NO;
+    }
+    //
+    SBBeaconKey result;
+    memset(&result, 0, sizeof(SBBeaconKey));
+    if (!SBParseHexBytes(characters, result.uuid, 16) ||
+        !SBParseDecimal(characters + 32, 5, &result.major) ||
+        !SBParseDecimal(characters + 37, 5, &result.minor)) {
+        return NO;
+    }
+    *key = result;
+    return YES;
+}
+
+BOOL SBBeaconKeyParseFullUUID(NSString *fullUUID, SBBeaconKey *key) {
+    NSUInteger length = fullUUID.length;
+    if (length < 42 || length > 46) {
+        return NO;
+    }
+    //
+    unichar buffer[46];
+    [fullUUID getCharacters:buffer range:NSMakeRange(0, length)];
+    return SBParseFullUUIDCharacters(buffer, length, key);
+}
+
+BOOL SBBeaconKeyParseFullUUIDBytes(const char *bytes, size_t length, SBBeaconKey *key) {
+    if (length < 42 || length > 46) {
+        return NO;
+    }
+    //
+    unichar buffer[46];
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = (unsigned char)bytes[i];
+    }
+    return SBParseFullUUIDCharacters(buffer, length, key);
+}
+
+NSString *SBBeaconKeyUUIDString(const SBBeaconKey *key) {
+    char characters[32];
+    for (int i = 0; i < 16; i++) {
+        characters[2 * i] = kSBHexDigits[key->uuid[i] >> 4];
+        characters[2 * i + 1] = kSBHexDigits[key->uuid[i] & 0x0f];
+    }
+    return [[NSString alloc] initWithBytes:characters length:sizeof(characters) encoding:NSASCIIStringEncoding];
+}
+
+NSString *SBBeaconKeyFullUUIDString(const SBBeaconKey *key) {
+    char characters[42];
+    for (int i = 0; i < 16; i++) {
+        characters[2 * i] = kSBHexDigits[key->uuid[i] >> 4];
+        characters[2 * i + 1] = kSBHexDigits[key->uuid[i] & 0x0f];
+    }
+    // major and minor, padded with 0's to length 5
+    uint16_t major = key->major;
+    uint16_t minor = key->minor;
+    for (int i = 4; i >= 0; i--) {
+        characters[32 + i] = (char)('0' + major % 10);
+        characters[37 + i] = (char)('0' + minor % 10);
+        major /= 10;
+        minor /= 10;
+    }
+    return [[NSString alloc] initWithBytes:characters length:sizeof(characters) encoding:NSASCIIStringEncoding];
+}
@@ -0,0 +1,55 @@
+//
+//  SBCampaignIndex.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import "SBEnums.h"
+
+#import "SBBeaconKey.h"
+
+@class SBMAction;
+
+/**
+ *  Maps beacon identities to the actions of a layout, split by trigger.
+ *  A lookup costs O(matches) instead of O(actions × beacons).
+ *  The index is immutable, build a new one when the actions change.
+ */
+@interface SBCampaignIndex : NSObject
+
+- (instancetype)initWithActions:(NSArray <SBMAction *> *)actions;
+
+/**
+ *  Candidate actions for a beacon and trigger, in layout order.
+ *  Actions with `kSBTriggerEnterExit` are returned for both enter and exit.
+ */
+- (NSArray <SBMAction *> *)actionsForBeacon:(SBMBeacon *)beacon trigger:(SBTriggerType)trigger;
+
+/**
+ *  Number of distinct beacons referenced by the indexed actions
+ */
+@property (nonatomic, readonly) NSUInteger beaconCount;
+
+@end
@@ -0,0 +1,173 @@
+//
+//  SBCampaignIndex.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBCampaignIndex.h"
+
+#import "SBModel.h"
+
+#import "SBInternalModels.h"
+
+#pragma mark - Key callbacks
+
+static Boolean SBBeaconKeyEqualCallBack(const void *value1, const void *value2) {
+    return SBBeaconKeyEqual(value1, value2);
+}
+
+static CFHashCode SBBeaconKeyHashCallBack(const void *value) {
+    return SBBeaconKeyHash(value);
+}
+
+#pragma mark - SBCampaignIndexEntry
+
+@interface SBCampaignIndexEntry : NSObject
+@property (strong, nonatomic) NSMutableArray <SBMAction *> *allActions;
+@property (strong, nonatomic) NSMutableArray <SBMAction *> *enterActions;
+@property (strong, nonatomic) NSMutableArray <SBMAction *> *exitActions;
+@end
+
+@implementation SBCampaignIndexEntry
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _allActions = [NSMutableArray new];
+        _enterActions = [NSMutableArray new];
+        _exitActions = [NSMutableArray new];
+    }
+    return self;
+}
+
+@end
+
+#pragma mark - SBCampaignIndex
+
+@interface SBCampaignIndex () {
+    CFMutableDictionaryRef table;
+    // keys are stored contiguously, the table only points into this buffer
+    SBBeaconKey *keys;
+    NSUInteger keyCount;
+}
+
+@end
+
+@implementation SBCampaignIndex
+
+- (instancetype)init {
+    return [self initWithActions:@[]];
+}
+
+- (instancetype)initWithActions:(NSArray <SBMAction *> *)actions {
+    self = [super init];
+    if (self) {
+        NSUInteger capacity = 0;
+        for (SBMAction *action in actions) {
+            capacity += action.beacons.count;
+        }
+        //
+        keys = calloc(MAX(capacity, 1), sizeof(SBBeaconKey));
+        //
+        CFDictionaryKeyCallBacks keyCallBacks = {0, NULL, NULL, NULL, SBBeaconKeyEqualCallBack, SBBeaconKeyHashCallBack};
+        table = CFDictionaryCreateMutable(kCFAllocatorDefault, (CFIndex)capacity, &keyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        //
+        for (SBMAction *action in actions) {
+            for (SBMBeacon *beacon in action.beacons) {
+                if (![beacon isKindOfClass:[SBMBeacon class]]) {
+                    continue;
+                }
+                [self addAction:action forBeacon:beacon];
+            }
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (table) {
+        CFRelease(table);
+    }
+    free(keys);
+}
+
+- (void)addAction:(SBMAction *)action forBeacon:(SBMBeacon *)beacon {
+    SBBeaconKey key;
+    if (![beacon getBeaconKey:&key]) {
+        return;
+    }
+    //
+    SBCampaignIndexEntry *entry = (__bridge SBCampaignIndexEntry *)CFDictionaryGetValue(table, &key);
+    if (!entry) {
+        entry = [SBCampaignIndexEntry new];
+        keys[keyCount] = key;
+        CFDictionarySetValue(table, &keys[keyCount], (__bridge const void *)entry);
+        keyCount++;
+    }
+    // a beacon listed twice in the same action must not make it fire twice
+    if (entry.allActions.lastObject == action) {
+        return;
+    }
+    //
+    [entry.allActions addObject:action];
+    if (action.trigger == kSBTriggerEnter || action.trigger == kSBTriggerEnterExit) {
+        [entry.enterActions addObject:action];
+    }
+    if (action.trigger == kSBTriggerExit || action.trigger == kSBTriggerEnterExit) {
+        [entry.exitActions addObject:action];
+    }
+}
+
+- (NSArray <SBMAction *> *)actionsForBeacon:(SBMBeacon *)beacon trigger:(SBTriggerType)trigger {
+    SBBeaconKey key;
+    if (![beacon getBeaconKey:&key]) {
+        return @[];
+    }
+    //
+    SBCampaignIndexEntry *entry = (__bridge SBCampaignIndexEntry *)CFDictionaryGetValue(table, &key);
+    if (!entry) {
+        return @[];
+    }
+    //
+    switch (trigger) {
+        case kSBTriggerEnter:
+            return entry.enterActions;
+        case kSBTriggerExit:
+            return entry.exitActions;
+        default: {
+            NSMutableArray *actions = [NSMutableArray new];
+            for (SBMAction *action in entry.allActions) {
+                if (action.trigger == trigger || action.trigger == kSBTriggerEnterExit) {
+                    [actions addObject:action];
+                }
+            }
+            return actions;
+        }
+    }
+}
+
+- (NSUInteger)beaconCount {
+    return keyCount;
+}
+
+@end
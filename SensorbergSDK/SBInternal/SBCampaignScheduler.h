@@ -0,0 +1,107 @@
+//
+//  SBCampaignScheduler.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class SBMAction;
+@class SBMCampaignAction;
+@class SBFireHistory;
+
+/**
+ *  Seconds since 1970, the scheduler reads the time only through it
+ */
+typedef NSTimeInterval (^SBCampaignSchedulerClock)(void);
+
+/**
+ *  Campaign actions waiting for their fireDate (delayed or deliverAt), delivered by the SDK instead of the host app.
+ *
+ *  The pending deliveries are a min-heap on the fire date: scheduling and cancelling are O(log n) and one timer
+ *  is armed for the earliest deadline only. When it fires, the due actions that haven't become suppressed meanwhile
+ *  (sendOnlyOnce, suppressionTime) are recorded in the fire history and published as SBEventPerformAction.
+ *
+ *  The heap is written to a file in Application Support on a private serial queue, in batches,
+ *  and restored when the scheduler is created: pending deliveries survive the termination of the app.
+ *  Changes not written yet are written when the scheduler is released.
+ */
+@interface SBCampaignScheduler : NSObject
+
++ (NSString *)defaultPath;
+
+/**
+ *  A scheduler on the wall clock, recording the fires in the shared history
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+/**
+ *  @param history the fire history the suppression is checked against and the deliveries are recorded in
+ *  @param clock   the time the deadlines are compared to, the wake-up timer is armed for the difference
+ */
+- (instancetype)initWithPath:(NSString *)path fireHistory:(SBFireHistory *)history clock:(SBCampaignSchedulerClock)clock;
+
+@property (nonatomic, readonly, copy) NSString *path;
+
+/**
+ *  Holds the campaign action until its fireDate.
+ *
+ *  @param campaignAction the action to publish, with its fireDate set
+ *  @param action         the layout action it was made of, for the suppression settings
+ *
+ *  @return NO if the campaign action has no fireDate or its campaign already has a pending delivery
+ */
+- (BOOL)scheduleCampaignAction:(SBMCampaignAction *)campaignAction forAction:(SBMAction *)action;
+
+/**
+ *  Drops the pending delivery of the campaign, NO if there was none
+ */
+- (BOOL)cancelCampaign:(NSString *)eid;
+
+- (BOOL)isCampaignPending:(NSString *)eid;
+
+/**
+ *  Publishes the actions whose fireDate passed, earliest first. Called by the wake-up timer.
+ *
+ *  @return the campaign actions published, without the ones dropped as suppressed
+ */
+- (NSArray <SBMCampaignAction *> *)fireDueActions;
+
+/**
+ *  The earliest fireDate pending, the wake-up timer is armed for it. 0 if nothing is pending.
+ */
+@property (nonatomic, readonly) NSTimeInterval nextDeadline;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ *  Drops the pending deliveries and deletes the file
+ */
+- (void)removeAllCampaigns;
+
+/**
+ *  Blocks until the pending changes are written.
+ */
+- (void)synchronize;
+
+@end
@@ -0,0 +1,450 @@
+//
+//  SBCampaignScheduler.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBCampaignScheduler.h"
+
+#import "SensorbergSDK.h"
+
+#import "SBInternalModels.h"
+#import "SBFireHistory.h"
+
+#import "SBUtility.h"
+
+#pragma mark - Constants
+
+// changes within this interval are written together
+static NSTimeInterval const kSBCampaignSchedulerWriteDelay = 1.0f;
+
+static NSInteger const kSBCampaignSchedulerVersion = 1;
+
+// the system may wake us this late, to coalesce the timer with others
+static uint64_t const kSBCampaignSchedulerLeeway = 1 * NSEC_PER_SEC;
+
+#pragma mark - SBScheduledCampaign
+
+@interface SBScheduledCampaign : NSObject <NSCoding>
+@property (strong, nonatomic) SBMCampaignAction *campaign;
+@property (nonatomic) NSTimeInterval deadline;
+// equal deadlines are delivered in the order they were scheduled
+@property (nonatomic) uint64_t sequence;
+@property (nonatomic) BOOL sendOnlyOnce;
+@property (nonatomic) int suppressionTime;
+@property (nonatomic) BOOL reportImmediately;
+// position in the heap, not persisted
+@property (nonatomic) NSUInteger heapIndex;
+@end
+
+@implementation SBScheduledCampaign
+
+- (void)encodeWithCoder:(NSCoder *)coder {
+    [coder encodeDouble:self.deadline forKey:@"deadline"];
+    [coder encodeInt64:(int64_t)self.sequence forKey:@"sequence"];
+    [coder encodeBool:self.sendOnlyOnce forKey:@"sendOnlyOnce"];
+    [coder encodeInt:self.suppressionTime forKey:@"suppressionTime"];
+    [coder encodeBool:self.reportImmediately forKey:@"reportImmediately"];
+    //
+    SBMCampaignAction *campaign = self.campaign;
+    [coder encodeObject:campaign.eid forKey:@"eid"];
+    [coder encodeObject:campaign.action forKey:@"action"];
+    [coder encodeObject:campaign.subject forKey:@"subject"];
+    [coder encodeObject:campaign.body forKey:@"body"];
+    [coder encodeObject:campaign.payload forKey:@"payload"];
+    [coder encodeObject:campaign.url forKey:@"url"];
+    [coder encodeInteger:campaign.trigger forKey:@"trigger"];
+    [coder encodeInteger:campaign.type forKey:@"type"];
+    [coder encodeObject:campaign.beacon.fullUUID forKey:@"beacon"];
+}
+
+- (instancetype)initWithCoder:(NSCoder *)coder {
+    NSString *eid = [coder decodeObjectForKey:@"eid"];
+    if (![eid isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    self = [super init];
+    if (self) {
+        _deadline = [coder decodeDoubleForKey:@"deadline"];
+        _sequence = (uint64_t)[coder decodeInt64ForKey:@"sequence"];
+        _sendOnlyOnce = [coder decodeBoolForKey:@"sendOnlyOnce"];
+        _suppressionTime = [coder decodeIntForKey:@"suppressionTime"];
+        _reportImmediately = [coder decodeBoolForKey:@"reportImmediately"];
+        //
+        SBMCampaignAction *campaign = [SBMCampaignAction new];
+        campaign.eid = eid;
+        campaign.action = [coder decodeObjectForKey:@"action"];
+        campaign.subject = [coder decodeObjectForKey:@"subject"];
+        campaign.body = [coder decodeObjectForKey:@"body"];
+        campaign.payload = [coder decodeObjectForKey:@"payload"];
+        campaign.url = [coder decodeObjectForKey:@"url"];
+        campaign.trigger = [coder decodeIntegerForKey:@"trigger"];
+        campaign.type = [coder decodeIntegerForKey:@"type"];
+        NSString *beacon = [coder decodeObjectForKey:@"beacon"];
+        campaign.beacon = beacon ? [[SBMBeacon alloc] initWithString:beacon] : nil;
+        campaign.fireDate = [NSDate dateWithTimeIntervalSince1970:_deadline];
+        _campaign = campaign;
+    }
+    return self;
+}
+
+@end
+
+static inline BOOL SBScheduledBefore(SBScheduledCampaign *a, SBScheduledCampaign *b) {
+    return a.deadline < b.deadline || (a.deadline == b.deadline && a.sequence < b.sequence);
+}
+
+#pragma mark - SBCampaignScheduler
+
+@interface SBCampaignScheduler () {
+    SBFireHistory *history;
+    SBCampaignSchedulerClock currentTime;
+    dispatch_queue_t queue;
+    // guarded by @synchronized(self)
+    NSMutableArray <SBScheduledCampaign *> *heap;
+    NSMutableDictionary <NSString *, SBScheduledCampaign *> *pending;
+    uint64_t nextSequence;
+    dispatch_source_t wakeTimer;
+    NSTimeInterval armedDeadline;
+    SBDeferredWrite *deferredWrite;
+}
+
+@end
+
+@implementation SBCampaignScheduler
+
++ (NSString *)defaultPath {
+    NSString *directory = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) firstObject];
+    return [[directory stringByAppendingPathComponent:kSBIdentifier] stringByAppendingPathComponent:@"campaigns.schedule"];
+}
+
+- (instancetype)init {
+    return [self initWithPath:[SBCampaignScheduler defaultPath]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    return [self initWithPath:path fireHistory:[SBFireHistory sharedHistory] clock:^NSTimeInterval{
+        return [[NSDate date] timeIntervalSince1970];
+    }];
+}
+
+- (instancetype)initWithPath:(NSString *)path fireHistory:(SBFireHistory *)fireHistory clock:(SBCampaignSchedulerClock)schedulerClock {
+    self = [super init];
+    if (self) {
+        _path = [path copy];
+        history = fireHistory;
+        currentTime = [schedulerClock copy];
+        queue = dispatch_queue_create("com.sensorberg.sdk.campaign.scheduler", DISPATCH_QUEUE_SERIAL);
+        __weak __typeof(self) weakSelf = self;
+        deferredWrite = [[SBDeferredWrite alloc] initWithQueue:queue delay:kSBCampaignSchedulerWriteDelay write:^{
+            [weakSelf write];
+        }];
+        heap = [NSMutableArray new];
+        pending = [NSMutableDictionary new];
+        //
+        [[NSFileManager defaultManager] createDirectoryAtPath:[_path stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+        [self restoreFromData:[NSData dataWithContentsOfFile:_path]];
+        [self armWakeTimer];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (wakeTimer) {
+        dispatch_source_cancel(wakeTimer);
+    }
+    // the deferred write only holds a weak reference, it's gone by now
+    if ([deferredWrite cancel]) {
+        [self write];
+    }
+}
+
+#pragma mark - Public
+
+- (BOOL)scheduleCampaignAction:(SBMCampaignAction *)campaignAction forAction:(SBMAction *)action {
+    if (!campaignAction.eid.length || !campaignAction.fireDate) {
+        return NO;
+    }
+    SBScheduledCampaign *entry = [SBScheduledCampaign new];
+    entry.campaign = campaignAction;
+    entry.deadline = campaignAction.fireDate.timeIntervalSince1970;
+    entry.sendOnlyOnce = action.sendOnlyOnce;
+    entry.suppressionTime = action.suppressionTime;
+    entry.reportImmediately = action.reportImmediately;
+    @synchronized (self) {
+        if (pending[campaignAction.eid]) {
+            return NO;
+        }
+        entry.sequence = nextSequence++;
+        [self insert:entry];
+    }
+    [self armWakeTimer];
+    [deferredWrite schedule];
+    return YES;
+}
+
+- (BOOL)cancelCampaign:(NSString *)eid {
+    if (!eid) {
+        return NO;
+    }
+    @synchronized (self) {
+        SBScheduledCampaign *entry = pending[eid];
+        if (!entry) {
+            return NO;
+        }
+        [self removeAtIndex:entry.heapIndex];
+    }
+    [self armWakeTimer];
+    [deferredWrite schedule];
+    return YES;
+}
+
+- (BOOL)isCampaignPending:(NSString *)eid {
+    if (!eid) {
+        return NO;
+    }
+    @synchronized (self) {
+        return pending[eid] != nil;
+    }
+}
+
+- (NSArray <SBMCampaignAction *> *)fireDueActions {
+    NSTimeInterval now = currentTime();
+    NSMutableArray <SBScheduledCampaign *> *due = [NSMutableArray new];
+    @synchronized (self) {
+        while (heap.count && heap[0].deadline <= now) {
+            [due addObject:heap[0]];
+            [self removeAtIndex:0];
+        }
+        // the timer fired: arm it again even if the earliest deadline is the same
+        armedDeadline = -1;
+    }
+    [self armWakeTimer];
+    if (!due.count) {
+        return @[];
+    }
+    [deferredWrite schedule];
+    //
+    NSMutableArray <SBMCampaignAction *> *published = [NSMutableArray arrayWithCapacity:due.count];
+    for (SBScheduledCampaign *entry in due) {
+        if ([self isSuppressed:entry now:now]) {
+            SBLog(@"🔕 Suppressed \"%@\"", entry.campaign.subject);
+            continue;
+        }
+        SBLog(@"🔔 Scheduled campaign \"%@\"", entry.campaign.subject);
+        [history recordFireOfCampaign:entry.campaign.eid date:[NSDate dateWithTimeIntervalSince1970:now]];
+        [SBMGetLayout publishCampaignAction:entry.campaign reportImmediately:entry.reportImmediately];
+        [published addObject:entry.campaign];
+    }
+    return published;
+}
+
+- (NSTimeInterval)nextDeadline {
+    @synchronized (self) {
+        return heap.count ? heap[0].deadline : 0;
+    }
+}
+
+- (NSUInteger)count {
+    @synchronized (self) {
+        return heap.count;
+    }
+}
+
+- (void)removeAllCampaigns {
+    @synchronized (self) {
+        [heap removeAllObjects];
+        [pending removeAllObjects];
+        // nothing left to write
+        [deferredWrite cancel];
+    }
+    [self armWakeTimer];
+    dispatch_sync(queue, ^{
+        [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    });
+}
+
+- (void)synchronize {
+    [deferredWrite flush];
+}
+
+#pragma mark - Suppression
+
+// the checks of checkCampaignsForBeacon:trigger:, again: the campaign may have fired while this one waited
+- (BOOL)isSuppressed:(SBScheduledCampaign *)entry now:(NSTimeInterval)now {
+    int64_t lastFire = [history lastFireOfCampaign:entry.campaign.eid];
+    if (!lastFire) {
+        return NO;
+    }
+    if (entry.sendOnlyOnce) {
+        return YES;
+    }
+    NSTimeInterval previousFire = now - lastFire / 1000.0;
+    return entry.suppressionTime && previousFire > 0 && previousFire < entry.suppressionTime;
+}
+
+#pragma mark - Heap (under @synchronized(self))
+
+- (void)insert:(SBScheduledCampaign *)entry {
+    entry.heapIndex = heap.count;
+    [heap addObject:entry];
+    pending[entry.campaign.eid] = entry;
+    [self siftUp:entry.heapIndex];
+}
+
+- (void)removeAtIndex:(NSUInteger)index {
+    SBScheduledCampaign *entry = heap[index];
+    [pending removeObjectForKey:entry.campaign.eid];
+    NSUInteger last = heap.count - 1;
+    if (index != last) {
+        [self swap:index with:last];
+    }
+    [heap removeLastObject];
+    if (index < heap.count) {
+        if (index > 0 && SBScheduledBefore(heap[index], heap[(index - 1) / 2])) {
+            [self siftUp:index];
+        } else {
+            [self siftDown:index];
+        }
+    }
+}
+
+- (void)siftUp:(NSUInteger)index {
+    while (index > 0) {
+        NSUInteger parent = (index - 1) / 2;
+        if (!SBScheduledBefore(heap[index], heap[parent])) {
+            break;
+        }
+        [self swap:index with:parent];
+        index = parent;
+    }
+}
+
+- (void)siftDown:(NSUInteger)index {
+    NSUInteger count = heap.count;
+    while (YES) {
+        NSUInteger smallest = index;
+        NSUInteger left = 2 * index + 1;
+        NSUInteger right = left + 1;
+        if (left < count && SBScheduledBefore(heap[left], heap[smallest])) {
+            smallest = left;
+        }
+        if (right < count && SBScheduledBefore(heap[right], heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        [self swap:index with:smallest];
+        index = smallest;
+    }
+}
+
+- (void)swap:(NSUInteger)a with:(NSUInteger)b {
+    [heap exchangeObjectAtIndex:a withObjectAtIndex:b];
+    heap[a].heapIndex = a;
+    heap[b].heapIndex = b;
+}
+
+#pragma mark - Wake-up
+
+- (void)armWakeTimer {
+    @synchronized (self) {
+        NSTimeInterval deadline = heap.count ? heap[0].deadline : 0;
+        if (deadline == armedDeadline) {
+            return;
+        }
+        armedDeadline = deadline;
+        if (!deadline) {
+            if (wakeTimer) {
+                dispatch_source_set_timer(wakeTimer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+            }
+            return;
+        }
+        if (!wakeTimer) {
+            wakeTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+            __weak __typeof(self) weakSelf = self;
+            dispatch_source_set_event_handler(wakeTimer, ^{
+                [weakSelf fireDueActions];
+            });
+            dispatch_resume(wakeTimer);
+        }
+        // wall time: the deadlines are dates, the timer must count while the device sleeps
+        NSTimeInterval delay = MAX(0, deadline - currentTime());
+        dispatch_source_set_timer(wakeTimer, dispatch_walltime(NULL, (int64_t)(delay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, kSBCampaignSchedulerLeeway);
+    }
+}
+
+#pragma mark - File
+
+- (void)restoreFromData:(NSData *)data {
+    if (!data) {
+        return;
+    }
+    id root;
+    @try {
+        root = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    } @catch (NSException *exception) {
+        root = nil;
+    }
+    if (![root isKindOfClass:[NSDictionary class]] ||
+        [root[@"version"] integerValue] != kSBCampaignSchedulerVersion ||
+        ![root[@"campaigns"] isKindOfClass:[NSArray class]]) {
+        SBLog(@"💀 Discarding unreadable campaign schedule");
+        return;
+    }
+    for (SBScheduledCampaign *entry in root[@"campaigns"]) {
+        if (![entry isKindOfClass:[SBScheduledCampaign class]] || pending[entry.campaign.eid]) {
+            continue;
+        }
+        entry.heapIndex = heap.count;
+        [heap addObject:entry];
+        pending[entry.campaign.eid] = entry;
+        nextSequence = MAX(nextSequence, entry.sequence + 1);
+    }
+    // written in heap order, but don't trust the file with it
+    for (NSUInteger i = heap.count / 2; i > 0; i--) {
+        [self siftDown:i - 1];
+    }
+    SBLog(@"Restored %lu scheduled campaigns", (unsigned long)heap.count);
+}
+
+// on queue
+- (void)write {
+    NSArray *snapshot;
+    @synchronized (self) {
+        snapshot = [heap copy];
+    }
+    //
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:@{ @"version"   : @(kSBCampaignSchedulerVersion),
+                                                                  @"campaigns" : snapshot }];
+    NSError *error;
+    if (![data writeToFile:self.path options:NSDataWritingAtomic error:&error]) {
+        SBLog(@"💀 Can't write campaign schedule: %@", error);
+    }
+}
+
+@end
@@ -0,0 +1,116 @@
+//
+//  SBEventBus.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import <tolo/Tolo.h>
+
+@class SBEventBusInstrumentation;
+
+typedef NS_ENUM(NSUInteger, SBEventBusDispatchMode) {
+    /**
+     *  Handlers are resolved to their IMPs at subscribe time and kept per event `Class`.
+     *  A publish looks up an immutable snapshot of the handlers and calls them directly.
+     */
+    SBEventBusDispatchModeTable = 0,
+    /**
+     *  Tolo's own bookkeeping: lookup by class name and `performSelector:withObject:`
+     */
+    SBEventBusDispatchModeTolo,
+};
+
+typedef NS_ENUM(NSUInteger, SBEventBusDeliveryMode) {
+    /**
+     *  Handlers run inside `publish:`, as in Tolo.
+     *  With `forceMainThread`, a publish from another thread waits until the main thread has run them.
+     */
+    SBEventBusDeliverySynchronous = 0,
+    /**
+     *  `publish:` never waits, the handlers run on the queue their subscriber was registered with.
+     *
+     *  Ordering:
+     *  - the bus orders concurrent publishes, each subscriber handles the events in that order
+     *  - for one event, the subscribers on the same queue run in subscription order,
+     *    before any of them handles the next event
+     *  - there is no order between different queues
+     *  - main queue deliveries are batched, one main queue block drains everything pending
+     *  - a delivery that hasn't started when `unsubscribe:` runs is dropped
+     *
+     *  Only applies to `SBEventBusDispatchModeTable`.
+     */
+    SBEventBusDeliveryAsynchronous,
+};
+
+/**
+ *  The event bus behind `SB_PUBLISH`, `SB_REGISTER` and `SB_UNREGISTER`, also `+[SensorbergSDK eventBus]`.
+ *  `[Tolo sharedInstance]` and Tolo's own macros are left alone.
+ *
+ *  Subscribing, producers (`PUBLISHER`) and `forceMainThread` work as in Tolo, except that
+ *  `on<Type>:` and `get<Type>` methods only count when `<Type>` is an existing class.
+ *
+ *  The methods of a subscriber class are looked up once and cached (until a prefix changes).
+ *  `unsubscribe:` only touches the event types that object registered for, handlers of
+ *  deallocated subscribers are pruned when their event type is next published.
+ */
+@interface SBEventBus : Tolo
+
++ (SBEventBus *)sharedInstance;
+
+/**
+ *  Defaults to `SBEventBusDispatchModeTable`.
+ *  Both modes keep their own subscriptions, set it before anything subscribes.
+ */
+@property (nonatomic) SBEventBusDispatchMode dispatchMode;
+
+/**
+ *  Defaults to `SBEventBusDeliverySynchronous`
+ */
+@property (nonatomic) SBEventBusDeliveryMode deliveryMode;
+
+/**
+ *  Publish counts and handler timings are recorded while set, nil (the default) turns it off.
+ *  Only applies to `SBEventBusDispatchModeTable`.
+ */
+@property (strong) SBEventBusInstrumentation *instrumentation;
+
+/**
+ *  Serial queue for the SDK's own subscribers that don't need the main thread
+ */
++ (dispatch_queue_t)internalQueue;
+
+/**
+ *  Like `subscribe:`, with asynchronous delivery the handlers of `object` run on `queue`.
+ *
+ *  @param queue a serial queue, nil for the main queue
+ */
+- (void)subscribe:(NSObject *)object queue:(dispatch_queue_t)queue;
+
+/**
+ *  Number of live handlers for the event class (table mode)
+ */
+- (NSUInteger)handlerCountForEventClass:(Class)eventClass;
+
+@end
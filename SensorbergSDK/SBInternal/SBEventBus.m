@@ -0,0 +1,688 @@
+//
+//  SBEventBus.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBEventBus.h"
+
+#import "SBEventBusInstrumentation.h"
+
+#import <mach/mach_time.h>
+#import <objc/runtime.h>
+#import <pthread.h>
+
+typedef void (*SBEventBusHandlerIMP)(id, SEL, id);
+typedef id (*SBEventBusProducerIMP)(id, SEL);
+
+@class SBEventBusQueue;
+
+/**
+ *  A subscriber method, resolved once
+ */
+@interface SBEventBusHandler : NSObject
+{
+@public
+    __weak id target;
+    SEL selector;
+    IMP imp;
+    // where asynchronous deliveries go
+    SBEventBusQueue *queue;
+    // set by unsubscribe:, deliveries still queued are dropped
+    volatile BOOL removed;
+    // where the instrumentation with `histogramTag` records this handler, guarded by the lock of the bus
+    SBLatencyHistogram *histogram;
+    NSUInteger histogramTag;
+}
+@end
+
+@implementation SBEventBusHandler
+@end
+
+/**
+ *  Deliveries pending on one dispatch queue, drained in order by one block at a time.
+ *  Guarded by the lock of the bus.
+ */
+@interface SBEventBusQueue : NSObject
+{
+@public
+    dispatch_queue_t queue;
+    NSMutableArray <SBEventBusHandler *> *handlers;
+    NSMutableArray *events;
+    BOOL scheduled;
+}
+@end
+
+@implementation SBEventBusQueue
+@end
+
+/**
+ *  A `<prefix><Type>` method of a subscriber class
+ */
+@interface SBEventBusMethod : NSObject
+{
+@public
+    Class eventClass;
+    SEL selector;
+    IMP imp;
+}
+@end
+
+@implementation SBEventBusMethod
+@end
+
+/**
+ *  What subscribing an instance of a class registers, found by reflection once per class.
+ *  Also the reverse index entry of a subscriber, it tells `unsubscribe:` which lists to touch.
+ */
+@interface SBEventBusClassTable : NSObject
+{
+@public
+    Class cls;
+    NSArray <SBEventBusMethod *> *observers;
+    NSArray <SBEventBusMethod *> *producers;
+}
+@end
+
+@implementation SBEventBusClassTable
+@end
+
+/**
+ *  The `<prefix><Type>` methods of the class, picked the way Tolo does:
+ *  own methods only, with one argument if `hasArgument`, none otherwise.
+ */
+static NSArray <SBEventBusMethod *> *SBEventBusMethodsOfClass(Class cls, NSString *prefix, BOOL hasArgument)
+{
+    NSMutableArray <SBEventBusMethod *> *result = [NSMutableArray new];
+    const char *cPrefix = prefix.UTF8String;
+    size_t prefixLength = strlen(cPrefix);
+    // self and _cmd come first
+    unsigned int argumentCount = hasArgument ? 3 : 2;
+    //
+    unsigned int count = 0;
+    Method *methods = class_copyMethodList(cls, &count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (method_getNumberOfArguments(methods[i]) != argumentCount)
+        {
+            continue;
+        }
+        SEL selector = method_getName(methods[i]);
+        const char *name = sel_getName(selector);
+        size_t nameLength = strlen(name);
+        if (nameLength <= prefixLength + (hasArgument ? 1 : 0) || strncmp(name, cPrefix, prefixLength) != 0)
+        {
+            continue;
+        }
+        NSString *typeName = [[NSString alloc] initWithBytes:name + prefixLength
+                                                      length:nameLength - prefixLength - (hasArgument ? 1 : 0)
+                                                    encoding:NSUTF8StringEncoding];
+        Class eventClass = NSClassFromString(typeName);
+        if (eventClass)
+        {
+            SBEventBusMethod *method = [SBEventBusMethod new];
+            method->eventClass = eventClass;
+            method->selector = selector;
+            method->imp = method_getImplementation(methods[i]);
+            [result addObject:method];
+        }
+    }
+    free(methods);
+    return [result copy];
+}
+
+static inline uint64_t SBEventBusNanoseconds(uint64_t machTime)
+{
+    static mach_timebase_info_data_t timebase;
+    if (!timebase.denom)
+    {
+        mach_timebase_info(&timebase);
+    }
+    return machTime * timebase.numer / timebase.denom;
+}
+
+@implementation SBEventBus
+{
+    SBEventBusInstrumentation *_instrumentation;
+    // mirrors `instrumentation != nil`, the only check a publish makes when it's off
+    volatile BOOL instrumented;
+    pthread_mutex_t lock;
+    // Class -> NSArray <SBEventBusHandler *>
+    // the arrays are replaced, never mutated, so a publish iterates them without copying
+    CFMutableDictionaryRef handlers;
+    // Class -> SBEventBusHandler of the PUBLISHER for that event type
+    CFMutableDictionaryRef producers;
+    // dispatch queue -> its pending deliveries
+    NSMapTable <dispatch_queue_t, SBEventBusQueue *> *queues;
+    // Class -> SBEventBusClassTable, dropped when a prefix changes
+    CFMutableDictionaryRef classTables;
+    // subscriber (weak) -> SBEventBusClassTable it registered with
+    NSMapTable <id, SBEventBusClassTable *> *registrations;
+}
+
++ (SBEventBus *)sharedInstance
+{
+    static dispatch_once_t once;
+    static SBEventBus *shared = nil;
+    dispatch_once(&once, ^{
+        shared = [[SBEventBus alloc] init];
+    });
+    return shared;
+}
+
++ (dispatch_queue_t)internalQueue
+{
+    static dispatch_once_t once;
+    static dispatch_queue_t queue;
+    dispatch_once(&once, ^{
+        queue = dispatch_queue_create("com.sensorberg.sdk.eventbus.internal", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        pthread_mutex_init(&lock, NULL);
+        // classes are never deallocated, the pointer is the key
+        handlers = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        producers = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        queues = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                       valueOptions:NSPointerFunctionsStrongMemory];
+        classTables = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        registrations = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                              valueOptions:NSPointerFunctionsStrongMemory];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    CFRelease(handlers);
+    CFRelease(producers);
+    CFRelease(classTables);
+    pthread_mutex_destroy(&lock);
+}
+
+- (void)setInstrumentation:(SBEventBusInstrumentation *)instrumentation
+{
+    @synchronized(self)
+    {
+        _instrumentation = instrumentation;
+        instrumented = instrumentation != nil;
+    }
+}
+
+- (SBEventBusInstrumentation *)instrumentation
+{
+    @synchronized(self)
+    {
+        return _instrumentation;
+    }
+}
+
+#pragma mark - Subscriptions
+
+- (void)subscribe:(NSObject *)object
+{
+    [self subscribe:object queue:nil];
+}
+
+- (void)subscribe:(NSObject *)object queue:(dispatch_queue_t)queue
+{
+    if (self.dispatchMode == SBEventBusDispatchModeTolo)
+    {
+        [super subscribe:object];
+        return;
+    }
+    if (!object)
+    {
+        return;
+    }
+    // prevent multiple subscriptions
+    [self unsubscribe:object];
+    //
+    SBEventBusClassTable *table = [self classTableForClass:[object class]];
+    if (!table->observers.count && !table->producers.count)
+    {
+        return;
+    }
+    // the cached IMPs are only good for instances of exactly that class, not for KVO subclasses
+    BOOL cachedIMPs = object_getClass(object) == table->cls;
+    //
+    pthread_mutex_lock(&lock);
+    SBEventBusQueue *pending = [self pendingQueueFor:queue ?: dispatch_get_main_queue()];
+    [registrations setObject:table forKey:object];
+    pthread_mutex_unlock(&lock);
+    //
+    NSMutableArray <SBEventBusHandler *> *newProducers = [NSMutableArray arrayWithCapacity:table->producers.count];
+    for (SBEventBusMethod *method in table->producers)
+    {
+        SBEventBusHandler *producer = [self handlerWithTarget:object method:method cachedIMP:cachedIMPs queue:pending];
+        pthread_mutex_lock(&lock);
+        CFDictionarySetValue(producers, (__bridge const void *)method->eventClass, (__bridge const void *)producer);
+        pthread_mutex_unlock(&lock);
+        [newProducers addObject:producer];
+    }
+    // publish to existing subscribers
+    for (SBEventBusHandler *producer in newProducers)
+    {
+        [self publish:((SBEventBusProducerIMP)producer->imp)(object, producer->selector)];
+    }
+    //
+    for (SBEventBusMethod *method in table->observers)
+    {
+        SBEventBusHandler *handler = [self handlerWithTarget:object method:method cachedIMP:cachedIMPs queue:pending];
+        const void *key = (__bridge const void *)method->eventClass;
+        pthread_mutex_lock(&lock);
+        NSArray *current = (__bridge NSArray *)CFDictionaryGetValue(handlers, key);
+        NSArray *updated = current ? [current arrayByAddingObject:handler] : @[handler];
+        CFDictionarySetValue(handlers, key, (__bridge const void *)updated);
+        SBEventBusHandler *producer = (__bridge SBEventBusHandler *)CFDictionaryGetValue(producers, key);
+        pthread_mutex_unlock(&lock);
+        // hand the current value to the new subscriber
+        id producerTarget = producer ? producer->target : nil;
+        if (producerTarget)
+        {
+            id value = ((SBEventBusProducerIMP)producer->imp)(producerTarget, producer->selector);
+            [self deliverEvent:value toHandlers:@[handler]];
+        }
+    }
+}
+
+- (SBEventBusClassTable *)classTableForClass:(Class)cls
+{
+    pthread_mutex_lock(&lock);
+    SBEventBusClassTable *table = (__bridge SBEventBusClassTable *)CFDictionaryGetValue(classTables, (__bridge const void *)cls);
+    pthread_mutex_unlock(&lock);
+    if (table)
+    {
+        return table;
+    }
+    // reflection runs outside the lock, should two threads race here they build the same table
+    table = [SBEventBusClassTable new];
+    table->cls = cls;
+    table->observers = SBEventBusMethodsOfClass(cls, self.observerPrefix, YES);
+    table->producers = SBEventBusMethodsOfClass(cls, self.publisherPrefix, NO);
+    //
+    pthread_mutex_lock(&lock);
+    CFDictionarySetValue(classTables, (__bridge const void *)cls, (__bridge const void *)table);
+    pthread_mutex_unlock(&lock);
+    return table;
+}
+
+- (void)setObserverPrefix:(NSString *)observerPrefix
+{
+    [super setObserverPrefix:observerPrefix];
+    [self removeClassTables];
+}
+
+- (void)setPublisherPrefix:(NSString *)publisherPrefix
+{
+    [super setPublisherPrefix:publisherPrefix];
+    [self removeClassTables];
+}
+
+- (void)removeClassTables
+{
+    // Tolo's init sets the prefixes before ours has run
+    if (!classTables)
+    {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    CFDictionaryRemoveAllValues(classTables);
+    pthread_mutex_unlock(&lock);
+}
+
+- (SBEventBusHandler *)handlerWithTarget:(id)target method:(SBEventBusMethod *)method cachedIMP:(BOOL)cachedIMP queue:(SBEventBusQueue *)queue
+{
+    SBEventBusHandler *handler = [SBEventBusHandler new];
+    handler->target = target;
+    handler->selector = method->selector;
+    // methodForSelector: follows the isa, so KVO subclasses are respected
+    handler->imp = cachedIMP ? method->imp : [target methodForSelector:method->selector];
+    handler->queue = queue;
+    return handler;
+}
+
+// called with the lock held
+- (SBEventBusQueue *)pendingQueueFor:(dispatch_queue_t)queue
+{
+    SBEventBusQueue *pending = [queues objectForKey:queue];
+    if (!pending)
+    {
+        pending = [SBEventBusQueue new];
+        pending->queue = queue;
+        pending->handlers = [NSMutableArray new];
+        pending->events = [NSMutableArray new];
+        [queues setObject:pending forKey:queue];
+    }
+    return pending;
+}
+
+- (void)unsubscribe:(NSObject *)object
+{
+    if (self.dispatchMode == SBEventBusDispatchModeTolo)
+    {
+        [super unsubscribe:object];
+        return;
+    }
+    if (!object)
+    {
+        return;
+    }
+    // only the lists the object registered with, dead handlers elsewhere are pruned when they are next published to
+    pthread_mutex_lock(&lock);
+    SBEventBusClassTable *table = [registrations objectForKey:object];
+    if (table)
+    {
+        [registrations removeObjectForKey:object];
+        for (SBEventBusMethod *method in table->observers)
+        {
+            const void *key = (__bridge const void *)method->eventClass;
+            [self removeHandlersOfTarget:object forKey:key list:(__bridge NSArray *)CFDictionaryGetValue(handlers, key)];
+        }
+        for (SBEventBusMethod *method in table->producers)
+        {
+            const void *key = (__bridge const void *)method->eventClass;
+            SBEventBusHandler *producer = (__bridge SBEventBusHandler *)CFDictionaryGetValue(producers, key);
+            id target = producer ? producer->target : nil;
+            if (producer && (!target || target == object))
+            {
+                CFDictionaryRemoveValue(producers, key);
+            }
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+// drops the handlers of `object` and the dead ones from the list, called with the lock held
+- (void)removeHandlersOfTarget:(id)object forKey:(const void *)key list:(NSArray <SBEventBusHandler *> *)list
+{
+    NSMutableArray *kept = nil;
+    NSUInteger index = 0;
+    for (SBEventBusHandler *handler in list)
+    {
+        id target = handler->target;
+        BOOL remove = !target || target == object;
+        if (remove)
+        {
+            handler->removed = YES;
+        }
+        if (remove && !kept)
+        {
+            kept = [NSMutableArray arrayWithCapacity:list.count];
+            [kept addObjectsFromArray:[list subarrayWithRange:NSMakeRange(0, index)]];
+        }
+        else if (!remove && kept)
+        {
+            [kept addObject:handler];
+        }
+        index++;
+    }
+    if (!kept)
+    {
+        return;
+    }
+    if (kept.count)
+    {
+        CFDictionarySetValue(handlers, key, (__bridge const void *)[kept copy]);
+    }
+    else
+    {
+        CFDictionaryRemoveValue(handlers, key);
+    }
+}
+
+- (NSUInteger)handlerCountForEventClass:(Class)eventClass
+{
+    pthread_mutex_lock(&lock);
+    NSArray *list = (__bridge NSArray *)CFDictionaryGetValue(handlers, (__bridge const void *)eventClass);
+    pthread_mutex_unlock(&lock);
+    //
+    NSUInteger count = 0;
+    for (SBEventBusHandler *handler in list)
+    {
+        if (handler->target)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+#pragma mark - Publishing
+
+- (void)publish:(id<NSObject>)event
+{
+    if (self.dispatchMode == SBEventBusDispatchModeTolo)
+    {
+        [super publish:event];
+        return;
+    }
+    BOOL asynchronous = self.deliveryMode == SBEventBusDeliveryAsynchronous;
+    if (!asynchronous && self.forceMainThread && ![NSThread isMainThread])
+    {
+        [self performSelectorOnMainThread:@selector(publish:) withObject:event waitUntilDone:YES];
+        return;
+    }
+    if (!event)
+    {
+        return;
+    }
+    //
+    Class eventClass = [event class];
+    if (__builtin_expect(instrumented, NO))
+    {
+        [self publishInstrumented:event ofClass:eventClass asynchronous:asynchronous];
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    NSArray *snapshot = (__bridge NSArray *)CFDictionaryGetValue(handlers, (__bridge const void *)eventClass);
+    if (asynchronous)
+    {
+        // enqueued under the lock, so every queue sees the publishes in the same order
+        if (![self enqueueEvent:event toHandlers:snapshot])
+        {
+            [self removeHandlersOfTarget:nil forKey:(__bridge const void *)eventClass list:snapshot];
+        }
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    pthread_mutex_unlock(&lock);
+    //
+    BOOL prune = NO;
+    for (SBEventBusHandler *handler in snapshot)
+    {
+        id target = handler->target;
+        if (target)
+        {
+            ((SBEventBusHandlerIMP)handler->imp)(target, handler->selector, event);
+        }
+        else
+        {
+            prune = YES;
+        }
+    }
+    //
+    if (prune)
+    {
+        [self pruneHandlersForClass:eventClass];
+    }
+}
+
+- (void)pruneHandlersForClass:(Class)eventClass
+{
+    pthread_mutex_lock(&lock);
+    NSArray *current = (__bridge NSArray *)CFDictionaryGetValue(handlers, (__bridge const void *)eventClass);
+    [self removeHandlersOfTarget:nil forKey:(__bridge const void *)eventClass list:current];
+    pthread_mutex_unlock(&lock);
+}
+
+- (void)deliverEvent:(id)event toHandlers:(NSArray <SBEventBusHandler *> *)list
+{
+    if (!event)
+    {
+        return;
+    }
+    if (self.deliveryMode == SBEventBusDeliveryAsynchronous)
+    {
+        pthread_mutex_lock(&lock);
+        [self enqueueEvent:event toHandlers:list];
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    for (SBEventBusHandler *handler in list)
+    {
+        id target = handler->target;
+        if (target)
+        {
+            ((SBEventBusHandlerIMP)handler->imp)(target, handler->selector, event);
+        }
+    }
+}
+
+#pragma mark - Asynchronous delivery
+
+// called with the lock held, NO if some of the handlers are dead
+- (BOOL)enqueueEvent:(id)event toHandlers:(NSArray <SBEventBusHandler *> *)list
+{
+    BOOL alive = YES;
+    for (SBEventBusHandler *handler in list)
+    {
+        if (!handler->target)
+        {
+            alive = NO;
+            continue;
+        }
+        SBEventBusQueue *pending = handler->queue;
+        [pending->handlers addObject:handler];
+        [pending->events addObject:event];
+        if (!pending->scheduled)
+        {
+            pending->scheduled = YES;
+            // the drain takes the lock, so it can't start before we're done here
+            dispatch_async(pending->queue, ^{
+                [self drain:pending];
+            });
+        }
+    }
+    return alive;
+}
+
+- (void)drain:(SBEventBusQueue *)pending
+{
+    pthread_mutex_lock(&lock);
+    NSArray <SBEventBusHandler *> *batchHandlers = pending->handlers;
+    NSArray *batchEvents = pending->events;
+    pending->handlers = [NSMutableArray new];
+    pending->events = [NSMutableArray new];
+    pending->scheduled = NO;
+    pthread_mutex_unlock(&lock);
+    //
+    SBEventBusInstrumentation *instrumentation = instrumented ? self.instrumentation : nil;
+    NSUInteger count = batchHandlers.count;
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        SBEventBusHandler *handler = batchHandlers[i];
+        id target = handler->target;
+        if (target && !handler->removed)
+        {
+            if (instrumentation)
+            {
+                [self callHandler:handler target:target event:batchEvents[i] recordingIn:instrumentation];
+            }
+            else
+            {
+                ((SBEventBusHandlerIMP)handler->imp)(target, handler->selector, batchEvents[i]);
+            }
+        }
+    }
+}
+
+#pragma mark - Instrumentation
+
+// publish: with the publish counted and the synchronous handlers timed
+- (void)publishInstrumented:(id)event ofClass:(Class)eventClass asynchronous:(BOOL)asynchronous
+{
+    SBEventBusInstrumentation *instrumentation = self.instrumentation;
+    [instrumentation recordPublishOfClass:eventClass];
+    //
+    pthread_mutex_lock(&lock);
+    NSArray *snapshot = (__bridge NSArray *)CFDictionaryGetValue(handlers, (__bridge const void *)eventClass);
+    if (asynchronous)
+    {
+        // the drain times the handlers
+        if (![self enqueueEvent:event toHandlers:snapshot])
+        {
+            [self removeHandlersOfTarget:nil forKey:(__bridge const void *)eventClass list:snapshot];
+        }
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    pthread_mutex_unlock(&lock);
+    //
+    BOOL prune = NO;
+    for (SBEventBusHandler *handler in snapshot)
+    {
+        id target = handler->target;
+        if (target && instrumentation)
+        {
+            [self callHandler:handler target:target event:event recordingIn:instrumentation];
+        }
+        else if (target)
+        {
+            ((SBEventBusHandlerIMP)handler->imp)(target, handler->selector, event);
+        }
+        else
+        {
+            prune = YES;
+        }
+    }
+    if (prune)
+    {
+        [self pruneHandlersForClass:eventClass];
+    }
+}
+
+- (void)callHandler:(SBEventBusHandler *)handler target:(id)target event:(id)event recordingIn:(SBEventBusInstrumentation *)instrumentation
+{
+    uint64_t start = mach_absolute_time();
+    ((SBEventBusHandlerIMP)handler->imp)(target, handler->selector, event);
+    uint64_t elapsed = SBEventBusNanoseconds(mach_absolute_time() - start);
+    //
+    pthread_mutex_lock(&lock);
+    if (handler->histogramTag != instrumentation.tag)
+    {
+        handler->histogram = [instrumentation histogramForSubscriberClass:[target class] selector:handler->selector eventClass:[event class]];
+        handler->histogramTag = instrumentation.tag;
+    }
+    SBLatencyHistogram *histogram = handler->histogram;
+    pthread_mutex_unlock(&lock);
+    [instrumentation recordValue:elapsed inHistogram:histogram];
+}
+
+@end
@@ -0,0 +1,96 @@
+//
+//  SBEventBusInstrumentation.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+// keys of `-[SBEventBusInstrumentation snapshot]`, times are NSTimeInterval
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsPublishes;
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsHandlers;
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsCount;
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsTotal;
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsMax;
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsP50;
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsP90;
+FOUNDATION_EXPORT NSString * const kSBEventStatisticsP99;
+
+/**
+ *  Log-linear latency histogram in the HDR style: exact below 8ns, then 8 buckets per power of two,
+ *  so a value is reported at most 12.5% too high. Covers the whole uint64_t range in nanoseconds.
+ *  Not thread safe, `SBEventBusInstrumentation` serializes the recording.
+ */
+@interface SBLatencyHistogram : NSObject
+
+- (void)recordValue:(uint64_t)nanoseconds;
+
+- (void)reset;
+
+@property (nonatomic, readonly) uint64_t count;
+@property (nonatomic, readonly) uint64_t total;
+@property (nonatomic, readonly) uint64_t max;
+
+/**
+ *  Highest value of the bucket that holds the percentile (0...100), never more than `max`
+ */
+- (uint64_t)valueAtPercentile:(double)percentile;
+
+@end
+
+/**
+ *  Publish counters per event class and handler timings per subscriber class and selector.
+ *  Recording is thread safe.
+ */
+@interface SBEventBusInstrumentation : NSObject
+
+/**
+ *  Distinguishes instrumentations, for handlers caching their histogram
+ */
+@property (nonatomic, readonly) NSUInteger tag;
+
+- (void)recordPublishOfClass:(Class)eventClass;
+
+/**
+ *  The histogram of a handler, the same for every subscriber of that class
+ */
+- (SBLatencyHistogram *)histogramForSubscriberClass:(Class)subscriberClass selector:(SEL)selector eventClass:(Class)eventClass;
+
+- (void)recordValue:(uint64_t)nanoseconds inHistogram:(SBLatencyHistogram *)histogram;
+
+/**
+ *  Event class name -> { publishes, handlers: { "<subscriber class> <selector>" -> { count, total, max, p50, p90, p99 } } }
+ */
+- (NSDictionary <NSString *, NSDictionary *> *)snapshot;
+
+/**
+ *  Logs the statistics with SBLog every interval while the instrumentation is alive, 0 (the default) to stop
+ */
+@property (nonatomic) NSTimeInterval logInterval;
+
+/**
+ *  Zeroes all counters, the handlers stay known
+ */
+- (void)reset;
+
+@end
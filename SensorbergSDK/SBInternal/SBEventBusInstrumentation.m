@@ -0,0 +1,272 @@
+//
+//  SBEventBusInstrumentation.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBEventBusInstrumentation.h"
+
+#import <pthread.h>
+
+#import "SensorbergSDK.h"
+
+NSString * const kSBEventStatisticsPublishes = @"publishes";
+NSString * const kSBEventStatisticsHandlers = @"handlers";
+NSString * const kSBEventStatisticsCount = @"count";
+NSString * const kSBEventStatisticsTotal = @"total";
+NSString * const kSBEventStatisticsMax = @"max";
+NSString * const kSBEventStatisticsP50 = @"p50";
+NSString * const kSBEventStatisticsP90 = @"p90";
+NSString * const kSBEventStatisticsP99 = @"p99";
+
+// values below 8 get a bucket each, then 8 sub-buckets for each power of two from 2^3 to 2^63
+static NSUInteger const kSBHistogramSubBucketBits = 3;
+static NSUInteger const kSBHistogramSubBuckets = 1 << kSBHistogramSubBucketBits;
+static NSUInteger const kSBHistogramBuckets = (64 - kSBHistogramSubBucketBits + 1) * kSBHistogramSubBuckets;
+
+static inline NSUInteger SBHistogramBucket(uint64_t value)
+{
+    if (value < kSBHistogramSubBuckets) {
+        return (NSUInteger)value;
+    }
+    NSUInteger msb = 63 - __builtin_clzll(value);
+    NSUInteger shift = msb - kSBHistogramSubBucketBits;
+    return (msb - kSBHistogramSubBucketBits + 1) * kSBHistogramSubBuckets + (NSUInteger)((value >> shift) & (kSBHistogramSubBuckets - 1));
+}
+
+static inline uint64_t SBHistogramBucketHighestValue(NSUInteger bucket)
+{
+    if (bucket < kSBHistogramSubBuckets) {
+        return bucket;
+    }
+    NSUInteger shift = bucket / kSBHistogramSubBuckets - 1;
+    uint64_t lowest = (uint64_t)(kSBHistogramSubBuckets + bucket % kSBHistogramSubBuckets) << shift;
+    return lowest + ((uint64_t)1 << shift) - 1;
+}
+
+@implementation SBLatencyHistogram
+{
+    uint64_t counts[kSBHistogramBuckets];
+}
+
+- (void)recordValue:(uint64_t)nanoseconds {
+    counts[SBHistogramBucket(nanoseconds)]++;
+    _count++;
+    _total += nanoseconds;
+    _max = MAX(_max, nanoseconds);
+}
+
+- (void)reset {
+    memset(counts, 0, sizeof(counts));
+    _count = 0;
+    _total = 0;
+    _max = 0;
+}
+
+- (uint64_t)valueAtPercentile:(double)percentile {
+    if (!_count) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)ceil(MIN(MAX(percentile, 0), 100) / 100. * _count);
+    rank = MAX(rank, 1);
+    uint64_t seen = 0;
+    for (NSUInteger bucket = 0; bucket < kSBHistogramBuckets; bucket++) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            return MIN(SBHistogramBucketHighestValue(bucket), _max);
+        }
+    }
+    return _max;
+}
+
+@end
+
+#pragma mark -
+
+/**
+ *  Statistics of one event class
+ */
+@interface SBEventBusEventStatistics : NSObject
+@property (nonatomic) uint64_t publishes;
+// "<subscriber class> <selector>" -> histogram
+@property (nonatomic, strong) NSMutableDictionary <NSString *, SBLatencyHistogram *> *handlers;
+@end
+
+@implementation SBEventBusEventStatistics
+@end
+
+@interface SBEventBusInstrumentation () {
+    pthread_mutex_t lock;
+    // Class -> SBEventBusEventStatistics
+    NSMapTable *events;
+    dispatch_source_t logTimer;
+}
+
+@end
+
+@implementation SBEventBusInstrumentation
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        static NSUInteger tags = 0;
+        // only ever compared, 0 means none
+        _tag = __sync_add_and_fetch(&tags, 1);
+        pthread_mutex_init(&lock, NULL);
+        events = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality
+                                       valueOptions:NSPointerFunctionsStrongMemory];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (logTimer) {
+        dispatch_source_cancel(logTimer);
+    }
+    pthread_mutex_destroy(&lock);
+}
+
+// called with the lock held
+- (SBEventBusEventStatistics *)statisticsForEventClass:(Class)eventClass
+{
+    SBEventBusEventStatistics *statistics = [events objectForKey:eventClass];
+    if (!statistics) {
+        statistics = [SBEventBusEventStatistics new];
+        statistics.handlers = [NSMutableDictionary new];
+        [events setObject:statistics forKey:eventClass];
+    }
+    return statistics;
+}
+
+- (void)recordPublishOfClass:(Class)eventClass
+{
+    pthread_mutex_lock(&lock);
+    [self statisticsForEventClass:eventClass].publishes++;
+    pthread_mutex_unlock(&lock);
+}
+
+- (SBLatencyHistogram *)histogramForSubscriberClass:(Class)subscriberClass selector:(SEL)selector eventClass:(Class)eventClass
+{
+    NSString *name = [NSString stringWithFormat:@"%@ %@", NSStringFromClass(subscriberClass), NSStringFromSelector(selector)];
+    pthread_mutex_lock(&lock);
+    SBEventBusEventStatistics *statistics = [self statisticsForEventClass:eventClass];
+    SBLatencyHistogram *histogram = statistics.handlers[name];
+    if (!histogram) {
+        histogram = [SBLatencyHistogram new];
+        statistics.handlers[name] = histogram;
+    }
+    pthread_mutex_unlock(&lock);
+    return histogram;
+}
+
+- (void)recordValue:(uint64_t)nanoseconds inHistogram:(SBLatencyHistogram *)histogram
+{
+    pthread_mutex_lock(&lock);
+    [histogram recordValue:nanoseconds];
+    pthread_mutex_unlock(&lock);
+}
+
+- (void)reset
+{
+    pthread_mutex_lock(&lock);
+    // handlers keep pointers to their histograms, clear them in place
+    for (SBEventBusEventStatistics *statistics in events.objectEnumerator) {
+        statistics.publishes = 0;
+        [statistics.handlers.allValues makeObjectsPerformSelector:@selector(reset)];
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+#pragma mark - Reporting
+
+- (NSDictionary<NSString *,NSDictionary *> *)snapshot
+{
+    NSMutableDictionary *snapshot = [NSMutableDictionary new];
+    pthread_mutex_lock(&lock);
+    for (id eventClass in events.keyEnumerator) {
+        SBEventBusEventStatistics *statistics = [events objectForKey:eventClass];
+        NSMutableDictionary *handlers = [NSMutableDictionary new];
+        [statistics.handlers enumerateKeysAndObjectsUsingBlock:^(NSString *name, SBLatencyHistogram *histogram, BOOL *stop) {
+            handlers[name] = @{kSBEventStatisticsCount: @(histogram.count),
+                               kSBEventStatisticsTotal: @(histogram.total / 1e9),
+                               kSBEventStatisticsMax: @(histogram.max / 1e9),
+                               kSBEventStatisticsP50: @([histogram valueAtPercentile:50] / 1e9),
+                               kSBEventStatisticsP90: @([histogram valueAtPercentile:90] / 1e9),
+                               kSBEventStatisticsP99: @([histogram valueAtPercentile:99] / 1e9)};
+        }];
+        snapshot[NSStringFromClass(eventClass)] = @{kSBEventStatisticsPublishes: @(statistics.publishes),
+                                                    kSBEventStatisticsHandlers: handlers};
+    }
+    pthread_mutex_unlock(&lock);
+    return snapshot;
+}
+
+- (NSString *)logDescription
+{
+    NSDictionary *snapshot = [self snapshot];
+    NSMutableString *description = [NSMutableString new];
+    for (NSString *eventName in [snapshot.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        NSDictionary *statistics = snapshot[eventName];
+        [description appendFormat:@"\n%@: %@ publishes", eventName, statistics[kSBEventStatisticsPublishes]];
+        // most expensive handlers first
+        NSDictionary *handlers = statistics[kSBEventStatisticsHandlers];
+        NSArray *names = [handlers keysSortedByValueUsingComparator:^NSComparisonResult(NSDictionary *a, NSDictionary *b) {
+            return [b[kSBEventStatisticsTotal] compare:a[kSBEventStatisticsTotal]];
+        }];
+        for (NSString *name in names) {
+            NSDictionary *handler = handlers[name];
+            [description appendFormat:@"\n    %@ ×%@ total %.2fms max %.2fms p50 %.3fms p90 %.3fms p99 %.3fms", name,
+             handler[kSBEventStatisticsCount],
+             [handler[kSBEventStatisticsTotal] doubleValue] * 1000.,
+             [handler[kSBEventStatisticsMax] doubleValue] * 1000.,
+             [handler[kSBEventStatisticsP50] doubleValue] * 1000.,
+             [handler[kSBEventStatisticsP90] doubleValue] * 1000.,
+             [handler[kSBEventStatisticsP99] doubleValue] * 1000.];
+        }
+    }
+    return description;
+}
+
+- (void)setLogInterval:(NSTimeInterval)logInterval
+{
+    _logInterval = logInterval;
+    if (logTimer) {
+        dispatch_source_cancel(logTimer);
+        logTimer = nil;
+    }
+    if (logInterval <= 0) {
+        return;
+    }
+    logTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+    uint64_t interval = (uint64_t)(logInterval * NSEC_PER_SEC);
+    dispatch_source_set_timer(logTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval, interval / 10);
+    __weak SBEventBusInstrumentation *weakSelf = self;
+    dispatch_source_set_event_handler(logTimer, ^{
+        SBLog(@"📊 Event bus%@", [weakSelf logDescription]);
+    });
+    dispatch_resume(logTimer);
+}
+
+@end
@@ -0,0 +1,62 @@
+//
+//  SBEventCoalescer.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Tick of the batched ranging and Bluetooth events, 1 second
+ */
+extern NSTimeInterval const kSBDefaultBatchInterval;
+
+/**
+ *  Collects values per key and hands them over in one batch per tick.
+ *  A key set again before the tick replaces its value but keeps its place (first seen first).
+ *  The tick starts with the first value after a flush, nothing is scheduled while idle.
+ *
+ *  Main thread only; the handler is called on the main queue.
+ */
+@interface SBEventCoalescer : NSObject
+
+- (instancetype)initWithInterval:(NSTimeInterval)interval handler:(void (^)(NSArray *values))handler;
+
+/**
+ *  Time between the first value of a batch and its delivery, a change applies from the next batch
+ */
+@property (nonatomic) NSTimeInterval interval;
+
+/**
+ *  Number of keys waiting for the next tick
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+- (void)coalesceValue:(id)value forKey:(id <NSCopying>)key;
+
+/**
+ *  Delivers the pending values now, does nothing if there are none
+ */
+- (void)flush;
+
+@end
@@ -0,0 +1,94 @@
+//
+//  SBEventCoalescer.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBEventCoalescer.h"
+
+NSTimeInterval const kSBDefaultBatchInterval = 1.0f;
+
+@interface SBEventCoalescer () {
+    void (^handler)(NSArray *values);
+    //
+    NSMutableArray *keys;
+    NSMutableDictionary *values;
+    // bumped by every flush, so a tick scheduled before a manual flush doesn't cut the next batch short
+    NSUInteger generation;
+    BOOL scheduled;
+}
+
+@end
+
+@implementation SBEventCoalescer
+
+- (instancetype)initWithInterval:(NSTimeInterval)interval handler:(void (^)(NSArray *))block
+{
+    self = [super init];
+    if (self) {
+        _interval = interval;
+        handler = [block copy];
+        keys = [NSMutableArray new];
+        values = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    return keys.count;
+}
+
+- (void)coalesceValue:(id)value forKey:(id <NSCopying>)key {
+    if (!values[key]) {
+        [keys addObject:key];
+    }
+    values[key] = value;
+    //
+    if (scheduled) {
+        return;
+    }
+    scheduled = YES;
+    NSUInteger tick = generation;
+    __weak SBEventCoalescer *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(self.interval, 0) * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        SBEventCoalescer *strongSelf = weakSelf;
+        if (strongSelf && strongSelf->generation == tick) {
+            [strongSelf flush];
+        }
+    });
+}
+
+- (void)flush {
+    generation++;
+    scheduled = NO;
+    if (!keys.count) {
+        return;
+    }
+    NSArray *batch = [values objectsForKeys:keys notFoundMarker:[NSNull null]];
+    [keys removeAllObjects];
+    [values removeAllObjects];
+    //
+    handler(batch);
+}
+
+@end
@@ -0,0 +1,74 @@
+//
+//  SBFireHistory.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class UICKeyChainStore;
+
+/**
+ *  When each campaign last fired, for the sendOnlyOnce and suppressionTime checks.
+ *
+ *  Lookups are a dictionary access, the file in Application Support is read once when the history is created
+ *  and rewritten on a private serial queue, in batches: all the fires of a short interval make one write.
+ */
+@interface SBFireHistory : NSObject
+
+/**
+ *  The history at the default path
+ */
++ (instancetype)sharedHistory;
+
++ (NSString *)defaultPath;
+
+- (instancetype)initWithPath:(NSString *)path;
+
+@property (nonatomic, readonly, copy) NSString *path;
+
+/**
+ *  Milliseconds since 1970 of the last fire of the campaign, 0 if it never fired
+ */
+- (int64_t)lastFireOfCampaign:(NSString *)eid;
+
+- (BOOL)campaignHasFired:(NSString *)eid;
+
+- (void)recordFireOfCampaign:(NSString *)eid date:(NSDate *)date;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+- (void)removeAllFires;
+
+/**
+ *  Imports the fire dates the previous versions kept in the keychain (eid -> date string),
+ *  once: only when there was no history file yet.
+ */
+- (void)migrateFromKeychain:(UICKeyChainStore *)keychain;
+
+/**
+ *  Blocks until the pending changes are written.
+ */
+- (void)synchronize;
+
+@end
@@ -0,0 +1,241 @@
+//
+//  SBFireHistory.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBFireHistory.h"
+
+#import <libkern/OSByteOrder.h>
+
+#import <UICKeyChainStore/UICKeyChainStore.h>
+
+#import "SensorbergSDK.h"
+
+#import "SBUtility.h"
+#import "SBISO8601.h"
+
+#pragma mark - Constants
+
+// changes within this interval are written together
+static NSTimeInterval const kSBFireHistoryWriteDelay = 1.0f;
+
+/**
+ *  File layout (little endian):
+ *  uint32 magic | uint32 version | uint32 count | count * (uint16 eid length | eid | int64 ms since 1970) | uint32 crc32 of all before
+ */
+static uint32_t const kSBFireHistoryMagic = 0x48464253; // SBFH
+static uint32_t const kSBFireHistoryVersion = 1;
+static size_t const kSBFireHistoryHeaderLength = 12;
+
+#pragma mark - SBFireHistory
+
+@interface SBFireHistory () {
+    dispatch_queue_t queue;
+    // guarded by @synchronized(self)
+    NSMutableDictionary <NSString *, NSNumber *> *fires;
+    SBDeferredWrite *deferredWrite;
+    // no file when loaded: the keychain may still hold the history
+    BOOL needsMigration;
+}
+
+@end
+
+@implementation SBFireHistory
+
++ (instancetype)sharedHistory {
+    static SBFireHistory *sharedHistory;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedHistory = [[SBFireHistory alloc] initWithPath:[SBFireHistory defaultPath]];
+    });
+    return sharedHistory;
+}
+
++ (NSString *)defaultPath {
+    NSString *directory = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) firstObject];
+    return [[directory stringByAppendingPathComponent:kSBIdentifier] stringByAppendingPathComponent:@"fires.history"];
+}
+
+- (instancetype)init {
+    return [self initWithPath:[SBFireHistory defaultPath]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (self) {
+        _path = [path copy];
+        queue = dispatch_queue_create("com.sensorberg.sdk.fire.history", DISPATCH_QUEUE_SERIAL);
+        __weak __typeof(self) weakSelf = self;
+        deferredWrite = [[SBDeferredWrite alloc] initWithQueue:queue delay:kSBFireHistoryWriteDelay write:^{
+            [weakSelf write];
+        }];
+        //
+        [[NSFileManager defaultManager] createDirectoryAtPath:[_path stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+        NSData *data = [NSData dataWithContentsOfFile:_path];
+        needsMigration = (data == nil);
+        fires = [self firesFromData:data];
+    }
+    return self;
+}
+
+#pragma mark - Public
+
+- (int64_t)lastFireOfCampaign:(NSString *)eid {
+    if (!eid) {
+        return 0;
+    }
+    @synchronized (self) {
+        return fires[eid].longLongValue;
+    }
+}
+
+- (BOOL)campaignHasFired:(NSString *)eid {
+    return [self lastFireOfCampaign:eid] != 0;
+}
+
+- (void)recordFireOfCampaign:(NSString *)eid date:(NSDate *)date {
+    if (!eid.length || !date) {
+        return;
+    }
+    int64_t milliseconds = (int64_t)llround(date.timeIntervalSince1970 * 1000);
+    @synchronized (self) {
+        fires[eid] = @(milliseconds);
+    }
+    [deferredWrite schedule];
+}
+
+- (NSUInteger)count {
+    @synchronized (self) {
+        return fires.count;
+    }
+}
+
+- (void)removeAllFires {
+    @synchronized (self) {
+        [fires removeAllObjects];
+    }
+    [deferredWrite schedule];
+}
+
+- (void)migrateFromKeychain:(UICKeyChainStore *)keychain {
+    @synchronized (self) {
+        if (!needsMigration || !keychain) {
+            return;
+        }
+        needsMigration = NO;
+    }
+    NSUInteger migrated = 0;
+    for (NSString *key in keychain.allKeys) {
+        if ([key isEqualToString:kPostLayout] || [key isEqualToString:kIDFA]) {
+            continue;
+        }
+        // the fires are the keys holding a date
+        NSString *value = [keychain stringForKey:key];
+        NSDate *date = value ? SBISO8601DateFromString(value) : nil;
+        if (date) {
+            @synchronized (self) {
+                if (!fires[key]) {
+                    fires[key] = @((int64_t)llround(date.timeIntervalSince1970 * 1000));
+                    migrated++;
+                }
+            }
+        }
+    }
+    SBLog(@"Migrated %lu campaign fires from the keychain", (unsigned long)migrated);
+    // written even if empty, the file marks the migration as done
+    [deferredWrite schedule];
+}
+
+- (void)synchronize {
+    [deferredWrite flush];
+}
+
+#pragma mark - File
+
+- (NSMutableDictionary *)firesFromData:(NSData *)data {
+    NSMutableDictionary *loaded = [NSMutableDictionary new];
+    const uint8_t *bytes = data.bytes;
+    NSUInteger length = data.length;
+    if (length < kSBFireHistoryHeaderLength + sizeof(uint32_t)) {
+        return loaded;
+    }
+    if (OSReadLittleInt32(bytes, 0) != kSBFireHistoryMagic ||
+        OSReadLittleInt32(bytes, 4) != kSBFireHistoryVersion ||
+        OSReadLittleInt32(bytes, length - sizeof(uint32_t)) != SBCRC32(bytes, length - sizeof(uint32_t))) {
+        SBLog(@"💀 Discarding unreadable campaign fire history");
+        return loaded;
+    }
+    uint32_t count = OSReadLittleInt32(bytes, 8);
+    NSUInteger end = length - sizeof(uint32_t);
+    NSUInteger offset = kSBFireHistoryHeaderLength;
+    for (uint32_t i = 0; i < count && offset + sizeof(uint16_t) <= end; i++) {
+        uint16_t eidLength = OSReadLittleInt16(bytes, offset);
+        offset += sizeof(uint16_t);
+        if (offset + eidLength + sizeof(int64_t) > end) {
+            break;
+        }
+        NSString *eid = [[NSString alloc] initWithBytes:bytes + offset length:eidLength encoding:NSUTF8StringEncoding];
+        offset += eidLength;
+        int64_t milliseconds = (int64_t)OSReadLittleInt64(bytes, offset);
+        offset += sizeof(int64_t);
+        if (eid) {
+            loaded[eid] = @(milliseconds);
+        }
+    }
+    return loaded;
+}
+
+// on queue
+- (void)write {
+    NSDictionary *snapshot;
+    @synchronized (self) {
+        snapshot = [fires copy];
+    }
+    //
+    NSMutableData *data = [NSMutableData dataWithLength:kSBFireHistoryHeaderLength];
+    uint8_t *header = data.mutableBytes;
+    OSWriteLittleInt32(header, 0, kSBFireHistoryMagic);
+    OSWriteLittleInt32(header, 4, kSBFireHistoryVersion);
+    OSWriteLittleInt32(header, 8, (uint32_t)snapshot.count);
+    [snapshot enumerateKeysAndObjectsUsingBlock:^(NSString *eid, NSNumber *milliseconds, BOOL *stop) {
+        NSData *eidData = [eid dataUsingEncoding:NSUTF8StringEncoding];
+        uint16_t eidLength = OSSwapHostToLittleInt16((uint16_t)MIN(eidData.length, UINT16_MAX));
+        int64_t value = (int64_t)OSSwapHostToLittleInt64(milliseconds.longLongValue);
+        [data appendBytes:&eidLength length:sizeof(eidLength)];
+        [data appendBytes:eidData.bytes length:OSSwapLittleToHostInt16(eidLength)];
+        [data appendBytes:&value length:sizeof(value)];
+    }];
+    uint32_t checksum = OSSwapHostToLittleInt32(SBCRC32(data.bytes, data.length));
+    [data appendBytes:&checksum length:sizeof(checksum)];
+    //
+    NSError *error;
+    if (![data writeToFile:self.path options:NSDataWritingAtomic error:&error]) {
+        SBLog(@"💀 Can't write campaign fire history: %@", error);
+    }
+}
+
+@end
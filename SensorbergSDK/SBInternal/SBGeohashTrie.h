@@ -0,0 +1,77 @@
+//
+//  SBGeohashTrie.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Longest geohash the trie and `SBGeohashEncode` handle
+ */
+FOUNDATION_EXPORT NSUInteger const kSBGeohashMaxLength;
+
+/**
+ *  Writes the geohash of the coordinate, `length` characters (at most kSBGeohashMaxLength) and a terminating 0
+ */
+FOUNDATION_EXPORT void SBGeohashEncode(double latitude, double longitude, NSUInteger length, char *hash);
+
+/**
+ *  Geohash regions in a prefix trie: the regions containing a point are the prefixes of its geohash,
+ *  found in one walk down the trie, O(geohash length) whatever the number of regions.
+ *
+ *  Nodes are numbered, the edges live in one open addressing table keyed by (node, character).
+ *  Not thread safe.
+ */
+@interface SBGeohashTrie : NSObject
+
+/**
+ *  @return NO if the geohash is empty, too long or has characters outside the geohash alphabet
+ */
+- (BOOL)addGeohash:(NSString *)geohash;
+
+- (void)removeGeohash:(NSString *)geohash;
+
+- (BOOL)containsGeohash:(NSString *)geohash;
+
+- (void)removeAllGeohashes;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+@property (nonatomic, readonly) NSArray <NSString *> *geohashes;
+
+/**
+ *  The regions containing the point with that geohash, shortest (largest region) first
+ */
+- (NSArray <NSString *> *)regionsContainingGeohash:(NSString *)geohash;
+
+/**
+ *  Allocation free variant for hot loops: the ids of the containing regions, shortest first
+ *
+ *  @return the number of ids written, at most `maximum`
+ */
+- (NSUInteger)regionIdsContainingHash:(const char *)hash length:(NSUInteger)length ids:(uint32_t *)ids maximum:(NSUInteger)maximum;
+
+- (NSString *)geohashOfRegionId:(uint32_t)regionId;
+
+@end
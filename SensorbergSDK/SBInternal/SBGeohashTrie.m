@@ -0,0 +1,307 @@
+//
+//  SBGeohashTrie.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBGeohashTrie.h"
+
+NSUInteger const kSBGeohashMaxLength = 12;
+
+static const char kSBGeohashAlphabet[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+
+static uint32_t const kSBNoRegion = UINT32_MAX;
+
+void SBGeohashEncode(double latitude, double longitude, NSUInteger length, char *hash)
+{
+    double latitudeRange[2] = {-90, 90};
+    double longitudeRange[2] = {-180, 180};
+    length = MIN(length, kSBGeohashMaxLength);
+    BOOL even = YES;
+    for (NSUInteger i = 0; i < length; i++) {
+        int symbol = 0;
+        for (int bit = 0; bit < 5; bit++) {
+            double *range = even ? longitudeRange : latitudeRange;
+            double value = even ? longitude : latitude;
+            double middle = (range[0] + range[1]) / 2;
+            symbol <<= 1;
+            if (value >= middle) {
+                symbol |= 1;
+                range[0] = middle;
+            } else {
+                range[1] = middle;
+            }
+            even = !even;
+        }
+        hash[i] = kSBGeohashAlphabet[symbol];
+    }
+    hash[length] = 0;
+}
+
+// character -> 0...31, -1 outside the alphabet; upper case is accepted
+static int8_t SBGeohashSymbols[256];
+
+@interface SBGeohashTrie () {
+    // per node: the region ending there, kSBNoRegion if none
+    uint32_t *terminals;
+    NSUInteger nodeCount;
+    NSUInteger nodeCapacity;
+    // edges: key (parent << 5 | symbol) + 1, 0 for an empty entry
+    uint64_t *edgeKeys;
+    uint32_t *edgeChildren;
+    NSUInteger edgeCount;
+    NSUInteger edgeCapacity;
+    // region id -> geohash, NSNull once removed
+    NSMutableArray *regions;
+    NSMutableIndexSet *freeRegionIds;
+}
+
+@end
+
+@implementation SBGeohashTrie
+
++ (void)initialize
+{
+    if (self == [SBGeohashTrie class]) {
+        memset(SBGeohashSymbols, -1, sizeof(SBGeohashSymbols));
+        for (int i = 0; i < 32; i++) {
+            SBGeohashSymbols[(uint8_t)kSBGeohashAlphabet[i]] = i;
+            SBGeohashSymbols[(uint8_t)toupper(kSBGeohashAlphabet[i])] = i;
+        }
+    }
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        regions = [NSMutableArray new];
+        freeRegionIds = [NSMutableIndexSet new];
+        [self reset];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(terminals);
+    free(edgeKeys);
+    free(edgeChildren);
+}
+
+- (void)reset {
+    free(terminals);
+    free(edgeKeys);
+    free(edgeChildren);
+    nodeCapacity = 64;
+    terminals = malloc(nodeCapacity * sizeof(uint32_t));
+    edgeCapacity = 128;
+    edgeKeys = calloc(edgeCapacity, sizeof(uint64_t));
+    edgeChildren = malloc(edgeCapacity * sizeof(uint32_t));
+    edgeCount = 0;
+    // the root
+    nodeCount = 1;
+    terminals[0] = kSBNoRegion;
+}
+
+- (NSUInteger)count {
+    return regions.count - freeRegionIds.count;
+}
+
+- (NSArray<NSString *> *)geohashes {
+    NSMutableArray *geohashes = [NSMutableArray arrayWithCapacity:self.count];
+    for (id region in regions) {
+        if (region != [NSNull null]) {
+            [geohashes addObject:region];
+        }
+    }
+    return geohashes;
+}
+
+#pragma mark - Edges
+
+static inline NSUInteger SBEdgeSlot(uint64_t key, NSUInteger capacity) {
+    return (NSUInteger)((key * 0x9E3779B97F4A7C15ULL) >> 17) & (capacity - 1);
+}
+
+static inline uint32_t SBTrieChild(const uint64_t *keys, const uint32_t *children, NSUInteger capacity, uint32_t node, int symbol) {
+    uint64_t key = (((uint64_t)node << 5) | (uint64_t)symbol) + 1;
+    for (NSUInteger slot = SBEdgeSlot(key, capacity); ; slot = (slot + 1) & (capacity - 1)) {
+        if (keys[slot] == key) {
+            return children[slot];
+        }
+        if (keys[slot] == 0) {
+            return 0;
+        }
+    }
+}
+
+- (void)insertEdgeKey:(uint64_t)key child:(uint32_t)child {
+    NSUInteger slot = SBEdgeSlot(key, edgeCapacity);
+    while (edgeKeys[slot]) {
+        slot = (slot + 1) & (edgeCapacity - 1);
+    }
+    edgeKeys[slot] = key;
+    edgeChildren[slot] = child;
+}
+
+- (uint32_t)childOf:(uint32_t)node symbol:(int)symbol create:(BOOL)create {
+    uint32_t child = SBTrieChild(edgeKeys, edgeChildren, edgeCapacity, node, symbol);
+    if (child || !create) {
+        return child;
+    }
+    // at most half full
+    if ((edgeCount + 1) * 2 > edgeCapacity) {
+        uint64_t *oldKeys = edgeKeys;
+        uint32_t *oldChildren = edgeChildren;
+        NSUInteger oldCapacity = edgeCapacity;
+        edgeCapacity *= 2;
+        edgeKeys = calloc(edgeCapacity, sizeof(uint64_t));
+        edgeChildren = malloc(edgeCapacity * sizeof(uint32_t));
+        for (NSUInteger slot = 0; slot < oldCapacity; slot++) {
+            if (oldKeys[slot]) {
+                [self insertEdgeKey:oldKeys[slot] child:oldChildren[slot]];
+            }
+        }
+        free(oldKeys);
+        free(oldChildren);
+    }
+    if (nodeCount == nodeCapacity) {
+        nodeCapacity *= 2;
+        terminals = reallocf(terminals, nodeCapacity * sizeof(uint32_t));
+    }
+    child = (uint32_t)nodeCount++;
+    terminals[child] = kSBNoRegion;
+    [self insertEdgeKey:(((uint64_t)node << 5) | (uint64_t)symbol) + 1 child:child];
+    edgeCount++;
+    return child;
+}
+
+#pragma mark - Regions
+
+// the node of the geohash, 0 if it isn't in the trie (or invalid); creates the path if asked to
+- (uint32_t)nodeOfGeohash:(NSString *)geohash create:(BOOL)create {
+    const char *hash = geohash.UTF8String;
+    size_t length = hash ? strlen(hash) : 0;
+    if (length == 0 || length > kSBGeohashMaxLength) {
+        return 0;
+    }
+    uint32_t node = 0;
+    for (size_t i = 0; i < length; i++) {
+        int symbol = SBGeohashSymbols[(uint8_t)hash[i]];
+        if (symbol < 0) {
+            return 0;
+        }
+        node = [self childOf:node symbol:symbol create:create];
+        if (!node) {
+            return 0;
+        }
+    }
+    return node;
+}
+
+- (BOOL)addGeohash:(NSString *)geohash {
+    uint32_t node = [self nodeOfGeohash:geohash create:YES];
+    if (!node) {
+        return NO;
+    }
+    if (terminals[node] != kSBNoRegion) {
+        return YES;
+    }
+    NSString *region = geohash.lowercaseString;
+    uint32_t regionId;
+    if (freeRegionIds.count) {
+        regionId = (uint32_t)freeRegionIds.firstIndex;
+        [freeRegionIds removeIndex:regionId];
+        regions[regionId] = region;
+    } else {
+        regionId = (uint32_t)regions.count;
+        [regions addObject:region];
+    }
+    terminals[node] = regionId;
+    return YES;
+}
+
+- (void)removeGeohash:(NSString *)geohash {
+    // the path stays, it is reused when the region comes back
+    uint32_t node = [self nodeOfGeohash:geohash create:NO];
+    if (node && terminals[node] != kSBNoRegion) {
+        regions[terminals[node]] = [NSNull null];
+        [freeRegionIds addIndex:terminals[node]];
+        terminals[node] = kSBNoRegion;
+    }
+}
+
+- (BOOL)containsGeohash:(NSString *)geohash {
+    uint32_t node = [self nodeOfGeohash:geohash create:NO];
+    return node && terminals[node] != kSBNoRegion;
+}
+
+- (void)removeAllGeohashes {
+    [regions removeAllObjects];
+    [freeRegionIds removeAllIndexes];
+    [self reset];
+}
+
+- (NSString *)geohashOfRegionId:(uint32_t)regionId {
+    id region = regionId < regions.count ? regions[regionId] : nil;
+    return region == [NSNull null] ? nil : region;
+}
+
+#pragma mark - Lookup
+
+- (NSUInteger)regionIdsContainingHash:(const char *)hash length:(NSUInteger)length ids:(uint32_t *)ids maximum:(NSUInteger)maximum {
+    NSUInteger found = 0;
+    uint32_t node = 0;
+    length = MIN(length, kSBGeohashMaxLength);
+    for (NSUInteger i = 0; i < length && found < maximum; i++) {
+        int symbol = SBGeohashSymbols[(uint8_t)hash[i]];
+        if (symbol < 0) {
+            break;
+        }
+        node = SBTrieChild(edgeKeys, edgeChildren, edgeCapacity, node, symbol);
+        if (!node) {
+            break;
+        }
+        if (terminals[node] != kSBNoRegion) {
+            ids[found++] = terminals[node];
+        }
+    }
+    return found;
+}
+
+- (NSArray<NSString *> *)regionsContainingGeohash:(NSString *)geohash {
+    const char *hash = geohash.UTF8String;
+    if (!hash) {
+        return @[];
+    }
+    uint32_t ids[kSBGeohashMaxLength];
+    NSUInteger found = [self regionIdsContainingHash:hash length:strlen(hash) ids:ids maximum:kSBGeohashMaxLength];
+    NSMutableArray *containing = [NSMutableArray arrayWithCapacity:found];
+    for (NSUInteger i = 0; i < found; i++) {
+        [containing addObject:regions[ids[i]]];
+    }
+    return containing;
+}
+
+@end
@@ -0,0 +1,70 @@
+//
+//  SBISO8601.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  The API date format (APIDateFormat, yyyy-MM-dd'T'HH:mm:ss.SSSZZZZZ) without NSDateFormatter:
+ *  fixed format, no locale, calendar or time zone lookups, no allocations in the C functions; safe to call from any thread.
+ */
+
+/**
+ *  Length of a formatted timestamp: yyyy-MM-ddTHH:mm:ss.SSSZ
+ */
+#define kSBISO8601Length 24
+
+/**
+ *  Milliseconds since 1970, rounded down
+ */
+int64_t SBISO8601MillisFromDate(NSDate *date);
+
+/**
+ *  Formats a UTC timestamp into exactly kSBISO8601Length characters (not NUL terminated).
+ *
+ *  @return NO if the year is outside 0...9999
+ */
+BOOL SBISO8601FormatMillis(int64_t millis, char buffer[kSBISO8601Length]);
+
+/**
+ *  The API date string of `date` in UTC, e.g. 2016-05-01T10:00:00.000Z
+ */
+NSString *SBISO8601StringFromDate(NSDate *date);
+
+/**
+ *  Parses a timestamp of `length` characters (no NUL needed): yyyy-MM-ddTHH:mm:ss, an optional fraction of a second
+ *  of any number of digits (truncated to milliseconds) and a zone, either Z or an offset written +HH:mm, +HHmm or +HH.
+ *  Every field is range checked, February 29th only in leap years.
+ *
+ *  @param millis receives the milliseconds since 1970
+ *
+ *  @return NO if the characters aren't such a timestamp
+ */
+BOOL SBISO8601ParseMillis(const char *buffer, size_t length, int64_t *millis);
+
+/**
+ *  The date of an API date string, nil if it isn't one
+ */
+NSDate *SBISO8601DateFromString(NSString *string);
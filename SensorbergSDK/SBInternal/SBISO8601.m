@@ -0,0 +1,236 @@
+//
+//  SBISO8601.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBISO8601.h"
+
+#import "SBUtility.h"
+
+static int64_t const kSBMillisPerDay = 86400000;
+
+// days since 1970-01-01 to proleptic Gregorian y/m/d (H. Hinnant, "chrono-Compatible Low-Level Date Algorithms")
+static void SBCivilFromDays(int64_t days, int64_t *year, unsigned *month, unsigned *day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = (unsigned)(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned shiftedMonth = (5 * dayOfYear + 2) / 153;
+    *day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    *month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    *year = (int64_t)yearOfEra + era * 400 + (*month <= 2);
+}
+
+// proleptic Gregorian y/m/d to days since 1970-01-01, the inverse of SBCivilFromDays
+static int64_t SBDaysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = (unsigned)(year - era * 400);
+    unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (int64_t)dayOfEra - 719468;
+}
+
+static inline unsigned SBDaysInMonth(unsigned year, unsigned month) {
+    static const unsigned char days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) {
+        return 29;
+    }
+    return days[month - 1];
+}
+
+// `count` digits at `buffer`, NO if one of them isn't
+static inline BOOL SBReadDigits(const char *buffer, int count, unsigned *value) {
+    unsigned result = 0;
+    for (int i = 0; i < count; i++) {
+        unsigned digit = (unsigned)(buffer[i] - '0');
+        if (digit > 9) {
+            return NO;
+        }
+        result = result * 10 + digit;
+    }
+    *value = result;
+    return YES;
+}
+
+static inline void SBWriteDigits(char *buffer, unsigned value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        buffer[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+int64_t SBISO8601MillisFromDate(NSDate *date) {
+    // round to microseconds first so 0.123 stored as 0.12299999 still formats as .123
+    return (int64_t)floor(round(date.timeIntervalSince1970 * 1000000.0) / 1000.0);
+}
+
+BOOL SBISO8601FormatMillis(int64_t millis, char buffer[kSBISO8601Length]) {
+    int64_t days = millis / kSBMillisPerDay;
+    int64_t remainder = millis % kSBMillisPerDay;
+    if (remainder < 0) {
+        remainder += kSBMillisPerDay;
+        days--;
+    }
+    //
+    int64_t year;
+    unsigned month, day;
+    SBCivilFromDays(days, &year, &month, &day);
+    if (year < 0 || year > 9999) {
+        return NO;
+    }
+    //
+    unsigned milliseconds = (unsigned)remainder;
+    SBWriteDigits(buffer, (unsigned)year, 4);
+    buffer[4] = '-';
+    SBWriteDigits(buffer + 5, month, 2);
+    buffer[7] = '-';
+    SBWriteDigits(buffer + 8, day, 2);
+    buffer[10] = 'T';
+    SBWriteDigits(buffer + 11, milliseconds / 3600000, 2);
+    buffer[13] = ':';
+    SBWriteDigits(buffer + 14, milliseconds / 60000 % 60, 2);
+    buffer[16] = ':';
+    SBWriteDigits(buffer + 17, milliseconds / 1000 % 60, 2);
+    buffer[19] = '.';
+    SBWriteDigits(buffer + 20, milliseconds % 1000, 3);
+    buffer[23] = 'Z';
+    return YES;
+}
+
+NSString *SBISO8601StringFromDate(NSDate *date) {
+    if (!date) {
+        return nil;
+    }
+    char buffer[kSBISO8601Length];
+    if (!SBISO8601FormatMillis(SBISO8601MillisFromDate(date), buffer)) {
+        return [dateFormatter stringFromDate:date];
+    }
+    return [[NSString alloc] initWithBytes:buffer length:kSBISO8601Length encoding:NSASCIIStringEncoding];
+}
+
+BOOL SBISO8601ParseMillis(const char *buffer, size_t length, int64_t *millis) {
+    // yyyy-MM-ddTHH:mm:ss and at least a Z
+    if (!buffer || length < 20) {
+        return NO;
+    }
+    unsigned year, month, day, hour, minute, second;
+    if (!SBReadDigits(buffer, 4, &year) || buffer[4] != '-' ||
+        !SBReadDigits(buffer + 5, 2, &month) || buffer[7] != '-' ||
+        !SBReadDigits(buffer + 8, 2, &day) || buffer[10] != 'T' ||
+        !SBReadDigits(buffer + 11, 2, &hour) || buffer[13] != ':' ||
+        !SBReadDigits(buffer + 14, 2, &minute) || buffer[16] != ':' ||
+        !SBReadDigits(buffer + 17, 2, &second)) {
+        return NO;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > SBDaysInMonth(year, month) ||
+        hour > 23 || minute > 59 || second > 59) {
+        return NO;
+    }
+    //
+    size_t offset = 19;
+    unsigned milliseconds = 0;
+    if (buffer[offset] == '.') {
+        offset++;
+        size_t digits = 0;
+        while (offset < length && (unsigned)(buffer[offset] - '0') <= 9) {
+            if (digits < 3) {
+                milliseconds = milliseconds * 10 + (unsigned)(buffer[offset] - '0');
+            }
+            digits++;
+            offset++;
+        }
+        if (!digits) {
+            return NO;
+        }
+        for (; digits < 3; digits++) {
+            milliseconds *= 10;
+        }
+    }
+    //
+    if (offset >= length) {
+        return NO;
+    }
+    int64_t zoneMinutes = 0;
+    char sign = buffer[offset++];
+    if (sign == 'Z') {
+        // UTC
+    } else if (sign == '+' || sign == '-') {
+        unsigned zoneHours, zoneMinute = 0;
+        if (offset + 2 > length || !SBReadDigits(buffer + offset, 2, &zoneHours)) {
+            return NO;
+        }
+        offset += 2;
+        if (offset < length && buffer[offset] == ':') {
+            offset++;
+            if (offset + 2 > length) {
+                return NO;
+            }
+        }
+        if (offset + 2 <= length) {
+            if (!SBReadDigits(buffer + offset, 2, &zoneMinute)) {
+                return NO;
+            }
+            offset += 2;
+        }
+        if (zoneHours > 23 || zoneMinute > 59) {
+            return NO;
+        }
+        zoneMinutes = (int64_t)(zoneHours * 60 + zoneMinute);
+        if (sign == '-') {
+            zoneMinutes = -zoneMinutes;
+        }
+    } else {
+        return NO;
+    }
+    if (offset != length) {
+        return NO;
+    }
+    //
+    int64_t days = SBDaysFromCivil(year, month, day);
+    int64_t secondOfDay = (int64_t)(hour * 3600 + minute * 60 + second) - zoneMinutes * 60;
+    *millis = (days * 86400 + secondOfDay) * 1000 + milliseconds;
+    return YES;
+}
+
+NSDate *SBISO8601DateFromString(NSString *string) {
+    if (![string isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    // the ASCII characters are usually stored as they are, no copy then
+    const char *characters = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingASCII);
+    char buffer[64];
+    if (!characters) {
+        if (![string getCString:buffer maxLength:sizeof(buffer) encoding:NSASCIIStringEncoding]) {
+            return nil;
+        }
+        characters = buffer;
+    }
+    int64_t millis;
+    if (!SBISO8601ParseMillis(characters, strlen(characters), &millis)) {
+        return nil;
+    }
+    return [NSDate dateWithTimeIntervalSince1970:millis / 1000.0];
+}
@@ -27,6 +27,10 @@
 
 #import "SBModel.h"
 
+@class SBCampaignIndex;
+@class SBTimeframeSchedule;
+@class SBCampaignScheduler;
+
 @interface SBInternalModels : SBModel
 @end
 
@@ -63,6 +67,11 @@
 @property (strong, nonatomic) NSString *location;
 @property (strong, nonatomic) NSString *pid;
 @property (strong, nonatomic) NSDate *dt;
+
+/**
+ *  The timeframes compiled for lookups, once when the action is parsed (and again when `timeframes` is replaced)
+ */
+- (SBTimeframeSchedule *)timeframeSchedule;
 @end
 
 #pragma mark - Post events
@@ -121,8 +130,31 @@
 @property (nonatomic) BOOL currentVersion;
 @property (strong, nonatomic) NSArray <SBMContent> *instantActions;
 
+/**
+ *  Beacon to action lookup, built once when the layout is parsed (and again when `actions` is replaced)
+ */
+- (SBCampaignIndex *)campaignIndex;
+
 - (void)checkCampaignsForBeacon:(SBMBeacon *)beacon trigger:(SBTriggerType)trigger;
 
+/**
+ *  When set, actions with a fireDate in the future are handed to the scheduler instead of being published right away
+ */
+- (SBCampaignScheduler *)campaignScheduler;
+- (void)setCampaignScheduler:(SBCampaignScheduler *)campaignScheduler;
+
+/**
+ *  Publishes the campaign action as SBEventPerformAction (SBEventInternalAction if silent),
+ *  and a forced SBEventReportHistory if `reportImmediately`
+ */
++ (void)publishCampaignAction:(SBMCampaignAction *)campaignAction reportImmediately:(BOOL)reportImmediately;
+
+/**
+ *  The first time after `date` at which an action of the layout enters or leaves its timeframes,
+ *  nil if none does: the timeframe checks give the same results until then.
+ */
+- (NSDate *)nextTimeframeTransitionAfter:(NSDate *)date;
+
 @end
 
 @interface SBMSettings : JSONModel
@@ -130,6 +162,8 @@
 @property (nonatomic, assign) NSTimeInterval monitoringDelay; // in Seconds.
 @property (nonatomic, assign) NSTimeInterval postSuppression; // in Seconds.
 @property (nonatomic, assign) NSTimeInterval rangingSuppression; // in seconds
+@property (nonatomic, assign) NSUInteger postChunkRecordCount; // max. records per analytics POST, 0 for no limit
+@property (nonatomic, assign) NSUInteger postChunkByteCount; // max. body size of an analytics POST in bytes, 0 for no limit
 @property (nonatomic, readonly, copy) NSDictionary *defaultBeaconRegions;
 @property (nonatomic, copy) NSDictionary *customBeaconRegions;
 @property (nonatomic, assign) BOOL enableBeaconScanning;
@@ -35,6 +35,16 @@
 
 #import "SBEvent.h"
 
+#import "SBCampaignIndex.h"
+
+#import "SBFireHistory.h"
+
+#import "SBTimeframeSchedule.h"
+#import "SBCampaignScheduler.h"
+#import "SBISO8601.h"
+#import "SBJSONReader.h"
+#import "SBJSONWriter.h"
+
 @implementation SBInternalModels
 @end
 
@@ -69,6 +79,8 @@
         _monitoringDelay = 30.0f; // 30 seconds
         _rangingSuppression = 3.5f; // 3.5 seconds
         _postSuppression = 60.0f; // 60 seconds
+        _postChunkRecordCount = 500;
+        _postChunkByteCount = 256 * 1024; // 256 KiB
         _enableBeaconScanning = YES;
         _defaultBeaconRegions = @{
                                   @"73676723-7400-0000-FFFF-0000FFFF0000":@"SB-0",
@@ -94,56 +106,84 @@
 
 - (id)copy
 {
-    return [[SBMSettings alloc] initWithDictionary:[self toDictionary] error:nil];
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer writeSettings:self];
+    SBJSONReader *reader = [[SBJSONReader alloc] initWithData:[writer data]];
+    return [reader readSettings];
 }
 
 @end
 
-@implementation SBMGetLayout
+@implementation SBMGetLayout {
+    // not a property, so JSONModel keeps it out of the JSON representation
+    SBCampaignIndex *_campaignIndex;
+    // nextTimeframeTransitionAfter: is the same for any time in [from, until)
+    int64_t _transitionCacheFrom;
+    int64_t _transitionCacheUntil;
+    __weak SBCampaignScheduler *_campaignScheduler;
+}
 
 + (BOOL)propertyIsOptional:(NSString *)propertyName {
     return YES;
 }
 
+- (BOOL)validate:(NSError *__autoreleasing *)error {
+    // the actions (and their beacons) are fully parsed at this point
+    _campaignIndex = [[SBCampaignIndex alloc] initWithActions:self.actions];
+    return [super validate:error];
+}
+
+- (void)setActions:(NSArray<SBMAction> *)actions {
+    _actions = actions;
+    _campaignIndex = nil;
+    @synchronized (self) {
+        _transitionCacheUntil = _transitionCacheFrom;
+    }
+}
+
+- (SBCampaignIndex *)campaignIndex {
+    if (!_campaignIndex) {
+        _campaignIndex = [[SBCampaignIndex alloc] initWithActions:self.actions];
+    }
+    return _campaignIndex;
+}
+
+- (SBCampaignScheduler *)campaignScheduler {
+    return _campaignScheduler;
+}
+
+- (void)setCampaignScheduler:(SBCampaignScheduler *)campaignScheduler {
+    _campaignScheduler = campaignScheduler;
+}
+
 - (void)checkCampaignsForBeacon:(SBMBeacon *)beacon trigger:(SBTriggerType)trigger {
     
     NSDate *now = [NSDate date];
+    int64_t time = SBTimeframeTimeFromDate(now);
     
-    for (SBMAction *action in self.actions) {
-        for (SBMBeacon *actionBeacon in action.beacons) {
-            if ([actionBeacon.fullUUID isEqualToString:beacon.fullUUID] == NO)
-            {
-                continue;
-            }
-            if (trigger!= action.trigger && action.trigger != kSBTriggerEnterExit)
-            {
-                SBLog(@"🔕 TRIGGER %lu-%lu",(unsigned long)trigger,(unsigned long)action.trigger);
-                continue;
-            }
-            
-            if (action.timeframes.count && [self campaignIsInTimeframes:action.timeframes] == NO) {
-                continue;
-            }
-            //
-            if (action.sendOnlyOnce && [self campaignHasFired:action.eid]) {
-                SBLog(@"🔕 Already fired");
-                continue;
-            }
-
-            if (!isNull(action.deliverAt) && [action.deliverAt earlierDate:now]==action.deliverAt) {
-                SBLog(@"🔕 Send at it's in the past");
-                continue;
-            }
-            
-            NSTimeInterval previousFire = [self secondsSinceLastFire:action.eid];
-            if (action.suppressionTime &&
-                (previousFire > 0 && previousFire < action.suppressionTime)) {
-                SBLog(@"🔕 Suppressed");
-                continue;
-            }
-            
-            [self fireAction:action forBeacon:beacon withTrigger:trigger];
+    for (SBMAction *action in [self.campaignIndex actionsForBeacon:beacon trigger:trigger]) {
+        if (action.timeframes.count && [action.timeframeSchedule containsTime:time] == NO) {
+            continue;
+        }
+        //
+        if (action.sendOnlyOnce && [self campaignHasFired:action.eid]) {
+            SBLog(@"🔕 Already fired");
+            continue;
+        }
+        
+        if (!isNull(action.deliverAt) && [action.deliverAt earlierDate:now]==action.deliverAt) {
+            SBLog(@"🔕 Send at it's in the past");
+            continue;
         }
+        
+        NSTimeInterval previousFire = [self secondsSinceLastFire:action.eid];
+        if (action.suppressionTime &&
+            (previousFire > 0 && previousFire < action.suppressionTime)) {
+            SBLog(@"🔕 Suppressed");
+            continue;
+        }
+        
+        [self fireAction:action forBeacon:beacon withTrigger:trigger];
     }
     //
 }
@@ -151,71 +191,81 @@
 #pragma mark - Helper methods
 
 - (BOOL)campaignHasFired:(NSString*)eid {
-    return !isNull([keychain stringForKey:eid]);
+    return [[SBFireHistory sharedHistory] campaignHasFired:eid];
 }
 
 - (NSTimeInterval)secondsSinceLastFire:(NSString*)eid {
     //
-    NSString *lastFireString = [keychain stringForKey:eid];
-    if (isNull(lastFireString)) {
+    int64_t lastFire = [[SBFireHistory sharedHistory] lastFireOfCampaign:eid];
+    if (!lastFire) {
         return -1;
     }
     //
-    NSDate *lastFireDate = [dateFormatter dateFromString:lastFireString];
-    return [[NSDate date] timeIntervalSinceDate:lastFireDate];
+    return [[NSDate date] timeIntervalSince1970] - lastFire / 1000.0;
 }
 
 - (BOOL)campaignIsInTimeframes:(NSArray <SBMTimeframe> *)timeframes {
-    
-    BOOL afterStart = NO;
-    BOOL beforeFinish = NO;
-    
-    NSDate *currentTime = [NSDate date];
-    
-    for (SBMTimeframe *time in timeframes) {
-        
-        afterStart = NO;
-        beforeFinish = NO;
-        
-        if (isNull(time.start) || (!isNull(time.start) && [currentTime earlierDate:time.start]==time.start)) {
-            SBLog(@"🔕 %@-%@",currentTime,time.start);
-            afterStart = YES;
-        }
-        //
-        if (isNull(time.end) || (!isNull(time.end) && [currentTime laterDate:time.end]==time.end)) {
-            SBLog(@"🔕 %@-%@",currentTime,time.end);
-            beforeFinish = YES;
+    SBTimeframeSchedule *schedule = [[SBTimeframeSchedule alloc] initWithTimeframes:timeframes];
+    return [schedule containsTime:SBTimeframeTimeFromDate([NSDate date])];
+}
+
+- (NSDate *)nextTimeframeTransitionAfter:(NSDate *)date {
+    int64_t time = SBTimeframeTimeFromDate(date);
+    @synchronized (self) {
+        if (time < _transitionCacheFrom || time >= _transitionCacheUntil) {
+            int64_t next = kSBTimeframeNever;
+            for (SBMAction *action in self.actions) {
+                if (action.timeframes.count) {
+                    next = MIN(next, [action.timeframeSchedule nextTransitionAfter:time]);
+                }
+            }
+            _transitionCacheFrom = time;
+            _transitionCacheUntil = next;
         }
-        //
-        if (afterStart && beforeFinish) {
-            return YES;
+        if (_transitionCacheUntil == kSBTimeframeNever) {
+            return nil;
         }
+        return [NSDate dateWithTimeIntervalSince1970:_transitionCacheUntil / 1000.0];
     }
-    return (afterStart && beforeFinish);
 }
-
 - (void)fireAction:(SBMAction *)action forBeacon:(SBMBeacon *)beacon withTrigger:(SBTriggerType)trigger
 {
     SBMCampaignAction *campaignAction = [self campainActionWithAction:action beacon:beacon trigger:trigger];
-    SBLog(@"🔔 Campaign \"%@\"",campaignAction.subject);
-    [keychain setString:[dateFormatter stringFromDate:[NSDate date]] forKey:action.eid];
     //
-    if (action.type!=kSBActionTypeSilent) {
-        PUBLISH((({
+    SBCampaignScheduler *scheduler = self.campaignScheduler;
+    if (scheduler && [campaignAction.fireDate timeIntervalSinceNow] > 0) {
+        // recorded as fired when it's delivered
+        if ([scheduler scheduleCampaignAction:campaignAction forAction:action]) {
+            SBLog(@"🕓 Campaign \"%@\" scheduled for %@",campaignAction.subject,campaignAction.fireDate);
+        } else {
+            SBLog(@"🔕 Already scheduled");
+        }
+        return;
+    }
+    //
+    SBLog(@"🔔 Campaign \"%@\"",campaignAction.subject);
+    [[SBFireHistory sharedHistory] recordFireOfCampaign:action.eid date:[NSDate date]];
+    [SBMGetLayout publishCampaignAction:campaignAction reportImmediately:action.reportImmediately];
+}
+
++ (void)publishCampaignAction:(SBMCampaignAction *)campaignAction reportImmediately:(BOOL)reportImmediately
+{
+    if (campaignAction.type!=kSBActionTypeSilent) {
+        SB_PUBLISH((({
             SBEventPerformAction *event = [SBEventPerformAction new];
             event.campaign = campaignAction;
             event;
         })));
     } else {
-        PUBLISH((({
+        SB_PUBLISH((({
             SBEventInternalAction *event = [SBEventInternalAction new];
             event.campaign = campaignAction;
             event;
         })));
     }
     //
-    if (action.reportImmediately) {
-        PUBLISH(({
+    if (reportImmediately) {
+        SB_PUBLISH(({
             SBEventReportHistory *reportEvent = [SBEventReportHistory new];
             reportEvent.forced = YES;
             reportEvent;
@@ -284,7 +334,9 @@ emptyImplementation(SBMMonitorEvent)
 
 emptyImplementation(SBMTimeframe)
 
-@implementation SBMAction
+@implementation SBMAction {
+    SBTimeframeSchedule *_timeframeSchedule;
+}
 
 - (BOOL)validate:(NSError *__autoreleasing *)error {
     NSMutableArray *newBeacons = [NSMutableArray new];
@@ -295,9 +347,22 @@ emptyImplementation(SBMTimeframe)
         }
     }
     self.beacons = [NSArray <SBMBeacon> arrayWithArray:newBeacons];
+    _timeframeSchedule = [[SBTimeframeSchedule alloc] initWithTimeframes:self.timeframes];
     return [super validate:error];
 }
 
+- (void)setTimeframes:(NSArray<SBMTimeframe> *)timeframes {
+    _timeframes = timeframes;
+    _timeframeSchedule = nil;
+}
+
+- (SBTimeframeSchedule *)timeframeSchedule {
+    if (!_timeframeSchedule) {
+        _timeframeSchedule = [[SBTimeframeSchedule alloc] initWithTimeframes:self.timeframes];
+    }
+    return _timeframeSchedule;
+}
+
 + (BOOL)propertyIsOptional:(NSString *)propertyName {
     return YES;
 }
@@ -326,11 +391,11 @@ emptyImplementation(SBMPostLayout)
 @implementation JSONValueTransformer (SBResolver)
 
 - (NSDate *)NSDateFromNSString:(NSString*)string {
-    return [dateFormatter dateFromString:string];
+    return SBISO8601DateFromString(string);
 }
 
 - (NSString*)JSONObjectFromNSDate:(NSDate *)date {
-    return [dateFormatter stringFromDate:date];
+    return SBISO8601StringFromDate(date);
 }
 
 @end
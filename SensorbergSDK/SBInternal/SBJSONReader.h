@@ -0,0 +1,145 @@
+//
+//  SBJSONReader.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import "SBInternalModels.h"
+
+typedef NS_ENUM(NSInteger, SBJSONType) {
+    SBJSONTypeNone = 0, // end of the data, or after an error
+    SBJSONTypeObject,
+    SBJSONTypeArray,
+    SBJSONTypeString,
+    SBJSONTypeNumber,
+    SBJSONTypeBool,
+    SBJSONTypeNull,
+};
+
+/**
+ *  An object key, pointing into the data (or into the reader for keys with escapes): valid until the next read
+ */
+typedef struct {
+    const uint8_t *bytes;
+    size_t length;
+} SBJSONKey;
+
+#define SBJSONKeyIs(key, literal) ((key).length == sizeof(literal) - 1 && memcmp((key).bytes, (literal), sizeof(literal) - 1) == 0)
+
+/**
+ *  Minimal pull JSON decoder reading UTF-8, the counterpart of SBJSONWriter.
+ *  The caller walks the tokens, values it doesn't ask for are skipped without building objects.
+ *  After a syntax error every read returns NO / nil and `error` tells where.
+ *  Not thread safe, use one reader per thread.
+ */
+@interface SBJSONReader : NSObject
+
+- (instancetype)initWithData:(NSData *)data;
+
+/**
+ *  The syntax error, in NSCocoaErrorDomain with the code NSJSONSerialization uses. nil while the JSON is fine.
+ */
+@property (nonatomic, readonly) NSError *error;
+
+/**
+ *  Type of the next value, without reading it
+ */
+- (SBJSONType)peekType;
+
+/**
+ *  Enters the next value if it is an object. NO (and the value skipped) if it isn't.
+ */
+- (BOOL)beginObject;
+
+/**
+ *  The key of the next member of the object entered last, its value is read next.
+ *  NO when the object ends (and it is left).
+ */
+- (BOOL)nextKey:(SBJSONKey *)key;
+
+/**
+ *  Enters the next value if it is an array. NO (and the value skipped) if it isn't.
+ */
+- (BOOL)beginArray;
+
+/**
+ *  YES if the array entered last has another element, it is read next.
+ *  NO when the array ends (and it is left).
+ */
+- (BOOL)nextElement;
+
+/**
+ *  A string, or a number as its `stringValue`. nil (and the value skipped) for other values.
+ */
+- (NSString *)readString;
+
+/**
+ *  A number, a numeric string (`doubleValue`) or a bool (1 or 0). NO (and the value skipped) for other values.
+ */
+- (BOOL)readDouble:(double *)value;
+
+/**
+ *  A bool, a number (not 0) or a string (`boolValue`). NO (and the value skipped) for other values.
+ */
+- (BOOL)readBool:(BOOL *)value;
+
+/**
+ *  An API date string or seconds since 1970. nil (and the value skipped) for other values.
+ */
+- (NSDate *)readDate;
+
+/**
+ *  The next value as a Foundation object, like NSJSONSerialization makes it
+ */
+- (id)readJSONObject;
+
+- (void)skipValue;
+
+/**
+ *  Checks that nothing but whitespace follows the value read
+ *
+ *  @return NO on a syntax error anywhere in the data
+ */
+- (BOOL)finish;
+
+@end
+
+/**
+ *  Direct decoders for the resolver models, building the same models as JSONModel's `initWithDictionary:`
+ *  without the NSDictionary intermediate, runtime property lookups or KVC.
+ *  Beacons are parsed into packed keys on the way, the timeframes compiled and the layout indexed.
+ *
+ *  Unlike JSONModel, a value of the wrong type (e.g. an action that isn't an object) is skipped instead of failing the model.
+ *  Each returns nil (and skips the value) if the next value isn't an object.
+ */
+@interface SBJSONReader (SBMGetLayout)
+
+- (SBMGetLayout *)readLayout;
+- (SBMAction *)readAction;
+- (SBMContent *)readContent;
+- (SBMTimeframe *)readTimeframe;
+- (SBMSettings *)readSettings;
+
+@end
@@ -0,0 +1,925 @@
+//
+//  SBJSONReader.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBJSONReader.h"
+
+#import "SBBeaconKey.h"
+#import "SBISO8601.h"
+
+#import "SBUtility.h"
+
+// deeper documents are an error, as for NSJSONSerialization
+#define kSBJSONReaderMaxDepth 512
+
+// keys with escapes are unescaped into the reader, longer ones match no field
+#define kSBJSONReaderKeyCapacity 128
+
+#pragma mark - Cursor
+
+typedef struct {
+    const uint8_t *bytes;
+    size_t length;
+    size_t offset;
+    BOOL failed;
+    size_t errorOffset;
+    // per nesting level: YES until the container's first member is read
+    size_t depth;
+    BOOL first[kSBJSONReaderMaxDepth];
+    uint8_t key[kSBJSONReaderKeyCapacity];
+} SBJSONCursor;
+
+static inline void SBJSONFail(SBJSONCursor *cursor) {
+    if (!cursor->failed) {
+        cursor->failed = YES;
+        cursor->errorOffset = cursor->offset;
+    }
+    cursor->offset = cursor->length;
+}
+
+// the next byte after whitespace, -1 at the end
+static inline int SBJSONPeek(SBJSONCursor *cursor) {
+    const uint8_t *bytes = cursor->bytes;
+    size_t offset = cursor->offset;
+    while (offset < cursor->length && (bytes[offset] == ' ' || bytes[offset] == '\n' || bytes[offset] == '\r' || bytes[offset] == '\t')) {
+        offset++;
+    }
+    cursor->offset = offset;
+    return offset < cursor->length ? bytes[offset] : -1;
+}
+
+static inline BOOL SBJSONIsDigit(int byte) {
+    return byte >= '0' && byte <= '9';
+}
+
+static inline int SBJSONHexValue(uint8_t byte) {
+    if (byte >= '0' && byte <= '9') {
+        return byte - '0';
+    }
+    if (byte >= 'a' && byte <= 'f') {
+        return byte - 'a' + 10;
+    }
+    if (byte >= 'A' && byte <= 'F') {
+        return byte - 'A' + 10;
+    }
+    return -1;
+}
+
+static SBJSONType SBJSONTypeOfByte(int byte) {
+    switch (byte) {
+        case '{':
+            return SBJSONTypeObject;
+        case '[':
+            return SBJSONTypeArray;
+        case '"':
+            return SBJSONTypeString;
+        case 't':
+        case 'f':
+            return SBJSONTypeBool;
+        case 'n':
+            return SBJSONTypeNull;
+        default:
+            return (byte == '-' || SBJSONIsDigit(byte)) ? SBJSONTypeNumber : SBJSONTypeNone;
+    }
+}
+
+// at '{' or '['
+static BOOL SBJSONEnter(SBJSONCursor *cursor) {
+    if (cursor->depth == kSBJSONReaderMaxDepth) {
+        SBJSONFail(cursor);
+        return NO;
+    }
+    cursor->offset++;
+    cursor->first[cursor->depth++] = YES;
+    return YES;
+}
+
+// YES if the container entered last has another member, NO when it ends (and is left) or on error
+static BOOL SBJSONNext(SBJSONCursor *cursor, uint8_t close) {
+    if (cursor->failed || !cursor->depth) {
+        return NO;
+    }
+    int byte = SBJSONPeek(cursor);
+    if (byte == close) {
+        cursor->offset++;
+        cursor->depth--;
+        return NO;
+    }
+    if (!cursor->first[cursor->depth - 1]) {
+        if (byte != ',') {
+            SBJSONFail(cursor);
+            return NO;
+        }
+        cursor->offset++;
+        byte = SBJSONPeek(cursor);
+        // no trailing comma
+        if (byte == close) {
+            SBJSONFail(cursor);
+            return NO;
+        }
+    }
+    if (byte < 0) {
+        SBJSONFail(cursor);
+        return NO;
+    }
+    cursor->first[cursor->depth - 1] = NO;
+    return YES;
+}
+
+// at '"': the characters are [start, end), the offset moves past the closing quote
+static BOOL SBJSONScanString(SBJSONCursor *cursor, size_t *start, size_t *end, BOOL *escaped) {
+    const uint8_t *bytes = cursor->bytes;
+    size_t length = cursor->length;
+    size_t i = cursor->offset + 1;
+    BOOL hasEscapes = NO;
+    while (i < length) {
+        uint8_t byte = bytes[i];
+        if (byte == '"') {
+            *start = cursor->offset + 1;
+            *end = i;
+            *escaped = hasEscapes;
+            cursor->offset = i + 1;
+            return YES;
+        }
+        if (byte < 0x20) {
+            break;
+        }
+        if (byte != '\\') {
+            i++;
+            continue;
+        }
+        hasEscapes = YES;
+        if (i + 1 >= length) {
+            break;
+        }
+        uint8_t escape = bytes[i + 1];
+        if (escape == 'u') {
+            if (i + 6 > length ||
+                SBJSONHexValue(bytes[i + 2]) < 0 || SBJSONHexValue(bytes[i + 3]) < 0 ||
+                SBJSONHexValue(bytes[i + 4]) < 0 || SBJSONHexValue(bytes[i + 5]) < 0) {
+                break;
+            }
+            i += 6;
+        } else if (escape == '"' || escape == '\\' || escape == '/' ||
+                   escape == 'b' || escape == 'f' || escape == 'n' || escape == 'r' || escape == 't') {
+            i += 2;
+        } else {
+            break;
+        }
+    }
+    cursor->offset = i;
+    SBJSONFail(cursor);
+    return NO;
+}
+
+static inline uint32_t SBJSONHex4(const uint8_t *bytes) {
+    return (uint32_t)(SBJSONHexValue(bytes[0]) << 12 | SBJSONHexValue(bytes[1]) << 8 | SBJSONHexValue(bytes[2]) << 4 | SBJSONHexValue(bytes[3]));
+}
+
+// escapes of a scanned string to UTF-8, never longer than the escaped form
+static size_t SBJSONUnescape(const uint8_t *source, size_t length, uint8_t *destination) {
+    size_t written = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t byte = source[i];
+        if (byte != '\\') {
+            destination[written++] = byte;
+            i++;
+            continue;
+        }
+        uint8_t escape = source[i + 1];
+        i += 2;
+        switch (escape) {
+            case 'b': destination[written++] = '\b'; break;
+            case 'f': destination[written++] = '\f'; break;
+            case 'n': destination[written++] = '\n'; break;
+            case 'r': destination[written++] = '\r'; break;
+            case 't': destination[written++] = '\t'; break;
+            case 'u': {
+                uint32_t code = SBJSONHex4(source + i);
+                i += 4;
+                if (code >= 0xd800 && code <= 0xdbff && i + 6 <= length && source[i] == '\\' && source[i + 1] == 'u') {
+                    uint32_t low = SBJSONHex4(source + i + 2);
+                    if (low >= 0xdc00 && low <= 0xdfff) {
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                        i += 6;
+                    }
+                }
+                if (code >= 0xd800 && code <= 0xdfff) {
+                    // lone surrogate
+                    code = 0xfffd;
+                }
+                if (code < 0x80) {
+                    destination[written++] = (uint8_t)code;
+                } else if (code < 0x800) {
+                    destination[written++] = (uint8_t)(0xc0 | code >> 6);
+                    destination[written++] = (uint8_t)(0x80 | (code & 0x3f));
+                } else if (code < 0x10000) {
+                    destination[written++] = (uint8_t)(0xe0 | code >> 12);
+                    destination[written++] = (uint8_t)(0x80 | (code >> 6 & 0x3f));
+                    destination[written++] = (uint8_t)(0x80 | (code & 0x3f));
+                } else {
+                    destination[written++] = (uint8_t)(0xf0 | code >> 18);
+                    destination[written++] = (uint8_t)(0x80 | (code >> 12 & 0x3f));
+                    destination[written++] = (uint8_t)(0x80 | (code >> 6 & 0x3f));
+                    destination[written++] = (uint8_t)(0x80 | (code & 0x3f));
+                }
+                break;
+            }
+            default:
+                // " \ /
+                destination[written++] = escape;
+                break;
+        }
+    }
+    return written;
+}
+
+// at '-' or a digit: the number is [offset, end), the offset doesn't move
+static BOOL SBJSONScanNumber(SBJSONCursor *cursor, size_t *end, BOOL *integral) {
+    const uint8_t *bytes = cursor->bytes;
+    size_t length = cursor->length;
+    size_t i = cursor->offset;
+    BOOL isIntegral = YES;
+    if (i < length && bytes[i] == '-') {
+        i++;
+    }
+    if (i < length && bytes[i] == '0') {
+        i++;
+    } else if (i < length && SBJSONIsDigit(bytes[i])) {
+        while (i < length && SBJSONIsDigit(bytes[i])) {
+            i++;
+        }
+    } else {
+        SBJSONFail(cursor);
+        return NO;
+    }
+    if (i < length && bytes[i] == '.') {
+        isIntegral = NO;
+        i++;
+        if (i >= length || !SBJSONIsDigit(bytes[i])) {
+            SBJSONFail(cursor);
+            return NO;
+        }
+        while (i < length && SBJSONIsDigit(bytes[i])) {
+            i++;
+        }
+    }
+    if (i < length && (bytes[i] == 'e' || bytes[i] == 'E')) {
+        isIntegral = NO;
+        i++;
+        if (i < length && (bytes[i] == '+' || bytes[i] == '-')) {
+            i++;
+        }
+        if (i >= length || !SBJSONIsDigit(bytes[i])) {
+            SBJSONFail(cursor);
+            return NO;
+        }
+        while (i < length && SBJSONIsDigit(bytes[i])) {
+            i++;
+        }
+    }
+    *end = i;
+    *integral = isIntegral;
+    return YES;
+}
+
+static BOOL SBJSONReadNumber(SBJSONCursor *cursor, double *value) {
+    size_t end;
+    BOOL integral;
+    if (!SBJSONScanNumber(cursor, &end, &integral)) {
+        return NO;
+    }
+    const uint8_t *bytes = cursor->bytes + cursor->offset;
+    size_t length = end - cursor->offset;
+    cursor->offset = end;
+    BOOL negative = bytes[0] == '-';
+    // exact in a double up to 15 digits
+    if (integral && length - negative <= 15) {
+        int64_t magnitude = 0;
+        for (size_t i = negative; i < length; i++) {
+            magnitude = magnitude * 10 + (bytes[i] - '0');
+        }
+        *value = negative ? -(double)magnitude : (double)magnitude;
+        return YES;
+    }
+    char digits[64];
+    if (length < sizeof(digits)) {
+        memcpy(digits, bytes, length);
+        digits[length] = 0;
+        *value = strtod(digits, NULL);
+    } else {
+        char *copy = malloc(length + 1);
+        memcpy(copy, bytes, length);
+        copy[length] = 0;
+        *value = strtod(copy, NULL);
+        free(copy);
+    }
+    return YES;
+}
+
+static BOOL SBJSONScanLiteral(SBJSONCursor *cursor, const char *literal, size_t length) {
+    if (cursor->length - cursor->offset < length || memcmp(cursor->bytes + cursor->offset, literal, length) != 0) {
+        SBJSONFail(cursor);
+        return NO;
+    }
+    cursor->offset += length;
+    return YES;
+}
+
+// at 't' or 'f'
+static BOOL SBJSONReadLiteralBool(SBJSONCursor *cursor, BOOL *value) {
+    if (cursor->bytes[cursor->offset] == 't') {
+        *value = YES;
+        return SBJSONScanLiteral(cursor, "true", 4);
+    }
+    *value = NO;
+    return SBJSONScanLiteral(cursor, "false", 5);
+}
+
+static BOOL SBJSONReadKey(SBJSONCursor *cursor, SBJSONKey *key) {
+    if (SBJSONPeek(cursor) != '"') {
+        SBJSONFail(cursor);
+        return NO;
+    }
+    size_t start, end;
+    BOOL escaped;
+    if (!SBJSONScanString(cursor, &start, &end, &escaped)) {
+        return NO;
+    }
+    if (SBJSONPeek(cursor) != ':') {
+        SBJSONFail(cursor);
+        return NO;
+    }
+    cursor->offset++;
+    if (key) {
+        if (!escaped) {
+            key->bytes = cursor->bytes + start;
+            key->length = end - start;
+        } else if (end - start <= kSBJSONReaderKeyCapacity) {
+            key->bytes = cursor->key;
+            key->length = SBJSONUnescape(cursor->bytes + start, end - start, cursor->key);
+        } else {
+            key->bytes = cursor->key;
+            key->length = 0;
+        }
+    }
+    return YES;
+}
+
+static void SBJSONSkip(SBJSONCursor *cursor) {
+    int byte = SBJSONPeek(cursor);
+    switch (byte) {
+        case '{':
+            if (SBJSONEnter(cursor)) {
+                while (SBJSONNext(cursor, '}')) {
+                    if (!SBJSONReadKey(cursor, NULL)) {
+                        return;
+                    }
+                    SBJSONSkip(cursor);
+                }
+            }
+            return;
+        case '[':
+            if (SBJSONEnter(cursor)) {
+                while (SBJSONNext(cursor, ']')) {
+                    SBJSONSkip(cursor);
+                }
+            }
+            return;
+        case '"': {
+            size_t start, end;
+            BOOL escaped;
+            SBJSONScanString(cursor, &start, &end, &escaped);
+            return;
+        }
+        case 't':
+            SBJSONScanLiteral(cursor, "true", 4);
+            return;
+        case 'f':
+            SBJSONScanLiteral(cursor, "false", 5);
+            return;
+        case 'n':
+            SBJSONScanLiteral(cursor, "null", 4);
+            return;
+        default:
+            if (byte == '-' || SBJSONIsDigit(byte)) {
+                size_t end;
+                BOOL integral;
+                if (SBJSONScanNumber(cursor, &end, &integral)) {
+                    cursor->offset = end;
+                }
+                return;
+            }
+            SBJSONFail(cursor);
+            return;
+    }
+}
+
+#pragma mark - SBJSONReader
+
+@interface SBJSONReader () {
+    NSData *data;
+    SBJSONCursor cursor;
+    // strings with escapes are unescaped here
+    NSMutableData *scratch;
+    NSError *syntaxError;
+}
+
+- (BOOL)readStringBytes:(const uint8_t **)bytes length:(size_t *)length;
+- (NSString *)stringWithBytes:(const uint8_t *)bytes length:(size_t)length;
+
+@end
+
+@implementation SBJSONReader
+
+- (instancetype)init {
+    return [self initWithData:[NSData data]];
+}
+
+- (instancetype)initWithData:(NSData *)jsonData {
+    self = [super init];
+    if (self) {
+        data = [jsonData copy];
+        cursor.bytes = data.bytes;
+        cursor.length = data.length;
+        // byte order mark
+        if (cursor.length >= 3 && cursor.bytes[0] == 0xef && cursor.bytes[1] == 0xbb && cursor.bytes[2] == 0xbf) {
+            cursor.offset = 3;
+        }
+        scratch = [NSMutableData new];
+    }
+    return self;
+}
+
+- (NSError *)error {
+    if (!cursor.failed) {
+        return nil;
+    }
+    if (!syntaxError) {
+        NSString *description = [NSString stringWithFormat:@"Invalid JSON around character %lu.", (unsigned long)cursor.errorOffset];
+        syntaxError = [NSError errorWithDomain:NSCocoaErrorDomain code:NSPropertyListReadCorruptError userInfo:@{NSDebugDescriptionKey : description}];
+    }
+    return syntaxError;
+}
+
+- (SBJSONType)peekType {
+    return SBJSONTypeOfByte(SBJSONPeek(&cursor));
+}
+
+- (BOOL)beginObject {
+    if (SBJSONPeek(&cursor) != '{') {
+        SBJSONSkip(&cursor);
+        return NO;
+    }
+    return SBJSONEnter(&cursor);
+}
+
+- (BOOL)nextKey:(SBJSONKey *)key {
+    if (!SBJSONNext(&cursor, '}')) {
+        return NO;
+    }
+    return SBJSONReadKey(&cursor, key);
+}
+
+- (BOOL)beginArray {
+    if (SBJSONPeek(&cursor) != '[') {
+        SBJSONSkip(&cursor);
+        return NO;
+    }
+    return SBJSONEnter(&cursor);
+}
+
+- (BOOL)nextElement {
+    return SBJSONNext(&cursor, ']');
+}
+
+// at '"': the unescaped UTF-8 of the string, valid until the next read
+- (BOOL)readStringBytes:(const uint8_t **)bytes length:(size_t *)length {
+    size_t start, end;
+    BOOL escaped;
+    if (!SBJSONScanString(&cursor, &start, &end, &escaped)) {
+        return NO;
+    }
+    if (!escaped) {
+        *bytes = cursor.bytes + start;
+        *length = end - start;
+        return YES;
+    }
+    if (scratch.length < end - start) {
+        scratch.length = end - start;
+    }
+    *length = SBJSONUnescape(cursor.bytes + start, end - start, scratch.mutableBytes);
+    *bytes = scratch.mutableBytes;
+    return YES;
+}
+
+- (NSString *)stringWithBytes:(const uint8_t *)bytes length:(size_t)length {
+    NSString *string = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (!string) {
+        // not UTF-8
+        SBJSONFail(&cursor);
+    }
+    return string;
+}
+
+- (NSString *)readString {
+    int byte = SBJSONPeek(&cursor);
+    if (byte == '"') {
+        const uint8_t *bytes;
+        size_t length;
+        if (![self readStringBytes:&bytes length:&length]) {
+            return nil;
+        }
+        return [self stringWithBytes:bytes length:length];
+    }
+    if (byte == '-' || SBJSONIsDigit(byte)) {
+        double value;
+        return SBJSONReadNumber(&cursor, &value) ? [@(value) stringValue] : nil;
+    }
+    SBJSONSkip(&cursor);
+    return nil;
+}
+
+- (BOOL)readDouble:(double *)value {
+    int byte = SBJSONPeek(&cursor);
+    if (byte == '-' || SBJSONIsDigit(byte)) {
+        return SBJSONReadNumber(&cursor, value);
+    }
+    if (byte == 't' || byte == 'f') {
+        BOOL boolValue;
+        if (!SBJSONReadLiteralBool(&cursor, &boolValue)) {
+            return NO;
+        }
+        *value = boolValue ? 1 : 0;
+        return YES;
+    }
+    if (byte == '"') {
+        NSString *string = [self readString];
+        if (!string) {
+            return NO;
+        }
+        *value = string.doubleValue;
+        return YES;
+    }
+    SBJSONSkip(&cursor);
+    return NO;
+}
+
+- (BOOL)readBool:(BOOL *)value {
+    int byte = SBJSONPeek(&cursor);
+    if (byte == 't' || byte == 'f') {
+        return SBJSONReadLiteralBool(&cursor, value);
+    }
+    if (byte == '-' || SBJSONIsDigit(byte)) {
+        double number;
+        if (!SBJSONReadNumber(&cursor, &number)) {
+            return NO;
+        }
+        *value = number != 0;
+        return YES;
+    }
+    if (byte == '"') {
+        NSString *string = [self readString];
+        if (!string) {
+            return NO;
+        }
+        *value = string.boolValue;
+        return YES;
+    }
+    SBJSONSkip(&cursor);
+    return NO;
+}
+
+- (NSDate *)readDate {
+    int byte = SBJSONPeek(&cursor);
+    if (byte == '"') {
+        const uint8_t *bytes;
+        size_t length;
+        int64_t millis;
+        if (![self readStringBytes:&bytes length:&length] || !SBISO8601ParseMillis((const char *)bytes, length, &millis)) {
+            return nil;
+        }
+        return [NSDate dateWithTimeIntervalSince1970:millis / 1000.0];
+    }
+    if (byte == '-' || SBJSONIsDigit(byte)) {
+        double seconds;
+        return SBJSONReadNumber(&cursor, &seconds) ? [NSDate dateWithTimeIntervalSince1970:seconds] : nil;
+    }
+    SBJSONSkip(&cursor);
+    return nil;
+}
+
+- (id)readJSONObject {
+    SBJSONPeek(&cursor);
+    size_t start = cursor.offset;
+    SBJSONSkip(&cursor);
+    if (cursor.failed) {
+        return nil;
+    }
+    NSData *value = [data subdataWithRange:NSMakeRange(start, cursor.offset - start)];
+    return [NSJSONSerialization JSONObjectWithData:value options:NSJSONReadingAllowFragments error:nil];
+}
+
+- (void)skipValue {
+    SBJSONSkip(&cursor);
+}
+
+- (BOOL)finish {
+    if (SBJSONPeek(&cursor) >= 0) {
+        SBJSONFail(&cursor);
+    }
+    return !cursor.failed;
+}
+
+@end
+
+#pragma mark - Resolver models
+
+@implementation SBJSONReader (SBMGetLayout)
+
+- (NSArray <NSString *> *)readStringArray {
+    if (![self beginArray]) {
+        return nil;
+    }
+    NSMutableArray *strings = [NSMutableArray new];
+    while ([self nextElement]) {
+        if ([self peekType] != SBJSONTypeString) {
+            [self skipValue];
+            continue;
+        }
+        NSString *string = [self readString];
+        if (string) {
+            [strings addObject:string];
+        }
+    }
+    return strings;
+}
+
+// full UUID strings, straight to packed keys
+- (NSArray <SBMBeacon *> *)readBeacons {
+    if (![self beginArray]) {
+        return nil;
+    }
+    NSMutableArray *beacons = [NSMutableArray new];
+    while ([self nextElement]) {
+        if ([self peekType] != SBJSONTypeString) {
+            [self skipValue];
+            continue;
+        }
+        const uint8_t *bytes;
+        size_t length;
+        if (![self readStringBytes:&bytes length:&length]) {
+            break;
+        }
+        SBBeaconKey key;
+        SBMBeacon *beacon;
+        if (SBBeaconKeyParseFullUUIDBytes((const char *)bytes, length, &key)) {
+            beacon = [[SBMBeacon alloc] initWithBeaconKey:key];
+        } else {
+            // what initWithString: makes of the rest, for the same beacons as before
+            NSString *string = [self stringWithBytes:bytes length:length];
+            beacon = string ? [[SBMBeacon alloc] initWithString:string] : nil;
+        }
+        if (!isNull(beacon)) {
+            [beacons addObject:beacon];
+        }
+    }
+    return beacons;
+}
+
+- (SBMGetLayout *)readLayout {
+    if (![self beginObject]) {
+        return nil;
+    }
+    SBMGetLayout *layout = [SBMGetLayout new];
+    SBJSONKey key;
+    double number;
+    BOOL flag;
+    while ([self nextKey:&key]) {
+        if (SBJSONKeyIs(key, "actions")) {
+            if ([self beginArray]) {
+                NSMutableArray *actions = [NSMutableArray new];
+                while ([self nextElement]) {
+                    SBMAction *action = [self readAction];
+                    if (action) {
+                        [actions addObject:action];
+                    }
+                }
+                layout.actions = (NSArray <SBMAction> *)actions;
+            }
+        } else if (SBJSONKeyIs(key, "accountProximityUUIDs")) {
+            NSArray *UUIDs = [self readStringArray];
+            if (UUIDs) {
+                layout.accountProximityUUIDs = UUIDs;
+            }
+        } else if (SBJSONKeyIs(key, "reportTrigger")) {
+            if ([self readDouble:&number]) {
+                layout.reportTrigger = (int)number;
+            }
+        } else if (SBJSONKeyIs(key, "currentVersion")) {
+            if ([self readBool:&flag]) {
+                layout.currentVersion = flag;
+            }
+        } else if (SBJSONKeyIs(key, "instantActions")) {
+            if ([self beginArray]) {
+                NSMutableArray *contents = [NSMutableArray new];
+                while ([self nextElement]) {
+                    SBMContent *content = [self readContent];
+                    if (content) {
+                        [contents addObject:content];
+                    }
+                }
+                layout.instantActions = (NSArray <SBMContent> *)contents;
+            }
+        } else {
+            [self skipValue];
+        }
+    }
+    // what validate: does after JSONModel
+    [layout campaignIndex];
+    return layout;
+}
+
+- (SBMAction *)readAction {
+    if (![self beginObject]) {
+        return nil;
+    }
+    SBMAction *action = [SBMAction new];
+    // validate: leaves an empty array when there are none
+    action.beacons = @[];
+    SBJSONKey key;
+    double number;
+    BOOL flag;
+    while ([self nextKey:&key]) {
+        if (SBJSONKeyIs(key, "eid")) {
+            action.eid = [self readString] ?: action.eid;
+        } else if (SBJSONKeyIs(key, "trigger")) {
+            if ([self readDouble:&number]) {
+                action.trigger = (SBTriggerType)number;
+            }
+        } else if (SBJSONKeyIs(key, "beacons")) {
+            action.beacons = [self readBeacons] ?: action.beacons;
+        } else if (SBJSONKeyIs(key, "suppressionTime")) {
+            if ([self readDouble:&number]) {
+                action.suppressionTime = (int)number;
+            }
+        } else if (SBJSONKeyIs(key, "delay")) {
+            if ([self readDouble:&number]) {
+                action.delay = (int)number;
+            }
+        } else if (SBJSONKeyIs(key, "reportImmediately")) {
+            if ([self readBool:&flag]) {
+                action.reportImmediately = flag;
+            }
+        } else if (SBJSONKeyIs(key, "sendOnlyOnce")) {
+            if ([self readBool:&flag]) {
+                action.sendOnlyOnce = flag;
+            }
+        } else if (SBJSONKeyIs(key, "deliverAt")) {
+            action.deliverAt = [self readDate];
+        } else if (SBJSONKeyIs(key, "content")) {
+            action.content = [self readContent] ?: action.content;
+        } else if (SBJSONKeyIs(key, "type")) {
+            if ([self readDouble:&number]) {
+                action.type = (SBActionType)number;
+            }
+        } else if (SBJSONKeyIs(key, "timeframes")) {
+            if ([self beginArray]) {
+                NSMutableArray *timeframes = [NSMutableArray new];
+                while ([self nextElement]) {
+                    SBMTimeframe *timeframe = [self readTimeframe];
+                    if (timeframe) {
+                        [timeframes addObject:timeframe];
+                    }
+                }
+                action.timeframes = (NSArray <SBMTimeframe> *)timeframes;
+            }
+        } else if (SBJSONKeyIs(key, "typeString")) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+            action.typeString = [self readString] ?: action.typeString;
+#pragma clang diagnostic pop
+        } else if (SBJSONKeyIs(key, "location")) {
+            action.location = [self readString] ?: action.location;
+        } else if (SBJSONKeyIs(key, "pid")) {
+            action.pid = [self readString] ?: action.pid;
+        } else if (SBJSONKeyIs(key, "dt")) {
+            action.dt = [self readDate];
+        } else {
+            [self skipValue];
+        }
+    }
+    // compiled here, on the parse queue, like validate: does
+    [action timeframeSchedule];
+    return action;
+}
+
+- (SBMContent *)readContent {
+    if (![self beginObject]) {
+        return nil;
+    }
+    SBMContent *content = [SBMContent new];
+    SBJSONKey key;
+    while ([self nextKey:&key]) {
+        if (SBJSONKeyIs(key, "subject")) {
+            content.subject = [self readString] ?: content.subject;
+        } else if (SBJSONKeyIs(key, "body")) {
+            content.body = [self readString] ?: content.body;
+        } else if (SBJSONKeyIs(key, "url")) {
+            content.url = [self readString] ?: content.url;
+        } else if (SBJSONKeyIs(key, "payload") && [self peekType] == SBJSONTypeObject) {
+            content.payload = [self readJSONObject];
+        } else {
+            [self skipValue];
+        }
+    }
+    return content;
+}
+
+- (SBMTimeframe *)readTimeframe {
+    if (![self beginObject]) {
+        return nil;
+    }
+    SBMTimeframe *timeframe = [SBMTimeframe new];
+    SBJSONKey key;
+    while ([self nextKey:&key]) {
+        if (SBJSONKeyIs(key, "start")) {
+            timeframe.start = [self readDate];
+        } else if (SBJSONKeyIs(key, "end")) {
+            timeframe.end = [self readDate];
+        } else {
+            [self skipValue];
+        }
+    }
+    return timeframe;
+}
+
+- (SBMSettings *)readSettings {
+    if (![self beginObject]) {
+        return nil;
+    }
+    // the defaults, for what the JSON doesn't set
+    SBMSettings *settings = [SBMSettings new];
+    SBJSONKey key;
+    double number;
+    BOOL flag;
+    while ([self nextKey:&key]) {
+        if (SBJSONKeyIs(key, "monitoringDelay")) {
+            if ([self readDouble:&number]) {
+                settings.monitoringDelay = number;
+            }
+        } else if (SBJSONKeyIs(key, "postSuppression")) {
+            if ([self readDouble:&number]) {
+                settings.postSuppression = number;
+            }
+        } else if (SBJSONKeyIs(key, "rangingSuppression")) {
+            if ([self readDouble:&number]) {
+                settings.rangingSuppression = number;
+            }
+        } else if (SBJSONKeyIs(key, "postChunkRecordCount")) {
+            if ([self readDouble:&number]) {
+                settings.postChunkRecordCount = (NSUInteger)(long long)number;
+            }
+        } else if (SBJSONKeyIs(key, "postChunkByteCount")) {
+            if ([self readDouble:&number]) {
+                settings.postChunkByteCount = (NSUInteger)(long long)number;
+            }
+        } else if (SBJSONKeyIs(key, "enableBeaconScanning")) {
+            if ([self readBool:&flag]) {
+                settings.enableBeaconScanning = flag;
+            }
+        } else if (SBJSONKeyIs(key, "resolverURL")) {
+            settings.resolverURL = [self readString] ?: settings.resolverURL;
+        } else if (SBJSONKeyIs(key, "customBeaconRegions") && [self peekType] == SBJSONTypeObject) {
+            settings.customBeaconRegions = [self readJSONObject];
+        } else {
+            [self skipValue];
+        }
+    }
+    return settings;
+}
+
+@end
@@ -0,0 +1,129 @@
+//
+//  SBJSONWriter.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import "SBInternalModels.h"
+
+/**
+ *  Minimal streaming JSON encoder writing UTF-8 into a growable buffer.
+ *  The buffer is kept across `reset`, so one writer can encode many documents without reallocating.
+ *  Not thread safe, use one writer per thread.
+ */
+@interface SBJSONWriter : NSObject
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ *  Number of bytes written so far
+ */
+@property (nonatomic, readonly) NSUInteger length;
+
+/**
+ *  The written bytes, valid until the next write or reset
+ */
+@property (nonatomic, readonly) const uint8_t *bytes;
+
+/**
+ *  A copy of the written bytes
+ */
+- (NSData *)data;
+
+/**
+ *  Drops the written bytes but keeps the buffer
+ */
+- (void)reset;
+
+- (void)beginObject;
+- (void)endObject;
+- (void)beginArray;
+- (void)endArray;
+
+- (void)writeKey:(NSString *)key;
+- (void)writeString:(NSString *)string;
+- (void)writeInteger:(long long)value;
+
+/**
+ *  Writes integral values as integers, others with the fewest digits that read back the same. null for NaN and infinity.
+ */
+- (void)writeDouble:(double)value;
+
+- (void)writeBool:(BOOL)value;
+- (void)writeNull;
+
+/**
+ *  Writes the date as an API date string (UTC)
+ */
+- (void)writeDate:(NSDate *)date;
+
+/**
+ *  Writes a Foundation JSON object (NSDictionary, NSArray, NSString, NSNumber, NSNull).
+ *  Dictionary keys are written sorted, so equal objects always give the same bytes.
+ *
+ *  @return NO if the object (or something it contains) can't be represented in JSON, nothing is written then
+ */
+- (BOOL)writeObject:(id)object;
+
+/**
+ *  Writes a complete, already encoded JSON value (e.g. the output of another writer)
+ */
+- (void)writeJSONBytes:(const uint8_t *)bytes length:(NSUInteger)length;
+
+@end
+
+/**
+ *  Direct encoders for the analytics models, producing the same JSON as `toJSONData` without the NSDictionary intermediate.
+ */
+@interface SBJSONWriter (SBMPostLayout)
+
+- (void)writeMonitorEvent:(SBMMonitorEvent *)event;
+- (void)writeReportAction:(SBMReportAction *)action;
+- (void)writeReportConversion:(SBMReportConversion *)conversion;
+
+/**
+ *  Writes one of the models above
+ *
+ *  @return NO if the record is not an analytics model
+ */
+- (BOOL)writeRecord:(JSONModel *)record;
+
+- (void)writePostLayout:(SBMPostLayout *)postData;
+
+@end
+
+/**
+ *  Direct encoders for the resolver models, the counterpart of SBJSONReader (SBMGetLayout).
+ *  Beacons are written as their full UUID strings, nil values are left out like `toDictionary` does.
+ */
+@interface SBJSONWriter (SBMGetLayout)
+
+- (void)writeLayout:(SBMGetLayout *)layout;
+- (void)writeAction:(SBMAction *)action;
+- (void)writeContent:(SBMContent *)content;
+- (void)writeTimeframe:(SBMTimeframe *)timeframe;
+- (void)writeSettings:(SBMSettings *)settings;
+
+@end
@@ -0,0 +1,646 @@
+//
+//  SBJSONWriter.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBJSONWriter.h"
+
+#import "SBISO8601.h"
+
+#import "SBUtility.h"
+
+// deeper documents are not produced by the SDK
+#define kSBJSONWriterMaxDepth 32
+
+@interface SBJSONWriter () {
+    uint8_t *buffer;
+    NSUInteger capacity;
+    NSUInteger length;
+    //
+    // per nesting level: YES once the container has an element
+    BOOL hasElements[kSBJSONWriterMaxDepth];
+    NSUInteger depth;
+    BOOL afterKey;
+}
+
+@end
+
+@implementation SBJSONWriter
+
+- (instancetype)init {
+    return [self initWithCapacity:4096];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)initialCapacity {
+    self = [super init];
+    if (self) {
+        capacity = MAX(initialCapacity, 64);
+        buffer = malloc(capacity);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(buffer);
+}
+
+#pragma mark - Buffer
+
+- (NSUInteger)length {
+    return length;
+}
+
+- (const uint8_t *)bytes {
+    return buffer;
+}
+
+- (NSData *)data {
+    return [NSData dataWithBytes:buffer length:length];
+}
+
+- (void)reset {
+    length = 0;
+    depth = 0;
+    afterKey = NO;
+    hasElements[0] = NO;
+}
+
+static inline void SBJSONEnsureCapacity(SBJSONWriter *writer, NSUInteger additional) {
+    if (writer->length + additional <= writer->capacity) {
+        return;
+    }
+    NSUInteger newCapacity = writer->capacity * 2;
+    while (newCapacity < writer->length + additional) {
+        newCapacity *= 2;
+    }
+    writer->buffer = reallocf(writer->buffer, newCapacity);
+    writer->capacity = newCapacity;
+}
+
+static inline void SBJSONAppend(SBJSONWriter *writer, const void *bytes, NSUInteger count) {
+    SBJSONEnsureCapacity(writer, count);
+    memcpy(writer->buffer + writer->length, bytes, count);
+    writer->length += count;
+}
+
+static inline void SBJSONAppendByte(SBJSONWriter *writer, uint8_t byte) {
+    SBJSONEnsureCapacity(writer, 1);
+    writer->buffer[writer->length++] = byte;
+}
+
+// separator handling shared by all values
+static inline void SBJSONBeginValue(SBJSONWriter *writer) {
+    if (writer->afterKey) {
+        writer->afterKey = NO;
+    } else if (writer->hasElements[writer->depth]) {
+        SBJSONAppendByte(writer, ',');
+    }
+    writer->hasElements[writer->depth] = YES;
+}
+
+#pragma mark - Structure
+
+- (void)beginObject {
+    SBJSONBeginValue(self);
+    SBJSONAppendByte(self, '{');
+    NSAssert(depth + 1 < kSBJSONWriterMaxDepth, @"JSON nested too deep");
+    hasElements[++depth] = NO;
+}
+
+- (void)endObject {
+    depth--;
+    SBJSONAppendByte(self, '}');
+}
+
+- (void)beginArray {
+    SBJSONBeginValue(self);
+    SBJSONAppendByte(self, '[');
+    NSAssert(depth + 1 < kSBJSONWriterMaxDepth, @"JSON nested too deep");
+    hasElements[++depth] = NO;
+}
+
+- (void)endArray {
+    depth--;
+    SBJSONAppendByte(self, ']');
+}
+
+- (void)writeKey:(NSString *)key {
+    [self writeString:key];
+    SBJSONAppendByte(self, ':');
+    afterKey = YES;
+}
+
+#pragma mark - Values
+
+static void SBJSONAppendEscaped(SBJSONWriter *writer, const uint8_t *bytes, NSUInteger count) {
+    static const char hex[] = "0123456789abcdef";
+    SBJSONEnsureCapacity(writer, count * 6);
+    for (NSUInteger i = 0; i < count; i++) {
+        uint8_t c = bytes[i];
+        if (c == '"' || c == '\\') {
+            writer->buffer[writer->length++] = '\\';
+            writer->buffer[writer->length++] = c;
+        } else if (c < 0x20) {
+            uint8_t escape[6] = {'\\', 'u', '0', '0', (uint8_t)hex[c >> 4], (uint8_t)hex[c & 0xf]};
+            memcpy(writer->buffer + writer->length, escape, sizeof(escape));
+            writer->length += sizeof(escape);
+        } else {
+            writer->buffer[writer->length++] = c;
+        }
+    }
+}
+
+- (void)writeString:(NSString *)string {
+    SBJSONBeginValue(self);
+    SBJSONAppendByte(self, '"');
+    //
+    NSUInteger stringLength = string.length;
+    NSUInteger maxLength = stringLength * 3;
+    SBJSONEnsureCapacity(self, maxLength + 1);
+    //
+    // encode straight into the buffer, then check whether anything needs escaping
+    NSUInteger used = 0;
+    NSRange remaining = NSMakeRange(0, 0);
+    BOOL converted = [string getBytes:buffer + length
+                            maxLength:maxLength
+                           usedLength:&used
+                             encoding:NSUTF8StringEncoding
+                              options:0
+                                range:NSMakeRange(0, stringLength)
+                       remainingRange:&remaining];
+    if (!converted || remaining.length) {
+        // unpaired surrogates, fall back to a lossy conversion
+        NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding allowLossyConversion:YES];
+        SBJSONAppendEscaped(self, data.bytes, data.length);
+    } else {
+        const uint8_t *encoded = buffer + length;
+        NSUInteger i = 0;
+        while (i < used && encoded[i] != '"' && encoded[i] != '\\' && encoded[i] >= 0x20) {
+            i++;
+        }
+        if (i == used) {
+            length += used;
+        } else {
+            NSData *data = [NSData dataWithBytes:encoded length:used];
+            SBJSONAppendEscaped(self, data.bytes, data.length);
+        }
+    }
+    //
+    SBJSONAppendByte(self, '"');
+}
+
+- (void)writeInteger:(long long)value {
+    SBJSONBeginValue(self);
+    char digits[24];
+    int position = sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[--position] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) {
+        digits[--position] = '-';
+    }
+    SBJSONAppend(self, digits + position, sizeof(digits) - position);
+}
+
+- (void)writeDouble:(double)value {
+    if (!isfinite(value)) {
+        [self writeNull];
+        return;
+    }
+    if (value == trunc(value) && fabs(value) < 1e15) {
+        [self writeInteger:(long long)value];
+        return;
+    }
+    // the shortest of the two that reads back the same
+    char digits[32];
+    int count = snprintf(digits, sizeof(digits), "%.15g", value);
+    if (strtod(digits, NULL) != value) {
+        count = snprintf(digits, sizeof(digits), "%.17g", value);
+    }
+    SBJSONBeginValue(self);
+    SBJSONAppend(self, digits, (NSUInteger)count);
+}
+
+- (void)writeBool:(BOOL)value {
+    SBJSONBeginValue(self);
+    if (value) {
+        SBJSONAppend(self, "true", 4);
+    } else {
+        SBJSONAppend(self, "false", 5);
+    }
+}
+
+- (void)writeNull {
+    SBJSONBeginValue(self);
+    SBJSONAppend(self, "null", 4);
+}
+
+- (void)writeDate:(NSDate *)date {
+    char formatted[kSBISO8601Length];
+    if (!SBISO8601FormatMillis(SBISO8601MillisFromDate(date), formatted)) {
+        [self writeString:[dateFormatter stringFromDate:date]];
+        return;
+    }
+    SBJSONBeginValue(self);
+    SBJSONEnsureCapacity(self, kSBISO8601Length + 2);
+    buffer[length++] = '"';
+    memcpy(buffer + length, formatted, kSBISO8601Length);
+    length += kSBISO8601Length;
+    buffer[length++] = '"';
+}
+
+- (BOOL)writeObject:(id)object {
+    // on failure the value is taken back, whatever of it was written
+    NSUInteger savedLength = length;
+    NSUInteger savedDepth = depth;
+    BOOL savedHasElements = hasElements[depth];
+    BOOL savedAfterKey = afterKey;
+    if ([self writeObjectValue:object]) {
+        return YES;
+    }
+    length = savedLength;
+    depth = savedDepth;
+    hasElements[depth] = savedHasElements;
+    afterKey = savedAfterKey;
+    return NO;
+}
+
+- (BOOL)writeObjectValue:(id)object {
+    if ([object isKindOfClass:[NSString class]]) {
+        [self writeString:object];
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        NSNumber *number = object;
+        if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+            [self writeBool:number.boolValue];
+        } else if (CFNumberIsFloatType((__bridge CFNumberRef)number)) {
+            double value = number.doubleValue;
+            if (!isfinite(value)) {
+                return NO;
+            }
+            [self writeDouble:value];
+        } else if (strcmp(number.objCType, @encode(unsigned long long)) == 0 && number.unsignedLongLongValue > LLONG_MAX) {
+            char digits[32];
+            int count = snprintf(digits, sizeof(digits), "%llu", number.unsignedLongLongValue);
+            SBJSONBeginValue(self);
+            SBJSONAppend(self, digits, (NSUInteger)count);
+        } else {
+            [self writeInteger:number.longLongValue];
+        }
+    } else if ([object isKindOfClass:[NSNull class]]) {
+        [self writeNull];
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        [self beginArray];
+        for (id element in object) {
+            if (![self writeObjectValue:element]) {
+                return NO;
+            }
+        }
+        [self endArray];
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        NSArray *keys = [object allKeys];
+        for (id key in keys) {
+            if (![key isKindOfClass:[NSString class]]) {
+                return NO;
+            }
+        }
+        // sorted: equal dictionaries give equal bytes, whatever order they enumerate in
+        [self beginObject];
+        for (NSString *key in [keys sortedArrayUsingSelector:@selector(compare:)]) {
+            [self writeKey:key];
+            if (![self writeObjectValue:object[key]]) {
+                return NO;
+            }
+        }
+        [self endObject];
+    } else {
+        return NO;
+    }
+    return YES;
+}
+
+- (void)writeJSONBytes:(const uint8_t *)bytes length:(NSUInteger)count {
+    SBJSONBeginValue(self);
+    SBJSONAppend(self, bytes, count);
+}
+
+@end
+
+#pragma mark - Analytics models
+
+@implementation SBJSONWriter (SBMPostLayout)
+
+- (void)writeMonitorEvent:(SBMMonitorEvent *)event {
+    [self beginObject];
+    if (event.pid) {
+        [self writeKey:@"pid"];
+        [self writeString:event.pid];
+    }
+    if (event.location) {
+        [self writeKey:@"location"];
+        [self writeString:event.location];
+    }
+    if (event.dt) {
+        [self writeKey:@"dt"];
+        [self writeDate:event.dt];
+    }
+    [self writeKey:@"trigger"];
+    [self writeInteger:event.trigger];
+    [self endObject];
+}
+
+- (void)writeReportAction:(SBMReportAction *)action {
+    [self beginObject];
+    if (action.eid) {
+        [self writeKey:@"eid"];
+        [self writeString:action.eid];
+    }
+    if (action.action) {
+        [self writeKey:@"action"];
+        [self writeString:action.action];
+    }
+    if (action.pid) {
+        [self writeKey:@"pid"];
+        [self writeString:action.pid];
+    }
+    if (action.dt) {
+        [self writeKey:@"dt"];
+        [self writeDate:action.dt];
+    }
+    if (action.location) {
+        [self writeKey:@"location"];
+        [self writeString:action.location];
+    }
+    [self writeKey:@"trigger"];
+    [self writeInteger:action.trigger];
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    if (action.reaction) {
+        [self writeKey:@"reaction"];
+        if (![self writeObject:action.reaction]) {
+            [self writeNull];
+        }
+    }
+#pragma clang diagnostic pop
+    [self endObject];
+}
+
+- (void)writeReportConversion:(SBMReportConversion *)conversion {
+    [self beginObject];
+    if (conversion.action) {
+        [self writeKey:@"action"];
+        [self writeString:conversion.action];
+    }
+    if (conversion.dt) {
+        [self writeKey:@"dt"];
+        [self writeDate:conversion.dt];
+    }
+    [self writeKey:@"type"];
+    [self writeInteger:conversion.type];
+    if (conversion.location) {
+        [self writeKey:@"location"];
+        [self writeString:conversion.location];
+    }
+    [self endObject];
+}
+
+- (BOOL)writeRecord:(JSONModel *)record {
+    if ([record isKindOfClass:[SBMMonitorEvent class]]) {
+        [self writeMonitorEvent:(SBMMonitorEvent *)record];
+    } else if ([record isKindOfClass:[SBMReportAction class]]) {
+        [self writeReportAction:(SBMReportAction *)record];
+    } else if ([record isKindOfClass:[SBMReportConversion class]]) {
+        [self writeReportConversion:(SBMReportConversion *)record];
+    } else {
+        return NO;
+    }
+    return YES;
+}
+
+- (void)writePostLayout:(SBMPostLayout *)postData {
+    [self beginObject];
+    if (postData.deviceTimestamp) {
+        [self writeKey:@"deviceTimestamp"];
+        [self writeDate:postData.deviceTimestamp];
+    }
+    if (postData.events) {
+        [self writeKey:@"events"];
+        [self beginArray];
+        for (SBMMonitorEvent *event in postData.events) {
+            [self writeMonitorEvent:event];
+        }
+        [self endArray];
+    }
+    if (postData.actions) {
+        [self writeKey:@"actions"];
+        [self beginArray];
+        for (SBMReportAction *action in postData.actions) {
+            [self writeReportAction:action];
+        }
+        [self endArray];
+    }
+    if (postData.conversions) {
+        [self writeKey:@"conversions"];
+        [self beginArray];
+        for (SBMReportConversion *conversion in postData.conversions) {
+            [self writeReportConversion:conversion];
+        }
+        [self endArray];
+    }
+    [self endObject];
+}
+
+@end
+
+#pragma mark - Resolver models
+
+@implementation SBJSONWriter (SBMGetLayout)
+
+- (void)writeLayout:(SBMGetLayout *)layout {
+    [self beginObject];
+    if (layout.accountProximityUUIDs) {
+        [self writeKey:@"accountProximityUUIDs"];
+        [self beginArray];
+        for (NSString *UUID in layout.accountProximityUUIDs) {
+            [self writeString:UUID];
+        }
+        [self endArray];
+    }
+    [self writeKey:@"reportTrigger"];
+    [self writeInteger:layout.reportTrigger];
+    if (layout.actions) {
+        [self writeKey:@"actions"];
+        [self beginArray];
+        for (SBMAction *action in layout.actions) {
+            [self writeAction:action];
+        }
+        [self endArray];
+    }
+    [self writeKey:@"currentVersion"];
+    [self writeBool:layout.currentVersion];
+    if (layout.instantActions) {
+        [self writeKey:@"instantActions"];
+        [self beginArray];
+        for (SBMContent *content in layout.instantActions) {
+            [self writeContent:content];
+        }
+        [self endArray];
+    }
+    [self endObject];
+}
+
+- (void)writeAction:(SBMAction *)action {
+    [self beginObject];
+    if (action.eid) {
+        [self writeKey:@"eid"];
+        [self writeString:action.eid];
+    }
+    [self writeKey:@"trigger"];
+    [self writeInteger:action.trigger];
+    if (action.beacons) {
+        [self writeKey:@"beacons"];
+        [self beginArray];
+        for (id beacon in action.beacons) {
+            // SBMBeacon after decoding, strings before validate:
+            if ([beacon isKindOfClass:[SBMBeacon class]]) {
+                [self writeString:[beacon fullUUID]];
+            } else if ([beacon isKindOfClass:[NSString class]]) {
+                [self writeString:beacon];
+            }
+        }
+        [self endArray];
+    }
+    [self writeKey:@"suppressionTime"];
+    [self writeInteger:action.suppressionTime];
+    [self writeKey:@"delay"];
+    [self writeInteger:action.delay];
+    [self writeKey:@"reportImmediately"];
+    [self writeBool:action.reportImmediately];
+    [self writeKey:@"sendOnlyOnce"];
+    [self writeBool:action.sendOnlyOnce];
+    if (action.deliverAt) {
+        [self writeKey:@"deliverAt"];
+        [self writeDate:action.deliverAt];
+    }
+    if (action.content) {
+        [self writeKey:@"content"];
+        [self writeContent:action.content];
+    }
+    [self writeKey:@"type"];
+    [self writeInteger:action.type];
+    if (action.timeframes) {
+        [self writeKey:@"timeframes"];
+        [self beginArray];
+        for (SBMTimeframe *timeframe in action.timeframes) {
+            [self writeTimeframe:timeframe];
+        }
+        [self endArray];
+    }
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    if (action.typeString) {
+        [self writeKey:@"typeString"];
+        [self writeString:action.typeString];
+    }
+#pragma clang diagnostic pop
+    if (action.location) {
+        [self writeKey:@"location"];
+        [self writeString:action.location];
+    }
+    if (action.pid) {
+        [self writeKey:@"pid"];
+        [self writeString:action.pid];
+    }
+    if (action.dt) {
+        [self writeKey:@"dt"];
+        [self writeDate:action.dt];
+    }
+    [self endObject];
+}
+
+- (void)writeContent:(SBMContent *)content {
+    [self beginObject];
+    if (content.subject) {
+        [self writeKey:@"subject"];
+        [self writeString:content.subject];
+    }
+    if (content.body) {
+        [self writeKey:@"body"];
+        [self writeString:content.body];
+    }
+    if (content.payload) {
+        [self writeKey:@"payload"];
+        if (![self writeObject:content.payload]) {
+            [self writeNull];
+        }
+    }
+    if (content.url) {
+        [self writeKey:@"url"];
+        [self writeString:content.url];
+    }
+    [self endObject];
+}
+
+- (void)writeTimeframe:(SBMTimeframe *)timeframe {
+    [self beginObject];
+    if (timeframe.start) {
+        [self writeKey:@"start"];
+        [self writeDate:timeframe.start];
+    }
+    if (timeframe.end) {
+        [self writeKey:@"end"];
+        [self writeDate:timeframe.end];
+    }
+    [self endObject];
+}
+
+- (void)writeSettings:(SBMSettings *)settings {
+    [self beginObject];
+    [self writeKey:@"monitoringDelay"];
+    [self writeDouble:settings.monitoringDelay];
+    [self writeKey:@"postSuppression"];
+    [self writeDouble:settings.postSuppression];
+    [self writeKey:@"rangingSuppression"];
+    [self writeDouble:settings.rangingSuppression];
+    [self writeKey:@"postChunkRecordCount"];
+    [self writeInteger:(long long)settings.postChunkRecordCount];
+    [self writeKey:@"postChunkByteCount"];
+    [self writeInteger:(long long)settings.postChunkByteCount];
+    if (settings.customBeaconRegions) {
+        [self writeKey:@"customBeaconRegions"];
+        if (![self writeObject:settings.customBeaconRegions]) {
+            [self writeNull];
+        }
+    }
+    [self writeKey:@"enableBeaconScanning"];
+    [self writeBool:settings.enableBeaconScanning];
+    if (settings.resolverURL) {
+        [self writeKey:@"resolverURL"];
+        [self writeString:settings.resolverURL];
+    }
+    [self endObject];
+}
+
+@end
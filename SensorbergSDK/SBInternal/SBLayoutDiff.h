@@ -0,0 +1,81 @@
+//
+//  SBLayoutDiff.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class SBMGetLayout;
+@class SBMAction;
+
+/**
+ *  64 bit FNV-1a over everything that defines a campaign action (trigger, beacons, timing, content, timeframes).
+ *  Runtime fields (pid, dt, location) are not part of it.
+ */
+uint64_t SBActionContentHash(SBMAction *action);
+
+/**
+ *  Structural difference between two layouts.
+ *  Actions are matched by `eid` and compared by `SBActionContentHash`, nothing is converted back to JSON.
+ */
+@interface SBLayoutDiff : NSObject
+
++ (instancetype)diffFromLayout:(SBMGetLayout *)oldLayout toLayout:(SBMGetLayout *)newLayout;
+
+/**
+ *  Actions of the new layout with an eid the old layout doesn't have
+ */
+@property (nonatomic, strong, readonly) NSArray <SBMAction *> *added;
+
+/**
+ *  Actions of the old layout with an eid the new layout doesn't have
+ */
+@property (nonatomic, strong, readonly) NSArray <SBMAction *> *removed;
+
+/**
+ *  New versions of the actions whose content changed
+ */
+@property (nonatomic, strong, readonly) NSArray <SBMAction *> *changed;
+
+/**
+ *  Old versions of `changed`, same order
+ */
+@property (nonatomic, strong, readonly) NSArray <SBMAction *> *replaced;
+
+/**
+ *  YES if the account proximity UUIDs, report trigger, version or instant actions differ
+ */
+@property (nonatomic, readonly) BOOL layoutAttributesChanged;
+
+/**
+ *  YES if the layouts are equivalent
+ */
+@property (nonatomic, readonly, getter=isEmpty) BOOL empty;
+
+/**
+ *  The old action equivalent to an action of the new layout, nil if it was added or changed
+ */
+- (SBMAction *)unchangedActionFor:(SBMAction *)action;
+
+@end
@@ -0,0 +1,248 @@
+//
+//  SBLayoutDiff.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBLayoutDiff.h"
+
+#import "SBInternalModels.h"
+
+#import "SBBeaconKey.h"
+
+#pragma mark - Content hash
+
+static uint64_t const kSBFNVOffsetBasis = 14695981039346656037ULL;
+static uint64_t const kSBFNVPrime = 1099511628211ULL;
+
+// every value is prefixed with a tag, so e.g. @"1" and @1 or [a,b] and [ab] hash differently
+typedef NS_ENUM(uint8_t, SBHashTag) {
+    kSBHashTagNil = 0,
+    kSBHashTagString,
+    kSBHashTagNumber,
+    kSBHashTagDate,
+    kSBHashTagArray,
+    kSBHashTagDictionary,
+    kSBHashTagBeacon,
+    kSBHashTagOther,
+};
+
+static inline void SBHashBytes(uint64_t *hash, const void *bytes, size_t length) {
+    const uint8_t *data = bytes;
+    uint64_t value = *hash;
+    for (size_t i = 0; i < length; i++) {
+        value ^= data[i];
+        value *= kSBFNVPrime;
+    }
+    *hash = value;
+}
+
+static inline void SBHashTag(uint64_t *hash, SBHashTag tag) {
+    SBHashBytes(hash, &tag, sizeof(tag));
+}
+
+static inline void SBHashInteger(uint64_t *hash, int64_t value) {
+    SBHashTag(hash, kSBHashTagNumber);
+    SBHashBytes(hash, &value, sizeof(value));
+}
+
+static void SBHashString(uint64_t *hash, NSString *string) {
+    SBHashTag(hash, kSBHashTagString);
+    uint8_t buffer[256];
+    NSUInteger used = 0;
+    NSRange remaining = NSMakeRange(0, string.length);
+    uint64_t length = string.length;
+    SBHashBytes(hash, &length, sizeof(length));
+    while (remaining.length) {
+        if (![string getBytes:buffer maxLength:sizeof(buffer) usedLength:&used encoding:NSUTF16LittleEndianStringEncoding options:0 range:remaining remainingRange:&remaining] || !used) {
+            break;
+        }
+        SBHashBytes(hash, buffer, used);
+    }
+}
+
+static void SBHashDate(uint64_t *hash, NSDate *date) {
+    SBHashTag(hash, kSBHashTagDate);
+    double interval = date.timeIntervalSince1970;
+    SBHashBytes(hash, &interval, sizeof(interval));
+}
+
+static void SBHashObject(uint64_t *hash, id object) {
+    if (!object || [object isKindOfClass:[NSNull class]]) {
+        SBHashTag(hash, kSBHashTagNil);
+    } else if ([object isKindOfClass:[NSString class]]) {
+        SBHashString(hash, object);
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        SBHashTag(hash, kSBHashTagNumber);
+        double value = [object doubleValue];
+        SBHashBytes(hash, &value, sizeof(value));
+    } else if ([object isKindOfClass:[NSDate class]]) {
+        SBHashDate(hash, object);
+    } else if ([object isKindOfClass:[SBMBeacon class]]) {
+        SBHashTag(hash, kSBHashTagBeacon);
+        SBBeaconKey key;
+        if ([object getBeaconKey:&key]) {
+            SBHashBytes(hash, &key, sizeof(key));
+        } else {
+            SBHashString(hash, [object fullUUID]);
+        }
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        SBHashTag(hash, kSBHashTagArray);
+        uint64_t count = [object count];
+        SBHashBytes(hash, &count, sizeof(count));
+        for (id element in object) {
+            SBHashObject(hash, element);
+        }
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        // key order of a dictionary is not defined
+        SBHashTag(hash, kSBHashTagDictionary);
+        NSArray *keys = [[object allKeys] sortedArrayUsingSelector:@selector(compare:)];
+        uint64_t count = keys.count;
+        SBHashBytes(hash, &count, sizeof(count));
+        for (id key in keys) {
+            SBHashObject(hash, key);
+            SBHashObject(hash, object[key]);
+        }
+    } else if ([object isKindOfClass:[SBMTimeframe class]]) {
+        SBMTimeframe *timeframe = object;
+        SBHashObject(hash, timeframe.start);
+        SBHashObject(hash, timeframe.end);
+    } else if ([object isKindOfClass:[SBMContent class]]) {
+        SBMContent *content = object;
+        SBHashObject(hash, content.subject);
+        SBHashObject(hash, content.body);
+        SBHashObject(hash, content.url);
+        SBHashObject(hash, content.payload);
+    } else {
+        SBHashTag(hash, kSBHashTagOther);
+        SBHashString(hash, [object description]);
+    }
+}
+
+uint64_t SBActionContentHash(SBMAction *action) {
+    uint64_t hash = kSBFNVOffsetBasis;
+    SBHashObject(&hash, action.eid);
+    SBHashInteger(&hash, action.trigger);
+    SBHashObject(&hash, action.beacons);
+    SBHashInteger(&hash, action.suppressionTime);
+    SBHashInteger(&hash, action.delay);
+    SBHashInteger(&hash, action.reportImmediately);
+    SBHashInteger(&hash, action.sendOnlyOnce);
+    SBHashObject(&hash, action.deliverAt);
+    SBHashObject(&hash, action.content);
+    SBHashInteger(&hash, action.type);
+    SBHashObject(&hash, action.timeframes);
+    return hash;
+}
+
+static uint64_t SBLayoutAttributesHash(SBMGetLayout *layout) {
+    uint64_t hash = kSBFNVOffsetBasis;
+    SBHashObject(&hash, layout.accountProximityUUIDs);
+    SBHashInteger(&hash, layout.reportTrigger);
+    SBHashInteger(&hash, layout.currentVersion);
+    SBHashObject(&hash, layout.instantActions);
+    return hash;
+}
+
+#pragma mark - SBLayoutDiff
+
+@interface SBLayoutDiff ()
+@property (nonatomic, strong, readwrite) NSArray <SBMAction *> *added;
+@property (nonatomic, strong, readwrite) NSArray <SBMAction *> *removed;
+@property (nonatomic, strong, readwrite) NSArray <SBMAction *> *changed;
+@property (nonatomic, strong, readwrite) NSArray <SBMAction *> *replaced;
+@property (nonatomic, readwrite) BOOL layoutAttributesChanged;
+// new action -> equivalent old action
+@property (nonatomic, strong) NSMapTable *unchanged;
+@end
+
+@implementation SBLayoutDiff
+
++ (instancetype)diffFromLayout:(SBMGetLayout *)oldLayout toLayout:(SBMGetLayout *)newLayout {
+    SBLayoutDiff *diff = [SBLayoutDiff new];
+    diff.layoutAttributesChanged = SBLayoutAttributesHash(oldLayout) != SBLayoutAttributesHash(newLayout);
+    //
+    // eid -> old actions with that eid, in layout order (eids should be unique, but don't rely on it)
+    NSMutableDictionary <NSString *, NSMutableArray <SBMAction *> *> *oldActions = [NSMutableDictionary dictionaryWithCapacity:oldLayout.actions.count];
+    for (SBMAction *action in oldLayout.actions) {
+        NSString *eid = action.eid ? : @"";
+        NSMutableArray *actions = oldActions[eid];
+        if (!actions) {
+            actions = [NSMutableArray arrayWithCapacity:1];
+            oldActions[eid] = actions;
+        }
+        [actions addObject:action];
+    }
+    //
+    NSMutableArray *added = [NSMutableArray new];
+    NSMutableArray *changed = [NSMutableArray new];
+    NSMutableArray *replaced = [NSMutableArray new];
+    NSMapTable *unchanged = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
+    //
+    for (SBMAction *action in newLayout.actions) {
+        NSMutableArray <SBMAction *> *candidates = oldActions[action.eid ? : @""];
+        SBMAction *previous = candidates.firstObject;
+        if (!previous) {
+            [added addObject:action];
+            continue;
+        }
+        [candidates removeObjectAtIndex:0];
+        //
+        if (SBActionContentHash(previous) == SBActionContentHash(action)) {
+            [unchanged setObject:previous forKey:action];
+        } else {
+            [changed addObject:action];
+            [replaced addObject:previous];
+        }
+    }
+    //
+    NSMutableArray *removed = [NSMutableArray new];
+    for (SBMAction *action in oldLayout.actions) {
+        if ([oldActions[action.eid ? : @""] indexOfObjectIdenticalTo:action] != NSNotFound) {
+            [removed addObject:action];
+        }
+    }
+    //
+    diff.added = added;
+    diff.removed = removed;
+    diff.changed = changed;
+    diff.replaced = replaced;
+    diff.unchanged = unchanged;
+    return diff;
+}
+
+- (BOOL)isEmpty {
+    return !self.layoutAttributesChanged && !self.added.count && !self.removed.count && !self.changed.count;
+}
+
+- (SBMAction *)unchangedActionFor:(SBMAction *)action {
+    return [self.unchanged objectForKey:action];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: +%lu -%lu ~%lu%@>", NSStringFromClass([self class]),
+            (unsigned long)self.added.count, (unsigned long)self.removed.count, (unsigned long)self.changed.count,
+            self.layoutAttributesChanged ? @" attributes" : @""];
+}
+
+@end
@@ -29,11 +29,25 @@
 
 #import "SBEnums.h"
 
+@class SBSignalFilter;
+
+@class SBSessionStore;
+
 @interface SBLocation : NSObject <CLLocationManagerDelegate> {
     
     //
 }
 
+/**
+ *  Sessions are kept in the store at the default path
+ */
+- (instancetype)init;
+
+/**
+ *  Restores the open sessions from the store and keeps it up to date
+ */
+- (instancetype)initWithSessionStore:(SBSessionStore *)store;
+
 - (void)requestAuthorization:(BOOL)always;
 
 @property (nonatomic, readonly) BOOL isMonitoring;
@@ -44,10 +58,42 @@
 
 - (void)startMonitoring:(NSArray*)regions __attribute__((nonnull));
 
+/**
+ *  Starts monitoring the regions that are not monitored yet and stops the ones no longer listed,
+ *  leaving the others (and their ranging) untouched. Same as `startMonitoring:` when not monitoring.
+ */
+- (void)updateMonitoredRegions:(NSArray*)regions __attribute__((nonnull));
+
 - (void)stopMonitoring;
 
+/**
+ *  Ranged beacons are published as one `SBEventRangedBeacons` per interval, default 1 second
+ */
+@property (nonatomic) NSTimeInterval batchInterval;
+
+/**
+ *  Also publish an `SBEventRangedBeacon` for every beacon of every ranging callback, default NO
+ */
+@property (nonatomic) BOOL publishesRangedBeacon;
+
+/**
+ *  Smooths the rssi of the ranged beacons and derives the filtered proximity,
+ *  its enter and exit thresholds decide which sightings open and keep a session
+ */
+@property (nonatomic, readonly) SBSignalFilter *signalFilter;
+
+/**
+ *  Drops the open sessions, also from the store, without publishing exit events
+ */
+- (void)removeAllSessions;
+
 #pragma mark - For Unit Tests
 
 - (NSDictionary *)currentSessions;
 
+/**
+ *  Time source of the sessions, seconds since 1970. Set it before the first beacon is ranged.
+ */
+@property (nonatomic, copy) NSTimeInterval (^clock)(void);
+
 @end
@@ -43,6 +43,16 @@
 
 #import "SBSettings.h"
 
+#import "SBEventCoalescer.h"
+
+#import "SBTimerWheel.h"
+
+#import "SBSignalFilter.h"
+
+#import "SBGeohashTrie.h"
+
+#import "SBSessionStore.h"
+
 #import <objc_geohash/GeoHash.h>
 
 @interface SBLocation() {
@@ -51,15 +61,36 @@
     NSArray *monitoredRegions;
     //
     NSMutableDictionary *sessions;
+    // the sessions again, on disk, for the next launch
+    SBSessionStore *sessionStore;
+    // SBMBeacon -> when its session is next looked at: lastSeen + monitoringDelay, then exit + rangingSuppression
+    // geohash -> exit + rangingSuppression
+    SBTimerWheel *sessionExpiry;
+    // the monitored geo regions
+    SBGeohashTrie *geoRegions;
+    // geohashes of the geo regions the last location was in
+    NSSet <NSString *> *insideGeoRegions;
+    // SBMBeacon -> latest SBEventRangedBeacon
+    SBEventCoalescer *rangedBeacons;
+    // when the filter state of beacons without a session was last dropped
+    NSTimeInterval lastFilterSweep;
 }
 
 @end
 
+static NSTimeInterval const kSBSessionExpiryTick = 1.0f;
+static NSUInteger const kSBSessionExpirySlots = 64;
+
 @implementation SBLocation
 
 #pragma mark - Lifecycle
 
 - (instancetype)init
+{
+    return [self initWithSessionStore:[[SBSessionStore alloc] initWithPath:[SBSessionStore defaultPath]]];
+}
+
+- (instancetype)initWithSessionStore:(SBSessionStore *)store
 {
     self = [super init];
     if (self) {
@@ -67,12 +98,41 @@
         locationManager.delegate = self;
         locationManager.desiredAccuracy = kCLLocationAccuracyHundredMeters;
         //
-        sessions = [NSMutableDictionary new];
+        // carry on with the sessions of the previous launch, no second enter for them
+        sessionStore = store;
+        sessions = [NSMutableDictionary dictionaryWithDictionary:store.restoredSessions];
+        geoRegions = [SBGeohashTrie new];
+        NSMutableSet *inside = [NSMutableSet new];
+        [sessions enumerateKeysAndObjectsUsingBlock:^(id key, SBMSession *session, BOOL *stop) {
+            if ([key isKindOfClass:[NSString class]] && session.exit<=0) {
+                [inside addObject:key];
+            }
+        }];
+        insideGeoRegions = inside;
+        _signalFilter = [SBSignalFilter new];
+        _clock = ^NSTimeInterval {
+            return [[NSDate date] timeIntervalSince1970];
+        };
         //
+        rangedBeacons = [[SBEventCoalescer alloc] initWithInterval:kSBDefaultBatchInterval handler:^(NSArray *values) {
+            SB_PUBLISH(({
+                SBEventRangedBeacons *event = [SBEventRangedBeacons new];
+                event.beacons = values;
+                event;
+            }));
+        }];
     }
     return self;
 }
 
+- (NSTimeInterval)batchInterval {
+    return rangedBeacons.interval;
+}
+
+- (void)setBatchInterval:(NSTimeInterval)batchInterval {
+    rangedBeacons.interval = batchInterval;
+}
+
 - (void)dealloc {
     [self stopMonitoring];
 }
@@ -81,7 +141,7 @@
 
 - (void)requestAuthorization:(BOOL)always {
     if (![CLLocationManager locationServicesEnabled]) {
-        PUBLISH(({
+        SB_PUBLISH(({
             SBEventLocationAuthorization *event = [SBEventLocationAuthorization new];
             event.locationAuthorization = SBLocationAuthorizationStatusUnavailable;
             event;
@@ -90,7 +150,7 @@
     }
     //
     if (![CLLocationManager isMonitoringAvailableForClass:[CLBeaconRegion class]] && ![CLLocationManager isMonitoringAvailableForClass:[CLRegion class]]) {
-        PUBLISH(({
+        SB_PUBLISH(({
             SBEventLocationAuthorization *event = [SBEventLocationAuthorization new];
             event.locationAuthorization = SBLocationAuthorizationStatusUnavailable;
             event;
@@ -105,7 +165,7 @@
     }
     //
     if ([self authorizationStatus] == SBLocationAuthorizationStatusUnimplemented) {
-        PUBLISH(({
+        SB_PUBLISH(({
             SBEventLocationAuthorization *event = [SBEventLocationAuthorization new];
             event.locationAuthorization = SBLocationAuthorizationStatusUnimplemented;
             event;
@@ -169,7 +229,7 @@
     monitoredRegions = [NSArray arrayWithArray:regions];
     
     for (NSString *region in monitoredRegions) {
-        if ([GeoHash verifyHash:region] && region.length<12) {
+        if ([self isGeoRegion:region]) {
             [self startMonitoringForGeoRegion:region];
         } else {
             [self startMonitoringForBeaconRegion:region];
@@ -177,10 +237,57 @@
     }
 }
 
+- (void)updateMonitoredRegions:(NSArray *)regions {
+    if (!_isMonitoring) {
+        [self startMonitoring:regions];
+        return;
+    }
+    //
+    NSMutableSet *current = [NSMutableSet setWithCapacity:monitoredRegions.count];
+    for (NSString *region in monitoredRegions) {
+        [current addObject:[self identifierForRegion:region]];
+    }
+    NSMutableSet *updated = [NSMutableSet setWithCapacity:regions.count];
+    for (NSString *region in regions) {
+        [updated addObject:[self identifierForRegion:region]];
+    }
+    //
+    for (CLRegion *region in locationManager.monitoredRegions.allObjects) {
+        if ([current containsObject:region.identifier] && ![updated containsObject:region.identifier]) {
+            if ([region isKindOfClass:[CLBeaconRegion class]]) {
+                [locationManager stopRangingBeaconsInRegion:(CLBeaconRegion *)region];
+            }
+            [locationManager stopMonitoringForRegion:region];
+            SBLog(@"Stopped monitoring for %@",region.identifier);
+        }
+    }
+    for (NSString *region in monitoredRegions) {
+        if ([self isGeoRegion:region] && ![updated containsObject:[self identifierForRegion:region]]) {
+            [geoRegions removeGeohash:region];
+            SBLog(@"Stopped monitoring for %@",region);
+        }
+    }
+    for (NSString *region in regions) {
+        NSString *identifier = [self identifierForRegion:region];
+        if ([current containsObject:identifier]) {
+            continue;
+        }
+        // a region listed twice starts once
+        [current addObject:identifier];
+        if ([self isGeoRegion:region]) {
+            [self startMonitoringForGeoRegion:region];
+        } else {
+            [self startMonitoringForBeaconRegion:region];
+        }
+    }
+    //
+    monitoredRegions = [NSArray arrayWithArray:regions];
+}
+
 #pragma mark - CLLocationManagerDelegate
 
 - (void)locationManager:(CLLocationManager *)manager didChangeAuthorizationStatus:(CLAuthorizationStatus)status {
-    PUBLISH(({
+    SB_PUBLISH(({
         SBEventLocationAuthorization *event = [SBEventLocationAuthorization new];
         event.locationAuthorization = [self authorizationStatus];
         event;
@@ -226,11 +333,12 @@
 
 - (void)locationManager:(CLLocationManager *)manager didUpdateLocations:(NSArray<CLLocation *> *)locations {
     _gps = locations.lastObject;
-    PUBLISH(({
+    SB_PUBLISH(({
         SBEventLocationUpdated *event = [SBEventLocationUpdated new];
         event.location = _gps;
         event;
     }));
+    [self updateGeoSessionsWithLocation:_gps];
     [locationManager stopUpdatingLocation];
 }
 
@@ -244,71 +352,166 @@
 
 #pragma mark - Internal methods
 
+- (SBTimerWheel *)sessionExpiry {
+    if (!sessionExpiry) {
+        // restored sessions pick up where they were
+        NSTimeInterval monitoringDelay = [SBSettings sharedManager].settings.monitoringDelay;
+        NSTimeInterval rangingDelay = [SBSettings sharedManager].settings.rangingSuppression;
+        NSMutableDictionary <id, NSNumber *> *deadlines = [NSMutableDictionary dictionaryWithCapacity:sessions.count];
+        __block NSTimeInterval start = self.clock();
+        [sessions enumerateKeysAndObjectsUsingBlock:^(id key, SBMSession *session, BOOL *stop) {
+            NSTimeInterval deadline = 0;
+            if (session.exit>0) {
+                deadline = session.exit + rangingDelay;
+            } else if ([key isKindOfClass:[SBMBeacon class]]) {
+                deadline = session.lastSeen + monitoringDelay;
+            }
+            if (deadline > 0) {
+                deadlines[key] = @(deadline);
+                // overdue ones are due at the first check
+                start = MIN(start, deadline - kSBSessionExpiryTick);
+            }
+        }];
+        // a slot per second, one turn covers the default monitoring delay
+        sessionExpiry = [[SBTimerWheel alloc] initWithTickDuration:kSBSessionExpiryTick slotCount:kSBSessionExpirySlots now:start];
+        [deadlines enumerateKeysAndObjectsUsingBlock:^(id key, NSNumber *deadline, BOOL *stop) {
+            [sessionExpiry scheduleKey:key deadline:deadline.doubleValue];
+        }];
+    }
+    return sessionExpiry;
+}
+
 - (void)updateSessionsWithBeacons:(NSArray *)beacons {
     if (!sessions) {
         sessions = [NSMutableDictionary new];
     }
-    
-    for (CLBeacon *beacon in beacons) {
+    NSTimeInterval now = self.clock();
+    NSTimeInterval monitoringDelay = [SBSettings sharedManager].settings.monitoringDelay;
+    SBTimerWheel *expiry = [self sessionExpiry];
+    // the whole callback goes through the filter in one pass
+    NSUInteger count = beacons.count;
+    NSMutableArray <SBMBeacon *> *identities = [NSMutableArray arrayWithCapacity:count];
+    NSUInteger slots[MAX(count, 1)];
+    NSInteger rssi[MAX(count, 1)];
+    for (NSUInteger i = 0; i < count; i++) {
+        CLBeacon *beacon = beacons[i];
         SBMBeacon *sbBeacon = [[SBMBeacon alloc] initWithCLBeacon:beacon];
+        [identities addObject:sbBeacon];
+        slots[i] = [_signalFilter slotForBeacon:sbBeacon];
+        rssi[i] = beacon.rssi;
+    }
+    [_signalFilter updateSlots:slots rssi:rssi count:count now:now];
+    double enterThreshold = _signalFilter.enterThreshold;
+    double exitThreshold = _signalFilter.exitThreshold;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        CLBeacon *beacon = beacons[i];
+        SBMBeacon *sbBeacon = identities[i];
+        double filteredRssi = [_signalFilter rssiOfSlot:slots[i]];
+        CLProximity filteredProximity = [_signalFilter proximityOfSlot:slots[i]];
+        CLLocationAccuracy filteredAccuracy = [_signalFilter accuracyOfSlot:slots[i]];
         
-        SBMSession *session = [sessions objectForKey:sbBeacon.fullUUID];
-        if (!session) {
+        SBMSession *session = [sessions objectForKey:sbBeacon];
+        // too weak to open a session: not seen, as far as enter and exit go
+        if (!session && (enterThreshold == 0 || (filteredRssi != 0 && filteredRssi >= enterThreshold))) {
             session = [[SBMSession alloc] initWithUUID:sbBeacon.fullUUID];
+            [sessions setObject:session forKey:sbBeacon];
             // Because we don't have a session with this beacon, let's fire an SBEventRegionEnter event
-            PUBLISH(({
+            SB_PUBLISH(({
                 SBEventRegionEnter *enter = [SBEventRegionEnter new];
                 enter.beacon = sbBeacon;
                 enter.rssi = [NSNumber numberWithInteger:beacon.rssi].intValue;
                 enter.proximity = beacon.proximity;
                 enter.accuracy = beacon.accuracy;
+                enter.filteredRssi = filteredRssi;
+                enter.filteredProximity = filteredProximity;
+                enter.filteredAccuracy = filteredAccuracy;
                 enter.location = _gps;
                 enter;
             }));
         }
-        session.lastSeen = [[NSDate date] timeIntervalSince1970];
-        if (session.exit) {
-            session.exit = 0;
+        // below the exit threshold a sighting doesn't keep the session open
+        if (session && (exitThreshold == 0 || (filteredRssi != 0 && filteredRssi >= exitThreshold))) {
+            session.lastSeen = now;
+            if (session.exit) {
+                session.exit = 0;
+            }
+            [expiry scheduleKey:sbBeacon deadline:now + monitoringDelay];
+            [sessionStore setSession:session forKey:sbBeacon];
         }
         //
-        [sessions setObject:session forKey:sbBeacon.fullUUID];
-        //
         if (beacon.proximity!=CLProximityUnknown) {
-            PUBLISH(({
-                SBEventRangedBeacon *event = [SBEventRangedBeacon new];
-                event.beacon = sbBeacon;
-                event.rssi = [NSNumber numberWithInteger:beacon.rssi].intValue;
-                event.proximity = beacon.proximity;
-                event.accuracy = beacon.accuracy;
-                event;
-            }));
+            SBEventRangedBeacon *event = [SBEventRangedBeacon new];
+            event.beacon = sbBeacon;
+            event.rssi = [NSNumber numberWithInteger:beacon.rssi].intValue;
+            event.proximity = beacon.proximity;
+            event.accuracy = beacon.accuracy;
+            event.filteredRssi = filteredRssi;
+            event.filteredProximity = filteredProximity;
+            event.filteredAccuracy = filteredAccuracy;
+            // last value wins until the next batch
+            [rangedBeacons coalesceValue:event forKey:sbBeacon];
+            if (self.publishesRangedBeacon) {
+                SB_PUBLISH(event);
+            }
         }
     }
+    // below the enter threshold a beacon never gets a session, nor the exit that frees its slot
+    if (now - lastFilterSweep >= monitoringDelay) {
+        lastFilterSweep = now;
+        NSDictionary *currentSessions = sessions;
+        [_signalFilter removeBeaconsUnseenSince:now - monitoringDelay passingTest:^BOOL(SBMBeacon *beacon) {
+            return currentSessions[beacon] == nil;
+        }];
+    }
 }
 
 - (void)checkRegionExit {
-    //
-    NSTimeInterval monitoringDelay = [SBSettings sharedManager].settings.monitoringDelay;
+    if (!sessions.count) {
+        return;
+    }
+    NSTimeInterval now = self.clock();
+    NSArray *due = [[self sessionExpiry] advanceTo:now];
+    if (!due.count) {
+        return;
+    }
     NSTimeInterval rangingDelay = [SBSettings sharedManager].settings.rangingSuppression;
-    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
-    
-    for (SBMSession *session in sessions.allValues) {
-        if (session.lastSeen + monitoringDelay <= now ) {
-            if (session.exit<=0) {
-                SBLog(@"Setting exit for %@", session.pid);
-                session.exit = now;
-            } else if ( session.exit + rangingDelay <= now ) {
-                PUBLISH(({
-                    SBEventRegionExit *exit = [SBEventRegionExit new];
-                    exit.beacon = [[SBMBeacon alloc] initWithString:session.pid];
-                    exit.location = _gps;
-                    exit;
-                }));
+    for (id key in due) {
+        SBMSession *session = sessions[key];
+        if (!session) {
+            continue;
+        }
+        if (session.exit<=0) {
+            SBLog(@"Setting exit for %@", session.pid);
+            session.exit = now;
+            [sessionExpiry scheduleKey:key deadline:now + rangingDelay];
+            [sessionStore setSession:session forKey:key];
+        } else {
+            // once: the session is gone before anyone hears of the exit
+            [sessions removeObjectForKey:key];
+            [sessionStore removeSessionForKey:key];
+            BOOL isBeacon = [key isKindOfClass:[SBMBeacon class]];
+            if (isBeacon) {
+                [_signalFilter removeBeacon:key];
             }
+            SB_PUBLISH(({
+                SBEventRegionExit *exit = [SBEventRegionExit new];
+                if (isBeacon) {
+                    exit.beacon = [key copy];
+                } else {
+                    exit.geohash = key;
+                }
+                exit.location = _gps;
+                exit;
+            }));
         }
     }
 }
 
+- (NSString *)identifierForRegion:(NSString *)region {
+    return [kSBIdentifier stringByAppendingPathExtension:[region stringByReplacingOccurrencesOfString:@"-" withString:@""]];
+}
+
 - (void)startMonitoringForBeaconRegion:(NSString *)region {
     NSUUID *uuid;
     CLBeaconRegion *beaconRegion;
@@ -328,7 +531,19 @@
     SBLog(@"Started monitoring for %@",beaconRegion.identifier);
 }
 
+- (void)removeAllSessions {
+    [sessions removeAllObjects];
+    // rebuilt from the (now empty) sessions when next needed
+    sessionExpiry = nil;
+    insideGeoRegions = [NSSet set];
+    [_signalFilter removeAllBeacons];
+    [sessionStore removeAllSessions];
+    [sessionStore synchronize];
+}
+
 - (void)stopMonitoring {
+    [geoRegions removeAllGeohashes];
+    insideGeoRegions = [NSSet set];
     for (CLRegion *region in locationManager.monitoredRegions.allObjects) {
         if ([region.identifier rangeOfString:kSBIdentifier].location!=NSNotFound) {
             [locationManager stopMonitoringForRegion:region];
@@ -376,8 +591,70 @@
     }
 }
 
+- (BOOL)isGeoRegion:(NSString *)region {
+    return [GeoHash verifyHash:region] && region.length<12;
+}
+
 - (void)startMonitoringForGeoRegion:(NSString *)region {
-    // TODO
+    // no CLRegion: the significant location changes are matched against the trie
+    if ([geoRegions addGeohash:region.lowercaseString]) {
+        SBLog(@"Started monitoring for %@",region);
+    }
+}
+
+- (void)updateGeoSessionsWithLocation:(CLLocation *)location {
+    if (!location || !geoRegions.count) {
+        return;
+    }
+    NSTimeInterval now = self.clock();
+    SBTimerWheel *expiry = [self sessionExpiry];
+    //
+    char hash[kSBGeohashMaxLength + 1];
+    SBGeohashEncode(location.coordinate.latitude, location.coordinate.longitude, kSBGeohashMaxLength, hash);
+    uint32_t regionIds[kSBGeohashMaxLength];
+    NSUInteger found = [geoRegions regionIdsContainingHash:hash length:kSBGeohashMaxLength ids:regionIds maximum:kSBGeohashMaxLength];
+    //
+    NSMutableSet <NSString *> *inside = [NSMutableSet setWithCapacity:found];
+    for (NSUInteger i = 0; i < found; i++) {
+        NSString *geohash = [geoRegions geohashOfRegionId:regionIds[i]];
+        [inside addObject:geohash];
+        SBMSession *session = sessions[geohash];
+        if (!session) {
+            session = [[SBMSession alloc] initWithUUID:geohash];
+            sessions[geohash] = session;
+            SB_PUBLISH(({
+                SBEventRegionEnter *enter = [SBEventRegionEnter new];
+                enter.geohash = geohash;
+                enter.location = location;
+                enter;
+            }));
+        }
+        session.lastSeen = now;
+        session.exit = 0;
+        // back inside before the suppression ran out: no exit
+        [expiry cancelKey:geohash];
+        [sessionStore setSession:session forKey:geohash];
+    }
+    // left: the exit is published once rangingSuppression has passed without coming back
+    NSTimeInterval rangingDelay = [SBSettings sharedManager].settings.rangingSuppression;
+    for (NSString *geohash in insideGeoRegions) {
+        SBMSession *session = sessions[geohash];
+        if (![inside containsObject:geohash] && session && session.exit<=0) {
+            session.exit = now;
+            [expiry scheduleKey:geohash deadline:now + rangingDelay];
+            [sessionStore setSession:session forKey:geohash];
+        }
+    }
+    insideGeoRegions = inside;
+    //
+    [self checkRegionExit];
+    if (expiry.count) {
+        // significant location changes can be far apart, don't wait for the next one to publish the exits
+        __weak SBLocation *weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)((rangingDelay + kSBSessionExpiryTick) * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            [weakSelf checkRegionExit];
+        });
+    }
 }
 
 #pragma mark - Events
@@ -392,14 +669,28 @@ SUBSCRIBE(SBEventApplicationDidEnterBackground) {
 }
 
 SUBSCRIBE(SBEventRegionExit) {
-    [sessions removeObjectForKey:event.beacon.fullUUID];
-    SBLog(@"Session closed for %@", event.beacon.fullUUID);
+    id key = event.beacon ? event.beacon : event.geohash;
+    if (!key) {
+        return;
+    }
+    [sessions removeObjectForKey:key];
+    [sessionExpiry cancelKey:key];
+    [sessionStore removeSessionForKey:key];
+    if (event.beacon) {
+        [_signalFilter removeBeacon:event.beacon];
+    }
+    SBLog(@"Session closed for %@", event.beacon ? event.beacon.fullUUID : event.geohash);
 }
 
 #pragma mark - For Unit Tests
 
 - (NSDictionary *)currentSessions {
-    return [sessions copy];
+    // keyed by fullUUID, like the session pid
+    NSMutableDictionary *currentSessions = [NSMutableDictionary dictionaryWithCapacity:sessions.count];
+    for (SBMSession *session in sessions.allValues) {
+        currentSessions[session.pid] = session;
+    }
+    return [currentSessions copy];
 }
 
 @end
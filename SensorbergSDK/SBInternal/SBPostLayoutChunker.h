@@ -0,0 +1,56 @@
+//
+//  SBPostLayoutChunker.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import "SBInternalModels.h"
+
+/**
+ *  One analytics POST: the records it carries and its encoded body.
+ */
+@interface SBPostLayoutChunk : NSObject
+@property (nonatomic, strong, readonly) SBMPostLayout *postData;
+@property (nonatomic, strong, readonly) NSData *body;
+@end
+
+/**
+ *  Splits an SBMPostLayout into chunks of at most `maxRecords` records and (unless a single record is larger) `maxBytes` bytes.
+ *  Chunks are encoded lazily, one per call to `nextChunk`, so the next chunk can be prepared while the previous one uploads.
+ */
+@interface SBPostLayoutChunker : NSObject
+
+/**
+ *  @param maxRecords maximum number of records per chunk, 0 for no limit
+ *  @param maxBytes   maximum body length per chunk, 0 for no limit
+ */
+- (instancetype)initWithPostLayout:(SBMPostLayout *)postData maxRecords:(NSUInteger)maxRecords maxBytes:(NSUInteger)maxBytes;
+
+/**
+ *  @return the next chunk, nil when all records have been handed out
+ */
+- (SBPostLayoutChunk *)nextChunk;
+
+@end
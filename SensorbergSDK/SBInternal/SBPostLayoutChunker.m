@@ -0,0 +1,184 @@
+//
+//  SBPostLayoutChunker.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBPostLayoutChunker.h"
+
+#import "SensorbergSDK.h"
+
+#import "SBUtility.h"
+
+#import "SBJSONWriter.h"
+
+typedef NS_ENUM(NSUInteger, SBPostLayoutSection) {
+    kSBPostLayoutSectionEvents = 0,
+    kSBPostLayoutSectionActions,
+    kSBPostLayoutSectionConversions,
+    kSBPostLayoutSectionCount
+};
+
+static NSString * const kSBPostLayoutSectionKeys[kSBPostLayoutSectionCount] = {@"events", @"actions", @"conversions"};
+
+@interface SBPostLayoutChunk ()
+@property (nonatomic, strong, readwrite) SBMPostLayout *postData;
+@property (nonatomic, strong, readwrite) NSData *body;
+@end
+
+@implementation SBPostLayoutChunk
+@end
+
+@interface SBPostLayoutChunker () {
+    NSArray *sections[kSBPostLayoutSectionCount];
+    NSUInteger section;
+    NSUInteger index;
+    //
+    NSUInteger maxRecords;
+    NSUInteger maxBytes;
+    //
+    NSDate *deviceTimestamp;
+    //
+    // bytes still to come while a section's array is open: "]", the empty arrays of the following sections and "}"
+    NSUInteger closingLength[kSBPostLayoutSectionCount];
+    //
+    // reused for every chunk
+    SBJSONWriter *body;
+    SBJSONWriter *scratch;
+}
+
+@end
+
+@implementation SBPostLayoutChunker
+
+- (instancetype)initWithPostLayout:(SBMPostLayout *)postData maxRecords:(NSUInteger)records maxBytes:(NSUInteger)bytes
+{
+    self = [super init];
+    if (self) {
+        sections[kSBPostLayoutSectionEvents] = postData.events ? : @[];
+        sections[kSBPostLayoutSectionActions] = postData.actions ? : @[];
+        sections[kSBPostLayoutSectionConversions] = postData.conversions ? : @[];
+        maxRecords = records ? : NSUIntegerMax;
+        maxBytes = bytes ? : NSUIntegerMax;
+        //
+        deviceTimestamp = postData.deviceTimestamp ? : [NSDate date];
+        //
+        NSUInteger closing = 1;
+        for (NSInteger i = kSBPostLayoutSectionCount - 1; i >= 0; i--) {
+            closingLength[i] = closing + 1;
+            // ,"key":[]
+            closing += kSBPostLayoutSectionKeys[i].length + 6;
+        }
+        //
+        body = [[SBJSONWriter alloc] initWithCapacity:MIN(maxBytes, 256 * 1024)];
+        scratch = [[SBJSONWriter alloc] initWithCapacity:1024];
+    }
+    return self;
+}
+
+- (void)skipExhaustedSections {
+    while (section < kSBPostLayoutSectionCount && index >= sections[section].count) {
+        section++;
+        index = 0;
+    }
+}
+
+- (SBPostLayoutChunk *)nextChunk {
+    [self skipExhaustedSections];
+    if (section >= kSBPostLayoutSectionCount) {
+        return nil;
+    }
+    //
+    NSMutableArray *records[kSBPostLayoutSectionCount];
+    for (NSUInteger i = 0; i < kSBPostLayoutSectionCount; i++) {
+        records[i] = [NSMutableArray new];
+    }
+    //
+    // envelope: {"deviceTimestamp":"...","events":[...],"actions":[...],"conversions":[...]}
+    [body reset];
+    [body beginObject];
+    [body writeKey:@"deviceTimestamp"];
+    [body writeDate:deviceTimestamp];
+    for (NSUInteger i = 0; i < section; i++) {
+        [body writeKey:kSBPostLayoutSectionKeys[i]];
+        [body beginArray];
+        [body endArray];
+    }
+    NSUInteger openSection = section;
+    [body writeKey:kSBPostLayoutSectionKeys[openSection]];
+    [body beginArray];
+    //
+    NSUInteger count = 0;
+    while (count < maxRecords) {
+        [self skipExhaustedSections];
+        if (section >= kSBPostLayoutSectionCount) {
+            break;
+        }
+        //
+        JSONModel *record = sections[section][index];
+        [scratch reset];
+        BOOL encoded = [scratch writeRecord:record];
+        if (encoded) {
+            // moving on to a later section costs exactly the empty arrays already counted in closingLength
+            NSUInteger separator = (section == openSection && records[section].count) ? 1 : 0;
+            if (count && body.length + closingLength[openSection] + separator + scratch.length > maxBytes) {
+                break;
+            }
+            //
+            while (openSection < section) {
+                [body endArray];
+                openSection++;
+                [body writeKey:kSBPostLayoutSectionKeys[openSection]];
+                [body beginArray];
+            }
+            [body writeJSONBytes:scratch.bytes length:scratch.length];
+        } else {
+            // keep it in the chunk so it is acknowledged (and dropped) with the others
+            SBLog(@"💀 Can't encode %@", record);
+        }
+        [records[section] addObject:record];
+        count++;
+        index++;
+    }
+    //
+    [body endArray];
+    for (NSUInteger i = openSection + 1; i < kSBPostLayoutSectionCount; i++) {
+        [body writeKey:kSBPostLayoutSectionKeys[i]];
+        [body beginArray];
+        [body endArray];
+    }
+    [body endObject];
+    //
+    SBMPostLayout *postData = [SBMPostLayout new];
+    postData.deviceTimestamp = deviceTimestamp;
+    postData.events = (NSArray <SBMMonitorEvent> *)[records[kSBPostLayoutSectionEvents] copy];
+    postData.actions = (NSArray <SBMReportAction> *)[records[kSBPostLayoutSectionActions] copy];
+    postData.conversions = (NSArray <SBMReportConversion> *)[records[kSBPostLayoutSectionConversions] copy];
+    //
+    SBPostLayoutChunk *chunk = [SBPostLayoutChunk new];
+    chunk.postData = postData;
+    chunk.body = body.data;
+    return chunk;
+}
+
+@end
@@ -0,0 +1,124 @@
+//
+//  SBRegionScheduler.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Picks the regions to monitor when there are more candidates than the OS allows.
+ *
+ *  Candidates are ranked by recent sightings (decaying), whether they were seen near the current geohash
+ *  and how many campaigns reference them. Most of the capacity goes to the best ranked regions, the
+ *  remaining `rotatingSlots` cycle through the others, longest unmonitored first, every `rotationInterval`.
+ *  A beacon region (42 characters) is left out while the proximity UUID region containing it is picked.
+ *
+ *  Regions are the lowercase, hyphen-less strings SBManager monitors. Only Foundation, times are passed in:
+ *  the same input always gives the same selection.
+ */
+@interface SBRegionScheduler : NSObject
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ *  Slots that rotate, default 5 (at most `capacity`)
+ */
+@property (nonatomic) NSUInteger rotatingSlots;
+
+/**
+ *  Time between two selections, default 5 minutes
+ */
+@property (nonatomic) NSTimeInterval rotationInterval;
+
+/**
+ *  Time in which the weight of a sighting halves, default 1 hour
+ */
+@property (nonatomic) NSTimeInterval sightingHalfLife;
+
+/**
+ *  Score of a (fresh) sighting, default 10
+ */
+@property (nonatomic) double sightingWeight;
+
+/**
+ *  Score of having been seen near `currentGeohash`, default 5
+ */
+@property (nonatomic) double geohashWeight;
+
+/**
+ *  Score per doubling of the campaigns referencing the region, default 1
+ */
+@property (nonatomic) double campaignWeight;
+
+/**
+ *  Score per hour a region hasn't been monitored, for the rotating slots only, default 1
+ */
+@property (nonatomic) double ageWeight;
+
+/**
+ *  Characters of a geohash that have to match, default 5 (about 5km)
+ */
+@property (nonatomic) NSUInteger geohashPrecision;
+
+/**
+ *  Where the device is, sightings are remembered with it
+ */
+@property (nonatomic, copy) NSString *currentGeohash;
+
+/**
+ *  Replaces the candidates, in order of preference for equal scores. What is known of the regions that stay is kept.
+ *
+ *  @param regions        candidate regions
+ *  @param campaignCounts region -> number of campaigns, missing for none
+ *  @param now            the time, seconds
+ */
+- (void)setCandidates:(NSArray <NSString *> *)regions campaignCounts:(NSDictionary <NSString *, NSNumber *> *)campaignCounts now:(NSTimeInterval)now;
+
+@property (nonatomic, readonly) NSArray <NSString *> *candidates;
+
+/**
+ *  A ranged beacon, counted for its own region and for its proximity UUID region
+ *
+ *  @param fullUUID the 42 character beacon identifier
+ */
+- (void)recordSightingOfBeacon:(NSString *)fullUUID now:(NSTimeInterval)now;
+
+/**
+ *  Rank of the region, without the rotation age
+ */
+- (double)scoreOfRegion:(NSString *)region now:(NSTimeInterval)now;
+
+/**
+ *  YES when the candidates changed or `rotationInterval` passed since the last selection
+ */
+- (BOOL)isSelectionDueAt:(NSTimeInterval)now;
+
+/**
+ *  The regions to monitor, at most `capacity`. Selects again if due, the last selection otherwise.
+ */
+- (NSArray <NSString *> *)regionsAt:(NSTimeInterval)now;
+
+@end
@@ -0,0 +1,259 @@
+//
+//  SBRegionScheduler.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBRegionScheduler.h"
+
+static NSUInteger const kSBProximityUUIDLength = 32;
+static NSUInteger const kSBBeaconIdentifierLength = 42;
+// geohashes remembered per region
+static NSUInteger const kSBRegionGeohashCount = 8;
+
+/**
+ *  What the scheduler knows of a candidate
+ */
+@interface SBRegionState : NSObject
+{
+@public
+    // index in the candidates, breaks ties
+    NSUInteger order;
+    NSUInteger campaigns;
+    // decayed sighting count as of `sightingTime`
+    double sightings;
+    NSTimeInterval sightingTime;
+    // when it was last picked
+    NSTimeInterval lastMonitored;
+    NSMutableOrderedSet <NSString *> *geohashes;
+}
+@end
+
+@implementation SBRegionState
+@end
+
+@interface SBRegionScheduler () {
+    // region -> SBRegionState, candidates only
+    NSMutableDictionary <NSString *, SBRegionState *> *states;
+    NSArray <NSString *> *selection;
+    NSTimeInterval lastSelection;
+    BOOL candidatesChanged;
+}
+
+@end
+
+@implementation SBRegionScheduler
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    self = [super init];
+    if (self) {
+        _capacity = capacity;
+        _rotatingSlots = 5;
+        _rotationInterval = 5 * 60;
+        _sightingHalfLife = 60 * 60;
+        _sightingWeight = 10;
+        _geohashWeight = 5;
+        _campaignWeight = 1;
+        _ageWeight = 1;
+        _geohashPrecision = 5;
+        _candidates = @[];
+        states = [NSMutableDictionary new];
+        selection = @[];
+        candidatesChanged = YES;
+    }
+    return self;
+}
+
+#pragma mark - Input
+
+- (void)setCandidates:(NSArray<NSString *> *)regions campaignCounts:(NSDictionary<NSString *,NSNumber *> *)campaignCounts now:(NSTimeInterval)now {
+    NSMutableDictionary *updated = [NSMutableDictionary dictionaryWithCapacity:regions.count];
+    NSMutableArray *candidates = [NSMutableArray arrayWithCapacity:regions.count];
+    for (NSString *region in regions) {
+        if (updated[region]) {
+            continue;
+        }
+        SBRegionState *state = states[region];
+        if (!state) {
+            state = [SBRegionState new];
+            // one rotation older than anything picked now, so new candidates go first
+            state->lastMonitored = now - self.rotationInterval;
+            state->geohashes = [NSMutableOrderedSet new];
+        }
+        NSUInteger campaigns = [campaignCounts[region] unsignedIntegerValue];
+        if (campaigns != state->campaigns) {
+            state->campaigns = campaigns;
+            candidatesChanged = YES;
+        }
+        state->order = candidates.count;
+        updated[region] = state;
+        [candidates addObject:region];
+    }
+    states = updated;
+    // the same list again (every layout) keeps the current selection until the next rotation
+    if (![candidates isEqualToArray:_candidates]) {
+        _candidates = [candidates copy];
+        candidatesChanged = YES;
+    }
+}
+
+- (void)recordSightingOfBeacon:(NSString *)fullUUID now:(NSTimeInterval)now {
+    [self recordSightingInRegion:fullUUID now:now];
+    if (fullUUID.length == kSBBeaconIdentifierLength) {
+        [self recordSightingInRegion:[fullUUID substringToIndex:kSBProximityUUIDLength] now:now];
+    }
+}
+
+- (void)recordSightingInRegion:(NSString *)region now:(NSTimeInterval)now {
+    SBRegionState *state = states[region];
+    if (!state) {
+        return;
+    }
+    state->sightings = [self sightingsOf:state now:now] + 1;
+    state->sightingTime = now;
+    NSString *geohash = [self prefixOfGeohash:self.currentGeohash];
+    if (geohash) {
+        // most recent last
+        [state->geohashes removeObject:geohash];
+        [state->geohashes addObject:geohash];
+        if (state->geohashes.count > kSBRegionGeohashCount) {
+            [state->geohashes removeObjectAtIndex:0];
+        }
+    }
+}
+
+#pragma mark - Scoring
+
+- (NSString *)prefixOfGeohash:(NSString *)geohash {
+    if (!geohash.length) {
+        return nil;
+    }
+    return geohash.length > self.geohashPrecision ? [geohash substringToIndex:self.geohashPrecision] : geohash;
+}
+
+- (double)sightingsOf:(SBRegionState *)state now:(NSTimeInterval)now {
+    if (state->sightings <= 0 || self.sightingHalfLife <= 0) {
+        return state->sightings;
+    }
+    return state->sightings * exp2(-MAX(now - state->sightingTime, 0) / self.sightingHalfLife);
+}
+
+- (double)scoreOf:(SBRegionState *)state geohash:(NSString *)geohash now:(NSTimeInterval)now {
+    double score = self.sightingWeight * [self sightingsOf:state now:now];
+    if (geohash && [state->geohashes containsObject:geohash]) {
+        score += self.geohashWeight;
+    }
+    score += self.campaignWeight * log2(1. + state->campaigns);
+    return score;
+}
+
+- (double)scoreOfRegion:(NSString *)region now:(NSTimeInterval)now {
+    SBRegionState *state = states[region];
+    return state ? [self scoreOf:state geohash:[self prefixOfGeohash:self.currentGeohash] now:now] : 0;
+}
+
+#pragma mark - Selection
+
+- (BOOL)isSelectionDueAt:(NSTimeInterval)now {
+    return candidatesChanged || now - lastSelection >= self.rotationInterval;
+}
+
+- (NSArray<NSString *> *)regionsAt:(NSTimeInterval)now {
+    if (![self isSelectionDueAt:now]) {
+        return selection;
+    }
+    candidatesChanged = NO;
+    lastSelection = now;
+    //
+    if (self.candidates.count <= self.capacity) {
+        selection = self.candidates;
+    } else {
+        selection = [self selectAt:now];
+    }
+    for (NSString *region in selection) {
+        states[region]->lastMonitored = now;
+    }
+    return selection;
+}
+
+- (NSArray <NSString *> *)selectAt:(NSTimeInterval)now {
+    NSUInteger count = self.candidates.count;
+    NSString *geohash = [self prefixOfGeohash:self.currentGeohash];
+    // scores once per selection, on the heap: the candidates aren't bounded
+    double *scores = malloc(2 * MAX(count, 1) * sizeof(double));
+    double *rotationScores = scores + count;
+    NSUInteger index = 0;
+    for (NSString *region in self.candidates) {
+        SBRegionState *state = states[region];
+        scores[index] = [self scoreOf:state geohash:geohash now:now];
+        rotationScores[index] = scores[index] + self.ageWeight * MAX(now - state->lastMonitored, 0) / 3600.;
+        index++;
+    }
+    NSComparator (^byScore)(double *) = ^NSComparator(double *values) {
+        return ^NSComparisonResult(NSString *a, NSString *b) {
+            NSUInteger i = self->states[a]->order, j = self->states[b]->order;
+            if (values[i] != values[j]) {
+                return values[i] > values[j] ? NSOrderedAscending : NSOrderedDescending;
+            }
+            return i < j ? NSOrderedAscending : (i > j ? NSOrderedDescending : NSOrderedSame);
+        };
+    };
+    //
+    NSUInteger rotating = MIN(self.rotatingSlots, self.capacity);
+    NSMutableOrderedSet <NSString *> *selected = [NSMutableOrderedSet orderedSetWithCapacity:self.capacity];
+    for (NSString *region in [self.candidates sortedArrayUsingComparator:byScore(scores)]) {
+        if (selected.count >= self.capacity - rotating) {
+            break;
+        }
+        [self addRegion:region to:selected];
+    }
+    for (NSString *region in [self.candidates sortedArrayUsingComparator:byScore(rotationScores)]) {
+        if (selected.count >= self.capacity) {
+            break;
+        }
+        [self addRegion:region to:selected];
+    }
+    free(scores);
+    return selected.array;
+}
+
+// a proximity UUID region replaces the beacon regions it contains, which are skipped from then on
+- (void)addRegion:(NSString *)region to:(NSMutableOrderedSet <NSString *> *)selected {
+    if ([selected containsObject:region]) {
+        return;
+    }
+    if (region.length == kSBBeaconIdentifierLength) {
+        if ([selected containsObject:[region substringToIndex:kSBProximityUUIDLength]]) {
+            return;
+        }
+    } else if (region.length == kSBProximityUUIDLength) {
+        NSIndexSet *covered = [selected indexesOfObjectsPassingTest:^BOOL(NSString *other, NSUInteger idx, BOOL *stop) {
+            return other.length == kSBBeaconIdentifierLength && [other hasPrefix:region];
+        }];
+        [selected removeObjectsAtIndexes:covered];
+    }
+    [selected addObject:region];
+}
+
+@end
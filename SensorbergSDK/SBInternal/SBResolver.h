@@ -29,6 +29,7 @@
 
 #import "SBInternalModels.h"
 
+@class SBCampaignScheduler;
 
 @interface SBResolver : NSObject
 
@@ -38,8 +39,40 @@
 
 - (void)ping;
 
+/**
+ *  Requests the layout and checks the campaigns for the beacon. Call on the main thread.
+ *  While an identical request (same URL and `useCache`) is in progress no new one is sent:
+ *  the caller waits for it, shares its layout and gets its own campaign check.
+ */
 - (void)requestLayoutForBeacon:(SBMBeacon * _Nullable)beacon trigger:(SBTriggerType)trigger useCache:(BOOL)useCache;
 
+/**
+ *  Attached to every layout the campaigns are checked against (also on a 304), so delayed actions are held instead of published
+ */
+@property (nonatomic, weak, nullable) SBCampaignScheduler *campaignScheduler;
+
+/**
+ *  Calls to requestLayoutForBeacon:trigger:useCache:
+ */
+@property (nonatomic, readonly) NSUInteger layoutRequestCount;
+
+/**
+ *  Calls that were answered by a request already in progress instead of a network call
+ */
+@property (nonatomic, readonly) NSUInteger coalescedLayoutRequestCount;
+
+/**
+ *  Parses a layout response. Thread safe, the resolver calls it on its parse queue.
+ *
+ *  @param parseError set if the data is not JSON
+ *  @param modelError set if the JSON is not a valid layout
+ *
+ *  @return the layout with its campaign index built, nil on error
+ */
++ (SBMGetLayout * _Nullable)layoutWithData:(NSData * _Nonnull)data
+                                parseError:(NSError * _Nullable * _Nullable)parseError
+                                modelError:(NSError * _Nullable * _Nullable)modelError;
+
 - (void)postLayout:(SBMPostLayout * _Nonnull)postData __attribute__((nonnull));
 
 - (void)requestSettingsWithAPIKey:(NSString * _Nonnull)key;
@@ -29,6 +29,10 @@
 
 #import "SBInternalEvents.h"
 #import "SBHTTPRequestManager.h"
+#import "SBHTTPValidatorCache.h"
+#import "SBPostLayoutChunker.h"
+#import "SBSettings.h"
+#import "SBJSONReader.h"
 
 #import <tolo/Tolo.h>
 
@@ -46,6 +50,33 @@ NSString * const SBDefaultSettingsPath = @"/applications/{apiKey}/settings/iOS";
 NSString * const SBDefaultAnalyticsPath = @"/layout";
 NSString * const SBDefaultPingPath = @"/";
 
+// number of analytics chunks queued for upload at the same time
+static NSUInteger const kSBPostLayoutPipelineDepth = 2;
+
+// a caller waiting for a layout request
+@interface SBResolverLayoutRequest : NSObject
+@property (nonatomic, strong) SBMBeacon *beacon;
+@property (nonatomic) SBTriggerType trigger;
+// the stored layout answers this caller when the resolver can't be reached
+@property (nonatomic) BOOL useCache;
+@end
+
+@implementation SBResolverLayoutRequest
+
+- (BOOL)isEqual:(id)object {
+    if (![object isKindOfClass:[SBResolverLayoutRequest class]]) {
+        return NO;
+    }
+    SBResolverLayoutRequest *other = object;
+    return self.trigger == other.trigger && (self.beacon == other.beacon || [self.beacon isEqual:other.beacon]);
+}
+
+- (NSUInteger)hash {
+    return self.beacon.hash ^ (NSUInteger)self.trigger;
+}
+
+@end
+
 @interface SBResolver() {
     double timestamp;
     
@@ -65,6 +96,22 @@ NSString * const SBDefaultPingPath = @"/";
     NSString *pingPath;
     
     NSString *targetAttributeString;
+    
+    // the layout last published and the URL it came from, a 304 for that URL needs no parsing
+    SBMGetLayout *lastLayout;
+    NSURL *lastLayoutURL;
+    NSURL *lastSettingsURL;
+    
+    // URL -> callers waiting for that request, the first one started it.
+    // Registered until the layout (or the error) is handed back on the main queue.
+    NSMutableDictionary <NSString *, NSMutableArray <SBResolverLayoutRequest *> *> *layoutRequestsInFlight;
+    
+    // serial, layouts are parsed in the order they arrive
+    dispatch_queue_t parseQueue;
+    
+    SBPostLayoutChunker *postChunker;
+    NSUInteger postChunksInFlight;
+    BOOL postFailed;
 }
 
 @end
@@ -96,6 +143,8 @@ NSString * const SBDefaultPingPath = @"/";
         pingPath = [defaults valueForKey:kPingKey] ? : SBDefaultPingPath;
         //
         httpHeader = [NSMutableDictionary new];
+        layoutRequestsInFlight = [NSMutableDictionary new];
+        parseQueue = dispatch_queue_create("com.sensorberg.sdk.resolver.parse", DISPATCH_QUEUE_SERIAL);
         NSString *ua = [[SBUtility userAgent] toJSONString];
         [httpHeader setObject:apiKey forKey:kAPIHeaderTag];
         [httpHeader setObject:ua forKey:kUserAgentTag];
@@ -127,6 +176,7 @@ NSString * const SBDefaultPingPath = @"/";
             [defaults synchronize];
             
             [[NSURLCache sharedURLCache] removeAllCachedResponses];
+            [[SBHTTPRequestManager sharedManager].validatorCache removeAllValidators];
             
             SBLog(@"Cleared cache because API Key changed");
         }
@@ -204,16 +254,17 @@ NSString * const SBDefaultPingPath = @"/";
     SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
     NSURL *requestURL = [self pingURL];
     
-    [manager getDataFromURL:requestURL headerFields:httpHeader useCache:NO completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    // never queued behind layout downloads or analytics uploads
+    [manager getDataFromURL:requestURL headerFields:httpHeader useCache:NO priority:NSOperationQueuePriorityVeryHigh completion:^(NSData * _Nullable data, NSError * _Nullable error) {
         if (error)
         {
-            PUBLISH(({
+            SB_PUBLISH(({
                 SBEventPing *event = [SBEventPing new];
                 event.error = [error copy];
                 event;
             }));
             
-            PUBLISH((({
+            SB_PUBLISH((({
                 SBEventReachabilityEvent *event = [SBEventReachabilityEvent new];
                 event.reachable = NO;
                 event;
@@ -221,13 +272,13 @@ NSString * const SBDefaultPingPath = @"/";
             
             return;
         }
-        PUBLISH((({
+        SB_PUBLISH((({
             SBEventPing *event = [SBEventPing new];
             event.latency = [NSDate timeIntervalSinceReferenceDate]-timestamp;
             event;
         })));
         //
-        PUBLISH((({
+        SB_PUBLISH((({
             SBEventReachabilityEvent *event = [SBEventReachabilityEvent new];
             event.reachable = YES;
             event;
@@ -238,7 +289,7 @@ NSString * const SBDefaultPingPath = @"/";
 
 - (void)publishSBEventGetLayoutWithBeacon:(SBMBeacon*)beacon trigger:(SBTriggerType)trigger error:(NSError *)error
 {
-    PUBLISH(({
+    SB_PUBLISH(({
         SBEventGetLayout *event = [SBEventGetLayout new];
         event.error = [error copy];
         event.beacon = beacon;
@@ -256,68 +307,216 @@ NSString * const SBDefaultPingPath = @"/";
     SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
     NSURL *requestURL = [self interactionsURL];
     
-    [manager getDataFromURL:requestURL headerFields:httpHeader useCache:useCache completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    _layoutRequestCount++;
+    //
+    // single flight: an identical request in progress answers this one too
+    SBResolverLayoutRequest *request = [SBResolverLayoutRequest new];
+    request.beacon = isNull(beacon) ? nil : beacon;
+    request.trigger = trigger;
+    request.useCache = useCache;
+    NSString *flightKey = requestURL.absoluteString;
+    NSMutableArray <SBResolverLayoutRequest *> *waiting = layoutRequestsInFlight[flightKey];
+    if (waiting)
+    {
+        SBLog(@"🔕 GET Layout already in progress, waiting for it");
+        [waiting addObject:request];
+        _coalescedLayoutRequestCount++;
+        return;
+    }
+    layoutRequestsInFlight[flightKey] = [NSMutableArray arrayWithObject:request];
+    
+    // always revalidated; the stored layout answers the callers with `useCache` when the resolver can't be reached
+    [manager conditionalGetDataFromURL:requestURL headerFields:httpHeader revalidate:YES completion:^(NSData * _Nullable data, BOOL notModified, NSError * _Nullable error) {
+        NSError *fallbackError = nil;
         if (error)
         {
-            [self publishSBEventGetLayoutWithBeacon:beacon trigger:trigger error:error];
+            BOOL fallback = NO;
+            for (SBResolverLayoutRequest *waiter in layoutRequestsInFlight[flightKey])
+            {
+                fallback = fallback || waiter.useCache;
+            }
+            NSData *cachedData = fallback ? [manager.validatorCache cachedDataForURL:requestURL] : nil;
+            if (!cachedData)
+            {
+                [self publishSBEventGetLayoutForRequests:[self finishLayoutFlight:flightKey fallbackError:nil] error:error];
+                return;
+            }
+            SBLog(@"🔕 GET Layout failed, using the stored layout (%@)", error.localizedDescription);
+            data = cachedData;
+            notModified = YES;
+            fallbackError = error;
+        }
+        
+        if (notModified && lastLayout && [lastLayoutURL isEqual:requestURL])
+        {
+            SBLog(@"👍 Layout not modified");
+            [self checkCampaignsOfLayout:lastLayout forRequests:[self finishLayoutFlight:flightKey fallbackError:fallbackError]];
             return;
         }
         
-        NSError *parseError = nil;
-        NSDictionary * responseObject = [NSJSONSerialization JSONObjectWithData:data
-                                                                        options:NSJSONReadingAllowFragments
-                                                                          error:&parseError];
+        // JSON parsing and model construction (with the campaign index) are done off the main thread,
+        // only the finished layout comes back to publish it and check the campaigns
+        dispatch_async(parseQueue, ^{
+            NSError *parseError = nil;
+            NSError *jsonError = nil;
+            SBMGetLayout *layout = [SBResolver layoutWithData:data parseError:&parseError modelError:&jsonError];
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                // callers that came in during the parse get this layout too
+                NSArray <SBResolverLayoutRequest *> *requests = [self finishLayoutFlight:flightKey fallbackError:fallbackError];
+                if (parseError)
+                {
+                    [self publishSBEventGetLayoutForRequests:requests error:parseError];
+                    return;
+                }
+                //
+                if (!jsonError)
+                {
+                    lastLayout = layout;
+                    lastLayoutURL = requestURL;
+                }
+                
+                SB_PUBLISH((({
+                    SBEventGetLayout *event = [SBEventGetLayout new];
+                    event.error = [jsonError copy];
+                    event.layout = layout;
+                    event;
+                })));
+                
+                [self checkCampaignsOfLayout:layout forRequests:requests];
+            });
+        });
+    }];
+}
+
+/**
+ *  Ends the flight, the next request for the URL starts a new one.
+ *
+ *  @param flightKey     the URL of the flight
+ *  @param fallbackError set when the stored layout stands in for the response:
+ *                       the waiters without `useCache` get this error instead
+ *
+ *  @return the waiters the layout answers
+ */
+- (NSArray <SBResolverLayoutRequest *> *)finishLayoutFlight:(NSString *)flightKey fallbackError:(NSError *)fallbackError
+{
+    NSArray <SBResolverLayoutRequest *> *requests = layoutRequestsInFlight[flightKey];
+    [layoutRequestsInFlight removeObjectForKey:flightKey];
+    if (!fallbackError)
+    {
+        return requests;
+    }
+    NSMutableArray <SBResolverLayoutRequest *> *answered = [NSMutableArray new];
+    NSMutableArray <SBResolverLayoutRequest *> *failed = [NSMutableArray new];
+    for (SBResolverLayoutRequest *request in requests)
+    {
+        [(request.useCache ? answered : failed) addObject:request];
+    }
+    [self publishSBEventGetLayoutForRequests:failed error:fallbackError];
+    return answered;
+}
+
++ (SBMGetLayout *)layoutWithData:(NSData *)data parseError:(NSError **)parseError modelError:(NSError **)modelError
+{
+    // decoded straight into the models, the beacons packed, timeframes compiled and the campaign index built on the way
+    SBJSONReader *reader = [[SBJSONReader alloc] initWithData:data];
+    SBMGetLayout *layout = [reader readLayout];
+    if (![reader finish])
+    {
         if (parseError)
         {
-            [self publishSBEventGetLayoutWithBeacon:beacon trigger:trigger error:parseError];
-            return;
+            *parseError = reader.error;
         }
-        NSError *jsonError;
-        //
-        SBMGetLayout *layout = [[SBMGetLayout alloc] initWithDictionary:responseObject error:&jsonError];
-        //
+        return nil;
+    }
+    if (!layout && modelError)
+    {
+        *modelError = [JSONModelError errorInvalidDataWithMessage:@"Layout is not a JSON object"];
+    }
+    return layout;
+}
 
-        PUBLISH((({
-            SBEventGetLayout *event = [SBEventGetLayout new];
-            event.error = [jsonError copy];
-            event.layout = layout;
-            event;
-        })));
+- (void)checkCampaignsOfLayout:(SBMGetLayout *)layout forRequests:(NSArray <SBResolverLayoutRequest *> *)requests
+{
+    [layout setCampaignScheduler:self.campaignScheduler];
+    for (SBResolverLayoutRequest *request in requests)
+    {
+        if (request.beacon)
+        {
+            [layout checkCampaignsForBeacon:request.beacon trigger:request.trigger];
+        }
+    }
+}
 
-        if (!isNull(beacon))
+- (void)publishSBEventGetLayoutForRequests:(NSArray <SBResolverLayoutRequest *> *)requests error:(NSError *)error
+{
+    // one error per beacon and trigger, identical waiters would only multiply the retries
+    NSMutableArray <SBResolverLayoutRequest *> *published = [NSMutableArray new];
+    for (SBResolverLayoutRequest *request in requests)
+    {
+        if ([published containsObject:request])
         {
-            [layout checkCampaignsForBeacon:beacon trigger:trigger];
+            continue;
         }
-    }];
+        [published addObject:request];
+        [self publishSBEventGetLayoutWithBeacon:request.beacon trigger:request.trigger error:error];
+    }
 }
 
 - (void)postLayout:(SBMPostLayout*)postData {
-    NSError *parseError = nil;
-    NSData *data = [NSJSONSerialization dataWithJSONObject:[postData toDictionary] options:0 error:&parseError];
-    if (parseError)
-    {
-        PUBLISH((({
-            SBEventPostLayout *event = [SBEventPostLayout new];
-            event.error = [parseError copy];
-            event;
-        })));
+    if (postChunker) {
+        // the records of the running upload would be sent twice
+        SBLog(@"🔕 POST layout already in progress");
         return;
     }
-    
+    //
+    SBMSettings *settings = [SBSettings sharedManager].settings;
+    postChunker = [[SBPostLayoutChunker alloc] initWithPostLayout:postData
+                                                      maxRecords:settings.postChunkRecordCount
+                                                        maxBytes:settings.postChunkByteCount];
+    postFailed = NO;
+    [self postNextChunks];
+}
+
+/**
+ *  Keeps up to kSBPostLayoutPipelineDepth chunks queued. Every chunk is acknowledged with its own SBEventPostLayout,
+ *  so only confirmed records are removed from the history. After a failure no new chunks are started,
+ *  the remaining records are sent with the next report.
+ */
+- (void)postNextChunks {
+    while (!postFailed && postChunksInFlight < kSBPostLayoutPipelineDepth) {
+        SBPostLayoutChunk *chunk = [postChunker nextChunk];
+        if (!chunk) {
+            break;
+        }
+        [self postChunk:chunk];
+    }
+    //
+    if (!postChunksInFlight) {
+        postChunker = nil;
+    }
+}
+
+- (void)postChunk:(SBPostLayoutChunk *)chunk {
     SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
     NSURL *requestURL = [self analyticsURL];
     
-    [manager postData:data
+    postChunksInFlight++;
+    [manager postData:chunk.body
                   URL:requestURL
          headerFields:httpHeader
            completion:^(NSData * _Nullable responseData, NSError * _Nullable error) {
+               postChunksInFlight--;
                //
                SBEventPostLayout *postEvent = [SBEventPostLayout new];
                if (!isNull(error)) {
                    postEvent.error = [error copy];
+                   postFailed = YES;
                }
-               postEvent.postData = postData;
-               PUBLISH(postEvent);
+               postEvent.postData = chunk.postData;
+               SB_PUBLISH(postEvent);
+               //
+               [self postNextChunks];
     }];
 }
 
@@ -325,7 +524,7 @@ NSString * const SBDefaultPingPath = @"/";
 {
     if (key.length == 0)
     {
-        PUBLISH((({
+        SB_PUBLISH((({
             SBUpdateSettingEvent *event = [SBUpdateSettingEvent new];
             event.error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSURLErrorBadURL userInfo:nil];
             event;
@@ -336,10 +535,27 @@ NSString * const SBDefaultPingPath = @"/";
     NSURL *URL = [self settingsURL];
     
     SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
-    [manager getDataFromURL:URL headerFields:nil useCache:YES completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    [manager conditionalGetDataFromURL:URL headerFields:nil revalidate:YES completion:^(NSData * _Nullable data, BOOL notModified, NSError * _Nullable error) {
         NSError *blockError = error;
         NSDictionary *responseDict = nil;
         
+        if (blockError)
+        {
+            // like the cached request this replaces, fall back to the stored settings
+            data = [manager.validatorCache cachedDataForURL:URL];
+            if (data)
+            {
+                blockError = nil;
+                notModified = YES;
+            }
+        }
+        
+        if (notModified && [lastSettingsURL isEqual:URL])
+        {
+            SBLog(@"👍 Settings not modified");
+            return;
+        }
+        
         if (isNull(blockError))
         {
             NSError *parseError =nil;
@@ -350,9 +566,13 @@ NSString * const SBDefaultPingPath = @"/";
             {
                 blockError = parseError;
             }
+            else
+            {
+                lastSettingsURL = URL;
+            }
         }
         //
-        PUBLISH((({
+        SB_PUBLISH((({
             SBUpdateSettingEvent *event = [SBUpdateSettingEvent new];
             event.responseDictionary = responseDict;
             event.error = blockError;
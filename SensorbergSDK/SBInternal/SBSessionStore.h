@@ -0,0 +1,83 @@
+//
+//  SBSessionStore.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class SBMSession;
+
+/**
+ *  On-disk table of the open region sessions, so a relaunch (iOS waking the app for a region event)
+ *  carries on with the sessions it had instead of entering every region again.
+ *
+ *  The file is a header and fixed size, checksummed records, memory mapped: restoring is one pass over
+ *  the mapping and an update rewrites one 64 byte record in place. Writes to the mapping survive the
+ *  process being killed; they are flushed to storage asynchronously, at most every few seconds.
+ *  A record torn by a power loss fails its checksum and is dropped, the others are unaffected.
+ *
+ *  Sessions are keyed by SBMBeacon or by geohash NSString. Not thread safe.
+ */
+@interface SBSessionStore : NSObject
+
+/**
+ *  Default location of the table, in Application Support
+ */
++ (NSString *)defaultPath;
+
+/**
+ *  Opens (or creates) the table at `path`. Without a usable file the store keeps nothing.
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+@property (nonatomic, readonly, copy) NSString *path;
+
+/**
+ *  The sessions found when the table was opened, SBMBeacon or geohash -> SBMSession
+ */
+@property (nonatomic, readonly) NSDictionary <id, SBMSession *> *restoredSessions;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ *  Stores the enter, lastSeen and exit of the session. lastSeen alone is only rewritten once it moved
+ *  by `lastSeenResolution`, a ranged beacon doesn't dirty a page every second.
+ */
+- (void)setSession:(SBMSession *)session forKey:(id)key;
+
+- (void)removeSessionForKey:(id)key;
+
+- (void)removeAllSessions;
+
+/**
+ *  Seconds, default 5
+ */
+@property (nonatomic) NSTimeInterval lastSeenResolution;
+
+/**
+ *  Blocks until the table is on storage.
+ */
+- (void)synchronize;
+
+@end
@@ -0,0 +1,389 @@
+//
+//  SBSessionStore.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBSessionStore.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+
+#import "SensorbergSDK.h"
+#import "SBUtility.h"
+
+#import "SBInternalModels.h"
+
+#import "SBBeaconKey.h"
+
+#pragma mark - Constants
+
+static uint32_t const kSBSessionStoreMagic = 0x53425353; // SBSS
+static uint32_t const kSBSessionStoreVersion = 1;
+static uint32_t const kSBSessionStoreInitialCapacity = 64;
+// msync(MS_ASYNC) at most this often
+static NSTimeInterval const kSBSessionStoreFlushInterval = 2.0f;
+
+typedef NS_ENUM(uint8_t, SBSessionRecordKind) {
+    kSBSessionRecordFree = 0,
+    kSBSessionRecordBeacon = 1,
+    kSBSessionRecordGeohash = 2,
+};
+
+/**
+ *  Native byte order, the file never leaves the device
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordLength;
+    uint8_t reserved[48];
+} SBSessionStoreHeader;
+
+typedef struct {
+    // crc32 of the rest of the record
+    uint32_t checksum;
+    uint8_t kind;
+    uint8_t reserved[3];
+    // SBBeaconKey, or the geohash zero padded
+    uint8_t key[24];
+    double enter;
+    double lastSeen;
+    double exit;
+    uint64_t unused;
+} SBSessionRecord;
+
+static inline uint32_t SBSessionRecordChecksum(const SBSessionRecord *record) {
+    return SBCRC32((const uint8_t *)record + sizeof(uint32_t), sizeof(SBSessionRecord) - sizeof(uint32_t));
+}
+
+#pragma mark - SBSessionStore
+
+@interface SBSessionStore () {
+    int fd;
+    SBSessionStoreHeader *header;
+    SBSessionRecord *records;
+    size_t mappedLength;
+    // key -> record index
+    NSMutableDictionary <id, NSNumber *> *slots;
+    NSMutableIndexSet *freeSlots;
+    BOOL flushScheduled;
+}
+
+@end
+
+@implementation SBSessionStore
+
++ (NSString *)defaultPath {
+    NSString *directory = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) firstObject];
+    return [[directory stringByAppendingPathComponent:kSBIdentifier] stringByAppendingPathComponent:@"sessions.table"];
+}
+
+- (instancetype)init {
+    return [self initWithPath:[SBSessionStore defaultPath]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (self) {
+        _path = [path copy];
+        _lastSeenResolution = 5;
+        slots = [NSMutableDictionary new];
+        freeSlots = [NSMutableIndexSet new];
+        fd = -1;
+        //
+        [[NSFileManager defaultManager] createDirectoryAtPath:[_path stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+        [self open];
+        _restoredSessions = [self restore];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (header) {
+        msync(header, mappedLength, MS_ASYNC);
+        munmap(header, mappedLength);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+- (NSUInteger)count {
+    return slots.count;
+}
+
+#pragma mark - File
+
+- (void)open {
+    fd = open(self.path.fileSystemRepresentation, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        SBLog(@"💀 Can't open session table: %s", strerror(errno));
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        [self close];
+        return;
+    }
+    //
+    uint32_t capacity = kSBSessionStoreInitialCapacity;
+    BOOL valid = NO;
+    if ((size_t)info.st_size >= sizeof(SBSessionStoreHeader)) {
+        SBSessionStoreHeader existing;
+        if (pread(fd, &existing, sizeof(existing), 0) == sizeof(existing) &&
+            existing.magic == kSBSessionStoreMagic &&
+            existing.version == kSBSessionStoreVersion &&
+            existing.recordLength == sizeof(SBSessionRecord) &&
+            existing.capacity > 0 &&
+            (size_t)info.st_size >= sizeof(SBSessionStoreHeader) + (size_t)existing.capacity * sizeof(SBSessionRecord)) {
+            capacity = existing.capacity;
+            valid = YES;
+        }
+    }
+    if (!valid && info.st_size > 0) {
+        SBLog(@"💀 Discarding unreadable session table");
+    }
+    if (![self mapCapacity:capacity reset:!valid]) {
+        [self close];
+    }
+}
+
+- (BOOL)mapCapacity:(uint32_t)capacity reset:(BOOL)reset {
+    size_t length = sizeof(SBSessionStoreHeader) + (size_t)capacity * sizeof(SBSessionRecord);
+    if (reset) {
+        // a fresh file reads as free records
+        if (ftruncate(fd, 0) != 0) {
+            return NO;
+        }
+    }
+    if (ftruncate(fd, (off_t)length) != 0) {
+        SBLog(@"💀 Can't size session table: %s", strerror(errno));
+        return NO;
+    }
+    void *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        SBLog(@"💀 Can't map session table: %s", strerror(errno));
+        return NO;
+    }
+    if (header) {
+        munmap(header, mappedLength);
+    }
+    header = mapping;
+    records = (SBSessionRecord *)((uint8_t *)mapping + sizeof(SBSessionStoreHeader));
+    mappedLength = length;
+    //
+    uint32_t previousCapacity = reset ? 0 : header->capacity;
+    header->magic = kSBSessionStoreMagic;
+    header->version = kSBSessionStoreVersion;
+    header->recordLength = sizeof(SBSessionRecord);
+    header->capacity = capacity;
+    if (capacity > previousCapacity) {
+        [freeSlots addIndexesInRange:NSMakeRange(previousCapacity, capacity - previousCapacity)];
+    }
+    return YES;
+}
+
+- (void)close {
+    if (header) {
+        munmap(header, mappedLength);
+        header = NULL;
+        records = NULL;
+        mappedLength = 0;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    [slots removeAllObjects];
+    [freeSlots removeAllIndexes];
+}
+
+- (NSDictionary *)restore {
+    if (!header) {
+        return @{};
+    }
+    NSMutableDictionary *sessions = [NSMutableDictionary new];
+    [freeSlots removeAllIndexes];
+    for (uint32_t i = 0; i < header->capacity; i++) {
+        SBSessionRecord *record = &records[i];
+        id key = nil;
+        if (record->kind != kSBSessionRecordFree && record->checksum == SBSessionRecordChecksum(record)) {
+            key = [self keyOfRecord:record];
+        }
+        if (!key || slots[key]) {
+            if (record->kind != kSBSessionRecordFree) {
+                // torn or duplicate, forget it
+                memset(record, 0, sizeof(SBSessionRecord));
+            }
+            [freeSlots addIndex:i];
+            continue;
+        }
+        //
+        SBMSession *session = [[SBMSession alloc] initWithUUID:[key isKindOfClass:[SBMBeacon class]] ? [key fullUUID] : key];
+        session.enter = [NSDate dateWithTimeIntervalSince1970:record->enter];
+        session.lastSeen = record->lastSeen;
+        session.exit = record->exit;
+        sessions[key] = session;
+        slots[key] = @(i);
+    }
+    return [sessions copy];
+}
+
+- (id)keyOfRecord:(const SBSessionRecord *)record {
+    switch (record->kind) {
+        case kSBSessionRecordBeacon: {
+            SBBeaconKey key;
+            memcpy(&key, record->key, sizeof(SBBeaconKey));
+            return [[SBMBeacon alloc] initWithBeaconKey:key];
+        }
+        case kSBSessionRecordGeohash: {
+            char geohash[sizeof(record->key) + 1];
+            memcpy(geohash, record->key, sizeof(record->key));
+            geohash[sizeof(record->key)] = 0;
+            return geohash[0] ? @(geohash) : nil;
+        }
+        default:
+            return nil;
+    }
+}
+
+// fills kind and key, NO if the key can't be stored
+- (BOOL)getRecord:(SBSessionRecord *)record forKey:(id)key {
+    memset(record, 0, sizeof(SBSessionRecord));
+    if ([key isKindOfClass:[SBMBeacon class]]) {
+        SBBeaconKey beaconKey;
+        if (![key getBeaconKey:&beaconKey]) {
+            return NO;
+        }
+        record->kind = kSBSessionRecordBeacon;
+        memcpy(record->key, &beaconKey, sizeof(SBBeaconKey));
+        return YES;
+    }
+    if ([key isKindOfClass:[NSString class]]) {
+        const char *geohash = [key UTF8String];
+        size_t length = geohash ? strlen(geohash) : 0;
+        if (!length || length > sizeof(record->key)) {
+            return NO;
+        }
+        record->kind = kSBSessionRecordGeohash;
+        memcpy(record->key, geohash, length);
+        return YES;
+    }
+    return NO;
+}
+
+- (void)scheduleFlush {
+    if (flushScheduled) {
+        return;
+    }
+    flushScheduled = YES;
+    __weak __typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kSBSessionStoreFlushInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [weakSelf flush];
+    });
+}
+
+- (void)flush {
+    flushScheduled = NO;
+    if (header) {
+        msync(header, mappedLength, MS_ASYNC);
+    }
+}
+
+#pragma mark - Public
+
+- (void)setSession:(SBMSession *)session forKey:(id)key {
+    if (!header || !session || !key) {
+        return;
+    }
+    NSNumber *slot = slots[key];
+    if (slot) {
+        SBSessionRecord *record = &records[slot.unsignedIntValue];
+        // a sighting: only every lastSeenResolution seconds
+        if (record->enter == session.enter.timeIntervalSince1970 &&
+            record->exit == session.exit &&
+            session.lastSeen >= record->lastSeen &&
+            session.lastSeen - record->lastSeen < self.lastSeenResolution) {
+            return;
+        }
+    } else {
+        if (!freeSlots.count && ![self mapCapacity:header->capacity * 2 reset:NO]) {
+            return;
+        }
+        slot = @(freeSlots.firstIndex);
+    }
+    //
+    SBSessionRecord record;
+    if (![self getRecord:&record forKey:key]) {
+        return;
+    }
+    record.enter = session.enter.timeIntervalSince1970;
+    record.lastSeen = session.lastSeen;
+    record.exit = session.exit;
+    record.checksum = SBSessionRecordChecksum(&record);
+    records[slot.unsignedIntValue] = record;
+    //
+    if (!slots[key]) {
+        slots[key] = slot;
+        [freeSlots removeIndex:slot.unsignedIntegerValue];
+    }
+    [self scheduleFlush];
+}
+
+- (void)removeSessionForKey:(id)key {
+    NSNumber *slot = key ? slots[key] : nil;
+    if (!slot) {
+        return;
+    }
+    memset(&records[slot.unsignedIntValue], 0, sizeof(SBSessionRecord));
+    [slots removeObjectForKey:key];
+    [freeSlots addIndex:slot.unsignedIntegerValue];
+    [self scheduleFlush];
+}
+
+- (void)removeAllSessions {
+    if (!header) {
+        return;
+    }
+    memset(records, 0, (size_t)header->capacity * sizeof(SBSessionRecord));
+    [slots removeAllObjects];
+    [freeSlots removeAllIndexes];
+    [freeSlots addIndexesInRange:NSMakeRange(0, header->capacity)];
+    [self scheduleFlush];
+}
+
+- (void)synchronize {
+    flushScheduled = NO;
+    if (header) {
+        msync(header, mappedLength, MS_SYNC);
+    }
+}
+
+@end
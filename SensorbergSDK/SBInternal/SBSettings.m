@@ -62,7 +62,7 @@ static SBSettings *_sharedManager = nil;
 {
     if (self = [super init])
     {
-        REGISTER();
+        SB_REGISTER();
     }
     
     return self;
@@ -90,7 +90,7 @@ SUBSCRIBE(SBUpdateSettingEvent)
 {
     if(event.error)
     {
-        PUBLISH((({
+        SB_PUBLISH((({
             SBSettingEvent *settingEvent = [SBSettingEvent new];
             settingEvent.error = event.error;
             settingEvent;
@@ -105,7 +105,7 @@ SUBSCRIBE(SBUpdateSettingEvent)
     
     if (mappingError || [[newSettings toDictionary] isEqualToDictionary:[self.settings toDictionary]])
     {
-        PUBLISH((({
+        SB_PUBLISH((({
             SBSettingEvent *settingEvent = [SBSettingEvent new];
             settingEvent.error = mappingError ?: [NSError errorWithDomain:NSCocoaErrorDomain code:NSURLErrorCancelled userInfo:nil];
             settingEvent;
@@ -117,7 +117,7 @@ SUBSCRIBE(SBUpdateSettingEvent)
     
     SBSettingEvent *settingEvent = [SBSettingEvent new];
     settingEvent.settings = [newSettings toDictionary];
-    PUBLISH(settingEvent);
+    SB_PUBLISH(settingEvent);
 }
 
 @end
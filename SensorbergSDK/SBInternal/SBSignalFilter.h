@@ -0,0 +1,144 @@
+//
+//  SBSignalFilter.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import <CoreLocation/CoreLocation.h>
+
+@class SBMBeacon;
+
+typedef NS_ENUM(NSUInteger, SBSignalFilterType) {
+    /**
+     *  Raw values, the last measurement is the estimate
+     */
+    SBSignalFilterNone = 0,
+    /**
+     *  Exponentially weighted moving average with weight `smoothing` for a new measurement
+     */
+    SBSignalFilterEWMA,
+    /**
+     *  One dimensional Kalman filter, the uncertainty grows with the time since the last measurement
+     */
+    SBSignalFilterKalman,
+};
+
+/**
+ *  Per-beacon RSSI filter with outlier rejection, and proximity with hysteresis.
+ *
+ *  The state of all beacons is kept in parallel C arrays (a slot per beacon, reused when a beacon is removed),
+ *  one ranging callback updates them in one pass.
+ *
+ *  Main thread only, like the location callbacks.
+ */
+@interface SBSignalFilter : NSObject
+
+/**
+ *  Defaults to `SBSignalFilterKalman`, a change applies to the next measurement
+ */
+@property (nonatomic) SBSignalFilterType type;
+
+/**
+ *  EWMA weight of a new measurement, 0...1, default 0.3
+ */
+@property (nonatomic) double smoothing;
+
+/**
+ *  Kalman process noise in dBm² per second, default 0.5
+ */
+@property (nonatomic) double processNoise;
+
+/**
+ *  Kalman measurement noise in dBm², default 16
+ */
+@property (nonatomic) double measurementNoise;
+
+/**
+ *  Measurements further than this many dBm from the estimate are dropped,
+ *  unless `maximumRejections` of them came in a row. Default 15.
+ */
+@property (nonatomic) double outlierThreshold;
+
+@property (nonatomic) NSUInteger maximumRejections;
+
+/**
+ *  RSSI at 1 meter, for the filtered accuracy. Default -59.
+ */
+@property (nonatomic) double measuredPower;
+
+/**
+ *  Filtered RSSI above which a beacon is immediate (default -55) and near (default -75), far below
+ */
+@property (nonatomic) double immediateThreshold;
+@property (nonatomic) double nearThreshold;
+
+/**
+ *  How far (dBm) the filtered RSSI has to cross a threshold to change the proximity, default 3
+ */
+@property (nonatomic) double hysteresis;
+
+/**
+ *  Filtered RSSI a beacon needs to open a session, and to keep it open. 0 (default) for any sighting.
+ *  With `exitThreshold` below `enterThreshold`, a beacon at the edge doesn't flap between enter and exit.
+ */
+@property (nonatomic) double enterThreshold;
+@property (nonatomic) double exitThreshold;
+
+/**
+ *  Number of beacons with state
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ *  The slot of the beacon, allocated on first use
+ */
+- (NSUInteger)slotForBeacon:(SBMBeacon *)beacon;
+
+/**
+ *  Feeds one ranging callback: `rssi[i]` measured for `slots[i]` at `now` (seconds).
+ *  A 0 rssi (not measured) leaves the slot as it is.
+ */
+- (void)updateSlots:(const NSUInteger *)slots rssi:(const NSInteger *)rssi count:(NSUInteger)count now:(NSTimeInterval)now;
+
+/**
+ *  Filtered values of a slot: 0, CLProximityUnknown and -1 before its first measurement
+ */
+- (double)rssiOfSlot:(NSUInteger)slot;
+- (CLProximity)proximityOfSlot:(NSUInteger)slot;
+- (CLLocationAccuracy)accuracyOfSlot:(NSUInteger)slot;
+
+/**
+ *  Frees the slot of the beacon, its state starts over next time
+ */
+- (void)removeBeacon:(SBMBeacon *)beacon;
+
+/**
+ *  Frees the slots of the beacons not in a callback since `time` (seconds) for which `predicate` returns YES
+ */
+- (void)removeBeaconsUnseenSince:(NSTimeInterval)time passingTest:(BOOL (^)(SBMBeacon *beacon))predicate;
+
+- (void)removeAllBeacons;
+
+@end
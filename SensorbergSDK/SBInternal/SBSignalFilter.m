@@ -0,0 +1,241 @@
+//
+//  SBSignalFilter.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBSignalFilter.h"
+
+#import "SBModel.h"
+
+@interface SBSignalFilter () {
+    // SBMBeacon -> slot
+    NSMutableDictionary <SBMBeacon *, NSNumber *> *slotIndex;
+    NSMutableIndexSet *freeSlots;
+    NSUInteger capacity;
+    NSUInteger slotCount;
+    // one entry per slot
+    double *estimates;
+    double *variances;
+    double *lastUpdates;
+    CLProximity *proximities;
+    uint16_t *rejections;
+    bool *measured;
+    // last callback the beacon was in, measured or not
+    double *sightings;
+}
+
+@end
+
+@implementation SBSignalFilter
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _type = SBSignalFilterKalman;
+        _smoothing = 0.3;
+        _processNoise = 0.5;
+        _measurementNoise = 16;
+        _outlierThreshold = 15;
+        _maximumRejections = 2;
+        _measuredPower = -59;
+        _immediateThreshold = -55;
+        _nearThreshold = -75;
+        _hysteresis = 3;
+        //
+        slotIndex = [NSMutableDictionary new];
+        freeSlots = [NSMutableIndexSet new];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(estimates);
+    free(variances);
+    free(lastUpdates);
+    free(proximities);
+    free(rejections);
+    free(measured);
+    free(sightings);
+}
+
+- (NSUInteger)count {
+    return slotIndex.count;
+}
+
+#pragma mark - Slots
+
+- (void)grow {
+    capacity = MAX(capacity * 2, 16);
+    estimates = reallocf(estimates, capacity * sizeof(double));
+    variances = reallocf(variances, capacity * sizeof(double));
+    lastUpdates = reallocf(lastUpdates, capacity * sizeof(double));
+    proximities = reallocf(proximities, capacity * sizeof(CLProximity));
+    rejections = reallocf(rejections, capacity * sizeof(uint16_t));
+    measured = reallocf(measured, capacity * sizeof(bool));
+    sightings = reallocf(sightings, capacity * sizeof(double));
+}
+
+- (void)resetSlot:(NSUInteger)slot {
+    estimates[slot] = 0;
+    variances[slot] = 0;
+    lastUpdates[slot] = 0;
+    proximities[slot] = CLProximityUnknown;
+    rejections[slot] = 0;
+    measured[slot] = false;
+    sightings[slot] = 0;
+}
+
+- (NSUInteger)slotForBeacon:(SBMBeacon *)beacon {
+    NSNumber *known = slotIndex[beacon];
+    if (known) {
+        return known.unsignedIntegerValue;
+    }
+    NSUInteger slot = freeSlots.firstIndex;
+    if (slot != NSNotFound) {
+        [freeSlots removeIndex:slot];
+    } else {
+        if (slotCount == capacity) {
+            [self grow];
+        }
+        slot = slotCount++;
+    }
+    [self resetSlot:slot];
+    slotIndex[beacon] = @(slot);
+    return slot;
+}
+
+- (void)removeBeacon:(SBMBeacon *)beacon {
+    NSNumber *known = slotIndex[beacon];
+    if (known) {
+        [slotIndex removeObjectForKey:beacon];
+        [freeSlots addIndex:known.unsignedIntegerValue];
+    }
+}
+
+- (void)removeBeaconsUnseenSince:(NSTimeInterval)time passingTest:(BOOL (^)(SBMBeacon *beacon))predicate {
+    NSMutableArray <SBMBeacon *> *stale = [NSMutableArray new];
+    [slotIndex enumerateKeysAndObjectsUsingBlock:^(SBMBeacon *beacon, NSNumber *slot, BOOL *stop) {
+        if (sightings[slot.unsignedIntegerValue] < time && (!predicate || predicate(beacon))) {
+            [stale addObject:beacon];
+        }
+    }];
+    for (SBMBeacon *beacon in stale) {
+        [self removeBeacon:beacon];
+    }
+}
+
+- (void)removeAllBeacons {
+    [slotIndex removeAllObjects];
+    [freeSlots removeAllIndexes];
+    slotCount = 0;
+}
+
+#pragma mark - Filtering
+
+- (void)updateSlots:(const NSUInteger *)slots rssi:(const NSInteger *)rssi count:(NSUInteger)count now:(NSTimeInterval)now {
+    SBSignalFilterType type = self.type;
+    double smoothing = MIN(MAX(self.smoothing, 0), 1);
+    double processNoise = self.processNoise;
+    double measurementNoise = self.measurementNoise;
+    double outlierThreshold = self.outlierThreshold;
+    NSUInteger maximumRejections = self.maximumRejections;
+    double immediate = self.immediateThreshold;
+    double near = self.nearThreshold;
+    double hysteresis = self.hysteresis;
+    //
+    for (NSUInteger i = 0; i < count; i++) {
+        NSUInteger slot = slots[i];
+        double z = (double)rssi[i];
+        if (slot >= slotCount) {
+            continue;
+        }
+        sightings[slot] = now;
+        if (rssi[i] == 0) {
+            continue;
+        }
+        if (!measured[slot]) {
+            estimates[slot] = z;
+            variances[slot] = measurementNoise;
+            lastUpdates[slot] = now;
+            measured[slot] = true;
+        } else {
+            double x = estimates[slot];
+            if (type != SBSignalFilterNone && fabs(z - x) > outlierThreshold && rejections[slot] < maximumRejections) {
+                rejections[slot]++;
+                continue;
+            }
+            rejections[slot] = 0;
+            switch (type) {
+                case SBSignalFilterNone:
+                    estimates[slot] = z;
+                    break;
+                case SBSignalFilterEWMA:
+                    estimates[slot] = x + smoothing * (z - x);
+                    break;
+                case SBSignalFilterKalman: {
+                    double p = variances[slot] + processNoise * MAX(now - lastUpdates[slot], 0);
+                    double k = p / (p + measurementNoise);
+                    estimates[slot] = x + k * (z - x);
+                    variances[slot] = (1 - k) * p;
+                    break;
+                }
+            }
+            lastUpdates[slot] = now;
+        }
+        // a threshold has to be crossed by `hysteresis` to leave the current zone
+        double estimate = estimates[slot];
+        CLProximity current = proximities[slot];
+        double up = current == CLProximityUnknown ? 0 : hysteresis;
+        double down = current == CLProximityUnknown ? 0 : -hysteresis;
+        CLProximity proximity;
+        if (current == CLProximityImmediate) {
+            proximity = estimate >= immediate + down ? CLProximityImmediate : (estimate >= near + down ? CLProximityNear : CLProximityFar);
+        } else if (current == CLProximityNear) {
+            proximity = estimate >= immediate + up ? CLProximityImmediate : (estimate >= near + down ? CLProximityNear : CLProximityFar);
+        } else {
+            proximity = estimate >= immediate + up ? CLProximityImmediate : (estimate >= near + up ? CLProximityNear : CLProximityFar);
+        }
+        proximities[slot] = proximity;
+    }
+}
+
+- (double)rssiOfSlot:(NSUInteger)slot {
+    return slot < slotCount && measured[slot] ? estimates[slot] : 0;
+}
+
+- (CLProximity)proximityOfSlot:(NSUInteger)slot {
+    return slot < slotCount ? proximities[slot] : CLProximityUnknown;
+}
+
+- (CLLocationAccuracy)accuracyOfSlot:(NSUInteger)slot {
+    if (slot >= slotCount || !measured[slot]) {
+        return -1;
+    }
+    // log-distance path loss, free space exponent
+    return pow(10., (self.measuredPower - estimates[slot]) / 20.);
+}
+
+@end
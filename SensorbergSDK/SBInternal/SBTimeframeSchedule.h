@@ -0,0 +1,61 @@
+//
+//  SBTimeframeSchedule.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class SBMTimeframe;
+
+/**
+ *  No transition ahead
+ */
+FOUNDATION_EXPORT int64_t const kSBTimeframeNever;
+
+/**
+ *  Milliseconds since 1970, rounded down
+ */
+FOUNDATION_EXPORT int64_t SBTimeframeTimeFromDate(NSDate *date);
+
+/**
+ *  The timeframes of an action compiled into sorted, disjoint [start, end) intervals of milliseconds since 1970.
+ *  A missing start or end is open ended. Lookups are a binary search, no NSDate involved. Immutable.
+ */
+@interface SBTimeframeSchedule : NSObject
+
+- (instancetype)initWithTimeframes:(NSArray <SBMTimeframe *> *)timeframes;
+
+/**
+ *  Number of intervals once overlapping timeframes are merged and empty ones dropped
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+- (BOOL)containsTime:(int64_t)time;
+
+/**
+ *  The first time after `time` at which `containsTime:` changes, kSBTimeframeNever if it doesn't
+ */
+- (int64_t)nextTransitionAfter:(int64_t)time;
+
+@end
@@ -0,0 +1,129 @@
+//
+//  SBTimeframeSchedule.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTimeframeSchedule.h"
+
+#import "SBInternalModels.h"
+
+int64_t const kSBTimeframeNever = INT64_MAX;
+
+int64_t SBTimeframeTimeFromDate(NSDate *date) {
+    return (int64_t)floor(date.timeIntervalSince1970 * 1000);
+}
+
+typedef struct {
+    int64_t start;
+    int64_t end;
+} SBTimeframeInterval;
+
+static int SBTimeframeIntervalCompare(const void *a, const void *b) {
+    int64_t start1 = ((const SBTimeframeInterval *)a)->start;
+    int64_t start2 = ((const SBTimeframeInterval *)b)->start;
+    return start1 < start2 ? -1 : (start1 > start2 ? 1 : 0);
+}
+
+@interface SBTimeframeSchedule () {
+    // sorted by start, disjoint and not touching
+    SBTimeframeInterval *intervals;
+    NSUInteger count;
+}
+
+@end
+
+@implementation SBTimeframeSchedule
+
+- (instancetype)init {
+    return [self initWithTimeframes:@[]];
+}
+
+- (instancetype)initWithTimeframes:(NSArray <SBMTimeframe *> *)timeframes {
+    self = [super init];
+    if (self) {
+        intervals = malloc(MAX(timeframes.count, 1) * sizeof(SBTimeframeInterval));
+        NSUInteger compiled = 0;
+        for (SBMTimeframe *timeframe in timeframes) {
+            if (![timeframe isKindOfClass:[SBMTimeframe class]]) {
+                continue;
+            }
+            SBTimeframeInterval interval;
+            interval.start = timeframe.start ? SBTimeframeTimeFromDate(timeframe.start) : INT64_MIN;
+            interval.end = timeframe.end ? SBTimeframeTimeFromDate(timeframe.end) : INT64_MAX;
+            // an end before the start never matches
+            if (interval.start < interval.end) {
+                intervals[compiled++] = interval;
+            }
+        }
+        qsort(intervals, compiled, sizeof(SBTimeframeInterval), SBTimeframeIntervalCompare);
+        // being in any of the timeframes is all that counts: merge
+        for (NSUInteger i = 0; i < compiled; i++) {
+            if (count && intervals[i].start <= intervals[count - 1].end) {
+                intervals[count - 1].end = MAX(intervals[count - 1].end, intervals[i].end);
+            } else {
+                intervals[count++] = intervals[i];
+            }
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(intervals);
+}
+
+- (NSUInteger)count {
+    return count;
+}
+
+// the last interval starting at or before `time`, NSNotFound if none
+- (NSUInteger)indexOfIntervalAt:(int64_t)time {
+    NSUInteger low = 0;
+    NSUInteger high = count;
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        if (intervals[middle].start <= time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low ? low - 1 : NSNotFound;
+}
+
+- (BOOL)containsTime:(int64_t)time {
+    NSUInteger index = [self indexOfIntervalAt:time];
+    return index != NSNotFound && time < intervals[index].end;
+}
+
+- (int64_t)nextTransitionAfter:(int64_t)time {
+    NSUInteger index = [self indexOfIntervalAt:time];
+    if (index != NSNotFound && time < intervals[index].end) {
+        return intervals[index].end;
+    }
+    NSUInteger next = index == NSNotFound ? 0 : index + 1;
+    return next < count ? intervals[next].start : kSBTimeframeNever;
+}
+
+@end
@@ -0,0 +1,68 @@
+//
+//  SBTimerWheel.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Hashed timer wheel: deadlines per key, filed in one of `slotCount` slots by tick.
+ *  Scheduling, rescheduling and cancelling are O(1), advancing only visits the slots of the elapsed ticks.
+ *
+ *  A deadline expires on the first `advanceTo:` after the end of its tick, so at most one tick late.
+ *  Later deadlines stay where they are until their slot comes around, so refreshing a key is a single store.
+ *
+ *  Not thread safe.
+ */
+@interface SBTimerWheel : NSObject
+
+/**
+ *  @param tickDuration granularity of the deadlines, in seconds
+ *  @param slotCount    deadlines further than `tickDuration * slotCount` ahead get looked at once per turn
+ *  @param now          the time the wheel starts at, on the clock of the deadlines
+ */
+- (instancetype)initWithTickDuration:(NSTimeInterval)tickDuration slotCount:(NSUInteger)slotCount now:(NSTimeInterval)now;
+
+/**
+ *  Sets the deadline of the key, replacing its previous one
+ */
+- (void)scheduleKey:(id <NSCopying>)key deadline:(NSTimeInterval)deadline;
+
+- (void)cancelKey:(id <NSCopying>)key;
+
+/**
+ *  The deadline of the key, 0 if it isn't scheduled
+ */
+- (NSTimeInterval)deadlineForKey:(id <NSCopying>)key;
+
+/**
+ *  Removes and returns the keys whose deadline passed, earliest deadline first
+ */
+- (NSArray *)advanceTo:(NSTimeInterval)now;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+- (void)removeAllKeys;
+
+@end
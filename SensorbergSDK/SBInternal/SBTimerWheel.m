@@ -0,0 +1,217 @@
+//
+//  SBTimerWheel.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTimerWheel.h"
+
+/**
+ *  A scheduled key, linked into the slot of `tick`
+ */
+@interface SBTimerWheelEntry : NSObject
+{
+@public
+    id key;
+    NSTimeInterval deadline;
+    // the tick it is filed under, at or before the tick of the deadline
+    int64_t tick;
+    SBTimerWheelEntry *next;
+    __unsafe_unretained SBTimerWheelEntry *previous;
+}
+@end
+
+@implementation SBTimerWheelEntry
+@end
+
+@interface SBTimerWheel () {
+    NSTimeInterval tickDuration;
+    NSUInteger slotCount;
+    // heads of the slot lists
+    __strong SBTimerWheelEntry **slots;
+    // key -> SBTimerWheelEntry
+    NSMutableDictionary *entries;
+    // the ticks up to this one have been handled
+    int64_t currentTick;
+}
+
+@end
+
+@implementation SBTimerWheel
+
+- (instancetype)initWithTickDuration:(NSTimeInterval)duration slotCount:(NSUInteger)count now:(NSTimeInterval)now
+{
+    self = [super init];
+    if (self) {
+        tickDuration = duration > 0 ? duration : 1;
+        slotCount = MAX(count, 1);
+        slots = (__strong SBTimerWheelEntry **)calloc(slotCount, sizeof(SBTimerWheelEntry *));
+        entries = [NSMutableDictionary new];
+        currentTick = [self tickOf:now] - 1;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self removeAllKeys];
+    free(slots);
+}
+
+- (NSUInteger)count {
+    return entries.count;
+}
+
+- (int64_t)tickOf:(NSTimeInterval)time {
+    return (int64_t)floor(time / tickDuration);
+}
+
+#pragma mark - Slot lists
+
+- (void)link:(SBTimerWheelEntry *)entry tick:(int64_t)tick {
+    // whatever is already due goes to the next tick that gets handled
+    entry->tick = MAX(tick, currentTick + 1);
+    NSUInteger slot = (NSUInteger)(entry->tick % (int64_t)slotCount);
+    entry->previous = nil;
+    entry->next = slots[slot];
+    if (entry->next) {
+        entry->next->previous = entry;
+    }
+    slots[slot] = entry;
+}
+
+- (void)unlink:(SBTimerWheelEntry *)entry {
+    if (entry->previous) {
+        entry->previous->next = entry->next;
+    } else {
+        slots[(NSUInteger)(entry->tick % (int64_t)slotCount)] = entry->next;
+    }
+    if (entry->next) {
+        entry->next->previous = entry->previous;
+    }
+    entry->next = nil;
+    entry->previous = nil;
+}
+
+#pragma mark - Scheduling
+
+- (void)scheduleKey:(id<NSCopying>)key deadline:(NSTimeInterval)deadline {
+    SBTimerWheelEntry *entry = entries[key];
+    if (!entry) {
+        entry = [SBTimerWheelEntry new];
+        entry->key = key;
+        entry->deadline = deadline;
+        entries[key] = entry;
+        [self link:entry tick:[self tickOf:deadline]];
+        return;
+    }
+    entry->deadline = deadline;
+    // a later deadline is picked up when the slot comes around, only an earlier one has to move
+    int64_t tick = [self tickOf:deadline];
+    if (tick < entry->tick && entry->tick > currentTick + 1) {
+        [self unlink:entry];
+        [self link:entry tick:tick];
+    }
+}
+
+- (void)cancelKey:(id<NSCopying>)key {
+    SBTimerWheelEntry *entry = entries[key];
+    if (entry) {
+        [self unlink:entry];
+        [entries removeObjectForKey:key];
+    }
+}
+
+- (NSTimeInterval)deadlineForKey:(id<NSCopying>)key {
+    SBTimerWheelEntry *entry = entries[key];
+    return entry ? entry->deadline : 0;
+}
+
+- (void)removeAllKeys {
+    // one by one, releasing a long list from its head would recurse through all of it
+    for (NSUInteger slot = 0; slot < slotCount; slot++) {
+        SBTimerWheelEntry *entry = slots[slot];
+        slots[slot] = nil;
+        while (entry) {
+            SBTimerWheelEntry *next = entry->next;
+            entry->next = nil;
+            entry->previous = nil;
+            entry = next;
+        }
+    }
+    [entries removeAllObjects];
+}
+
+#pragma mark - Expiry
+
+- (NSArray *)advanceTo:(NSTimeInterval)now {
+    // only whole ticks are handled: everything filed before `target` is at or past its deadline
+    int64_t target = [self tickOf:now];
+    if (target <= currentTick + 1) {
+        return @[];
+    }
+    NSMutableArray <SBTimerWheelEntry *> *expired = nil;
+    // after a long gap one turn visits every slot
+    int64_t last = MIN(target - 1, currentTick + (int64_t)slotCount);
+    for (int64_t tick = currentTick + 1; tick <= last; tick++) {
+        SBTimerWheelEntry *entry = slots[(NSUInteger)(tick % (int64_t)slotCount)];
+        while (entry) {
+            SBTimerWheelEntry *next = entry->next;
+            // later turns of the wheel stay
+            if (entry->tick < target) {
+                int64_t due = [self tickOf:entry->deadline];
+                if (due < target) {
+                    [self unlink:entry];
+                    if (!expired) {
+                        expired = [NSMutableArray new];
+                    }
+                    [expired addObject:entry];
+                } else if (due % (int64_t)slotCount == tick % (int64_t)slotCount) {
+                    // same slot, a later turn
+                    entry->tick = due;
+                } else {
+                    // filed past `target`, so the loop skips it should it reach that slot again
+                    [self unlink:entry];
+                    [self link:entry tick:due];
+                }
+            }
+            entry = next;
+        }
+    }
+    currentTick = target - 1;
+    //
+    if (!expired) {
+        return @[];
+    }
+    [expired sortUsingComparator:^NSComparisonResult(SBTimerWheelEntry *a, SBTimerWheelEntry *b) {
+        return a->deadline < b->deadline ? NSOrderedAscending : (a->deadline > b->deadline ? NSOrderedDescending : NSOrderedSame);
+    }];
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:expired.count];
+    for (SBTimerWheelEntry *entry in expired) {
+        [keys addObject:entry->key];
+        [entries removeObjectForKey:entry->key];
+    }
+    return keys;
+}
+
+@end
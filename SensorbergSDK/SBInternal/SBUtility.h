@@ -35,6 +35,7 @@
 @property (strong, nonatomic) NSString *app;
 @end
 
+// APIDateFormat, not thread safe: the SDK parses and formats with SBISO8601, this is only left for years outside 0...9999
 extern NSDateFormatter  *dateFormatter;
 
 extern UICKeyChainStore *keychain;
@@ -58,3 +59,35 @@ extern NSString *const  kCacheKey;
 + (SBMUserAgent *)userAgent;
 
 @end
+
+/**
+ *  CRC-32 (IEEE 802.3), the checksum of the SDK's own files
+ */
+uint32_t SBCRC32(const uint8_t *bytes, size_t length);
+
+/**
+ *  Write-behind of a persisted object: the changes of `delay` seconds go to disk in one write.
+ *  The write block runs on `queue`, it takes its snapshot itself.
+ */
+@interface SBDeferredWrite : NSObject
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue delay:(NSTimeInterval)delay write:(dispatch_block_t)write;
+
+/**
+ *  Call after every change, the write runs once per `delay`
+ */
+- (void)schedule;
+
+/**
+ *  Drops the pending write, when there is nothing left to write (or the owner writes itself)
+ *
+ *  @return YES if a write was pending
+ */
+- (BOOL)cancel;
+
+/**
+ *  Runs the pending write now, waits for it. Not from `queue`.
+ */
+- (void)flush;
+
+@end
@@ -92,3 +92,88 @@ NSString *const kCacheKey = @"cacheKey";
 }
 
 @end
+
+uint32_t SBCRC32(const uint8_t *bytes, size_t length) {
+    static uint32_t table[256];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    });
+    //
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+#pragma mark - SBDeferredWrite
+
+@interface SBDeferredWrite () {
+    dispatch_queue_t queue;
+    NSTimeInterval delay;
+    dispatch_block_t write;
+    // guarded by @synchronized(self)
+    BOOL scheduled;
+}
+
+@end
+
+@implementation SBDeferredWrite
+
+- (instancetype)initWithQueue:(dispatch_queue_t)writeQueue delay:(NSTimeInterval)writeDelay write:(dispatch_block_t)writeBlock {
+    self = [super init];
+    if (self) {
+        queue = writeQueue;
+        delay = writeDelay;
+        write = [writeBlock copy];
+    }
+    return self;
+}
+
+- (void)schedule {
+    @synchronized (self) {
+        if (scheduled) {
+            return;
+        }
+        scheduled = YES;
+    }
+    __weak __typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), queue, ^{
+        [weakSelf writeIfScheduled];
+    });
+}
+
+- (BOOL)cancel {
+    @synchronized (self) {
+        BOOL pending = scheduled;
+        scheduled = NO;
+        return pending;
+    }
+}
+
+- (void)flush {
+    dispatch_sync(queue, ^{
+        [self writeIfScheduled];
+    });
+}
+
+// on queue
+- (void)writeIfScheduled {
+    @synchronized (self) {
+        if (!scheduled) {
+            return;
+        }
+        scheduled = NO;
+    }
+    // a change from here on schedules the next write
+    write();
+}
+
+@end
@@ -235,6 +235,81 @@
  */
 - (void)reportConversion:(SBConversionType)type forCampaignAction:(NSString*)action;
 
+/**
+ *  Asynchronous event delivery
+ *
+ *  @discussion By default an event published from a background thread waits until the main thread has handled it.
+ *  When enabled, publishing never waits: the delegate gets the events in batches on the main queue and the SDK's analytics
+ *  handle theirs on a private serial queue. Each subscriber still sees the events in the order they were published.
+ *
+ *  @since 2.5
+ */
+@property (nonatomic) BOOL asynchronousEventDelivery;
+
+/**
+ *  Batch interval of the ranging and Bluetooth events
+ *
+ *  @discussion Ranged beacons are published as one SBEventRangedBeacons and discovered or updated peripherals as one SBEventDevicesUpdated per interval,
+ *  each beacon or peripheral listed once with its latest values. Defaults to 1 second.
+ *
+ *  @since 2.5
+ */
+@property (nonatomic) NSTimeInterval eventBatchInterval;
+
+/**
+ *  Per-item ranging and Bluetooth events
+ *
+ *  @discussion When enabled, SBEventRangedBeacon is also published for every beacon of every ranging callback, SBEventDeviceDiscovered for every advertisement
+ *  and SBEventDeviceUpdated for every update, in addition to the batched events. Defaults to NO.
+ *
+ *  @since 2.5
+ */
+@property (nonatomic) BOOL publishesPerItemEvents;
+
+/**
+ *  SDK-side delivery of delayed campaigns
+ *
+ *  @discussion Campaigns with a delay or a deliverAt date are published as SBEventPerformAction with their fireDate set when triggered,
+ *  and the app is left to deliver them. When enabled, the SDK holds them instead and publishes them at their fireDate, also after the app
+ *  was terminated and launched again. A campaign that fired meanwhile and is suppressed (sendOnlyOnce, suppressionTime) is dropped.
+ *  The pending deliveries are kept while disabled. Defaults to NO.
+ *
+ *  @since 2.5
+ */
+@property (nonatomic) BOOL schedulesDelayedActions;
+
+/**
+ *  Start recording event bus statistics
+ *
+ *  @discussion Counts the publishes of every event class and times every subscriber method, see `eventStatistics`.
+ *  Calling it again starts over with empty statistics.
+ *
+ *  @param interval Seconds between dumps of the statistics to the debug log, 0 for none
+ *
+ *  @since 2.5
+ */
+- (void)startEventInstrumentationWithLogInterval:(NSTimeInterval)interval;
+
+/**
+ *  Stop recording event bus statistics, and drop them
+ *
+ *  @since 2.5
+ */
+- (void)stopEventInstrumentation;
+
+/**
+ *  Event bus statistics recorded since `startEventInstrumentationWithLogInterval:`
+ *
+ *  @discussion Keyed by event class name, each value holds `publishes` (NSNumber) and `handlers`: a dictionary keyed by
+ *  "<subscriber class> <selector>" with `count`, `total`, `max`, `p50`, `p90` and `p99`. Times are in seconds,
+ *  the percentiles are accurate to 12.5%. Empty when the instrumentation isn't running.
+ *
+ *  @return A snapshot of the statistics
+ *
+ *  @since 2.5
+ */
+- (NSDictionary <NSString *, NSDictionary *> *)eventStatistics;
+
 - (instancetype)init __attribute__((unavailable("use [SBManager sharedManager]")));
 
 - (instancetype)new __attribute__((unavailable("use [SBManager sharedManager]")));
@@ -282,7 +357,8 @@
 /**
  *  SBEventRangedBeacons
  *
- *  Event fired when a beacon has been ranged. The resulting event contains the beacon (`SBMBeacon`), proximity, accuracy and RSSI values
+ *  Event fired once per `eventBatchInterval` with the beacons ranged during that interval: `beacons` holds one SBEventRangedBeacon
+ *  per beacon (`SBMBeacon`), with the latest proximity, accuracy and RSSI values
  *
  *  @since 2.0
  */
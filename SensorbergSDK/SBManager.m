@@ -34,7 +34,19 @@
 
 #import "SBInternalEvents.h"
 
+#import "SBLayoutDiff.h"
+
+#import "SBRegionScheduler.h"
+
+#import "SBFireHistory.h"
+#import "SBCampaignScheduler.h"
+#import "SBSessionStore.h"
+
+#import "SBEventBus.h"
+#import "SBEventBusInstrumentation.h"
+
 #import "SBUtility.h"
+#import "SBISO8601.h"
 #import "SBSettings.h"
 #import "NSString+SBUUID.h"
 
@@ -44,6 +56,8 @@
 
 #import <tolo/Tolo.h>
 
+#import <objc_geohash/GeoHash.h>
+
 #pragma mark - Constants
 
 static const NSInteger kSBMaxMonitoringRegionCount = 20;
@@ -64,6 +78,11 @@ static const NSInteger kSBMaxMonitoringRegionCount = 20;
     SBMGetLayout    *layout;
     
     NSDictionary    *targetAttributes;
+    
+    SBRegionScheduler   *regionScheduler;
+    dispatch_source_t   rotationTimer;
+    
+    SBCampaignScheduler *campaignScheduler;
 }
 
 @end
@@ -111,12 +130,26 @@ static dispatch_once_t once;
     //
     [keychain removeAllItems];
     keychain = nil;
+    [[SBFireHistory sharedHistory] removeAllFires];
+    if (campaignScheduler) {
+        [campaignScheduler removeAllCampaigns];
+        campaignScheduler = nil;
+    } else {
+        // pending on disk while scheduling is off, they'd come back with it
+        [[NSFileManager defaultManager] removeItemAtPath:[SBCampaignScheduler defaultPath] error:nil];
+    }
+    // the next client would carry on with these sessions, and never enter their beacons
+    if (locClient) {
+        [locClient removeAllSessions];
+    } else {
+        [[NSFileManager defaultManager] removeItemAtPath:[SBSessionStore defaultPath] error:nil];
+    }
     //
-    UNREGISTER();
-    [[Tolo sharedInstance] unsubscribe:anaClient];
-    [[Tolo sharedInstance] unsubscribe:apiClient];
-    [[Tolo sharedInstance] unsubscribe:locClient];
-    [[Tolo sharedInstance] unsubscribe:bleClient];
+    SB_UNREGISTER();
+    [[SBEventBus sharedInstance] unsubscribe:anaClient];
+    [[SBEventBus sharedInstance] unsubscribe:apiClient];
+    [[SBEventBus sharedInstance] unsubscribe:locClient];
+    [[SBEventBus sharedInstance] unsubscribe:bleClient];
     //
     anaClient = nil;
     apiClient = nil;
@@ -125,7 +158,7 @@ static dispatch_once_t once;
     //
     [[NSNotificationCenter defaultCenter] removeObserver:self];
     //
-    PUBLISH([SBEventResetManager new]);
+    SB_PUBLISH([SBEventResetManager new]);
 }
 
 - (instancetype)init
@@ -135,20 +168,25 @@ static dispatch_once_t once;
         //
         if (isNull(locClient)) {
             locClient = [SBLocation new];
-            [[Tolo sharedInstance] subscribe:locClient];
+            [[SBEventBus sharedInstance] subscribe:locClient];
         }
         //
         if (isNull(bleClient)) {
             bleClient = [SBBluetooth sharedManager];
-            [[Tolo sharedInstance] subscribe:bleClient];
+            [[SBEventBus sharedInstance] subscribe:bleClient];
+        }
+        //
+        if (isNull(regionScheduler)) {
+            regionScheduler = [[SBRegionScheduler alloc] initWithCapacity:kSBMaxMonitoringRegionCount];
         }
         //
         if (isNull(anaClient)) {
             anaClient = [SBAnalytics new];
-            [[Tolo sharedInstance] subscribe:anaClient];
+            // only matters with asynchronous delivery, the analytics don't need the main thread
+            [[SBEventBus sharedInstance] subscribe:anaClient queue:[SBEventBus internalQueue]];
         }
         //
-        REGISTER();
+        SB_REGISTER();
         // set the latency to a negative value before the first health check
         ping = -1;
         [apiClient ping];
@@ -197,21 +235,24 @@ static dispatch_once_t once;
     //
     keychain.accessibility = UICKeyChainStoreAccessibilityAlways;
     keychain.synchronizable = YES;
+    // the campaign fires used to be kept in the keychain
+    [[SBFireHistory sharedHistory] migrateFromKeychain:keychain];
     //
     SBAPIKey = apiKey.length ? apiKey : kSBDefaultAPIKey;
     //
     if (isNull(apiClient)) {
         apiClient = [[SBResolver alloc] initWithApiKey:SBAPIKey];
-        [[Tolo sharedInstance] subscribe:apiClient];
+        apiClient.campaignScheduler = campaignScheduler;
+        [[SBEventBus sharedInstance] subscribe:apiClient];
         
         // publish event
         SBEventUpdateTargetAttributes *event = [SBEventUpdateTargetAttributes new];
         event.targetAttributes = targetAttributes;
-        PUBLISH(event);
+        SB_PUBLISH(event);
     }
     //
     if (!isNull(delegate)) {
-        [[Tolo sharedInstance] subscribe:delegate];
+        [[SBEventBus sharedInstance] subscribe:delegate];
     }
     //
     [apiClient requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
@@ -221,6 +262,67 @@ static dispatch_once_t once;
     SBLog(@"👍 Sensorberg SDK [%@]",[SBUtility userAgent].sdk);
 }
 
+#pragma mark - Event delivery
+
+- (void)setAsynchronousEventDelivery:(BOOL)asynchronousEventDelivery {
+    [SBEventBus sharedInstance].deliveryMode = asynchronousEventDelivery ? SBEventBusDeliveryAsynchronous : SBEventBusDeliverySynchronous;
+}
+
+- (BOOL)asynchronousEventDelivery {
+    return [SBEventBus sharedInstance].deliveryMode == SBEventBusDeliveryAsynchronous;
+}
+
+- (void)startEventInstrumentationWithLogInterval:(NSTimeInterval)interval {
+    SBEventBusInstrumentation *instrumentation = [SBEventBusInstrumentation new];
+    instrumentation.logInterval = interval;
+    [SBEventBus sharedInstance].instrumentation = instrumentation;
+}
+
+- (void)stopEventInstrumentation {
+    [SBEventBus sharedInstance].instrumentation = nil;
+}
+
+- (NSDictionary<NSString *,NSDictionary *> *)eventStatistics {
+    return [[SBEventBus sharedInstance].instrumentation snapshot] ?: @{};
+}
+
+#pragma mark - Event batching
+
+- (void)setEventBatchInterval:(NSTimeInterval)eventBatchInterval {
+    locClient.batchInterval = eventBatchInterval;
+    bleClient.batchInterval = eventBatchInterval;
+}
+
+- (NSTimeInterval)eventBatchInterval {
+    return locClient.batchInterval;
+}
+
+- (void)setPublishesPerItemEvents:(BOOL)publishesPerItemEvents {
+    locClient.publishesRangedBeacon = publishesPerItemEvents;
+    bleClient.publishesDeviceEvents = publishesPerItemEvents;
+}
+
+- (BOOL)publishesPerItemEvents {
+    return locClient.publishesRangedBeacon;
+}
+
+#pragma mark - Campaign scheduling
+
+- (void)setSchedulesDelayedActions:(BOOL)schedulesDelayedActions {
+    if (schedulesDelayedActions == (campaignScheduler != nil)) {
+        return;
+    }
+    // the pending deliveries stay on disk while disabled, with the changes of the last second
+    [campaignScheduler synchronize];
+    campaignScheduler = schedulesDelayedActions ? [[SBCampaignScheduler alloc] initWithPath:[SBCampaignScheduler defaultPath]] : nil;
+    apiClient.campaignScheduler = campaignScheduler;
+    [layout setCampaignScheduler:campaignScheduler];
+}
+
+- (BOOL)schedulesDelayedActions {
+    return campaignScheduler != nil;
+}
+
 #pragma mark - Resolver methods
 
 - (NSString *)resolverURL
@@ -367,10 +469,15 @@ SUBSCRIBE(SBEventPing) {
 
 - (void)startMonitoring:(NSArray <NSString*>*)UUIDs {
     [locClient startMonitoring:UUIDs];
+    [self startRegionRotation];
 }
 
 - (void)stopMonitoring {
     [locClient stopMonitoring];
+    if (rotationTimer) {
+        dispatch_source_cancel(rotationTimer);
+        rotationTimer = nil;
+    }
 }
 
 - (void)setIDFAValue:(NSString*)IDFA {
@@ -380,7 +487,7 @@ SUBSCRIBE(SBEventPing) {
         [keychain removeItemForKey:kIDFA];
     }
     //
-    PUBLISH([SBEventUpdateHeaders new]);
+    SB_PUBLISH([SBEventUpdateHeaders new]);
 }
 
 - (void)setTargetAttributes:(NSDictionary*)attributes {
@@ -388,7 +495,7 @@ SUBSCRIBE(SBEventPing) {
     //
     SBEventUpdateTargetAttributes *event = [SBEventUpdateTargetAttributes new];
     event.targetAttributes = attributes;
-    PUBLISH(event);
+    SB_PUBLISH(event);
 }
 
 - (void)reportConversion:(SBConversionType)type forCampaignAction:(NSString *)action {
@@ -396,7 +503,7 @@ SUBSCRIBE(SBEventPing) {
         return;
     }
     //
-    PUBLISH((({
+    SB_PUBLISH((({
         SBEventReportConversion *event = [SBEventReportConversion new];
         event.action = action;
         event.conversionType = type;
@@ -424,21 +531,29 @@ SUBSCRIBE(SBEventGetLayout) {
         return;
     }
     
-    if (layout && [layout.toDictionary isEqualToDictionary:event.layout.toDictionary])
-    {
-        return;
+    // also when it's dropped as unchanged: the resolver keeps checking the campaigns of its own copy
+    [event.layout setCampaignScheduler:campaignScheduler];
+    SBLayoutDiff *diff = nil;
+    if (layout && event.layout) {
+        diff = [SBLayoutDiff diffFromLayout:layout toLayout:event.layout];
+        if (diff.isEmpty) {
+            return;
+        }
+        SBLog(@"👍 Layout changed %@", diff);
     }
     
     //
     SBLog(@"👍 GET layout");
     layout = event.layout;
+    [layout setCampaignScheduler:campaignScheduler];
     //
     if (delay>3) {
-        PUBLISH([SBEventReportHistory new]);
+        SB_PUBLISH([SBEventReportHistory new]);
     }
     //
     if (locClient.isMonitoring) {
-        [self startMonitoring];
+        // only the regions that were added or dropped are touched, so coverage of the others never lapses
+        [locClient updateMonitoredRegions:[self monitoringBeaconRegions]];
     }
     //
     delay = 0.1f;
@@ -467,8 +582,31 @@ SUBSCRIBE(SBEventRangedBeacon) {
     //
 }
 
+SUBSCRIBE(SBEventRangedBeacons) {
+    NSTimeInterval now = [NSDate date].timeIntervalSince1970;
+    for (SBEventRangedBeacon *ranged in event.beacons) {
+        [regionScheduler recordSightingOfBeacon:ranged.beacon.fullUUID now:now];
+    }
+    [self rotateMonitoredRegionsIfDue];
+}
+
+#pragma mark SBEventLocationUpdated
+SUBSCRIBE(SBEventLocationUpdated) {
+    if (event.location) {
+        regionScheduler.currentGeohash = [GeoHash hashForLatitude:event.location.coordinate.latitude
+                                                        longitude:event.location.coordinate.longitude
+                                                           length:(unsigned int)regionScheduler.geohashPrecision];
+    }
+    [self rotateMonitoredRegionsIfDue];
+}
+
 #pragma mark SBEventRegionEnter
 SUBSCRIBE(SBEventRegionEnter) {
+    if (!event.beacon) {
+        // geo regions have no campaigns in the layout yet
+        SBLog(@"👀 %@",event.geohash);
+        return;
+    }
     SBLog(@"👀 %@",[event.beacon description]);
     //
     SBTriggerType triggerType = kSBTriggerEnter;
@@ -482,6 +620,11 @@ SUBSCRIBE(SBEventRegionEnter) {
 
 #pragma mark SBEventRegionExit
 SUBSCRIBE(SBEventRegionExit) {
+    if (!event.beacon) {
+        // geo regions have no campaigns in the layout yet
+        SBLog(@"🏁 %@",event.geohash);
+        return;
+    }
     SBLog(@"🏁 %@",[event.beacon description]);
     //
     SBTriggerType triggerType = kSBTriggerExit;
@@ -498,7 +641,7 @@ SUBSCRIBE(SBEventReportHistory) {
     if (!event.forced) {
         NSString *lastPostString = [keychain stringForKey:kPostLayout];
         if (!isNull(lastPostString)) {
-            NSDate *lastPostDate = [dateFormatter dateFromString:lastPostString];
+            NSDate *lastPostDate = SBISO8601DateFromString(lastPostString);
             if (!isNull(lastPostDate)) {
                 if ([[NSDate date] timeIntervalSinceDate:lastPostDate] < [SBSettings sharedManager].settings.postSuppression) {
                     return;
@@ -517,7 +660,7 @@ SUBSCRIBE(SBEventReportHistory) {
         SBLog(@"❓ POST layout");
         //
         // Set lastPost timestamp
-        NSString *lastPostString = [dateFormatter stringFromDate:[NSDate date]];
+        NSString *lastPostString = SBISO8601StringFromDate([NSDate date]);
         [keychain setString:lastPostString forKey:kPostLayout];
         //
         [apiClient postLayout:postData];
@@ -527,27 +670,27 @@ SUBSCRIBE(SBEventReportHistory) {
 #pragma mark - Application lifecycle
 
 - (void)applicationDidFinishLaunchingWithOptions:(NSNotification *)notification {
-    PUBLISH([SBEventApplicationLaunched new]);
+    SB_PUBLISH([SBEventApplicationLaunched new]);
 }
 
 - (void)applicationDidBecomeActive:(NSNotification *)notification {
-    PUBLISH([SBEventApplicationActive new]);
+    SB_PUBLISH([SBEventApplicationActive new]);
 }
 
 - (void)applicationWillResignActive:(NSNotification *)notification {
-    PUBLISH([SBEventApplicationWillResignActive new]);
+    SB_PUBLISH([SBEventApplicationWillResignActive new]);
 }
 
 - (void)applicationWillTerminate:(NSNotification *)notification {
-    PUBLISH([SBEventApplicationWillTerminate new]);
+    SB_PUBLISH([SBEventApplicationWillTerminate new]);
 }
 
 - (void)applicationWillEnterForeground:(NSNotification *)notification {
-    PUBLISH([SBEventApplicationWillEnterForeground new]);
+    SB_PUBLISH([SBEventApplicationWillEnterForeground new]);
 }
 
 - (void)applicationDidEnterBackground:(NSNotification *)notification {
-    PUBLISH([SBEventApplicationDidEnterBackground new]);
+    SB_PUBLISH([SBEventApplicationDidEnterBackground new]);
 }
 
 #pragma mark - Application events
@@ -559,12 +702,12 @@ SUBSCRIBE(SBEventPerformAction) {
 
 #pragma mark SBEventApplicationActive
 SUBSCRIBE(SBEventApplicationActive) {
-    PUBLISH([SBEventReportHistory new]);
+    SB_PUBLISH([SBEventReportHistory new]);
 }
 
 #pragma mark SBEventApplicationDidEnterBackground
 SUBSCRIBE(SBEventApplicationDidEnterBackground) {
-    PUBLISH(({
+    SB_PUBLISH(({
         SBEventReportHistory *reportEvent = [SBEventReportHistory new];
         reportEvent.forced = YES;
         reportEvent;
@@ -590,54 +733,80 @@ SUBSCRIBE(SBSettingEvent)
 
 - (NSArray * _Nonnull)monitoringBeaconRegions
 {
-    NSMutableSet *proximityUUIDSet = [NSMutableSet new];
+    // more candidates than the OS monitors: the scheduler ranks them and rotates the rest in and out
+    NSTimeInterval now = [NSDate date].timeIntervalSince1970;
+    [regionScheduler setCandidates:[self candidateBeaconRegions] campaignCounts:[self campaignCountsOfRegions] now:now];
+    return [regionScheduler regionsAt:now];
+}
+
+- (NSArray <NSString *> *)candidateBeaconRegions
+{
+    NSMutableOrderedSet *proximityUUIDSet = [NSMutableOrderedSet new];
     //
     if (isNull(layout) || layout.accountProximityUUIDs.count==0) {
         for (NSString *proximityUUIDString in [SBSettings sharedManager].settings.customBeaconRegions.allKeys)
         {
-            if (proximityUUIDSet.count<kSBMaxMonitoringRegionCount) {
-                [proximityUUIDSet addObject:[[NSString stripHyphensFromUUIDString:proximityUUIDString] lowercaseString]];
-            }
+            [proximityUUIDSet addObject:[[NSString stripHyphensFromUUIDString:proximityUUIDString] lowercaseString]];
         }
-        return proximityUUIDSet.allObjects;
+        return proximityUUIDSet.array;
     }
     //
-    NSMutableSet *proximityBeacons = [NSMutableSet new];
-    //
-    for (SBMAction *action in layout.actions) {
-        for (SBMBeacon *bid in action.beacons) {
-            [proximityBeacons addObject:bid.fullUUID];
+    if ([SBSettings sharedManager].settings.enableBeaconScanning) {
+        for (SBMAction *action in layout.actions) {
+            for (SBMBeacon *bid in action.beacons) {
+                [proximityUUIDSet addObject:bid.fullUUID];
+            }
         }
     }
     
-    if ([SBSettings sharedManager].settings.enableBeaconScanning &&
-        proximityBeacons.count<kSBMaxMonitoringRegionCount) {
-        //
-        [proximityUUIDSet addObjectsFromArray:[proximityBeacons allObjects]];
-        
-        for (NSString *region in layout.accountProximityUUIDs)
-        {
-            if (proximityUUIDSet.count < kSBMaxMonitoringRegionCount) {
-                [proximityUUIDSet addObject:[[NSString stripHyphensFromUUIDString:region] lowercaseString]];
-            } else {
-                return proximityUUIDSet.allObjects;
-            }
-        }
-        
-    } else {
-        [proximityUUIDSet addObjectsFromArray:layout.accountProximityUUIDs];
+    for (NSString *region in layout.accountProximityUUIDs)
+    {
+        [proximityUUIDSet addObject:[[NSString stripHyphensFromUUIDString:region] lowercaseString]];
     }
     
     for (NSString *proximityUUIDString in [SBSettings sharedManager].settings.customBeaconRegions.allKeys)
     {
-        if (proximityUUIDSet.count < kSBMaxMonitoringRegionCount) {
-            [proximityUUIDSet addObject:[[NSString stripHyphensFromUUIDString:proximityUUIDString] lowercaseString]];
-        } else {
-            break;
+        [proximityUUIDSet addObject:[[NSString stripHyphensFromUUIDString:proximityUUIDString] lowercaseString]];
+    }
+
+    return proximityUUIDSet.array;
+}
+
+// campaigns per beacon region and per proximity UUID region
+- (NSDictionary <NSString *, NSNumber *> *)campaignCountsOfRegions
+{
+    NSMutableDictionary *counts = [NSMutableDictionary new];
+    for (SBMAction *action in layout.actions) {
+        for (SBMBeacon *bid in action.beacons) {
+            counts[bid.fullUUID] = @([counts[bid.fullUUID] unsignedIntegerValue] + 1);
+            counts[bid.uuid] = @([counts[bid.uuid] unsignedIntegerValue] + 1);
         }
     }
+    return counts;
+}
 
-    return proximityUUIDSet.allObjects;
+- (void)startRegionRotation
+{
+    if (rotationTimer) {
+        return;
+    }
+    // while the app runs; in the background the ranging and location events drive it
+    rotationTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    uint64_t interval = (uint64_t)(regionScheduler.rotationInterval * NSEC_PER_SEC);
+    dispatch_source_set_timer(rotationTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval, interval / 10);
+    __weak SBManager *weakSelf = self;
+    dispatch_source_set_event_handler(rotationTimer, ^{
+        [weakSelf rotateMonitoredRegionsIfDue];
+    });
+    dispatch_resume(rotationTimer);
+}
+
+- (void)rotateMonitoredRegionsIfDue
+{
+    if (!locClient.isMonitoring || ![regionScheduler isSelectionDueAt:[NSDate date].timeIntervalSince1970]) {
+        return;
+    }
+    [locClient updateMonitoredRegions:[self monitoringBeaconRegions]];
 }
 
 @end
@@ -38,7 +38,7 @@
     A wrapper of the CLBeacon object to make accessing properties easier
  */
 @protocol SBMBeacon @end
-@interface SBMBeacon : NSObject
+@interface SBMBeacon : NSObject <NSCopying>
 @property (strong, nonatomic) NSString *uuid;
 @property (nonatomic) int major;
 @property (nonatomic) int minor;
@@ -29,6 +29,8 @@
 
 #import "NSString+SBUUID.h"
 
+#import "SBBeaconKey.h"
+
 emptyImplementation(SBModel)
 
 @implementation SBMCampaignAction
@@ -37,19 +39,40 @@ emptyImplementation(SBModel)
 
 #pragma mark - SBPeripheral
 
+@interface SBMBeacon () {
+    // the identity is kept packed, the string forms are only built when asked for
+    uint8_t _uuidBytes[16];
+    BOOL _hasUUIDBytes;
+    NSString *_rawUUID; // only set when the uuid is not 32 hex characters
+    NSUInteger _hash;
+}
+@property (atomic, strong) NSString *cachedUUID;
+@property (atomic, strong) NSString *cachedFullUUID;
+@property (nonatomic, readonly) BOOL hasBeaconKey;
+@end
+
 @implementation SBMBeacon
 
 - (instancetype)initWithCLBeacon:(CLBeacon*)beacon {
     self = [super init];
     if (self) {
-        self.uuid = [[NSString stripHyphensFromUUIDString:beacon.proximityUUID.UUIDString] lowercaseString];
-        self.major = [beacon.major intValue];
-        self.minor = [beacon.minor intValue];
+        if (beacon.proximityUUID) {
+            [beacon.proximityUUID getUUIDBytes:_uuidBytes];
+            _hasUUIDBytes = YES;
+        }
+        _major = [beacon.major intValue];
+        _minor = [beacon.minor intValue];
+        [self identityChanged];
     }
     return self;
 }
 
 - (instancetype)initWithString:(NSString *)fullUUID {
+    SBBeaconKey key;
+    if (SBBeaconKeyParseFullUUID(fullUUID, &key)) {
+        return [self initWithBeaconKey:key];
+    }
+    //
     self = [super init];
     if (self) {
         NSString *tmpUUID = [fullUUID stringByReplacingOccurrencesOfString:@"-" withString:@""];
@@ -72,6 +95,58 @@ emptyImplementation(SBModel)
     return self;
 }
 
+#pragma mark - Identity
+
+- (NSString *)uuid {
+    if (!_hasUUIDBytes) {
+        return _rawUUID;
+    }
+    NSString *uuid = self.cachedUUID;
+    if (!uuid) {
+        SBBeaconKey key;
+        memcpy(key.uuid, _uuidBytes, sizeof(_uuidBytes));
+        uuid = SBBeaconKeyUUIDString(&key);
+        self.cachedUUID = uuid;
+    }
+    return uuid;
+}
+
+- (void)setUuid:(NSString *)uuid {
+    _hasUUIDBytes = SBBeaconKeyParseUUID(uuid, _uuidBytes);
+    _rawUUID = _hasUUIDBytes ? nil : uuid;
+    [self identityChanged];
+}
+
+- (void)setMajor:(int)major {
+    _major = major;
+    [self identityChanged];
+}
+
+- (void)setMinor:(int)minor {
+    _minor = minor;
+    [self identityChanged];
+}
+
+- (BOOL)hasBeaconKey {
+    return _hasUUIDBytes && _major >= 0 && _major <= UINT16_MAX && _minor >= 0 && _minor <= UINT16_MAX;
+}
+
+- (void)identityChanged {
+    self.cachedUUID = nil;
+    self.cachedFullUUID = nil;
+    //
+    SBBeaconKey key;
+    if ([self getBeaconKey:&key]) {
+        _hash = SBBeaconKeyHash(&key);
+    } else {
+        _hash = _rawUUID.hash ^ ((NSUInteger)_major << 16) ^ (NSUInteger)_minor;
+    }
+}
+
+- (NSUInteger)hash {
+    return _hash;
+}
+
 - (BOOL)isEqual:(SBMBeacon*)object
 {
     if (self == object)
@@ -84,16 +159,56 @@ emptyImplementation(SBModel)
         return NO;
     }
     
+    if (_hash != object->_hash)
+    {
+        return NO;
+    }
+    
+    if (self.hasBeaconKey && object.hasBeaconKey)
+    {
+        return self.major==object.major && self.minor==object.minor && memcmp(_uuidBytes, object->_uuidBytes, sizeof(_uuidBytes)) == 0;
+    }
+    
     return self.major==object.major && self.minor==object.minor && [self.uuid isEqualToString:object.uuid];
 }
 
+- (id)copyWithZone:(NSZone *)zone {
+    SBMBeacon *copy = [[[self class] allocWithZone:zone] init];
+    if (copy) {
+        memcpy(copy->_uuidBytes, _uuidBytes, sizeof(_uuidBytes));
+        copy->_hasUUIDBytes = _hasUUIDBytes;
+        copy->_rawUUID = _rawUUID;
+        copy->_major = _major;
+        copy->_minor = _minor;
+        copy->_hash = _hash;
+        copy.cachedUUID = self.cachedUUID;
+        copy.cachedFullUUID = self.cachedFullUUID;
+    }
+    return copy;
+}
+
 - (NSString*)fullUUID {
-    return [NSString stringWithFormat:@"%@%@%@", self.uuid, //uuid
-            [NSString stringWithFormat:@"%0*d",5,self.major], // major, padded with 0's to length 5
-            [NSString stringWithFormat:@"%0*d",5,self.minor]]; // minor, padded with 0's to length 5
+    NSString *fullUUID = self.cachedFullUUID;
+    if (fullUUID) {
+        return fullUUID;
+    }
+    //
+    SBBeaconKey key;
+    if ([self getBeaconKey:&key]) {
+        fullUUID = SBBeaconKeyFullUUIDString(&key);
+    } else {
+        fullUUID = [NSString stringWithFormat:@"%@%@%@", self.uuid, //uuid
+                    [NSString stringWithFormat:@"%0*d",5,self.major], // major, padded with 0's to length 5
+                    [NSString stringWithFormat:@"%0*d",5,self.minor]]; // minor, padded with 0's to length 5
+    }
+    self.cachedFullUUID = fullUUID;
+    return fullUUID;
 }
 
 - (NSUUID*)UUID {
+    if (_hasUUIDBytes) {
+        return [[NSUUID alloc] initWithUUIDBytes:_uuidBytes];
+    }
     return [[NSUUID alloc] initWithUUIDString:[NSString hyphenateUUIDString:self.uuid]];
 }
 
@@ -102,3 +217,29 @@ emptyImplementation(SBModel)
 }
 
 @end
+
+@implementation SBMBeacon (SBBeaconKey)
+
+- (instancetype)initWithBeaconKey:(SBBeaconKey)key {
+    self = [super init];
+    if (self) {
+        memcpy(_uuidBytes, key.uuid, sizeof(_uuidBytes));
+        _hasUUIDBytes = YES;
+        _major = key.major;
+        _minor = key.minor;
+        [self identityChanged];
+    }
+    return self;
+}
+
+- (BOOL)getBeaconKey:(SBBeaconKey *)key {
+    if (!key || !self.hasBeaconKey) {
+        return NO;
+    }
+    memcpy(key->uuid, _uuidBytes, sizeof(_uuidBytes));
+    key->major = (uint16_t)_major;
+    key->minor = (uint16_t)_minor;
+    return YES;
+}
+
+@end
@@ -61,6 +61,12 @@ void sbLogFuncObjC_impl(const char * f, int l, NSString * fmt, ...) NS_FORMAT_FU
 
 #define emptyImplementation(className)      @implementation className @end
 
+// the SDK's events go over its own bus, use these instead of Tolo's REGISTER / UNREGISTER / PUBLISH
+// to receive them (`SUBSCRIBE` and `PUBLISHER` are used as they are)
+#define SB_REGISTER()                       [[SensorbergSDK eventBus] subscribe:self]
+#define SB_UNREGISTER()                     [[SensorbergSDK eventBus] unsubscribe:self]
+#define SB_PUBLISH(_value_)                 [[SensorbergSDK eventBus] publish:_value_]
+
 /**
  *  This is the main header of the Sensorberg SDK. You need to import this file in all the classes where you use the SDK and all required classes will also be included.
  */
@@ -68,6 +74,12 @@ void sbLogFuncObjC_impl(const char * f, int l, NSString * fmt, ...) NS_FORMAT_FU
 
 + (NSString *)applicationIdentifier;
 
+/**
+ *  The event bus the SDK publishes on, a `Tolo` of its own (not `[Tolo sharedInstance]`).
+ *  Subscribe to the SDK events with `SB_REGISTER()`, or `[[SensorbergSDK eventBus] subscribe:object]`.
+ */
++ (Tolo *)eventBus;
+
 /*
  *  @method defaultBeaconRegions
  *
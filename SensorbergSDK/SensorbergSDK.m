@@ -25,6 +25,7 @@
 
 #import "SensorbergSDK.h"
 #import "SBSettings.h"
+#import "SBEventBus.h"
 
 // for deviceName
 #import <sys/utsname.h>
@@ -45,6 +46,10 @@ void sbLogFuncObjC_impl(const char * f, int l, NSString *fmt, ...) {
     return [[NSBundle mainBundle] objectForInfoDictionaryKey:(__bridge NSString*)kCFBundleIdentifierKey];
 }
 
++ (Tolo *)eventBus {
+    return [SBEventBus sharedInstance];
+}
+
 + (NSDictionary *)defaultBeaconRegions {
     return [[SBSettings sharedManager] settings].defaultBeaconRegions;
 }
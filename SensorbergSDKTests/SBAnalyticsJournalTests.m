@@ -0,0 +1,194 @@
+//
+//  SBAnalyticsJournalTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+
+#import "SBAnalyticsJournal.h"
+#import "SBInternalModels.h"
+
+@interface SBAnalyticsJournalTests : SBTestCase
+@property (nonatomic, copy) NSString *path;
+@end
+
+@implementation SBAnalyticsJournalTests
+
+- (void)setUp {
+    [super setUp];
+    self.continueAfterFailure = NO;
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.journal", [NSUUID UUID].UUIDString]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    self.path = nil;
+    [super tearDown];
+}
+
+- (SBMMonitorEvent *)monitorEventWithIndex:(NSUInteger)index {
+    SBMMonitorEvent *event = [SBMMonitorEvent new];
+    event.pid = [NSString stringWithFormat:@"7367672374000000ffff0000ffff0003%010lu", (unsigned long)index];
+    event.dt = [NSDate date];
+    event.trigger = kSBTriggerEnter;
+    event.location = @"u33dbfcyg";
+    return event;
+}
+
+- (unsigned long long)fileLength {
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:self.path error:nil] fileSize];
+}
+
+- (void)test000ReplayRestoresRecordsInOrder {
+    SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    [journal appendRecord:[self monitorEventWithIndex:0]];
+    SBMReportAction *action = [SBMReportAction new];
+    action.eid = @"367348a0dfa84492a0078ead26cf9385";
+    action.pid = @"7367672374000000ffff0000ffff00030000200747";
+    action.dt = [NSDate date];
+    action.trigger = kSBTriggerEnter;
+    [journal appendRecord:action];
+    SBMReportConversion *conversion = [SBMReportConversion new];
+    conversion.action = @"This Is the Test action.";
+    conversion.dt = [NSDate date];
+    conversion.type = kSBConversionSuccessful;
+    [journal appendRecord:conversion];
+    [journal synchronize];
+    
+    NSArray *records = [[SBAnalyticsJournal alloc] initWithPath:self.path].records;
+    XCTAssertEqual(records.count, 3);
+    XCTAssert([records[0] isKindOfClass:[SBMMonitorEvent class]]);
+    XCTAssertEqualObjects([records[1] eid], action.eid);
+    XCTAssertEqualObjects([records[2] action], conversion.action);
+}
+
+- (void)test001RemovedRecordsAreNotReplayed {
+    SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    NSMutableArray *events = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 10; i++) {
+        [events addObject:[self monitorEventWithIndex:i]];
+        [journal appendRecord:events.lastObject];
+    }
+    [journal removeRecords:[events subarrayWithRange:NSMakeRange(0, 4)]];
+    [journal synchronize];
+    
+    SBAnalyticsJournal *replayed = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    XCTAssertEqual(replayed.records.count, 6);
+    // the removed ones aren't held on to
+    XCTAssertEqual([[replayed valueForKey:@"recordIDs"] count], 6);
+    XCTAssertEqualObjects([replayed.records.firstObject pid], [events[4] pid]);
+    // replayed records can be removed as well
+    [replayed removeRecords:replayed.records];
+    [replayed synchronize];
+    XCTAssertEqual([self fileLength], 0);
+    XCTAssertEqual([[SBAnalyticsJournal alloc] initWithPath:self.path].records.count, 0);
+}
+
+- (void)test002TornTailIsTruncated {
+    SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    [journal appendRecord:[self monitorEventWithIndex:0]];
+    [journal appendRecord:[self monitorEventWithIndex:1]];
+    [journal synchronize];
+    journal = nil;
+    unsigned long long length = [self fileLength];
+    // simulate a crash halfway through the second record
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:self.path];
+    [handle truncateFileAtOffset:length - 10];
+    [handle closeFile];
+    
+    journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    XCTAssertEqual(journal.records.count, 1);
+    XCTAssert([self fileLength] < length - 10);
+    // appending after the truncation must keep the journal readable
+    [journal appendRecord:[self monitorEventWithIndex:2]];
+    [journal synchronize];
+    XCTAssertEqual([[SBAnalyticsJournal alloc] initWithPath:self.path].records.count, 2);
+}
+
+- (void)test003CorruptRecordStopsReplay {
+    SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    [journal appendRecord:[self monitorEventWithIndex:0]];
+    [journal synchronize];
+    unsigned long long length = [self fileLength];
+    [journal appendRecord:[self monitorEventWithIndex:1]];
+    [journal synchronize];
+    journal = nil;
+    // flip a payload byte of the second record
+    NSFileHandle *handle = [NSFileHandle fileHandleForUpdatingAtPath:self.path];
+    [handle seekToFileOffset:length + 20];
+    [handle writeData:[@"#" dataUsingEncoding:NSUTF8StringEncoding]];
+    [handle closeFile];
+    
+    XCTAssertEqual([[SBAnalyticsJournal alloc] initWithPath:self.path].records.count, 1);
+    XCTAssertEqual([self fileLength], length);
+}
+
+- (void)test004CompactionAfterRemoval {
+    SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    NSMutableArray *events = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 2000; i++) {
+        [events addObject:[self monitorEventWithIndex:i]];
+        [journal appendRecord:events.lastObject];
+    }
+    [journal synchronize];
+    unsigned long long length = [self fileLength];
+    
+    [journal removeRecords:[events subarrayWithRange:NSMakeRange(0, 1900)]];
+    [journal synchronize];
+    XCTAssert([self fileLength] < length / 5);
+    
+    NSArray *records = [[SBAnalyticsJournal alloc] initWithPath:self.path].records;
+    XCTAssertEqual(records.count, 100);
+    XCTAssertEqualObjects([records.firstObject pid], [events[1900] pid]);
+}
+
+#pragma mark - Benchmarks
+
+- (void)testPerformanceAppend {
+    NSMutableArray *events = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 10000; i++) {
+        [events addObject:[self monitorEventWithIndex:i]];
+    }
+    [self measureBlock:^{
+        [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+        SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+        for (SBMMonitorEvent *event in events) {
+            [journal appendRecord:event];
+        }
+        [journal synchronize];
+    }];
+}
+
+- (void)testPerformanceReplay {
+    SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:self.path];
+    for (NSUInteger i = 0; i < 10000; i++) {
+        [journal appendRecord:[self monitorEventWithIndex:i]];
+    }
+    [journal synchronize];
+    [self measureBlock:^{
+        XCTAssertEqual([[SBAnalyticsJournal alloc] initWithPath:self.path].records.count, 10000);
+    }];
+}
+
+@end
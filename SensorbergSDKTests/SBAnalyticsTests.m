@@ -24,11 +24,16 @@
 //
 
 #import "SBTestCase.h"
+#import "SensorbergSDK.h"
 #import "SBEvent.h"
 #import "SBAnalytics.h"
 #import "SBInternalEvents.h"
+#import "SBAnalyticsJournal.h"
 #import <tolo/Tolo.h>
 
+FOUNDATION_EXPORT NSString *const kSBIdentifier;
+FOUNDATION_EXPORT NSString *const kSBEvents;
+
 @interface SBMGetLayout (XCTests)
 - (SBMCampaignAction *)campainActionWithAction:(SBMAction *)action beacon:(SBMBeacon *)beacon trigger:(SBTriggerType)trigger;
 @end
@@ -44,11 +49,11 @@
     [super setUp];
     self.sut = [SBAnalytics new];
     self.sbBeacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00030000200747"];
-    [[Tolo sharedInstance] subscribe:self.sut];
+    [[SensorbergSDK eventBus] subscribe:self.sut];
 }
 
 - (void)tearDown {
-    [[Tolo sharedInstance] unsubscribe:self.sut];
+    [[SensorbergSDK eventBus] unsubscribe:self.sut];
     self.sbBeacon = nil;
     [super tearDown];
 }
@@ -58,7 +63,7 @@
     event.beacon = self.sbBeacon;
     event.location = [[CLLocation alloc] initWithLatitude:0 longitude:0];
     
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSArray <SBMMonitorEvent> *events = [self.sut events];
     BOOL hasEnteredBeacon = NO;
@@ -80,7 +85,7 @@
     event.beacon = self.sbBeacon;
     event.location = [[CLLocation alloc] initWithLatitude:0 longitude:0];
     
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSArray <SBMMonitorEvent> *events = [self.sut events];
     BOOL hasEnteredBeacon = NO;
@@ -132,7 +137,7 @@
     SBMGetLayout *newLayout = [[SBMGetLayout alloc] initWithDictionary:layoutDict error:nil];
     SBEventPerformAction *event = [SBEventPerformAction new];
     event.campaign = [newLayout campainActionWithAction:newLayout.actions[0] beacon:self.sbBeacon trigger:kSBTriggerEnter];
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSArray <SBMReportAction> *actions = [self.sut actions];
     BOOL hasReportAction = NO;
@@ -158,7 +163,7 @@
     event.action = eid;
     event.conversionType = kSBConversionSuccessful;
     
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSArray <SBMReportConversion> *conversions = [self.sut conversions];
     BOOL hasReportConversion = NO;
@@ -184,7 +189,7 @@
     event.action = eid;
     event.conversionType = kSBConversionIgnored;
     
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSArray <SBMReportConversion> *conversions = [self.sut conversions];
     BOOL hasReportConversion = NO;
@@ -227,7 +232,7 @@
 
 - (void)test006SBPostLayoutEvent
 {
-    PUBLISH(((( {SBEventPostLayout *event = [SBEventPostLayout new]; event;}))));
+    SB_PUBLISH(((( {SBEventPostLayout *event = [SBEventPostLayout new]; event;}))));
     NSArray <SBMReportAction> *actionsAfterEvent = [self.sut actions];
     NSArray <SBMReportConversion> *conversionsAfterEvent = [self.sut conversions];
     NSArray <SBMMonitorEvent> *eventsAfterEvent = [self.sut events];
@@ -239,14 +244,14 @@
 
 - (void)test006SBEventReportConversionWithError
 {
-    PUBLISH(((( {SBEventPostLayout *event = [SBEventPostLayout new]; event;}))));
+    SB_PUBLISH(((( {SBEventPostLayout *event = [SBEventPostLayout new]; event;}))));
     
     NSString *eid = @"This Is the Test eid.";
     SBEventReportConversion *event = [SBEventReportConversion new];
     event.action = eid;
     event.conversionType = kSBConversionSuccessful;
     event.error = [NSError new];
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSArray <SBMReportConversion> *conversions = [self.sut conversions];
     BOOL hasReportConversion = NO;
@@ -265,4 +270,39 @@
 }
 
 
+- (void)test007MigrationIsNotRepeatedAfterACrash
+{
+    [[SensorbergSDK eventBus] unsubscribe:self.sut];
+    self.sut = nil;
+    NSUserDefaults *defaults = [[NSUserDefaults alloc] initWithSuiteName:kSBIdentifier];
+    NSMutableArray *keyedEvents = [NSMutableArray new];
+    NSMutableSet *pids = [NSMutableSet new];
+    for (NSUInteger i = 0; i < 3; i++) {
+        SBMMonitorEvent *event = [SBMMonitorEvent new];
+        event.pid = [NSString stringWithFormat:@"7367672374000000ffff0000ffff0003%010lu", (unsigned long)(900 + i)];
+        event.dt = [NSDate dateWithTimeIntervalSince1970:1462096800.125 + i];
+        event.trigger = kSBTriggerEnter;
+        [keyedEvents addObject:[event toJSONString]];
+        [pids addObject:event.pid];
+    }
+    [defaults setObject:keyedEvents forKey:kSBEvents];
+    NSUInteger migrated;
+    @autoreleasepool {
+        migrated = [SBAnalytics new].events.count;
+    }
+    XCTAssertNil([defaults objectForKey:kSBEvents]);
+    // the launch died after the journal was written, before the keys were removed
+    [defaults setObject:keyedEvents forKey:kSBEvents];
+    @autoreleasepool {
+        XCTAssertEqual([SBAnalytics new].events.count, migrated);
+    }
+    XCTAssertNil([defaults objectForKey:kSBEvents]);
+    //
+    SBAnalyticsJournal *journal = [[SBAnalyticsJournal alloc] initWithPath:[SBAnalyticsJournal defaultPath]];
+    [journal removeRecords:[journal.records filteredArrayUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(JSONModel *record, NSDictionary *bindings) {
+        return [record isKindOfClass:[SBMMonitorEvent class]] && [pids containsObject:[(SBMMonitorEvent *)record pid]];
+    }]]];
+    [journal synchronize];
+}
+
 @end
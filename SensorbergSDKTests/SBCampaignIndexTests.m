@@ -0,0 +1,171 @@
+//
+//  SBCampaignIndexTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+
+#import "SBInternalModels.h"
+#import "SBCampaignIndex.h"
+
+static NSUInteger const kSBSyntheticActionCount = 10000;
+static NSUInteger const kSBSyntheticBeaconCount = 500;
+
+@interface SBCampaignIndexTests : SBTestCase
+@property (nonatomic, strong) NSArray <SBMBeacon *> *beacons;
+@property (nonatomic, strong) SBMGetLayout *layout;
+@end
+
+@implementation SBCampaignIndexTests
+
+- (void)setUp {
+    [super setUp];
+    self.continueAfterFailure = NO;
+    //
+    srand48(42);
+    NSMutableArray *beacons = [NSMutableArray arrayWithCapacity:kSBSyntheticBeaconCount];
+    for (NSUInteger i = 0; i < kSBSyntheticBeaconCount; i++) {
+        NSString *fullUUID = [NSString stringWithFormat:@"73676723740000%02luffff0000ffff0003%05lu%05lu", (unsigned long)(i % 8), (unsigned long)(i / 100), (unsigned long)(i % 100)];
+        [beacons addObject:[[SBMBeacon alloc] initWithString:fullUUID]];
+    }
+    self.beacons = beacons;
+    //
+    NSMutableArray *actions = [NSMutableArray arrayWithCapacity:kSBSyntheticActionCount];
+    for (NSUInteger i = 0; i < kSBSyntheticActionCount; i++) {
+        SBMAction *action = [SBMAction new];
+        action.eid = [NSString stringWithFormat:@"%032lu", (unsigned long)i];
+        action.trigger = (SBTriggerType)(1 + lrand48() % 3);
+        NSMutableOrderedSet *actionBeacons = [NSMutableOrderedSet new];
+        NSUInteger beaconCount = 1 + lrand48() % 3;
+        while (actionBeacons.count < beaconCount) {
+            [actionBeacons addObject:beacons[lrand48() % kSBSyntheticBeaconCount]];
+        }
+        action.beacons = actionBeacons.array;
+        [actions addObject:action];
+    }
+    self.layout = [SBMGetLayout new];
+    self.layout.actions = (NSArray <SBMAction> *)actions;
+}
+
+- (void)tearDown {
+    self.beacons = nil;
+    self.layout = nil;
+    [super tearDown];
+}
+
+// the matching rules of the former linear scan in checkCampaignsForBeacon:trigger:
+- (NSArray *)linearScanForBeacon:(SBMBeacon *)beacon trigger:(SBTriggerType)trigger {
+    NSMutableArray *matches = [NSMutableArray new];
+    for (SBMAction *action in self.layout.actions) {
+        for (SBMBeacon *actionBeacon in action.beacons) {
+            if ([actionBeacon.fullUUID isEqualToString:beacon.fullUUID] == NO) {
+                continue;
+            }
+            if (trigger != action.trigger && action.trigger != kSBTriggerEnterExit) {
+                continue;
+            }
+            [matches addObject:action];
+        }
+    }
+    return matches;
+}
+
+- (void)testIndexMatchesLinearScan {
+    XCTAssertEqual(self.layout.campaignIndex.beaconCount, kSBSyntheticBeaconCount);
+    for (SBMBeacon *beacon in self.beacons) {
+        for (SBTriggerType trigger = kSBTriggerEnter; trigger <= kSBTriggerEnterExit; trigger++) {
+            XCTAssertEqualObjects([self.layout.campaignIndex actionsForBeacon:beacon trigger:trigger], [self linearScanForBeacon:beacon trigger:trigger]);
+        }
+    }
+}
+
+- (void)testUnknownBeaconHasNoActions {
+    SBMBeacon *beacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00ff0000100001"];
+    XCTAssertEqual([self.layout.campaignIndex actionsForBeacon:beacon trigger:kSBTriggerEnter].count, 0);
+    XCTAssertEqual([self.layout.campaignIndex actionsForBeacon:nil trigger:kSBTriggerEnter].count, 0);
+}
+
+- (void)testDuplicateBeaconInActionMatchesOnce {
+    SBMAction *action = [SBMAction new];
+    action.trigger = kSBTriggerEnterExit;
+    action.beacons = @[self.beacons[0], self.beacons[0]];
+    SBCampaignIndex *index = [[SBCampaignIndex alloc] initWithActions:@[action]];
+    XCTAssertEqualObjects([index actionsForBeacon:self.beacons[0] trigger:kSBTriggerEnter], @[action]);
+    XCTAssertEqualObjects([index actionsForBeacon:self.beacons[0] trigger:kSBTriggerExit], @[action]);
+}
+
+- (void)testIndexIsBuiltWhenLayoutIsParsed {
+    NSDictionary *layoutDict = @{
+                                 @"accountProximityUUIDs" : @[@"7367672374000000ffff0000ffff0003"],
+                                 @"actions" : @[@{
+                                                    @"eid": @"367348a0dfa84492a0078ead26cf9385",
+                                                    @"trigger": @(kSBTriggerEnter),
+                                                    @"beacons": @[@"7367672374000000ffff0000ffff00030000200747",
+                                                                  @"7367672374000000ffff0000ffff00070100001200"],
+                                                    @"type": @(1)
+                                                    }]
+                                 };
+    NSError *error;
+    SBMGetLayout *layout = [[SBMGetLayout alloc] initWithDictionary:layoutDict error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqual(layout.campaignIndex.beaconCount, 2);
+    SBMBeacon *beacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00030000200747"];
+    XCTAssertEqual([layout.campaignIndex actionsForBeacon:beacon trigger:kSBTriggerEnter].count, 1);
+    XCTAssertEqual([layout.campaignIndex actionsForBeacon:beacon trigger:kSBTriggerExit].count, 0);
+}
+
+#pragma mark - Benchmarks
+
+- (void)testPerformanceBuildIndex {
+    [self measureBlock:^{
+        SBCampaignIndex *index = [[SBCampaignIndex alloc] initWithActions:self.layout.actions];
+        XCTAssertEqual(index.beaconCount, kSBSyntheticBeaconCount);
+    }];
+}
+
+- (void)testPerformanceIndexedLookup {
+    SBCampaignIndex *index = self.layout.campaignIndex;
+    [self measureBlock:^{
+        NSUInteger matches = 0;
+        for (NSUInteger i = 0; i < 100; i++) {
+            for (SBMBeacon *beacon in self.beacons) {
+                matches += [index actionsForBeacon:beacon trigger:kSBTriggerEnter].count;
+            }
+        }
+        XCTAssert(matches > 0);
+    }];
+}
+
+- (void)testPerformanceLinearScan {
+    NSArray *beacons = [self.beacons subarrayWithRange:NSMakeRange(0, 5)];
+    [self measureBlock:^{
+        NSUInteger matches = 0;
+        for (SBMBeacon *beacon in beacons) {
+            matches += [self linearScanForBeacon:beacon trigger:kSBTriggerEnter].count;
+        }
+        XCTAssert(matches > 0);
+    }];
+}
+
+@end
@@ -0,0 +1,356 @@
+//
+//  SBCampaignSchedulerTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "SBTestCase.h"
+
+#import "SensorbergSDK.h"
+
+#import "SBCampaignScheduler.h"
+#import "SBFireHistory.h"
+#import "SBInternalModels.h"
+#import "SBEvent.h"
+#import "SBResolver.h"
+#import "SBHTTPRequestManager.h"
+#import "SBHTTPValidatorCache.h"
+#import "SBTestURLProtocol.h"
+
+#import <tolo/Tolo.h>
+
+static NSTimeInterval const kSBCampaignSchedulerTestsEpoch = 1467331200;
+
+@interface SBMGetLayout (SBCampaignSchedulerTests)
+- (void)fireAction:(SBMAction *)action forBeacon:(SBMBeacon *)beacon withTrigger:(SBTriggerType)trigger;
+@end
+
+@interface SBCampaignSchedulerTests : SBTestCase
+@property (nonatomic, copy) NSString *path;
+@property (nonatomic, copy) NSString *historyPath;
+@property (nonatomic, strong) SBFireHistory *history;
+// the virtual clock of the schedulers
+@property (nonatomic) NSTimeInterval now;
+@property (nonatomic, strong) NSMutableArray <SBMCampaignAction *> *published;
+@end
+
+@implementation SBCampaignSchedulerTests
+
+- (void)setUp {
+    [super setUp];
+    NSString *name = [NSUUID UUID].UUIDString;
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:[name stringByAppendingPathExtension:@"schedule"]];
+    self.historyPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[name stringByAppendingPathExtension:@"history"]];
+    self.history = [[SBFireHistory alloc] initWithPath:self.historyPath];
+    self.now = kSBCampaignSchedulerTestsEpoch;
+    self.published = [NSMutableArray new];
+    SB_REGISTER();
+}
+
+- (void)tearDown {
+    SB_UNREGISTER();
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:self.historyPath error:nil];
+    self.history = nil;
+    self.published = nil;
+    [super tearDown];
+}
+
+SUBSCRIBE(SBEventPerformAction)
+{
+    [self.published addObject:event.campaign];
+}
+
+- (SBCampaignScheduler *)scheduler {
+    __weak __typeof(self) weakSelf = self;
+    return [[SBCampaignScheduler alloc] initWithPath:self.path fireHistory:self.history clock:^NSTimeInterval{
+        return weakSelf.now;
+    }];
+}
+
+- (NSString *)eidWithIndex:(NSUInteger)index {
+    return [NSString stringWithFormat:@"367348a0dfa84492a0078ead%08lx", (unsigned long)index];
+}
+
+- (SBMCampaignAction *)campaignWithIndex:(NSUInteger)index delay:(NSTimeInterval)delay {
+    SBMCampaignAction *campaign = [SBMCampaignAction new];
+    campaign.eid = [self eidWithIndex:index];
+    campaign.action = [NSUUID UUID].UUIDString;
+    campaign.subject = [NSString stringWithFormat:@"Campaign %lu", (unsigned long)index];
+    campaign.fireDate = [NSDate dateWithTimeIntervalSince1970:self.now + delay];
+    campaign.type = kSBActionTypeText;
+    return campaign;
+}
+
+- (void)test000DeliversInFireDateOrder {
+    SBCampaignScheduler *scheduler = [self scheduler];
+    srand48(2016);
+    for (NSUInteger i = 0; i < 500; i++) {
+        XCTAssertTrue([scheduler scheduleCampaignAction:[self campaignWithIndex:i delay:60 + floor(drand48() * 3600)] forAction:[SBMAction new]]);
+    }
+    XCTAssertEqual(scheduler.count, 500);
+    // nothing is due yet
+    XCTAssertEqual([scheduler fireDueActions].count, 0);
+    //
+    NSTimeInterval previous = 0;
+    NSUInteger delivered = 0;
+    while (scheduler.count) {
+        self.now = scheduler.nextDeadline;
+        for (SBMCampaignAction *campaign in [scheduler fireDueActions]) {
+            XCTAssertGreaterThanOrEqual(campaign.fireDate.timeIntervalSince1970, previous);
+            XCTAssertLessThanOrEqual(campaign.fireDate.timeIntervalSince1970, self.now);
+            previous = campaign.fireDate.timeIntervalSince1970;
+            delivered++;
+        }
+    }
+    XCTAssertEqual(delivered, 500);
+    XCTAssertEqual(self.published.count, 500);
+    XCTAssertEqual(self.history.count, 500);
+    XCTAssertEqual(scheduler.nextDeadline, 0);
+}
+
+- (void)test001CancelKeepsTheEarliestDeadline {
+    SBCampaignScheduler *scheduler = [self scheduler];
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:0 delay:300] forAction:[SBMAction new]];
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:1 delay:100] forAction:[SBMAction new]];
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:2 delay:200] forAction:[SBMAction new]];
+    XCTAssertEqual(scheduler.nextDeadline, self.now + 100);
+    // one pending delivery per campaign
+    XCTAssertFalse([scheduler scheduleCampaignAction:[self campaignWithIndex:1 delay:50] forAction:[SBMAction new]]);
+    XCTAssertFalse([scheduler scheduleCampaignAction:[SBMCampaignAction new] forAction:[SBMAction new]]);
+    //
+    XCTAssertTrue([scheduler cancelCampaign:[self eidWithIndex:1]]);
+    XCTAssertFalse([scheduler cancelCampaign:[self eidWithIndex:1]]);
+    XCTAssertFalse([scheduler isCampaignPending:[self eidWithIndex:1]]);
+    XCTAssertEqual(scheduler.nextDeadline, self.now + 200);
+    XCTAssertTrue([scheduler cancelCampaign:[self eidWithIndex:0]]);
+    XCTAssertEqual(scheduler.nextDeadline, self.now + 200);
+    //
+    self.now += 1000;
+    NSArray *due = [scheduler fireDueActions];
+    XCTAssertEqual(due.count, 1);
+    XCTAssertEqualObjects([due.firstObject eid], [self eidWithIndex:2]);
+}
+
+- (void)test002SuppressedCampaignsAreDropped {
+    SBCampaignScheduler *scheduler = [self scheduler];
+    SBMAction *once = [SBMAction new];
+    once.sendOnlyOnce = YES;
+    SBMAction *suppressed = [SBMAction new];
+    suppressed.suppressionTime = 600;
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:0 delay:60] forAction:once];
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:1 delay:60] forAction:suppressed];
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:2 delay:60] forAction:suppressed];
+    // fired while waiting
+    [self.history recordFireOfCampaign:[self eidWithIndex:0] date:[NSDate dateWithTimeIntervalSince1970:self.now - 86400]];
+    [self.history recordFireOfCampaign:[self eidWithIndex:1] date:[NSDate dateWithTimeIntervalSince1970:self.now]];
+    [self.history recordFireOfCampaign:[self eidWithIndex:2] date:[NSDate dateWithTimeIntervalSince1970:self.now - 3600]];
+    //
+    self.now += 60;
+    NSArray *due = [scheduler fireDueActions];
+    XCTAssertEqual(due.count, 1);
+    XCTAssertEqualObjects([due.firstObject eid], [self eidWithIndex:2]);
+    XCTAssertEqual(self.published.count, 1);
+    XCTAssertEqual(scheduler.count, 0);
+    XCTAssertEqual([self.history lastFireOfCampaign:[self eidWithIndex:2]], (int64_t)(self.now * 1000));
+}
+
+- (void)test003PendingCampaignsSurviveARelaunch {
+    SBCampaignScheduler *scheduler = [self scheduler];
+    SBMCampaignAction *campaign = [self campaignWithIndex:0 delay:120];
+    campaign.body = @"body";
+    campaign.payload = @{ @"key" : @[@1, @"two"] };
+    campaign.url = @"http://www.sensorberg.com";
+    campaign.trigger = kSBTriggerEnterExit;
+    campaign.beacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00030000200747"];
+    SBMAction *action = [SBMAction new];
+    action.reportImmediately = YES;
+    [scheduler scheduleCampaignAction:campaign forAction:action];
+    for (NSUInteger i = 1; i < 100; i++) {
+        [scheduler scheduleCampaignAction:[self campaignWithIndex:i delay:200 + i] forAction:[SBMAction new]];
+    }
+    [scheduler cancelCampaign:[self eidWithIndex:50]];
+    [scheduler synchronize];
+    scheduler = nil;
+    //
+    SBCampaignScheduler *relaunched = [self scheduler];
+    XCTAssertEqual(relaunched.count, 98);
+    XCTAssertEqual(relaunched.nextDeadline, self.now + 120);
+    XCTAssertFalse([relaunched isCampaignPending:[self eidWithIndex:50]]);
+    //
+    self.now += 120;
+    SBMCampaignAction *restored = [relaunched fireDueActions].firstObject;
+    XCTAssertEqualObjects(restored.eid, campaign.eid);
+    XCTAssertEqualObjects(restored.action, campaign.action);
+    XCTAssertEqualObjects(restored.subject, campaign.subject);
+    XCTAssertEqualObjects(restored.body, campaign.body);
+    XCTAssertEqualObjects(restored.payload, campaign.payload);
+    XCTAssertEqualObjects(restored.url, campaign.url);
+    XCTAssertEqualObjects(restored.fireDate, campaign.fireDate);
+    XCTAssertEqualObjects(restored.beacon, campaign.beacon);
+    XCTAssertEqual(restored.trigger, campaign.trigger);
+    XCTAssertEqual(restored.type, campaign.type);
+    //
+    self.now += 1000;
+    XCTAssertEqual([relaunched fireDueActions].count, 97);
+}
+
+- (void)test004UnreadableScheduleIsDiscarded {
+    [[@"not a schedule" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:self.path atomically:YES];
+    SBCampaignScheduler *scheduler = [self scheduler];
+    XCTAssertEqual(scheduler.count, 0);
+    XCTAssertTrue([scheduler scheduleCampaignAction:[self campaignWithIndex:0 delay:60] forAction:[SBMAction new]]);
+}
+
+- (void)test005LayoutHandsDelayedActionsToTheScheduler {
+    SBCampaignScheduler *scheduler = [[SBCampaignScheduler alloc] initWithPath:self.path];
+    SBMGetLayout *layout = [SBMGetLayout new];
+    [layout setCampaignScheduler:scheduler];
+    SBMAction *action = [SBMAction new];
+    action.eid = [self eidWithIndex:0];
+    action.type = kSBActionTypeText;
+    action.delay = 3600;
+    [layout fireAction:action forBeacon:nil withTrigger:kSBTriggerEnter];
+    // held, and not recorded as fired yet
+    XCTAssertEqual(self.published.count, 0);
+    XCTAssertTrue([scheduler isCampaignPending:action.eid]);
+    XCTAssertFalse([[SBFireHistory sharedHistory] campaignHasFired:action.eid]);
+    // without a delay it's published right away
+    action.eid = [self eidWithIndex:1];
+    action.delay = 0;
+    [layout fireAction:action forBeacon:nil withTrigger:kSBTriggerEnter];
+    XCTAssertEqual(self.published.count, 1);
+    XCTAssertEqual(scheduler.count, 1);
+    [[SBFireHistory sharedHistory] removeAllFires];
+    [scheduler removeAllCampaigns];
+}
+
+- (void)test006ChangesAreWrittenWhenReleased {
+    SBCampaignScheduler *scheduler = [self scheduler];
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:0 delay:60] forAction:[SBMAction new]];
+    [scheduler scheduleCampaignAction:[self campaignWithIndex:1 delay:120] forAction:[SBMAction new]];
+    [scheduler synchronize];
+    // released before the deferred write
+    [scheduler cancelCampaign:[self eidWithIndex:0]];
+    scheduler = nil;
+    SBCampaignScheduler *relaunched = [self scheduler];
+    XCTAssertEqual(relaunched.count, 1);
+    XCTAssertFalse([relaunched isCampaignPending:[self eidWithIndex:0]]);
+    //
+    // a reset leaves nothing to restore
+    [relaunched removeAllCampaigns];
+    relaunched = nil;
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:self.path]);
+    XCTAssertEqual([self scheduler].count, 0);
+}
+
+// the resolver checks the campaigns of the layouts it parses, and of the last one on a 304
+- (void)test007ResolverHandsDelayedActionsToTheScheduler {
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
+    SBHTTPValidatorCache *previousCache = manager.validatorCache;
+    manager.validatorCache = [[SBHTTPValidatorCache alloc] initWithDirectory:directory];
+    //
+    NSString *enterBeacon = @"7367672374000000ffff0000ffff00030000200747";
+    NSString *otherBeacon = @"7367672374000000ffff0000ffff00030000200748";
+    NSMutableArray *eids = [NSMutableArray new];
+    NSMutableArray *actions = [NSMutableArray new];
+    for (NSString *beacon in @[enterBeacon, otherBeacon]) {
+        NSString *eid = [[NSUUID UUID].UUIDString stringByReplacingOccurrencesOfString:@"-" withString:@""];
+        [eids addObject:eid];
+        [actions addObject:@{@"eid": eid,
+                             @"trigger": @(kSBTriggerEnter),
+                             @"beacons": @[beacon],
+                             @"type": @(kSBActionTypeText),
+                             @"delay": @(3600),
+                             @"content": @{@"subject": @"Subject", @"body": @"Body", @"url": @"http://www.sensorberg.com"}}];
+    }
+    NSData *layoutData = [NSJSONSerialization dataWithJSONObject:@{@"accountProximityUUIDs": @[@"7367672374000000ffff0000ffff0003"],
+                                                                   @"actions": actions}
+                                                         options:0
+                                                           error:nil];
+    __block NSUInteger notModified = 0;
+    [SBTestURLProtocol setResponseHeaderFields:@{@"ETag": @"\"v1\""}];
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        if ([[request valueForHTTPHeaderField:@"If-None-Match"] isEqualToString:@"\"v1\""]) {
+            notModified++;
+            *statusCode = 304;
+            return nil;
+        }
+        return layoutData;
+    }];
+    [SBTestURLProtocol install];
+    //
+    // on the wall clock, like the layout's fire dates
+    SBCampaignScheduler *scheduler = [[SBCampaignScheduler alloc] initWithPath:self.path];
+    SBResolver *resolver = [[SBResolver alloc] initWithApiKey:@"TestAPIKey"];
+    resolver.campaignScheduler = scheduler;
+    [resolver requestLayoutForBeacon:[[SBMBeacon alloc] initWithString:enterBeacon] trigger:kSBTriggerEnter useCache:NO];
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        return [scheduler isCampaignPending:eids[0]];
+    }] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    //
+    [resolver requestLayoutForBeacon:[[SBMBeacon alloc] initWithString:otherBeacon] trigger:kSBTriggerEnter useCache:NO];
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        return [scheduler isCampaignPending:eids[1]];
+    }] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    //
+    [SBTestURLProtocol uninstall];
+    manager.validatorCache = previousCache;
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+    //
+    XCTAssertEqual(notModified, 1);
+    XCTAssertEqual(scheduler.count, 2);
+    // held, not published with a future fireDate
+    XCTAssertEqual(self.published.count, 0);
+    [scheduler removeAllCampaigns];
+}
+
+#pragma mark - Benchmarks
+
+- (void)testPerformanceScheduleCancelAndDeliver {
+    NSUInteger const pending = 10000;
+    NSMutableArray *campaigns = [NSMutableArray arrayWithCapacity:pending];
+    srand48(2016);
+    for (NSUInteger i = 0; i < pending; i++) {
+        [campaigns addObject:[self campaignWithIndex:i delay:60 + floor(drand48() * 86400)]];
+    }
+    SBMAction *action = [SBMAction new];
+    [self measureBlock:^{
+        self.now = kSBCampaignSchedulerTestsEpoch;
+        SBCampaignScheduler *scheduler = [self scheduler];
+        for (SBMCampaignAction *campaign in campaigns) {
+            [scheduler scheduleCampaignAction:campaign forAction:action];
+        }
+        for (NSUInteger i = 0; i < pending; i += 2) {
+            [scheduler cancelCampaign:[campaigns[i] eid]];
+        }
+        self.now += 86400 * 2;
+        XCTAssertEqual([scheduler fireDueActions].count, pending / 2);
+        [self.history removeAllFires];
+        [scheduler removeAllCampaigns];
+    }];
+}
+
+@end
@@ -0,0 +1,584 @@
+//
+//  SBEventBusTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+#import "SensorbergSDK.h"
+#import "SBEventBus.h"
+#import "SBEventBusInstrumentation.h"
+
+static NSUInteger const kSBEventBusBenchmarkPublishes = 100000;
+
+@interface SBEventBusTestEvent : NSObject
+@property (nonatomic) NSUInteger value;
+@end
+
+@implementation SBEventBusTestEvent
+@end
+
+@interface SBEventBusOtherTestEvent : NSObject
+@end
+
+@implementation SBEventBusOtherTestEvent
+@end
+
+@interface SBEventBusTestSubscriber : NSObject
+@property (nonatomic) NSUInteger count;
+@property (nonatomic) NSUInteger lastValue;
+@property (nonatomic, copy) void (^onEvent)(SBEventBusTestEvent *event);
+@end
+
+@implementation SBEventBusTestSubscriber
+
+SUBSCRIBE(SBEventBusTestEvent)
+{
+    self.count++;
+    self.lastValue = event.value;
+    if (self.onEvent) {
+        self.onEvent(event);
+    }
+}
+
+@end
+
+@interface SBEventBusTestProducer : NSObject
+@end
+
+@implementation SBEventBusTestProducer
+
+PUBLISHER(SBEventBusTestEvent)
+{
+    SBEventBusTestEvent *event = [SBEventBusTestEvent new];
+    event.value = 42;
+    return event;
+}
+
+@end
+
+@interface SBEventBusWideSubscriber : NSObject
+@property (nonatomic) NSUInteger count;
+@end
+
+@implementation SBEventBusWideSubscriber
+
+SUBSCRIBE(SBEventBusTestEvent)
+{
+    self.count++;
+}
+
+SUBSCRIBE(SBEventBusOtherTestEvent)
+{
+    self.count++;
+}
+
+@end
+
+@interface SBEventBusPrefixSubscriber : NSObject
+@property (nonatomic) NSUInteger count;
+@end
+
+@implementation SBEventBusPrefixSubscriber
+
+- (void)handleSBEventBusTestEvent:(SBEventBusTestEvent *)event
+{
+    self.count++;
+}
+
+@end
+
+// appends "<name><value>" to a shared log
+@interface SBEventBusOrderSubscriber : NSObject
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, strong) NSMutableArray <NSString *> *log;
+@property (nonatomic) BOOL onInternalQueue;
+@end
+
+static void *kSBEventBusTestQueueKey = &kSBEventBusTestQueueKey;
+
+@implementation SBEventBusOrderSubscriber
+
+SUBSCRIBE(SBEventBusTestEvent)
+{
+    self.onInternalQueue = dispatch_get_specific(kSBEventBusTestQueueKey) != NULL;
+    @synchronized (self.log) {
+        [self.log addObject:[NSString stringWithFormat:@"%@%lu", self.name, (unsigned long)event.value]];
+    }
+}
+
+@end
+
+@interface SBEventBusTests : SBTestCase
+@property (nonatomic, strong) SBEventBus *bus;
+@end
+
+@implementation SBEventBusTests
+
+- (void)setUp {
+    [super setUp];
+    self.bus = [SBEventBus new];
+}
+
+- (void)tearDown {
+    self.bus = nil;
+    [super tearDown];
+}
+
+- (SBEventBusTestEvent *)eventWithValue:(NSUInteger)value {
+    SBEventBusTestEvent *event = [SBEventBusTestEvent new];
+    event.value = value;
+    return event;
+}
+
+- (void)test000SDKEventBusIsNotToloSharedInstance {
+    XCTAssertTrue([[SensorbergSDK eventBus] isKindOfClass:[SBEventBus class]]);
+    XCTAssertFalse([[Tolo sharedInstance] isKindOfClass:[SBEventBus class]]);
+    XCTAssertEqual([SensorbergSDK eventBus], [SBEventBus sharedInstance]);
+    XCTAssertTrue([SensorbergSDK eventBus].forceMainThread);
+}
+
+- (void)test001PublishReachesSubscribersOfThatClassOnly {
+    SBEventBusTestSubscriber *first = [SBEventBusTestSubscriber new];
+    SBEventBusTestSubscriber *second = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:first];
+    [self.bus subscribe:second];
+    // subscribing twice doesn't deliver twice
+    [self.bus subscribe:first];
+    
+    [self.bus publish:[self eventWithValue:7]];
+    [self.bus publish:[SBEventBusOtherTestEvent new]];
+    
+    XCTAssertEqual(first.count, 1);
+    XCTAssertEqual(second.count, 1);
+    XCTAssertEqual(first.lastValue, 7);
+    XCTAssertEqual([self.bus handlerCountForEventClass:[SBEventBusTestEvent class]], 2);
+    XCTAssertEqual([self.bus handlerCountForEventClass:[SBEventBusOtherTestEvent class]], 0);
+}
+
+- (void)test002UnsubscribeStopsDelivery {
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:subscriber];
+    [self.bus unsubscribe:subscriber];
+    [self.bus publish:[self eventWithValue:1]];
+    XCTAssertEqual(subscriber.count, 0);
+    XCTAssertEqual([self.bus handlerCountForEventClass:[SBEventBusTestEvent class]], 0);
+}
+
+- (void)test003DeallocatedSubscribersArePruned {
+    @autoreleasepool {
+        [self.bus subscribe:[SBEventBusTestSubscriber new]];
+    }
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:subscriber];
+    [self.bus publish:[self eventWithValue:1]];
+    XCTAssertEqual(subscriber.count, 1);
+    XCTAssertEqual([self.bus handlerCountForEventClass:[SBEventBusTestEvent class]], 1);
+}
+
+- (void)test004HandlersMayUnsubscribeWhilePublishing {
+    SBEventBusTestSubscriber *first = [SBEventBusTestSubscriber new];
+    SBEventBusTestSubscriber *second = [SBEventBusTestSubscriber new];
+    __weak SBEventBus *bus = self.bus;
+    __weak SBEventBusTestSubscriber *weakSecond = second;
+    first.onEvent = ^(SBEventBusTestEvent *event) {
+        [bus unsubscribe:weakSecond];
+    };
+    [self.bus subscribe:first];
+    [self.bus subscribe:second];
+    // the publish in progress still delivers to its snapshot
+    [self.bus publish:[self eventWithValue:1]];
+    [self.bus publish:[self eventWithValue:2]];
+    XCTAssertEqual(first.count, 2);
+    XCTAssertEqual(second.count, 1);
+}
+
+- (void)test005ProducerValueIsDeliveredOnSubscribe {
+    SBEventBusTestSubscriber *early = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:early];
+    SBEventBusTestProducer *producer = [SBEventBusTestProducer new];
+    [self.bus subscribe:producer];
+    XCTAssertEqual(early.count, 1);
+    XCTAssertEqual(early.lastValue, 42);
+    
+    SBEventBusTestSubscriber *late = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:late];
+    XCTAssertEqual(late.count, 1);
+    XCTAssertEqual(late.lastValue, 42);
+    
+    [self.bus unsubscribe:producer];
+    SBEventBusTestSubscriber *afterProducer = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:afterProducer];
+    XCTAssertEqual(afterProducer.count, 0);
+}
+
+- (void)test006BackgroundPublishIsDeliveredOnTheMainThread {
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"delivered"];
+    subscriber.onEvent = ^(SBEventBusTestEvent *event) {
+        XCTAssertTrue([NSThread isMainThread]);
+        [expectation fulfill];
+    };
+    [self.bus subscribe:subscriber];
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        [self.bus publish:[self eventWithValue:1]];
+    });
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+#pragma mark - Asynchronous delivery
+
+- (void)test007AsynchronousPublishDoesNotWaitForTheMainThread {
+    self.bus.deliveryMode = SBEventBusDeliveryAsynchronous;
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:subscriber];
+    
+    // with synchronous delivery this would deadlock: the main thread waits for the publish to return
+    dispatch_semaphore_t published = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        [self.bus publish:[self eventWithValue:1]];
+        dispatch_semaphore_signal(published);
+    });
+    XCTAssertEqual(dispatch_semaphore_wait(published, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC))), 0);
+    XCTAssertEqual(subscriber.count, 0);
+    
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"count == 1"] evaluatedWithObject:subscriber handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)test008AsynchronousDeliveryKeepsPublishOrderPerQueue {
+    self.bus.deliveryMode = SBEventBusDeliveryAsynchronous;
+    dispatch_queue_t queue = dispatch_queue_create("com.sensorberg.sdk.tests.eventbus", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(queue, kSBEventBusTestQueueKey, kSBEventBusTestQueueKey, NULL);
+    NSMutableArray *queueLog = [NSMutableArray new];
+    NSMutableArray *mainLog = [NSMutableArray new];
+    //
+    SBEventBusOrderSubscriber *a = [SBEventBusOrderSubscriber new];
+    a.name = @"a";
+    a.log = queueLog;
+    SBEventBusOrderSubscriber *b = [SBEventBusOrderSubscriber new];
+    b.name = @"b";
+    b.log = queueLog;
+    SBEventBusOrderSubscriber *mainSubscriber = [SBEventBusOrderSubscriber new];
+    mainSubscriber.name = @"m";
+    mainSubscriber.log = mainLog;
+    [self.bus subscribe:a queue:queue];
+    [self.bus subscribe:b queue:queue];
+    [self.bus subscribe:mainSubscriber];
+    
+    NSUInteger const events = 1000;
+    NSMutableArray *expectedQueueLog = [NSMutableArray new];
+    NSMutableArray *expectedMainLog = [NSMutableArray new];
+    for (NSUInteger i = 0; i < events; i++) {
+        [expectedQueueLog addObject:[NSString stringWithFormat:@"a%lu", (unsigned long)i]];
+        [expectedQueueLog addObject:[NSString stringWithFormat:@"b%lu", (unsigned long)i]];
+        [expectedMainLog addObject:[NSString stringWithFormat:@"m%lu", (unsigned long)i]];
+    }
+    // one publishing thread, so the bus order is the loop order
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        for (NSUInteger i = 0; i < events; i++) {
+            [self.bus publish:[self eventWithValue:i]];
+        }
+    });
+    
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        @synchronized (queueLog) {
+            return queueLog.count == 2 * events && mainLog.count == events;
+        }
+    }] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    XCTAssertEqualObjects(queueLog, expectedQueueLog);
+    XCTAssertEqualObjects(mainLog, expectedMainLog);
+    XCTAssertTrue(a.onInternalQueue);
+    XCTAssertTrue(b.onInternalQueue);
+    XCTAssertFalse(mainSubscriber.onInternalQueue);
+}
+
+- (void)test009QueuedDeliveriesAreDroppedOnUnsubscribe {
+    self.bus.deliveryMode = SBEventBusDeliveryAsynchronous;
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    SBEventBusTestSubscriber *witness = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:subscriber];
+    [self.bus subscribe:witness];
+    // both deliveries are queued for the main queue, which doesn't drain until we wait
+    [self.bus publish:[self eventWithValue:1]];
+    [self.bus unsubscribe:subscriber];
+    
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"count == 1"] evaluatedWithObject:witness handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual(subscriber.count, 0);
+}
+
+#pragma mark - Subscription bookkeeping
+
+- (void)test010UnsubscribeOnlyRemovesThatSubscriber {
+    SBEventBusWideSubscriber *wide = [SBEventBusWideSubscriber new];
+    SBEventBusTestSubscriber *narrow = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:wide];
+    [self.bus subscribe:narrow];
+    [self.bus unsubscribe:wide];
+    // unsubscribing twice, or something that never subscribed, is harmless
+    [self.bus unsubscribe:wide];
+    [self.bus unsubscribe:[NSObject new]];
+    
+    [self.bus publish:[self eventWithValue:1]];
+    [self.bus publish:[SBEventBusOtherTestEvent new]];
+    XCTAssertEqual(wide.count, 0);
+    XCTAssertEqual(narrow.count, 1);
+    
+    [self.bus subscribe:wide];
+    [self.bus publish:[self eventWithValue:2]];
+    [self.bus publish:[SBEventBusOtherTestEvent new]];
+    XCTAssertEqual(wide.count, 2);
+    XCTAssertEqual(narrow.count, 2);
+}
+
+- (void)test011DeadSubscribersArePrunedOnPublish {
+    SBEventBusTestSubscriber *survivor = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:survivor];
+    @autoreleasepool {
+        for (NSUInteger i = 0; i < 10; i++) {
+            [self.bus subscribe:[SBEventBusWideSubscriber new]];
+        }
+    }
+    XCTAssertEqual([self.bus handlerCountForEventClass:[SBEventBusOtherTestEvent class]], 0);
+    [self.bus publish:[SBEventBusOtherTestEvent new]];
+    [self.bus publish:[self eventWithValue:1]];
+    XCTAssertEqual(survivor.count, 1);
+    XCTAssertEqual([self.bus handlerCountForEventClass:[SBEventBusTestEvent class]], 1);
+}
+
+- (void)test012PrefixChangeDropsTheCachedClassTables {
+    SBEventBusPrefixSubscriber *subscriber = [SBEventBusPrefixSubscriber new];
+    [self.bus subscribe:subscriber];
+    [self.bus publish:[self eventWithValue:1]];
+    XCTAssertEqual(subscriber.count, 0);
+    
+    self.bus.observerPrefix = @"handle";
+    [self.bus subscribe:subscriber];
+    [self.bus publish:[self eventWithValue:2]];
+    XCTAssertEqual(subscriber.count, 1);
+}
+
+#pragma mark - Instrumentation
+
+- (void)test013HistogramPercentilesStayWithinABucket {
+    SBLatencyHistogram *histogram = [SBLatencyHistogram new];
+    XCTAssertEqual([histogram valueAtPercentile:50], 0);
+    for (uint64_t value = 1; value <= 1000; value++) {
+        [histogram recordValue:value * 1000];
+    }
+    XCTAssertEqual(histogram.count, 1000);
+    XCTAssertEqual(histogram.max, 1000000);
+    XCTAssertEqual(histogram.total, 500500000);
+    // reported at most one bucket (12.5%) too high, never below the exact value
+    for (NSNumber *percentile in @[@50, @90, @99]) {
+        double exact = percentile.doubleValue * 10000;
+        uint64_t reported = [histogram valueAtPercentile:percentile.doubleValue];
+        XCTAssertGreaterThanOrEqual(reported, exact);
+        XCTAssertLessThanOrEqual(reported, exact * 1.125);
+    }
+    XCTAssertEqual([histogram valueAtPercentile:100], 1000000);
+    //
+    [histogram recordValue:3];
+    [histogram recordValue:UINT64_MAX];
+    XCTAssertEqual([histogram valueAtPercentile:0], 3);
+    XCTAssertEqual([histogram valueAtPercentile:100], UINT64_MAX);
+}
+
+- (void)test014InstrumentationCountsPublishesAndTimesHandlers {
+    SBEventBusInstrumentation *instrumentation = [SBEventBusInstrumentation new];
+    self.bus.instrumentation = instrumentation;
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    subscriber.onEvent = ^(SBEventBusTestEvent *event) {
+        usleep(2000);
+    };
+    [self.bus subscribe:subscriber];
+    for (NSUInteger i = 0; i < 5; i++) {
+        [self.bus publish:[self eventWithValue:i]];
+    }
+    [self.bus publish:[SBEventBusOtherTestEvent new]];
+    //
+    NSDictionary *statistics = [instrumentation snapshot][NSStringFromClass([SBEventBusTestEvent class])];
+    XCTAssertEqualObjects(statistics[kSBEventStatisticsPublishes], @5);
+    NSDictionary *handler = statistics[kSBEventStatisticsHandlers][@"SBEventBusTestSubscriber onSBEventBusTestEvent:"];
+    XCTAssertEqualObjects(handler[kSBEventStatisticsCount], @5);
+    XCTAssertGreaterThanOrEqual([handler[kSBEventStatisticsTotal] doubleValue], 0.010);
+    XCTAssertGreaterThanOrEqual([handler[kSBEventStatisticsMax] doubleValue], 0.002);
+    XCTAssertGreaterThanOrEqual([handler[kSBEventStatisticsP50] doubleValue], 0.002);
+    XCTAssertLessThanOrEqual([handler[kSBEventStatisticsP99] doubleValue], [handler[kSBEventStatisticsMax] doubleValue]);
+    // published without subscribers
+    NSDictionary *other = [instrumentation snapshot][NSStringFromClass([SBEventBusOtherTestEvent class])];
+    XCTAssertEqualObjects(other[kSBEventStatisticsPublishes], @1);
+    XCTAssertEqual([other[kSBEventStatisticsHandlers] count], 0);
+}
+
+- (void)test015AsynchronousDeliveriesAreTimed {
+    SBEventBusInstrumentation *instrumentation = [SBEventBusInstrumentation new];
+    self.bus.instrumentation = instrumentation;
+    self.bus.deliveryMode = SBEventBusDeliveryAsynchronous;
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"delivered"];
+    subscriber.onEvent = ^(SBEventBusTestEvent *event) {
+        if (event.value == 2) {
+            [expectation fulfill];
+        }
+    };
+    [self.bus subscribe:subscriber queue:[SBEventBus internalQueue]];
+    [self.bus publish:[self eventWithValue:1]];
+    [self.bus publish:[self eventWithValue:2]];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    // the drain records after the handler returns
+    dispatch_sync([SBEventBus internalQueue], ^{});
+    //
+    NSDictionary *statistics = [instrumentation snapshot][NSStringFromClass([SBEventBusTestEvent class])];
+    XCTAssertEqualObjects(statistics[kSBEventStatisticsPublishes], @2);
+    XCTAssertEqualObjects(statistics[kSBEventStatisticsHandlers][@"SBEventBusTestSubscriber onSBEventBusTestEvent:"][kSBEventStatisticsCount], @2);
+}
+
+- (void)test016NothingIsRecordedOnceTurnedOff {
+    SBEventBusInstrumentation *instrumentation = [SBEventBusInstrumentation new];
+    self.bus.instrumentation = instrumentation;
+    SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+    [self.bus subscribe:subscriber];
+    [self.bus publish:[self eventWithValue:1]];
+    self.bus.instrumentation = nil;
+    [self.bus publish:[self eventWithValue:2]];
+    XCTAssertEqual(subscriber.count, 2);
+    XCTAssertEqualObjects([instrumentation snapshot][NSStringFromClass([SBEventBusTestEvent class])][kSBEventStatisticsPublishes], @1);
+    // a new instrumentation starts from scratch
+    SBEventBusInstrumentation *next = [SBEventBusInstrumentation new];
+    self.bus.instrumentation = next;
+    [self.bus publish:[self eventWithValue:3]];
+    NSDictionary *statistics = [next snapshot][NSStringFromClass([SBEventBusTestEvent class])];
+    XCTAssertEqualObjects(statistics[kSBEventStatisticsPublishes], @1);
+    XCTAssertEqualObjects(statistics[kSBEventStatisticsHandlers][@"SBEventBusTestSubscriber onSBEventBusTestEvent:"][kSBEventStatisticsCount], @1);
+    [next reset];
+    XCTAssertEqualObjects([next snapshot][NSStringFromClass([SBEventBusTestEvent class])][kSBEventStatisticsPublishes], @0);
+}
+
+#pragma mark - Benchmarks
+
+- (void)measureSubscribeCycleWithMode:(SBEventBusDispatchMode)mode {
+    SBEventBus *bus = [SBEventBus new];
+    bus.dispatchMode = mode;
+    // an app with a few hundred live subscribers, one of them coming and going per screen
+    NSMutableArray *others = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 200; i++) {
+        SBEventBusWideSubscriber *other = [SBEventBusWideSubscriber new];
+        [bus subscribe:other];
+        [others addObject:other];
+    }
+    SBEventBusWideSubscriber *subscriber = [SBEventBusWideSubscriber new];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 1000; i++) {
+            [bus subscribe:subscriber];
+            [bus unsubscribe:subscriber];
+        }
+    }];
+    XCTAssertEqual(others.count, 200);
+}
+
+- (void)testPerformanceSubscribeCycleTable {
+    [self measureSubscribeCycleWithMode:SBEventBusDispatchModeTable];
+}
+
+- (void)testPerformanceSubscribeCycleTolo {
+    [self measureSubscribeCycleWithMode:SBEventBusDispatchModeTolo];
+}
+
+
+- (NSArray *)subscribersOnBus:(SBEventBus *)bus count:(NSUInteger)count {
+    NSMutableArray *subscribers = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        SBEventBusTestSubscriber *subscriber = [SBEventBusTestSubscriber new];
+        [bus subscribe:subscriber];
+        [subscribers addObject:subscriber];
+    }
+    return subscribers;
+}
+
+- (double)publishesPerSecondWithMode:(SBEventBusDispatchMode)mode subscribers:(NSUInteger)count {
+    SBEventBus *bus = [SBEventBus new];
+    bus.dispatchMode = mode;
+    NSArray *subscribers = [self subscribersOnBus:bus count:count];
+    SBEventBusTestEvent *event = [self eventWithValue:1];
+    NSUInteger publishes = kSBEventBusBenchmarkPublishes / count;
+    //
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    @autoreleasepool {
+        for (NSUInteger i = 0; i < publishes; i++) {
+            [bus publish:event];
+        }
+    }
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent() - start;
+    XCTAssertEqual(((SBEventBusTestSubscriber *)subscribers.firstObject).count, publishes);
+    return publishes / time;
+}
+
+// the publish rate per subscriber count, in the test log
+- (void)testPublishRatePerSubscriberCount {
+    for (NSNumber *count in @[@1, @10, @100]) {
+        double table = [self publishesPerSecondWithMode:SBEventBusDispatchModeTable subscribers:count.unsignedIntegerValue];
+        double tolo = [self publishesPerSecondWithMode:SBEventBusDispatchModeTolo subscribers:count.unsignedIntegerValue];
+        NSLog(@"Event bus: %3lu subscribers, table %10.0f publishes/s, Tolo %10.0f publishes/s (%.1fx)",
+              count.unsignedLongValue, table, tolo, table / tolo);
+    }
+}
+
+- (void)measurePublishWithMode:(SBEventBusDispatchMode)mode subscribers:(NSUInteger)count {
+    SBEventBus *bus = [SBEventBus new];
+    bus.dispatchMode = mode;
+    NSArray *subscribers = [self subscribersOnBus:bus count:count];
+    SBEventBusTestEvent *event = [self eventWithValue:1];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            [bus publish:event];
+        }
+    }];
+    XCTAssertGreaterThan(((SBEventBusTestSubscriber *)subscribers.firstObject).count, 0);
+}
+
+- (void)testPerformancePublishTable10Subscribers {
+    [self measurePublishWithMode:SBEventBusDispatchModeTable subscribers:10];
+}
+
+- (void)testPerformancePublishTolo10Subscribers {
+    [self measurePublishWithMode:SBEventBusDispatchModeTolo subscribers:10];
+}
+
+- (void)testPerformancePublishInstrumented10Subscribers {
+    SBEventBus *bus = [SBEventBus new];
+    bus.instrumentation = [SBEventBusInstrumentation new];
+    NSArray *subscribers = [self subscribersOnBus:bus count:10];
+    SBEventBusTestEvent *event = [self eventWithValue:1];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            [bus publish:event];
+        }
+    }];
+    XCTAssertGreaterThan(((SBEventBusTestSubscriber *)subscribers.firstObject).count, 0);
+}
+
+@end
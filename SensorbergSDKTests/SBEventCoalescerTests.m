@@ -0,0 +1,102 @@
+//
+//  SBEventCoalescerTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+#import "SBEventCoalescer.h"
+
+@interface SBEventCoalescerTests : SBTestCase
+@property (nonatomic, strong) SBEventCoalescer *sut;
+@property (nonatomic, strong) NSMutableArray <NSArray *> *batches;
+@end
+
+@implementation SBEventCoalescerTests
+
+- (void)setUp {
+    [super setUp];
+    self.batches = [NSMutableArray new];
+    __weak SBEventCoalescerTests *weakSelf = self;
+    self.sut = [[SBEventCoalescer alloc] initWithInterval:0.05 handler:^(NSArray *values) {
+        [weakSelf.batches addObject:values];
+    }];
+}
+
+- (void)tearDown {
+    self.sut = nil;
+    self.batches = nil;
+    [super tearDown];
+}
+
+- (void)test000LastValueWinsInFirstSeenOrder {
+    [self.sut coalesceValue:@1 forKey:@"b"];
+    [self.sut coalesceValue:@2 forKey:@"a"];
+    [self.sut coalesceValue:@3 forKey:@"b"];
+    XCTAssertEqual(self.sut.count, 2);
+    [self.sut flush];
+    XCTAssertEqualObjects(self.batches, (@[@[@3, @2]]));
+    XCTAssertEqual(self.sut.count, 0);
+}
+
+- (void)test001OneBatchPerTick {
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self.sut coalesceValue:@(i) forKey:@(i % 10)];
+    }
+    XCTAssertEqual(self.batches.count, 0);
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"batches.@count == 1"] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(self.batches.firstObject.count, 10);
+    XCTAssertEqualObjects(self.batches.firstObject.lastObject, @99);
+}
+
+- (void)test002NothingIsDeliveredWhenIdle {
+    [self.sut flush];
+    XCTestExpectation *idle = [self expectationWithDescription:@"idle"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.15 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [idle fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(self.batches.count, 0);
+}
+
+- (void)test003ManualFlushRestartsTheTick {
+    self.sut.interval = 0.2;
+    [self.sut coalesceValue:@1 forKey:@"a"];
+    [self.sut flush];
+    // the tick scheduled for the first batch must not cut this one short
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.1 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [self.sut coalesceValue:@2 forKey:@"a"];
+    });
+    XCTestExpectation *early = [self expectationWithDescription:@"early"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.25 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        XCTAssertEqual(self.batches.count, 1);
+        [early fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"batches.@count == 2"] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqualObjects(self.batches.lastObject, @[@2]);
+}
+
+@end
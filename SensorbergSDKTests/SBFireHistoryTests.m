@@ -0,0 +1,164 @@
+//
+//  SBFireHistoryTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "SBTestCase.h"
+
+#import "SBFireHistory.h"
+#import "SBUtility.h"
+
+static NSString * const kSBFireHistoryTestsService = @"com.sensorberg.sdk.tests.fire.history";
+
+@interface SBFireHistoryTests : SBTestCase
+@property (nonatomic, copy) NSString *path;
+@property (nonatomic, strong) UICKeyChainStore *keychain;
+@end
+
+@implementation SBFireHistoryTests
+
+- (void)setUp {
+    [super setUp];
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.history", [NSUUID UUID].UUIDString]];
+    self.keychain = [UICKeyChainStore keyChainStoreWithService:kSBFireHistoryTestsService];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    [self.keychain removeAllItems];
+    self.keychain = nil;
+    self.path = nil;
+    [super tearDown];
+}
+
+- (NSString *)eidWithIndex:(NSUInteger)index {
+    return [NSString stringWithFormat:@"367348a0dfa84492a0078ead%08lx", (unsigned long)index];
+}
+
+- (void)test000FiresAreKeptInMilliseconds {
+    SBFireHistory *history = [[SBFireHistory alloc] initWithPath:self.path];
+    XCTAssertFalse([history campaignHasFired:[self eidWithIndex:0]]);
+    XCTAssertEqual([history lastFireOfCampaign:nil], 0);
+    [history recordFireOfCampaign:[self eidWithIndex:0] date:[NSDate dateWithTimeIntervalSince1970:1467331200.1234]];
+    XCTAssertTrue([history campaignHasFired:[self eidWithIndex:0]]);
+    XCTAssertEqual([history lastFireOfCampaign:[self eidWithIndex:0]], 1467331200123);
+    // the latest fire wins
+    [history recordFireOfCampaign:[self eidWithIndex:0] date:[NSDate dateWithTimeIntervalSince1970:1467331300]];
+    XCTAssertEqual([history lastFireOfCampaign:[self eidWithIndex:0]], 1467331300000);
+    XCTAssertEqual(history.count, 1);
+}
+
+- (void)test001ChangesAreWrittenInOneBatch {
+    SBFireHistory *history = [[SBFireHistory alloc] initWithPath:self.path];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [history recordFireOfCampaign:[self eidWithIndex:i] date:[NSDate dateWithTimeIntervalSince1970:1467331200 + i]];
+    }
+    // not written yet
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:self.path]);
+    [history synchronize];
+    
+    SBFireHistory *loaded = [[SBFireHistory alloc] initWithPath:self.path];
+    XCTAssertEqual(loaded.count, 100);
+    XCTAssertEqual([loaded lastFireOfCampaign:[self eidWithIndex:99]], 1467331299000);
+    
+    [history removeAllFires];
+    [history synchronize];
+    XCTAssertEqual([[SBFireHistory alloc] initWithPath:self.path].count, 0);
+}
+
+- (void)test002CorruptFileIsDiscarded {
+    SBFireHistory *history = [[SBFireHistory alloc] initWithPath:self.path];
+    [history recordFireOfCampaign:[self eidWithIndex:0] date:[NSDate date]];
+    [history synchronize];
+    NSFileHandle *handle = [NSFileHandle fileHandleForUpdatingAtPath:self.path];
+    [handle seekToFileOffset:20];
+    [handle writeData:[@"#" dataUsingEncoding:NSUTF8StringEncoding]];
+    [handle closeFile];
+    
+    XCTAssertEqual([[SBFireHistory alloc] initWithPath:self.path].count, 0);
+}
+
+- (void)test003KeychainFiresAreMigratedOnce {
+    NSDate *fired = [NSDate dateWithTimeIntervalSince1970:1467331200];
+    [self.keychain setString:[dateFormatter stringFromDate:fired] forKey:[self eidWithIndex:0]];
+    [self.keychain setString:[dateFormatter stringFromDate:fired] forKey:kPostLayout];
+    [self.keychain setString:@"not a date" forKey:[self eidWithIndex:1]];
+    
+    SBFireHistory *history = [[SBFireHistory alloc] initWithPath:self.path];
+    [history migrateFromKeychain:self.keychain];
+    XCTAssertEqual(history.count, 1);
+    XCTAssertEqual([history lastFireOfCampaign:[self eidWithIndex:0]], 1467331200000);
+    [history synchronize];
+    
+    // the file exists now: a later fire in the keychain is not imported again
+    [self.keychain setString:[dateFormatter stringFromDate:fired] forKey:[self eidWithIndex:2]];
+    SBFireHistory *relaunched = [[SBFireHistory alloc] initWithPath:self.path];
+    [relaunched migrateFromKeychain:self.keychain];
+    XCTAssertEqual(relaunched.count, 1);
+}
+
+#pragma mark - Benchmarks
+
+- (void)testFireChecksHistoryVersusKeychain {
+    SBFireHistory *history = [[SBFireHistory alloc] initWithPath:self.path];
+    NSString *fired = [dateFormatter stringFromDate:[NSDate date]];
+    for (NSUInteger i = 0; i < 20; i++) {
+        [history recordFireOfCampaign:[self eidWithIndex:i] date:[NSDate date]];
+        [self.keychain setString:fired forKey:[self eidWithIndex:i]];
+    }
+    NSUInteger const checks = 1000;
+    // what secondsSinceLastFire: did for every matching action
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < checks; i++) {
+        NSString *lastFire = [self.keychain stringForKey:[self eidWithIndex:i % 40]];
+        if (lastFire) {
+            [[NSDate date] timeIntervalSinceDate:[dateFormatter dateFromString:lastFire]];
+        }
+    }
+    NSTimeInterval keychainTime = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < checks; i++) {
+        [history lastFireOfCampaign:[self eidWithIndex:i % 40]];
+    }
+    NSTimeInterval historyTime = CFAbsoluteTimeGetCurrent() - start;
+    NSLog(@"Fire checks, %lu lookups: keychain %.3fs, fire history %.4fs (%.0fx)",
+          (unsigned long)checks, keychainTime, historyTime, keychainTime / historyTime);
+}
+
+- (void)testPerformanceFireChecks {
+    SBFireHistory *history = [[SBFireHistory alloc] initWithPath:self.path];
+    NSMutableArray <NSString *> *eids = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 400; i++) {
+        [eids addObject:[self eidWithIndex:i]];
+        if (i % 2) {
+            [history recordFireOfCampaign:eids.lastObject date:[NSDate date]];
+        }
+    }
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 100000; i++) {
+            [history lastFireOfCampaign:eids[i % eids.count]];
+        }
+    }];
+}
+
+@end
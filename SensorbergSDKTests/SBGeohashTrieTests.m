@@ -0,0 +1,225 @@
+//
+//  SBGeohashTrieTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+#import "SBGeohashTrie.h"
+#import <objc_geohash/GeoHash.h>
+
+static NSUInteger const kSBGeohashBenchmarkRegions = 100000;
+static NSUInteger const kSBGeohashBenchmarkFixes = 2000000;
+static NSUInteger const kSBGeohashBenchmarkCities = 500;
+
+// xorshift64*, the same fixes on every run
+static uint64_t SBGeohashRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static double SBGeohashRandomUnit(uint64_t *state) {
+    return (SBGeohashRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void SBGeohashBenchmarkCities(double cities[][2]) {
+    uint64_t state = 2016;
+    for (NSUInteger i = 0; i < kSBGeohashBenchmarkCities; i++) {
+        cities[i][0] = SBGeohashRandomUnit(&state) * 120 - 60;
+        cities[i][1] = SBGeohashRandomUnit(&state) * 360 - 180;
+    }
+}
+
+@interface SBGeohashTrieTests : SBTestCase
+@property (nonatomic, strong) SBGeohashTrie *sut;
+@end
+
+@implementation SBGeohashTrieTests
+
+- (void)setUp {
+    [super setUp];
+    self.sut = [SBGeohashTrie new];
+}
+
+- (void)tearDown {
+    self.sut = nil;
+    [super tearDown];
+}
+
+- (void)testEncodingMatchesGeoHash {
+    uint64_t state = 42;
+    char hash[13];
+    for (NSUInteger i = 0; i < 10000; i++) {
+        double latitude = SBGeohashRandomUnit(&state) * 180 - 90;
+        double longitude = SBGeohashRandomUnit(&state) * 360 - 180;
+        SBGeohashEncode(latitude, longitude, 12, hash);
+        XCTAssertEqualObjects(@(hash), [GeoHash hashForLatitude:latitude longitude:longitude length:12]);
+    }
+    SBGeohashEncode(52.5219, 13.4132, 5, hash);
+    XCTAssertEqualObjects(@(hash), @"u33dc");
+}
+
+- (void)testRegionsContainingAGeohashAreItsPrefixes {
+    XCTAssertTrue([self.sut addGeohash:@"u33"]);
+    XCTAssertTrue([self.sut addGeohash:@"u33dc1"]);
+    XCTAssertTrue([self.sut addGeohash:@"U33D9"]);
+    XCTAssertTrue([self.sut addGeohash:@"u281z"]);
+    XCTAssertTrue([self.sut addGeohash:@"u33"]);
+    XCTAssertEqual(self.sut.count, 4);
+    //
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u33dc1r4npyc"], (@[@"u33", @"u33dc1"]));
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u33d9ysq"], (@[@"u33", @"u33d9"]));
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u33"], @[@"u33"]);
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u3"], @[]);
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u336xzcppuk4"], @[]);
+    XCTAssertTrue([self.sut containsGeohash:@"u33d9"]);
+    XCTAssertFalse([self.sut containsGeohash:@"u33d"]);
+}
+
+- (void)testInvalidGeohashesAreRejected {
+    XCTAssertFalse([self.sut addGeohash:@""]);
+    XCTAssertFalse([self.sut addGeohash:@"u33a"]);
+    XCTAssertFalse([self.sut addGeohash:@"u33dc1r4npyc0"]);
+    XCTAssertEqual(self.sut.count, 0);
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u33a"], @[]);
+}
+
+- (void)testRemovedRegionsNoLongerMatchAndTheirIdsAreReused {
+    [self.sut addGeohash:@"u33"];
+    [self.sut addGeohash:@"u33dc"];
+    [self.sut removeGeohash:@"u33"];
+    [self.sut removeGeohash:@"u33d"];
+    XCTAssertEqual(self.sut.count, 1);
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u33dc1"], @[@"u33dc"]);
+    [self.sut addGeohash:@"u281z"];
+    XCTAssertEqual(self.sut.count, 2);
+    XCTAssertEqualObjects([self.sut geohashOfRegionId:0], @"u281z");
+    XCTAssertEqualObjects([NSSet setWithArray:self.sut.geohashes], ([NSSet setWithObjects:@"u33dc", @"u281z", nil]));
+    //
+    [self.sut removeAllGeohashes];
+    XCTAssertEqual(self.sut.count, 0);
+    XCTAssertEqualObjects([self.sut regionsContainingGeohash:@"u33dc1"], @[]);
+}
+
+- (void)testManyRegionsMatchTheSetOfPrefixes {
+    uint64_t state = 7;
+    NSMutableSet <NSString *> *regions = [NSMutableSet new];
+    char hash[13];
+    for (NSUInteger i = 0; i < 5000; i++) {
+        SBGeohashEncode(SBGeohashRandomUnit(&state) * 10 + 45, SBGeohashRandomUnit(&state) * 10 + 5, 2 + SBGeohashRandom(&state) % 6, hash);
+        [regions addObject:@(hash)];
+        XCTAssertTrue([self.sut addGeohash:@(hash)]);
+    }
+    XCTAssertEqual(self.sut.count, regions.count);
+    for (NSUInteger i = 0; i < 5000; i++) {
+        SBGeohashEncode(SBGeohashRandomUnit(&state) * 12 + 44, SBGeohashRandomUnit(&state) * 12 + 4, 12, hash);
+        NSString *geohash = @(hash);
+        NSMutableArray *expected = [NSMutableArray new];
+        for (NSUInteger length = 1; length <= 12; length++) {
+            NSString *prefix = [geohash substringToIndex:length];
+            if ([regions containsObject:prefix]) {
+                [expected addObject:prefix];
+            }
+        }
+        XCTAssertEqualObjects([self.sut regionsContainingGeohash:geohash], expected);
+    }
+}
+
+#pragma mark - Benchmarks
+
+// regions of 5 to 8 characters (5km down to 40m) around a few hundred cities, fixes half in the cities, half anywhere
+- (void)addBenchmarkRegionsToTrie:(SBGeohashTrie *)trie set:(NSMutableSet *)set {
+    uint64_t state = 1;
+    double cities[kSBGeohashBenchmarkCities][2];
+    SBGeohashBenchmarkCities(cities);
+    char hash[13];
+    for (NSUInteger i = 0; i < kSBGeohashBenchmarkRegions; i++) {
+        double *city = cities[SBGeohashRandom(&state) % kSBGeohashBenchmarkCities];
+        SBGeohashEncode(city[0] + SBGeohashRandomUnit(&state) * 0.2 - 0.1, city[1] + SBGeohashRandomUnit(&state) * 0.2 - 0.1, 5 + SBGeohashRandom(&state) % 4, hash);
+        [trie addGeohash:@(hash)];
+        [set addObject:@(hash)];
+    }
+}
+
+- (NSUInteger)feedFixes:(NSUInteger)fixes toTrie:(SBGeohashTrie *)trie set:(NSSet *)set {
+    uint64_t state = 1979;
+    double cities[kSBGeohashBenchmarkCities][2];
+    SBGeohashBenchmarkCities(cities);
+    NSUInteger matches = 0;
+    char hash[13];
+    uint32_t ids[12];
+    for (NSUInteger i = 0; i < fixes; i++) {
+        @autoreleasepool {
+            if (i % 2) {
+                double *city = cities[SBGeohashRandom(&state) % kSBGeohashBenchmarkCities];
+                SBGeohashEncode(city[0] + SBGeohashRandomUnit(&state) * 0.2 - 0.1, city[1] + SBGeohashRandomUnit(&state) * 0.2 - 0.1, 12, hash);
+            } else {
+                SBGeohashEncode(SBGeohashRandomUnit(&state) * 120 - 60, SBGeohashRandomUnit(&state) * 360 - 180, 12, hash);
+            }
+            if (trie) {
+                matches += [trie regionIdsContainingHash:hash length:12 ids:ids maximum:12];
+            } else {
+                // the obvious alternative: look up every prefix of the fix
+                NSString *geohash = @(hash);
+                for (NSUInteger length = 1; length <= 12; length++) {
+                    if ([set containsObject:[geohash substringToIndex:length]]) {
+                        matches++;
+                    }
+                }
+            }
+        }
+    }
+    return matches;
+}
+
+- (void)testGeoRegionLookupTrieVersusPrefixSet {
+    SBGeohashTrie *trie = [SBGeohashTrie new];
+    NSMutableSet *set = [NSMutableSet new];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    [self addBenchmarkRegionsToTrie:trie set:set];
+    NSTimeInterval build = CFAbsoluteTimeGetCurrent() - start;
+    //
+    start = CFAbsoluteTimeGetCurrent();
+    NSUInteger trieMatches = [self feedFixes:kSBGeohashBenchmarkFixes toTrie:trie set:nil];
+    NSTimeInterval trieTime = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    NSUInteger setMatches = [self feedFixes:kSBGeohashBenchmarkFixes toTrie:nil set:set];
+    NSTimeInterval setTime = CFAbsoluteTimeGetCurrent() - start;
+    //
+    XCTAssertEqual(trieMatches, setMatches);
+    NSLog(@"Geo regions, %lu regions (built in %.3fs), %lu fixes, %lu matches: trie %.3fs (%.0f fixes/s), prefix set %.3fs (%.1fx)",
+          (unsigned long)trie.count, build, (unsigned long)kSBGeohashBenchmarkFixes, (unsigned long)trieMatches,
+          trieTime, kSBGeohashBenchmarkFixes / trieTime, setTime, setTime / trieTime);
+}
+
+- (void)testPerformanceGeoRegionLookup {
+    SBGeohashTrie *trie = [SBGeohashTrie new];
+    [self addBenchmarkRegionsToTrie:trie set:[NSMutableSet new]];
+    [self measureBlock:^{
+        [self feedFixes:kSBGeohashBenchmarkFixes / 10 toTrie:trie set:nil];
+    }];
+}
+
+@end
@@ -25,11 +25,14 @@
 
 #import "SBTestCase.h"
 
+#import "SensorbergSDK.h"
+
 #import "SBResolver.h"
 #import "SBSettings.h"
 #import "SBInternalModels.h"
 #import "SBEvent.h"
 #import "SBInternalEvents.h"
+#import "SBFireHistory.h"
 
 #import "SBUtility.h"
 #import <tolo/Tolo.h>
@@ -96,12 +99,13 @@
     self.defaultBeacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00030000200747"];
     self.suppressionTimeBeacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00070100001200"];
     keychain = [UICKeyChainStore keyChainStoreWithService:@"c36553abc7e22a18a4611885addd6fdf457cc69890ba4edc7650fe242aa42378"];
+    [[SBFireHistory sharedHistory] removeAllFires];
 
-    REGISTER();
+    SB_REGISTER();
 }
 
 - (void)tearDown {
-    UNREGISTER();
+    SB_UNREGISTER();
     self.expectation = nil;
     self.expectedEvent = nil;
     self.defaultLayoutDict = nil;
@@ -111,6 +115,7 @@
     self.expectedReportHistoryEvent = nil;
     [keychain removeAllItems];
     keychain = nil;
+    [[SBFireHistory sharedHistory] removeAllFires];
     [super tearDown];
 }
 
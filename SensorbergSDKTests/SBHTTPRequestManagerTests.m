@@ -26,10 +26,15 @@
 #import "SBTestCase.h"
 #import "SBHTTPRequestManager.h"
 #import "SBEvent.h"
+#import "SBTestURLProtocol.h"
 
 #import <tolo/Tolo.h>
 
 
+@interface SBHTTPRequestManager (XCTests)
+- (NSURLSession *)sessionForCachePolicy:(NSURLRequestCachePolicy)cachePolicy;
+@end
+
 @interface SBHTTPRequestManagerTests : SBTestCase
 @property (nonatomic, strong) SBHTTPRequestManager *sut;
 @end
@@ -139,5 +144,88 @@
     self.sut = nil;
 }
 
+- (void)test005SessionsAreReusedPerCachePolicy
+{
+    self.sut = [SBHTTPRequestManager new];
+    NSURLSession *session = [self.sut sessionForCachePolicy:NSURLRequestReloadIgnoringLocalCacheData];
+    XCTAssertEqual([self.sut sessionForCachePolicy:NSURLRequestReloadIgnoringLocalCacheData], session);
+    XCTAssertNotEqual([self.sut sessionForCachePolicy:NSURLRequestReturnCacheDataElseLoad], session);
+    
+    self.sut.sessionConfiguration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    XCTAssertNotEqual([self.sut sessionForCachePolicy:NSURLRequestReloadIgnoringLocalCacheData], session);
+    self.sut = nil;
+}
+
+- (void)test006PingIsNotQueuedBehindUploads
+{
+    NSMutableArray <NSString *> *requests = [NSMutableArray new];
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        @synchronized (requests) {
+            [requests addObject:request.HTTPMethod];
+        }
+        return [NSData data];
+    }];
+    [SBTestURLProtocol install];
+    
+    SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
+    NSUInteger postCount = 8;
+    __block NSUInteger completions = 0;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Wait for all requests"];
+    void (^completed)(void) = ^{
+        if (++completions == postCount + 1) {
+            [expectation fulfill];
+        }
+    };
+    // queue everything before anything runs, the ping is queued last
+    [manager.operationQueue setSuspended:YES];
+    NSURL *URL = [NSURL URLWithString:@"https://resolver.sensorberg.com/layout"];
+    for (NSUInteger i = 0; i < postCount; i++) {
+        [manager postData:[self postData] URL:URL headerFields:@{} completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+            completed();
+        }];
+    }
+    [manager getDataFromURL:[NSURL URLWithString:@"https://resolver.sensorberg.com/"] headerFields:nil useCache:NO priority:NSOperationQueuePriorityVeryHigh completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+        completed();
+    }];
+    [manager.operationQueue setSuspended:NO];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    [SBTestURLProtocol uninstall];
+    
+    // the ping starts with the first batch instead of after all uploads
+    NSUInteger pingIndex = [requests indexOfObject:@"GET"];
+    XCTAssertNotEqual(pingIndex, NSNotFound);
+    XCTAssertLessThan(pingIndex, postCount / 2);
+}
+
+- (void)test007ConnectionIsReused
+{
+    self.sut = [SBHTTPRequestManager new];
+    NSURL *URL = [NSURL URLWithString:@"https://resolver.sensorberg.com/layout"];
+    NSDictionary *httpHeader = @{@"X-Api-Key" : @"c36553abc7e22a18a4611885addd6fdf457cc69890ba4edc7650fe242aa42378",
+                                 @"Content-Type" : @"application/json"};
+    for (NSUInteger i = 0; i < 2; i++) {
+        XCTestExpectation *expectation = [self expectationWithDescription:@"Wait for connect server response"];
+        [self.sut getDataFromURL:URL headerFields:httpHeader useCache:NO completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+            XCTAssertNil(error);
+            [expectation fulfill];
+        }];
+        [self waitForExpectationsWithTimeout:4 handler:nil];
+    }
+    
+    if ([NSURLSessionTaskMetrics class]) {
+        // the metrics arrive on the session queue, shortly after the completion
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:.5]];
+        SBHTTPConnectionMetrics *metrics = [self.sut connectionMetrics];
+        XCTAssertEqual(metrics.requestCount, 2);
+        XCTAssertEqual(metrics.openedConnectionCount, 1);
+        XCTAssertEqual(metrics.reusedConnectionCount, 1);
+        // the snapshot keeps its counts, the manager starts over
+        [self.sut resetConnectionMetrics];
+        XCTAssertEqual(metrics.requestCount, 2);
+        XCTAssertEqual([self.sut connectionMetrics].requestCount, 0);
+        XCTAssertEqual([self.sut connectionMetrics].fetchDuration, 0);
+    }
+    self.sut = nil;
+}
 
 @end
@@ -0,0 +1,261 @@
+//
+//  SBHTTPValidatorTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+
+#import "SensorbergSDK.h"
+
+#import "SBResolver.h"
+#import "SBInternalEvents.h"
+#import "SBHTTPRequestManager.h"
+#import "SBHTTPValidatorCache.h"
+#import "SBTestURLProtocol.h"
+
+#import <tolo/Tolo.h>
+
+@interface SBHTTPValidatorTests : SBTestCase
+@property (nonatomic, copy) NSString *directory;
+@property (nonatomic, strong) SBHTTPValidatorCache *previousCache;
+@property (nonatomic, strong) NSMutableArray <SBEventGetLayout *> *layoutEvents;
+@property (nonatomic, strong) XCTestExpectation *layoutExpectation;
+@end
+
+@implementation SBHTTPValidatorTests
+
+- (void)setUp {
+    [super setUp];
+    self.continueAfterFailure = NO;
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
+    self.previousCache = manager.validatorCache;
+    manager.validatorCache = [[SBHTTPValidatorCache alloc] initWithDirectory:self.directory];
+    self.layoutEvents = [NSMutableArray new];
+    SB_REGISTER();
+    [SBTestURLProtocol install];
+}
+
+- (void)tearDown {
+    [SBTestURLProtocol uninstall];
+    SB_UNREGISTER();
+    [SBHTTPRequestManager sharedManager].validatorCache = self.previousCache;
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    self.layoutEvents = nil;
+    self.layoutExpectation = nil;
+    [super tearDown];
+}
+
+SUBSCRIBE(SBEventGetLayout) {
+    [self.layoutEvents addObject:event];
+    [self.layoutExpectation fulfill];
+}
+
+- (NSData *)layoutData {
+    NSDictionary *layout = @{@"accountProximityUUIDs": @[@"7367672374000000ffff0000ffff0003"],
+                             @"actions": @[@{@"eid": @"367348a0dfa84492a0078ead26cf9385",
+                                             @"trigger": @(kSBTriggerEnter),
+                                             @"beacons": @[@"7367672374000000ffff0000ffff00030000200747"],
+                                             @"type": @(1)}]};
+    return [NSJSONSerialization dataWithJSONObject:layout options:0 error:nil];
+}
+
+// ETag "v1": 304 when the client has it, the layout otherwise
+- (void)serveLayoutWithRequestLog:(NSMutableArray <NSURLRequest *> *)requests {
+    NSData *layoutData = [self layoutData];
+    [SBTestURLProtocol setResponseHeaderFields:@{@"ETag": @"\"v1\""}];
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        @synchronized (requests) {
+            [requests addObject:request];
+        }
+        if ([[request valueForHTTPHeaderField:@"If-None-Match"] isEqualToString:@"\"v1\""]) {
+            *statusCode = 304;
+            return nil;
+        }
+        return layoutData;
+    }];
+}
+
+- (void)waitForRunLoop:(NSTimeInterval)interval {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:interval]];
+}
+
+- (void)test000NotModifiedLayoutIsNotPublishedAgain {
+    NSMutableArray *requests = [NSMutableArray new];
+    [self serveLayoutWithRequestLog:requests];
+    SBResolver *resolver = [[SBResolver alloc] initWithApiKey:@"TestAPIKey"];
+    
+    self.layoutExpectation = [self expectationWithDescription:@"Wait for the layout"];
+    [resolver requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    self.layoutExpectation = nil;
+    XCTAssertNil([requests.firstObject valueForHTTPHeaderField:@"If-None-Match"]);
+    
+    // both cache modes share one revalidation
+    [resolver requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:YES];
+    [resolver requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
+    [self waitForRunLoop:1];
+    
+    XCTAssertEqual(requests.count, 2);
+    XCTAssertEqualObjects([requests[1] valueForHTTPHeaderField:@"If-None-Match"], @"\"v1\"");
+    XCTAssertEqual(resolver.coalescedLayoutRequestCount, 1);
+    XCTAssertEqual(self.layoutEvents.count, 1);
+}
+
+- (void)test001StoredLayoutIsPublishedByANewResolver {
+    NSMutableArray *requests = [NSMutableArray new];
+    [self serveLayoutWithRequestLog:requests];
+    
+    self.layoutExpectation = [self expectationWithDescription:@"Wait for the layout"];
+    [[[SBResolver alloc] initWithApiKey:@"TestAPIKey"] requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    // e.g. after a relaunch: a 304, but nothing parsed yet
+    self.layoutExpectation = [self expectationWithDescription:@"Wait for the stored layout"];
+    [[[SBResolver alloc] initWithApiKey:@"TestAPIKey"] requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    XCTAssertEqual(requests.count, 2);
+    XCTAssertEqualObjects([requests[1] valueForHTTPHeaderField:@"If-None-Match"], @"\"v1\"");
+    XCTAssertEqual(self.layoutEvents.count, 2);
+    XCTAssertNil(self.layoutEvents.lastObject.error);
+    XCTAssertEqualObjects(self.layoutEvents.lastObject.layout.actions.firstObject.eid, @"367348a0dfa84492a0078ead26cf9385");
+}
+
+- (void)test002LastModifiedIsSentAsIfModifiedSince {
+    NSString *lastModified = @"Wed, 01 Jun 2016 07:36:02 GMT";
+    NSData *settings = [@"{\"settings\":{}}" dataUsingEncoding:NSUTF8StringEncoding];
+    [SBTestURLProtocol setResponseHeaderFields:@{@"Last-Modified": lastModified}];
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        if ([[request valueForHTTPHeaderField:@"If-Modified-Since"] isEqualToString:lastModified]) {
+            *statusCode = 304;
+            return nil;
+        }
+        return settings;
+    }];
+    
+    SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
+    NSURL *URL = [NSURL URLWithString:@"https://resolver.sensorberg.com/applications/TestAPIKey/settings/iOS"];
+    __block BOOL notModified = YES;
+    __block NSData *data;
+    XCTestExpectation *first = [self expectationWithDescription:@"First response"];
+    [manager conditionalGetDataFromURL:URL headerFields:nil revalidate:YES completion:^(NSData *responseData, BOOL responseNotModified, NSError *error) {
+        XCTAssertNil(error);
+        notModified = responseNotModified;
+        [first fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    XCTAssertFalse(notModified);
+    
+    XCTestExpectation *second = [self expectationWithDescription:@"Second response"];
+    [manager conditionalGetDataFromURL:URL headerFields:nil revalidate:YES completion:^(NSData *responseData, BOOL responseNotModified, NSError *error) {
+        XCTAssertNil(error);
+        notModified = responseNotModified;
+        data = responseData;
+        [second fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    XCTAssertTrue(notModified);
+    XCTAssertEqualObjects(data, settings);
+}
+
+- (void)test003ValidatorsAreKeptPerQuery {
+    NSMutableArray *requests = [NSMutableArray new];
+    [self serveLayoutWithRequestLog:requests];
+    
+    SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
+    NSURL *URL = [NSURL URLWithString:@"https://resolver.sensorberg.com/layout?gender=female"];
+    NSURL *otherURL = [NSURL URLWithString:@"https://resolver.sensorberg.com/layout?gender=male"];
+    XCTestExpectation *first = [self expectationWithDescription:@"First response"];
+    [manager conditionalGetDataFromURL:URL headerFields:nil revalidate:YES completion:^(NSData *data, BOOL notModified, NSError *error) {
+        [first fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    __block BOOL otherNotModified = YES;
+    XCTestExpectation *second = [self expectationWithDescription:@"Other attributes"];
+    [manager conditionalGetDataFromURL:otherURL headerFields:nil revalidate:YES completion:^(NSData *data, BOOL notModified, NSError *error) {
+        otherNotModified = notModified;
+        [second fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    XCTAssertFalse(otherNotModified);
+    XCTAssertNil([requests[1] valueForHTTPHeaderField:@"If-None-Match"]);
+    XCTAssertNotNil([manager.validatorCache cachedDataForURL:URL]);
+    XCTAssertNotNil([manager.validatorCache cachedDataForURL:otherURL]);
+}
+
+- (void)test004ValidatorsSurviveARestart {
+    NSMutableArray *requests = [NSMutableArray new];
+    [self serveLayoutWithRequestLog:requests];
+    
+    NSURL *URL = [NSURL URLWithString:@"https://resolver.sensorberg.com/layout"];
+    XCTestExpectation *first = [self expectationWithDescription:@"First response"];
+    [[SBHTTPRequestManager sharedManager] conditionalGetDataFromURL:URL headerFields:nil revalidate:YES completion:^(NSData *data, BOOL notModified, NSError *error) {
+        [first fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    SBHTTPValidatorCache *reloaded = [[SBHTTPValidatorCache alloc] initWithDirectory:self.directory];
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:URL];
+    XCTAssertTrue([reloaded addValidatorsToRequest:request]);
+    XCTAssertEqualObjects([request valueForHTTPHeaderField:@"If-None-Match"], @"\"v1\"");
+    XCTAssertEqualObjects([reloaded cachedDataForURL:URL], [self layoutData]);
+}
+
+- (void)test005StoredLayoutOnlyAnswersTheCallersAskingForIt {
+    NSMutableArray *requests = [NSMutableArray new];
+    [self serveLayoutWithRequestLog:requests];
+    self.layoutExpectation = [self expectationWithDescription:@"Wait for the layout"];
+    [[[SBResolver alloc] initWithApiKey:@"TestAPIKey"] requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    self.layoutExpectation = nil;
+    // the resolver can't be reached now
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        *statusCode = 503;
+        return nil;
+    }];
+    
+    SBMBeacon *beacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00030000200747"];
+    SBResolver *resolver = [[SBResolver alloc] initWithApiKey:@"TestAPIKey"];
+    [resolver requestLayoutForBeacon:beacon trigger:kSBTriggerExit useCache:NO];
+    [resolver requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:YES];
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        return self.layoutEvents.count >= 3;
+    }] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    [self waitForRunLoop:.5];
+    
+    XCTAssertEqual(resolver.coalescedLayoutRequestCount, 1);
+    XCTAssertEqual(self.layoutEvents.count, 3);
+    // the caller without useCache gets the error
+    XCTAssertNotNil(self.layoutEvents[1].error);
+    XCTAssertEqualObjects(self.layoutEvents[1].beacon, beacon);
+    // the other one the stored layout
+    XCTAssertNil(self.layoutEvents[2].error);
+    XCTAssertEqualObjects(self.layoutEvents[2].layout.actions.firstObject.eid, @"367348a0dfa84492a0078ead26cf9385");
+}
+
+@end
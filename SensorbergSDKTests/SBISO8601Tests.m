@@ -0,0 +1,201 @@
+//
+//  SBISO8601Tests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "SBTestCase.h"
+
+#import "SBISO8601.h"
+#import "SBUtility.h"
+#import "SensorbergSDK.h"
+
+static NSUInteger const kSBISO8601BenchmarkCount = 100000;
+
+@interface SBISO8601Tests : SBTestCase
+@end
+
+@implementation SBISO8601Tests
+
+- (BOOL)parse:(NSString *)string millis:(int64_t *)millis {
+    const char *characters = string.UTF8String;
+    return SBISO8601ParseMillis(characters, strlen(characters), millis);
+}
+
+// APIDateFormat in the time zone `offset` minutes east of UTC, as the server or an older SDK may write it
+- (NSDateFormatter *)formatterWithOffset:(NSInteger)offset {
+    NSDateFormatter *formatter = [NSDateFormatter new];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
+    formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:offset * 60];
+    formatter.dateFormat = APIDateFormat;
+    return formatter;
+}
+
+- (void)test000ParsesTheZones {
+    int64_t millis;
+    NSDictionary <NSString *, NSNumber *> *samples = @{ @"2016-05-01T10:00:00.000+0000"     : @1462096800000,
+                                                        @"2016-05-01T10:00:00.000Z"         : @1462096800000,
+                                                        @"2016-05-01T12:00:00.125+02:00"    : @1462096800125,
+                                                        @"2016-05-01T07:30:00.5-02:30"      : @1462096800500,
+                                                        @"2016-05-01T10:00:00+00"           : @1462096800000,
+                                                        @"2016-05-01T10:00:00.123999Z"      : @1462096800123,
+                                                        @"1969-12-31T23:59:59.999Z"         : @-1,
+                                                        @"2000-02-29T00:00:00.000Z"         : @951782400000 };
+    [samples enumerateKeysAndObjectsUsingBlock:^(NSString *string, NSNumber *expected, BOOL *stop) {
+        int64_t parsed = 0;
+        XCTAssertTrue([self parse:string millis:&parsed], @"%@", string);
+        XCTAssertEqual(parsed, expected.longLongValue, @"%@", string);
+    }];
+    XCTAssertEqualObjects(SBISO8601DateFromString(@"2016-05-01T12:00:00.125+02:00"), [NSDate dateWithTimeIntervalSince1970:1462096800.125]);
+    // not ASCII, not stored as C string
+    XCTAssertNil(SBISO8601DateFromString(@"2016-05-01T12:00:00.125+02:00 🎉"));
+    XCTAssertNil(SBISO8601DateFromString((NSString *)[NSNull null]));
+    XCTAssertFalse(SBISO8601ParseMillis(NULL, 0, &millis));
+}
+
+- (void)test001RejectsMalformedTimestamps {
+    NSArray <NSString *> *samples = @[@"",
+                                      @"2016-05-01",
+                                      @"2016-05-01 10:00:00.000Z",
+                                      @"2016-13-01T10:00:00.000Z",
+                                      @"2016-00-01T10:00:00.000Z",
+                                      @"2016-04-31T10:00:00.000Z",
+                                      @"2001-02-29T10:00:00.000Z",
+                                      @"1900-02-29T10:00:00.000Z",
+                                      @"2016-05-01T24:00:00.000Z",
+                                      @"2016-05-01T10:60:00.000Z",
+                                      @"2016-05-01T10:00:60.000Z",
+                                      @"2016-05-01T10:00:00.Z",
+                                      @"2016-05-01T10:00:00.000",
+                                      @"2016-05-01T10:00:00.000+1",
+                                      @"2016-05-01T10:00:00.000+01:",
+                                      @"2016-05-01T10:00:00.000+01:3",
+                                      @"2016-05-01T10:00:00.000+24:00",
+                                      @"2016-05-01T10:00:00.000Z ",
+                                      @"+016-05-01T10:00:00.000Z"];
+    for (NSString *string in samples) {
+        int64_t millis;
+        XCTAssertFalse([self parse:string millis:&millis], @"%@", string);
+        XCTAssertNil(SBISO8601DateFromString(string), @"%@", string);
+    }
+}
+
+- (void)test002FuzzAgainstDateFormatter {
+    NSMutableDictionary <NSNumber *, NSDateFormatter *> *formatters = [NSMutableDictionary new];
+    srand48(8601);
+    for (NSUInteger i = 0; i < 20000; i++) {
+        int64_t millis = (int64_t)(drand48() * 4102444800000.0);
+        // quarter hours from -12:00 to +14:00
+        NSInteger offset = (NSInteger)(drand48() * 105) * 15 - 720;
+        NSDateFormatter *formatter = formatters[@(offset)] ?: (formatters[@(offset)] = [self formatterWithOffset:offset]);
+        NSDate *date = [NSDate dateWithTimeIntervalSince1970:millis / 1000.0];
+        NSString *string = [formatter stringFromDate:date];
+        //
+        int64_t parsed;
+        XCTAssertTrue([self parse:string millis:&parsed], @"%@", string);
+        XCTAssertEqual(parsed, SBISO8601MillisFromDate([formatter dateFromString:string]), @"%@", string);
+        // what we write, the formatter reads
+        NSString *formatted = SBISO8601StringFromDate(date);
+        XCTAssertEqual(SBISO8601MillisFromDate([formatter dateFromString:formatted]), SBISO8601MillisFromDate(date), @"%@", formatted);
+        XCTAssertEqual(SBISO8601MillisFromDate(SBISO8601DateFromString(formatted)), SBISO8601MillisFromDate(date), @"%@", formatted);
+        //
+        // garbled: whatever both accept, they agree on
+        NSMutableData *garbled = [[string dataUsingEncoding:NSASCIIStringEncoding] mutableCopy];
+        char *bytes = garbled.mutableBytes;
+        for (NSUInteger j = 0, count = 1 + (NSUInteger)(drand48() * 3); j < count; j++) {
+            bytes[(NSUInteger)(drand48() * garbled.length)] = (char)(32 + drand48() * 95);
+        }
+        if (drand48() < 0.2) {
+            garbled.length = (NSUInteger)(drand48() * garbled.length);
+        }
+        NSString *garbledString = [[NSString alloc] initWithData:garbled encoding:NSASCIIStringEncoding];
+        NSDate *ours = SBISO8601DateFromString(garbledString);
+        NSDate *theirs = [formatter dateFromString:garbledString];
+        if (ours && theirs) {
+            XCTAssertEqual(SBISO8601MillisFromDate(ours), SBISO8601MillisFromDate(theirs), @"%@", garbledString);
+        }
+    }
+}
+
+#pragma mark - Benchmarks
+
+- (NSArray <NSString *> *)benchmarkStrings {
+    NSMutableArray *strings = [NSMutableArray arrayWithCapacity:kSBISO8601BenchmarkCount];
+    for (NSUInteger i = 0; i < kSBISO8601BenchmarkCount; i++) {
+        [strings addObject:SBISO8601StringFromDate([NSDate dateWithTimeIntervalSince1970:1462096800.125 + i * 61.001])];
+    }
+    return strings;
+}
+
+- (void)testDateFormatterVersusISO8601 {
+    NSArray <NSString *> *strings = [self benchmarkStrings];
+    NSMutableArray <NSDate *> *dates = [NSMutableArray arrayWithCapacity:strings.count];
+    //
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSString *string in strings) {
+        @autoreleasepool {
+            [dates addObject:[dateFormatter dateFromString:string]];
+        }
+    }
+    NSTimeInterval formatterParse = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSDate *date in dates) {
+        @autoreleasepool {
+            [dateFormatter stringFromDate:date];
+        }
+    }
+    NSTimeInterval formatterFormat = CFAbsoluteTimeGetCurrent() - start;
+    //
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSString *string in strings) {
+        @autoreleasepool {
+            SBISO8601DateFromString(string);
+        }
+    }
+    NSTimeInterval parse = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSDate *date in dates) {
+        @autoreleasepool {
+            SBISO8601StringFromDate(date);
+        }
+    }
+    NSTimeInterval format = CFAbsoluteTimeGetCurrent() - start;
+    NSLog(@"ISO-8601, %lu timestamps: parse formatter %.3fs, SBISO8601 %.3fs (%.0fx); format formatter %.3fs, SBISO8601 %.3fs (%.0fx)",
+          (unsigned long)strings.count, formatterParse, parse, formatterParse / parse, formatterFormat, format, formatterFormat / format);
+}
+
+- (void)testPerformanceParseMillis {
+    NSMutableData *buffers = [NSMutableData dataWithLength:kSBISO8601BenchmarkCount * kSBISO8601Length];
+    char *bytes = buffers.mutableBytes;
+    for (NSUInteger i = 0; i < kSBISO8601BenchmarkCount; i++) {
+        SBISO8601FormatMillis(1462096800125 + (int64_t)i * 61001, bytes + i * kSBISO8601Length);
+    }
+    [self measureBlock:^{
+        int64_t millis;
+        for (NSUInteger i = 0; i < kSBISO8601BenchmarkCount; i++) {
+            SBISO8601ParseMillis(bytes + i * kSBISO8601Length, kSBISO8601Length, &millis);
+        }
+    }];
+}
+
+@end
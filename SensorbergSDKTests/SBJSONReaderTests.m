@@ -0,0 +1,387 @@
+//
+//  SBJSONReaderTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "SBTestCase.h"
+
+#import "SBJSONReader.h"
+#import "SBJSONWriter.h"
+#import "SBResolver.h"
+#import "SBCampaignIndex.h"
+#import "SBISO8601.h"
+
+static NSString *const kSBFixtureLayout = @"bfdfe1ec8020c2adb1ad7e56ce2fbf75791ce7213b505d63de5d6d3d39717a22";
+
+@interface SBJSONReaderTests : SBTestCase
+@end
+
+@implementation SBJSONReaderTests
+
+- (SBJSONReader *)readerWithString:(NSString *)string {
+    return [[SBJSONReader alloc] initWithData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+// what the resolver did before: NSJSONSerialization, then JSONModel
+- (SBMGetLayout *)JSONModelLayoutWithData:(NSData *)data {
+    NSDictionary *object = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    NSError *error;
+    SBMGetLayout *layout = [[SBMGetLayout alloc] initWithDictionary:object error:&error];
+    XCTAssertNil(error);
+    return layout;
+}
+
+// a resolver response with `count` actions, using every field the models have and some they don't
+- (NSData *)layoutDataWithActionCount:(NSUInteger)count {
+    srand48(42);
+    NSMutableArray *actions = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSMutableArray *beacons = [NSMutableArray new];
+        NSUInteger beaconCount = 1 + lrand48() % 3;
+        for (NSUInteger b = 0; b < beaconCount; b++) {
+            long beacon = lrand48() % 500;
+            [beacons addObject:[NSString stringWithFormat:@"73676723740000%02luffff0000ffff0003%05lu%05lu", (unsigned long)(beacon % 8), (unsigned long)(beacon / 100), (unsigned long)(beacon % 100)]];
+        }
+        if (i % 10 == 0) {
+            // dropped by both
+            [beacons addObject:@"not a beacon"];
+        }
+        int64_t start = 1451606400000 + lrand48() % 100000 * 1000 + lrand48() % 1000;
+        NSMutableDictionary *timeframe = [@{@"start": SBISO8601StringFromDate([NSDate dateWithTimeIntervalSince1970:start / 1000.0])} mutableCopy];
+        if (i % 3) {
+            timeframe[@"end"] = SBISO8601StringFromDate([NSDate dateWithTimeIntervalSince1970:(start + 86400000) / 1000.0]);
+        }
+        NSMutableDictionary *action = [@{@"eid": [NSString stringWithFormat:@"%032lu", (unsigned long)i],
+                                         @"trigger": @(1 + lrand48() % 3),
+                                         @"beacons": beacons,
+                                         @"type": @(1 + lrand48() % 3),
+                                         @"suppressionTime": @(lrand48() % 3600),
+                                         @"delay": @(lrand48() % 2 * 60),
+                                         @"reportImmediately": @(i % 2 == 0),
+                                         @"sendOnlyOnce": @(i % 3 == 0),
+                                         @"typeString": @"notification",
+                                         @"supressionTime": @(-1),
+                                         @"content": @{@"subject": [NSString stringWithFormat:@"Subject \"%lu\" ü", (unsigned long)i],
+                                                       @"body": @"Body\nwith 🎉",
+                                                       @"payload": i % 2 ? @{@"key": @"value", @"list": @[@1, @2.5, @YES, [NSNull null]]} : [NSNull null],
+                                                       @"url": @"http://www.sensorberg.com/?q=\"x\""},
+                                         @"timeframes": @[timeframe]} mutableCopy];
+        if (i % 4 == 0) {
+            action[@"deliverAt"] = SBISO8601StringFromDate([NSDate dateWithTimeIntervalSince1970:start / 1000.0]);
+        }
+        [actions addObject:action];
+    }
+    NSDictionary *layout = @{@"accountProximityUUIDs": @[@"7367672374000000ffff0000ffff0003", @"73676723740000000000000000000000"],
+                             @"reportTrigger": @(3600),
+                             @"actions": actions,
+                             @"currentVersion": @YES,
+                             @"instantActions": @[],
+                             @"unknown": @{@"nested": @[@{@"deep": @"value"}]}};
+    return [NSJSONSerialization dataWithJSONObject:layout options:0 error:nil];
+}
+
+- (void)assertTimeframe:(SBMTimeframe *)timeframe equalTo:(SBMTimeframe *)expected {
+    XCTAssertEqualWithAccuracy(timeframe.start.timeIntervalSince1970, expected.start.timeIntervalSince1970, 1e-6);
+    XCTAssertEqualWithAccuracy(timeframe.end.timeIntervalSince1970, expected.end.timeIntervalSince1970, 1e-6);
+    XCTAssertEqual(timeframe.start == nil, expected.start == nil);
+    XCTAssertEqual(timeframe.end == nil, expected.end == nil);
+}
+
+- (void)assertContent:(SBMContent *)content equalTo:(SBMContent *)expected {
+    XCTAssertEqualObjects(content.subject, expected.subject);
+    XCTAssertEqualObjects(content.body, expected.body);
+    XCTAssertEqualObjects(content.payload, expected.payload);
+    XCTAssertEqualObjects(content.url, expected.url);
+}
+
+- (void)assertAction:(SBMAction *)action equalTo:(SBMAction *)expected {
+    XCTAssertEqualObjects(action.eid, expected.eid);
+    XCTAssertEqual(action.trigger, expected.trigger);
+    XCTAssertEqualObjects([action.beacons valueForKey:@"fullUUID"], [expected.beacons valueForKey:@"fullUUID"]);
+    for (id beacon in action.beacons) {
+        XCTAssert([beacon isKindOfClass:[SBMBeacon class]]);
+    }
+    XCTAssertEqual(action.suppressionTime, expected.suppressionTime);
+    XCTAssertEqual(action.delay, expected.delay);
+    XCTAssertEqual(action.reportImmediately, expected.reportImmediately);
+    XCTAssertEqual(action.sendOnlyOnce, expected.sendOnlyOnce);
+    XCTAssertEqualWithAccuracy(action.deliverAt.timeIntervalSince1970, expected.deliverAt.timeIntervalSince1970, 1e-6);
+    XCTAssertEqual(action.deliverAt == nil, expected.deliverAt == nil);
+    [self assertContent:action.content equalTo:expected.content];
+    XCTAssertEqual(action.type, expected.type);
+    XCTAssertEqual(action.timeframes.count, expected.timeframes.count);
+    for (NSUInteger i = 0; i < MIN(action.timeframes.count, expected.timeframes.count); i++) {
+        [self assertTimeframe:action.timeframes[i] equalTo:expected.timeframes[i]];
+    }
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    XCTAssertEqualObjects(action.typeString, expected.typeString);
+#pragma clang diagnostic pop
+    XCTAssertEqualObjects(action.location, expected.location);
+    XCTAssertEqualObjects(action.pid, expected.pid);
+    XCTAssertEqualObjects(action.dt, expected.dt);
+}
+
+- (void)assertLayout:(SBMGetLayout *)layout equalTo:(SBMGetLayout *)expected {
+    XCTAssertNotNil(layout);
+    XCTAssertEqualObjects(layout.accountProximityUUIDs, expected.accountProximityUUIDs);
+    XCTAssertEqual(layout.reportTrigger, expected.reportTrigger);
+    XCTAssertEqual(layout.currentVersion, expected.currentVersion);
+    XCTAssertEqual(layout.instantActions.count, expected.instantActions.count);
+    for (NSUInteger i = 0; i < MIN(layout.instantActions.count, expected.instantActions.count); i++) {
+        [self assertContent:layout.instantActions[i] equalTo:expected.instantActions[i]];
+    }
+    XCTAssertEqual(layout.actions.count, expected.actions.count);
+    for (NSUInteger i = 0; i < MIN(layout.actions.count, expected.actions.count); i++) {
+        [self assertAction:layout.actions[i] equalTo:expected.actions[i]];
+    }
+    XCTAssertEqual(layout.campaignIndex.beaconCount, expected.campaignIndex.beaconCount);
+}
+
+#pragma mark - Tokens
+
+- (void)test000WalksTokens {
+    SBJSONReader *reader = [self readerWithString:@" {\"s\": \"a\\\"b\\\\c\\/d\\n\\u00e9\\ud83c\\udf89\", \"n\": [0, -12, 1.5e3, 123456789012345678],\r\n\"b\": true, \"z\": null, \"o\": {}, \"k\\u0065y\": 1} "];
+    SBJSONKey key;
+    double number;
+    BOOL flag;
+    XCTAssertEqual([reader peekType], SBJSONTypeObject);
+    XCTAssert([reader beginObject]);
+    
+    XCTAssert([reader nextKey:&key]);
+    XCTAssert(SBJSONKeyIs(key, "s"));
+    XCTAssertEqual([reader peekType], SBJSONTypeString);
+    XCTAssertEqualObjects([reader readString], @"a\"b\\c/d\né🎉");
+    
+    XCTAssert([reader nextKey:&key]);
+    XCTAssert(SBJSONKeyIs(key, "n"));
+    XCTAssert([reader beginArray]);
+    NSMutableArray *numbers = [NSMutableArray new];
+    while ([reader nextElement]) {
+        XCTAssertEqual([reader peekType], SBJSONTypeNumber);
+        XCTAssert([reader readDouble:&number]);
+        [numbers addObject:@(number)];
+    }
+    XCTAssertEqualObjects(numbers, (@[@0, @(-12), @1500, @(123456789012345678.0)]));
+    
+    XCTAssert([reader nextKey:&key]);
+    XCTAssert(SBJSONKeyIs(key, "b"));
+    XCTAssertEqual([reader peekType], SBJSONTypeBool);
+    XCTAssert([reader readBool:&flag]);
+    XCTAssertTrue(flag);
+    
+    XCTAssert([reader nextKey:&key]);
+    XCTAssert(SBJSONKeyIs(key, "z"));
+    XCTAssertEqual([reader peekType], SBJSONTypeNull);
+    XCTAssertNil([reader readString]);
+    
+    XCTAssert([reader nextKey:&key]);
+    XCTAssert(SBJSONKeyIs(key, "o"));
+    XCTAssert([reader beginObject]);
+    XCTAssertFalse([reader nextKey:&key]);
+    
+    // keys are unescaped
+    XCTAssert([reader nextKey:&key]);
+    XCTAssert(SBJSONKeyIs(key, "key"));
+    [reader skipValue];
+    
+    XCTAssertFalse([reader nextKey:&key]);
+    XCTAssert([reader finish]);
+    XCTAssertNil(reader.error);
+    XCTAssertEqual([reader peekType], SBJSONTypeNone);
+}
+
+- (void)test001RejectsInvalidJSON {
+    NSArray *invalid = @[@"", @"{", @"[1,]", @"{\"a\":1,}", @"[1 2]", @"{\"a\" 1}", @"{1:2}", @"[01]", @"[1.]", @"[-]", @"[1e]",
+                         @"[\"\\x\"]", @"[\"\\u12\"]", @"[\"a\nb\"]", @"[nul]", @"[truex]", @"{} {}", @"[,1]", @"{,}", @"\"open"];
+    for (NSString *string in invalid) {
+        SBJSONReader *reader = [self readerWithString:string];
+        [reader skipValue];
+        XCTAssertFalse([reader finish], @"%@", string);
+        XCTAssertEqualObjects(reader.error.domain, NSCocoaErrorDomain);
+        XCTAssertEqual(reader.error.code, NSPropertyListReadCorruptError);
+        // NSJSONSerialization agrees
+        XCTAssertNil([NSJSONSerialization JSONObjectWithData:[string dataUsingEncoding:NSUTF8StringEncoding] options:NSJSONReadingAllowFragments error:nil], @"%@", string);
+    }
+    
+    // not UTF-8
+    uint8_t latin1[] = {'[', '"', 0xe9, '"', ']'};
+    SBJSONReader *reader = [[SBJSONReader alloc] initWithData:[NSData dataWithBytes:latin1 length:sizeof(latin1)]];
+    XCTAssert([reader beginArray]);
+    XCTAssert([reader nextElement]);
+    XCTAssertNil([reader readString]);
+    XCTAssertFalse([reader finish]);
+    
+    // nesting is limited, like NSJSONSerialization does
+    NSString *deep = [[@"" stringByPaddingToLength:1000 withString:@"[" startingAtIndex:0] stringByAppendingString:[@"" stringByPaddingToLength:1000 withString:@"]" startingAtIndex:0]];
+    reader = [self readerWithString:deep];
+    [reader skipValue];
+    XCTAssertFalse([reader finish]);
+}
+
+- (void)test002ConvertsTypesLikeJSONModel {
+    SBJSONReader *reader = [self readerWithString:@"[42, \"7.5\", true, \"true\", 0, \"2016-06-01T07:36:02.565+0000\", 1464766562.5, \"not a date\", {\"skipped\": [1]}]"];
+    double number;
+    BOOL flag;
+    XCTAssert([reader beginArray]);
+    XCTAssert([reader nextElement]);
+    XCTAssertEqualObjects([reader readString], @"42");
+    XCTAssert([reader nextElement]);
+    XCTAssert([reader readDouble:&number]);
+    XCTAssertEqual(number, 7.5);
+    XCTAssert([reader nextElement]);
+    XCTAssert([reader readDouble:&number]);
+    XCTAssertEqual(number, 1);
+    XCTAssert([reader nextElement]);
+    XCTAssert([reader readBool:&flag]);
+    XCTAssertTrue(flag);
+    XCTAssert([reader nextElement]);
+    XCTAssert([reader readBool:&flag]);
+    XCTAssertFalse(flag);
+    XCTAssert([reader nextElement]);
+    XCTAssertEqualWithAccuracy([reader readDate].timeIntervalSince1970, 1464766562.565, 1e-6);
+    XCTAssert([reader nextElement]);
+    XCTAssertEqualWithAccuracy([reader readDate].timeIntervalSince1970, 1464766562.5, 1e-6);
+    XCTAssert([reader nextElement]);
+    XCTAssertNil([reader readDate]);
+    XCTAssert([reader nextElement]);
+    XCTAssertFalse([reader readDouble:&number]);
+    XCTAssertFalse([reader nextElement]);
+    XCTAssert([reader finish]);
+}
+
+#pragma mark - Models
+
+- (void)test003FixtureMatchesJSONModel {
+    NSString *path = [[NSBundle bundleForClass:self.class] pathForResource:kSBFixtureLayout ofType:@"json"];
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    XCTAssertNotNil(data);
+    
+    SBJSONReader *reader = [[SBJSONReader alloc] initWithData:data];
+    SBMGetLayout *layout = [reader readLayout];
+    XCTAssert([reader finish]);
+    [self assertLayout:layout equalTo:[self JSONModelLayoutWithData:data]];
+    
+    SBMAction *action = layout.actions.firstObject;
+    XCTAssertEqualObjects([action.beacons.firstObject fullUUID], @"7367672374000000ffff0000ffff00030000200747");
+    XCTAssertEqual(action.suppressionTime, -1);
+    XCTAssertNil(action.content.payload);
+    XCTAssertNotNil([action.timeframes.firstObject start]);
+}
+
+- (void)test004GeneratedLayoutMatchesJSONModel {
+    NSData *data = [self layoutDataWithActionCount:200];
+    SBJSONReader *reader = [[SBJSONReader alloc] initWithData:data];
+    SBMGetLayout *layout = [reader readLayout];
+    XCTAssert([reader finish]);
+    [self assertLayout:layout equalTo:[self JSONModelLayoutWithData:data]];
+    XCTAssertGreaterThan(layout.campaignIndex.beaconCount, 0);
+}
+
+- (void)test005ResolverReportsErrors {
+    NSError *parseError;
+    NSError *modelError;
+    XCTAssertNil([SBResolver layoutWithData:[@"{\"actions\": [" dataUsingEncoding:NSUTF8StringEncoding] parseError:&parseError modelError:&modelError]);
+    XCTAssertNotNil(parseError);
+    XCTAssertNil(modelError);
+    
+    parseError = nil;
+    XCTAssertNil([SBResolver layoutWithData:[@"[]" dataUsingEncoding:NSUTF8StringEncoding] parseError:&parseError modelError:&modelError]);
+    XCTAssertNil(parseError);
+    XCTAssertNotNil(modelError);
+}
+
+- (void)test006LayoutWriterRoundTrips {
+    NSData *data = [self layoutDataWithActionCount:50];
+    SBMGetLayout *layout = [[[SBJSONReader alloc] initWithData:data] readLayout];
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer writeLayout:layout];
+    
+    // JSONModel reads what the writer wrote, and so does the reader
+    [self assertLayout:[self JSONModelLayoutWithData:writer.data] equalTo:layout];
+    [self assertLayout:[[[SBJSONReader alloc] initWithData:writer.data] readLayout] equalTo:layout];
+}
+
+- (void)test007SettingsWriterMatchesJSONModel {
+    SBMSettings *settings = [SBMSettings new];
+    settings.rangingSuppression = 0.1;
+    settings.customBeaconRegions = @{@"73676723-7400-0000-FFFF-0000FFFF0000": @"Custom"};
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer writeSettings:settings];
+    NSDictionary *written = [NSJSONSerialization JSONObjectWithData:writer.data options:0 error:nil];
+    XCTAssertEqualObjects(written, [settings toDictionary]);
+    
+    SBMSettings *copy = [settings copy];
+    XCTAssertEqualObjects([copy toDictionary], [settings toDictionary]);
+    
+    // left out when nil, so the copy gets the default like JSONModel gave it
+    settings.resolverURL = nil;
+    XCTAssertEqualObjects([[settings copy] resolverURL], [SBMSettings new].resolverURL);
+}
+
+#pragma mark - Performance
+
+- (void)test008ThroughputAgainstJSONModel {
+    NSData *data = [self layoutDataWithActionCount:5000];
+    NSUInteger runs = 5;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < runs; i++) {
+        @autoreleasepool {
+            NSDictionary *object = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+            XCTAssertNotNil([[SBMGetLayout alloc] initWithDictionary:object error:nil]);
+        }
+    }
+    CFAbsoluteTime JSONModelTime = (CFAbsoluteTimeGetCurrent() - start) / runs;
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < runs; i++) {
+        @autoreleasepool {
+            XCTAssertNotNil([[[SBJSONReader alloc] initWithData:data] readLayout]);
+        }
+    }
+    CFAbsoluteTime readerTime = (CFAbsoluteTimeGetCurrent() - start) / runs;
+    NSLog(@"Layout decode: %lu bytes, JSONModel %.2f ms (%.1f MB/s), SBJSONReader %.2f ms (%.1f MB/s)",
+          (unsigned long)data.length,
+          JSONModelTime * 1000., data.length / JSONModelTime / 1e6,
+          readerTime * 1000., data.length / readerTime / 1e6);
+}
+
+- (void)testPerformanceJSONModelLayout {
+    NSData *data = [self layoutDataWithActionCount:5000];
+    [self measureBlock:^{
+        @autoreleasepool {
+            NSDictionary *object = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+            XCTAssertNotNil([[SBMGetLayout alloc] initWithDictionary:object error:nil]);
+        }
+    }];
+}
+
+- (void)testPerformanceReaderLayout {
+    NSData *data = [self layoutDataWithActionCount:5000];
+    [self measureBlock:^{
+        @autoreleasepool {
+            XCTAssertNotNil([[[SBJSONReader alloc] initWithData:data] readLayout]);
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,275 @@
+//
+//  SBJSONWriterTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+
+#import "SBJSONWriter.h"
+#import "SBISO8601.h"
+#import "SBUtility.h"
+
+static NSUInteger const kSBBenchmarkEventCount = 100000;
+
+@interface SBJSONWriterTests : SBTestCase
+@end
+
+@implementation SBJSONWriterTests
+
+- (void)setUp {
+    [super setUp];
+    self.continueAfterFailure = NO;
+}
+
+// milliseconds are the resolution of both encodings
+- (NSDate *)dateWithMillis:(int64_t)millis {
+    return [NSDate dateWithTimeIntervalSince1970:millis / 1000.0];
+}
+
+- (id)objectFromWriter:(SBJSONWriter *)writer {
+    NSError *error;
+    id object = [NSJSONSerialization JSONObjectWithData:writer.data options:0 error:&error];
+    XCTAssertNil(error);
+    return object;
+}
+
+// replace the date strings with the instants they represent, whatever zone they are written in
+- (NSDictionary *)normalizedDictionary:(NSDictionary *)dictionary {
+    NSMutableDictionary *normalized = [dictionary mutableCopy];
+    for (NSString *key in @[@"dt", @"deviceTimestamp"]) {
+        if (normalized[key]) {
+            NSDate *date = [dateFormatter dateFromString:normalized[key]];
+            XCTAssertNotNil(date, @"%@", normalized[key]);
+            normalized[key] = @(round(date.timeIntervalSince1970 * 1000));
+        }
+    }
+    return normalized;
+}
+
+- (SBMPostLayout *)postLayoutWithEventCount:(NSUInteger)count {
+    NSDate *now = [self dateWithMillis:1462096800125];
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        SBMMonitorEvent *event = [SBMMonitorEvent new];
+        event.pid = [NSString stringWithFormat:@"7367672374000000ffff0000ffff0003%010lu", (unsigned long)i];
+        event.dt = now;
+        event.trigger = i % 2 ? kSBTriggerExit : kSBTriggerEnter;
+        event.location = @"u33dbfcyg";
+        [events addObject:event];
+    }
+    SBMPostLayout *postData = [SBMPostLayout new];
+    postData.deviceTimestamp = now;
+    postData.events = (NSArray <SBMMonitorEvent> *)events;
+    postData.actions = (NSArray <SBMReportAction> *)@[];
+    postData.conversions = (NSArray <SBMReportConversion> *)@[];
+    return postData;
+}
+
+#pragma mark - Formatting
+
+- (void)test000ISO8601MatchesDateFormatter {
+    NSDateFormatter *formatter = [NSDateFormatter new];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"UTC"];
+    formatter.calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
+    formatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ss.SSS'Z'";
+    
+    // fractions exact in binary, NSDateFormatter truncates where SBISO8601 rounds representation noise
+    int64_t samples[] = {0, 125, 500, 951782400000 /* 2000-02-29 */, 1462096800125, 4102444799875 /* 2099-12-31 */, -1000, 253402300799500 /* 9999-12-31 */};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        XCTAssertEqualObjects(SBISO8601StringFromDate([self dateWithMillis:samples[i]]), [formatter stringFromDate:[self dateWithMillis:samples[i]]]);
+    }
+    srand48(42);
+    for (NSUInteger i = 0; i < 10000; i++) {
+        int64_t millis = (int64_t)(drand48() * 4102444800.0) * 1000 + 125 * (int64_t)(drand48() * 8);
+        XCTAssertEqualObjects(SBISO8601StringFromDate([self dateWithMillis:millis]), [formatter stringFromDate:[self dateWithMillis:millis]]);
+    }
+}
+
+- (void)test001EscapesStrings {
+    SBJSONWriter *writer = [SBJSONWriter new];
+    NSArray *strings = @[@"", @"plain", @"quote \" backslash \\ slash /", @"\n\r\t\b\f\x01\x1f", @"äöü ß 🎉 日本"];
+    [writer beginArray];
+    for (NSString *string in strings) {
+        [writer writeString:string];
+    }
+    [writer endArray];
+    XCTAssertEqualObjects([self objectFromWriter:writer], strings);
+}
+
+- (void)test002WritesFoundationObjects {
+    SBJSONWriter *writer = [SBJSONWriter new];
+    NSDictionary *object = @{@"int": @(-42),
+                             @"max": @(LLONG_MAX),
+                             @"min": @(LLONG_MIN),
+                             @"double": @(0.25),
+                             @"bool": @YES,
+                             @"null": [NSNull null],
+                             @"nested": @{@"array": @[@1, @"two", @[], @{}]}};
+    XCTAssert([writer writeObject:object]);
+    XCTAssertEqualObjects([self objectFromWriter:writer], object);
+    
+    [writer reset];
+    XCTAssertFalse([writer writeObject:@{@"date": [NSDate date]}]);
+    [writer reset];
+    XCTAssertFalse([writer writeObject:@(NAN)]);
+}
+
+- (void)test007InvalidNestedValueWritesNothing {
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer beginObject];
+    [writer writeKey:@"before"];
+    [writer writeInteger:1];
+    for (id invalid in @[@{@"a": @1, @"b": @[@2, @(NAN)]}, @{@"a": @1, @2: @"key"}, @[@1, [NSDate date]]]) {
+        [writer writeKey:@"invalid"];
+        XCTAssertFalse([writer writeObject:invalid]);
+        // what the model encoders do
+        [writer writeNull];
+    }
+    [writer writeKey:@"after"];
+    XCTAssert([writer writeObject:@{@"c": @[@3]}]);
+    [writer endObject];
+    NSDictionary *expected = @{@"before": @1, @"invalid": [NSNull null], @"after": @{@"c": @[@3]}};
+    XCTAssertEqualObjects([self objectFromWriter:writer], expected);
+    
+    SBMReportAction *action = [SBMReportAction new];
+    action.eid = @"367348a0dfa84492a0078ead26cf9385";
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    action.reaction = @{@"a": @1, @"b": @(INFINITY)};
+#pragma clang diagnostic pop
+    [writer reset];
+    [writer writeReportAction:action];
+    XCTAssertEqualObjects([self objectFromWriter:writer][@"reaction"], [NSNull null]);
+}
+
+- (void)test008EqualDictionariesWriteEqualBytes {
+    NSMutableDictionary *ascending = [NSMutableDictionary dictionaryWithCapacity:1];
+    NSMutableDictionary *descending = [NSMutableDictionary dictionaryWithCapacity:64];
+    for (NSUInteger i = 0; i < 40; i++) {
+        ascending[[NSString stringWithFormat:@"key%02lu", (unsigned long)i]] = @{@"x": @(i), @"a": @[@(i)]};
+        descending[[NSString stringWithFormat:@"key%02lu", (unsigned long)(39 - i)]] = @{@"a": @[@(39 - i)], @"x": @(39 - i)};
+    }
+    XCTAssertEqualObjects(ascending, descending);
+    SBJSONWriter *first = [SBJSONWriter new];
+    SBJSONWriter *second = [SBJSONWriter new];
+    XCTAssert([first writeObject:ascending]);
+    XCTAssert([second writeObject:descending]);
+    XCTAssertEqualObjects(first.data, second.data);
+    
+    [first reset];
+    XCTAssert([first writeObject:@{@"b": @2, @"c": @{@"z": @0, @"y": @1}, @"a": @1}]);
+    XCTAssertEqualObjects([[NSString alloc] initWithData:first.data encoding:NSUTF8StringEncoding], @"{\"a\":1,\"b\":2,\"c\":{\"y\":1,\"z\":0}}");
+}
+
+#pragma mark - Models
+
+- (void)test003MonitorEventMatchesJSONModel {
+    SBMMonitorEvent *event = [self postLayoutWithEventCount:1].events.firstObject;
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer writeMonitorEvent:event];
+    XCTAssertEqualObjects([self normalizedDictionary:[self objectFromWriter:writer]], [self normalizedDictionary:[event toDictionary]]);
+    
+    // nil properties are left out, like toDictionary does
+    event.location = nil;
+    [writer reset];
+    [writer writeMonitorEvent:event];
+    XCTAssertEqualObjects([self normalizedDictionary:[self objectFromWriter:writer]], [self normalizedDictionary:[event toDictionary]]);
+}
+
+- (void)test004ReportActionMatchesJSONModel {
+    SBMReportAction *action = [SBMReportAction new];
+    action.eid = @"367348a0dfa84492a0078ead26cf9385";
+    action.action = @"\"quoted\" action";
+    action.pid = @"7367672374000000ffff0000ffff00030000200747";
+    action.dt = [self dateWithMillis:1462096800125];
+    action.trigger = kSBTriggerEnterExit;
+    action.location = @"u33dbfcyg";
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    action.reaction = @{@"subject": @"Hello", @"count": @2};
+#pragma clang diagnostic pop
+    
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer writeReportAction:action];
+    XCTAssertEqualObjects([self normalizedDictionary:[self objectFromWriter:writer]], [self normalizedDictionary:[action toDictionary]]);
+}
+
+- (void)test005ReportConversionMatchesJSONModel {
+    SBMReportConversion *conversion = [SBMReportConversion new];
+    conversion.action = @"This Is the Test action.";
+    conversion.dt = [self dateWithMillis:1462096800125];
+    conversion.type = kSBConversionSuccessful;
+    
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer writeReportConversion:conversion];
+    XCTAssertEqualObjects([self normalizedDictionary:[self objectFromWriter:writer]], [self normalizedDictionary:[conversion toDictionary]]);
+}
+
+- (void)test006PostLayoutMatchesJSONModel {
+    SBMPostLayout *postData = [self postLayoutWithEventCount:10];
+    SBJSONWriter *writer = [SBJSONWriter new];
+    [writer writePostLayout:postData];
+    
+    NSDictionary *written = [self objectFromWriter:writer];
+    NSDictionary *expected = [postData toDictionary];
+    XCTAssertEqualObjects([self normalizedDictionary:written], [self normalizedDictionary:expected]);
+    XCTAssertEqual([written[@"events"] count], 10);
+    for (NSUInteger i = 0; i < 10; i++) {
+        XCTAssertEqualObjects([self normalizedDictionary:written[@"events"][i]], [self normalizedDictionary:expected[@"events"][i]]);
+    }
+}
+
+#pragma mark - Performance
+
+- (void)measureEncoding:(void (^)(void))block {
+    if (@available(iOS 13.0, *)) {
+        [self measureWithMetrics:@[[XCTClockMetric new], [XCTMemoryMetric new]] block:block];
+    } else {
+        [self measureBlock:block];
+    }
+}
+
+- (void)testPerformanceJSONModelPostLayout {
+    SBMPostLayout *postData = [self postLayoutWithEventCount:kSBBenchmarkEventCount];
+    [self measureEncoding:^{
+        @autoreleasepool {
+            NSData *data = [NSJSONSerialization dataWithJSONObject:[postData toDictionary] options:0 error:nil];
+            XCTAssert(data.length);
+        }
+    }];
+}
+
+- (void)testPerformanceWriterPostLayout {
+    SBMPostLayout *postData = [self postLayoutWithEventCount:kSBBenchmarkEventCount];
+    [self measureEncoding:^{
+        @autoreleasepool {
+            SBJSONWriter *writer = [SBJSONWriter new];
+            [writer writePostLayout:postData];
+            XCTAssert(writer.length);
+        }
+    }];
+}
+
+@end
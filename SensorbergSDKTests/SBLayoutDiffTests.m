@@ -0,0 +1,187 @@
+//
+//  SBLayoutDiffTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+
+#import "SBInternalModels.h"
+#import "SBCampaignIndex.h"
+#import "SBLayoutDiff.h"
+
+static NSUInteger const kSBLayoutActionCount = 2000;
+
+@interface SBLayoutDiffTests : SBTestCase
+@end
+
+@implementation SBLayoutDiffTests
+
+- (void)setUp {
+    [super setUp];
+    self.continueAfterFailure = NO;
+}
+
+- (NSString *)beaconForIndex:(NSUInteger)index {
+    return [NSString stringWithFormat:@"7367672374000000ffff0000ffff0003%05lu%05lu", (unsigned long)(index / 100), (unsigned long)(index % 100)];
+}
+
+- (NSMutableDictionary *)actionDictionaryWithIndex:(NSUInteger)index {
+    return [@{@"eid": [NSString stringWithFormat:@"%032lu", (unsigned long)index],
+              @"trigger": @(1 + index % 3),
+              @"beacons": @[[self beaconForIndex:index % 300], [self beaconForIndex:(index * 7) % 300]],
+              @"suppressionTime": @(30),
+              @"type": @(1),
+              @"content": @{@"subject": @"Subject", @"body": @"Body", @"url": @"http://www.sensorberg.com", @"payload": @{@"a": @1, @"b": @[@"x", @"y"]}},
+              @"timeframes": @[@{@"start": @"2016-05-01T10:00:00.000+0000"}]} mutableCopy];
+}
+
+- (NSMutableArray *)actionDictionariesWithCount:(NSUInteger)count {
+    NSMutableArray *actions = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [actions addObject:[self actionDictionaryWithIndex:i]];
+    }
+    return actions;
+}
+
+- (SBMGetLayout *)layoutWithActions:(NSArray *)actions {
+    NSError *error;
+    SBMGetLayout *layout = [[SBMGetLayout alloc] initWithDictionary:@{@"accountProximityUUIDs": @[@"7367672374000000ffff0000ffff0003"],
+                                                                     @"actions": actions}
+                                                              error:&error];
+    XCTAssertNil(error);
+    return layout;
+}
+
+- (NSArray *)actionIdsInIndex:(SBCampaignIndex *)index forBeacon:(NSString *)beacon trigger:(SBTriggerType)trigger {
+    NSMutableArray *eids = [NSMutableArray new];
+    for (SBMAction *action in [index actionsForBeacon:[[SBMBeacon alloc] initWithString:beacon] trigger:trigger]) {
+        [eids addObject:action.eid];
+    }
+    return eids;
+}
+
+- (void)test000SameLayoutHasEmptyDiff {
+    SBMGetLayout *oldLayout = [self layoutWithActions:[self actionDictionariesWithCount:50]];
+    SBMGetLayout *newLayout = [self layoutWithActions:[self actionDictionariesWithCount:50]];
+    SBLayoutDiff *diff = [SBLayoutDiff diffFromLayout:oldLayout toLayout:newLayout];
+    XCTAssertTrue(diff.isEmpty);
+    for (SBMAction *action in newLayout.actions) {
+        XCTAssertNotNil([diff unchangedActionFor:action]);
+    }
+}
+
+- (void)test001DiffFindsAddedRemovedAndChangedActions {
+    NSMutableArray *actions = [self actionDictionariesWithCount:50];
+    SBMGetLayout *oldLayout = [self layoutWithActions:actions];
+    //
+    [actions removeObjectAtIndex:3];
+    actions[10][@"suppressionTime"] = @(60);
+    actions[20][@"content"] = @{@"subject": @"Other", @"body": @"Body", @"url": @"http://www.sensorberg.com"};
+    [actions addObject:[self actionDictionaryWithIndex:1000]];
+    SBMGetLayout *newLayout = [self layoutWithActions:actions];
+    //
+    SBLayoutDiff *diff = [SBLayoutDiff diffFromLayout:oldLayout toLayout:newLayout];
+    XCTAssertFalse(diff.isEmpty);
+    XCTAssertFalse(diff.layoutAttributesChanged);
+    XCTAssertEqualObjects([diff.removed valueForKey:@"eid"], @[oldLayout.actions[3].eid]);
+    XCTAssertEqualObjects([diff.added valueForKey:@"eid"], @[newLayout.actions.lastObject.eid]);
+    XCTAssertEqualObjects([diff.changed valueForKey:@"eid"], (@[newLayout.actions[10].eid, newLayout.actions[20].eid]));
+    XCTAssertEqualObjects([diff.replaced valueForKey:@"eid"], [diff.changed valueForKey:@"eid"]);
+}
+
+- (void)test002HashIgnoresPayloadKeyOrderButNotValues {
+    NSMutableDictionary *first = [self actionDictionaryWithIndex:0];
+    NSMutableDictionary *second = [self actionDictionaryWithIndex:0];
+    NSMutableDictionary *content = [second[@"content"] mutableCopy];
+    content[@"payload"] = @{@"b": @[@"x", @"y"], @"a": @1};
+    second[@"content"] = content;
+    XCTAssertEqual(SBActionContentHash([self layoutWithActions:@[first]].actions.firstObject),
+                   SBActionContentHash([self layoutWithActions:@[second]].actions.firstObject));
+    
+    content[@"payload"] = @{@"a": @1, @"b": @[@"y", @"x"]};
+    second[@"content"] = content;
+    XCTAssertNotEqual(SBActionContentHash([self layoutWithActions:@[first]].actions.firstObject),
+                      SBActionContentHash([self layoutWithActions:@[second]].actions.firstObject));
+}
+
+- (void)test003AccountUUIDsChangeLayoutAttributes {
+    NSArray *actions = [self actionDictionariesWithCount:5];
+    SBMGetLayout *oldLayout = [self layoutWithActions:actions];
+    SBMGetLayout *newLayout = [self layoutWithActions:actions];
+    newLayout.accountProximityUUIDs = @[@"7367672374000000ffff0000ffff0004"];
+    SBLayoutDiff *diff = [SBLayoutDiff diffFromLayout:oldLayout toLayout:newLayout];
+    XCTAssertTrue(diff.layoutAttributesChanged);
+    XCTAssertFalse(diff.isEmpty);
+}
+
+- (void)test004DiffKeepsTheIndexOfEachLayout {
+    NSMutableArray *actions = [self actionDictionariesWithCount:200];
+    SBMGetLayout *oldLayout = [self layoutWithActions:actions];
+    SBCampaignIndex *oldIndex = oldLayout.campaignIndex;
+    //
+    [actions removeObjectsInRange:NSMakeRange(0, 10)];
+    for (NSUInteger i = 50; i < 60; i++) {
+        actions[i][@"beacons"] = @[[self beaconForIndex:299 - i]];
+    }
+    for (NSUInteger i = 0; i < 10; i++) {
+        [actions insertObject:[self actionDictionaryWithIndex:500 + i] atIndex:i * 20];
+    }
+    SBMGetLayout *newLayout = [self layoutWithActions:actions];
+    SBMGetLayout *expected = [self layoutWithActions:actions];
+    SBCampaignIndex *newIndex = newLayout.campaignIndex;
+    //
+    SBLayoutDiff *diff = [SBLayoutDiff diffFromLayout:oldLayout toLayout:newLayout];
+    XCTAssertFalse(diff.isEmpty);
+    XCTAssertEqual(oldLayout.campaignIndex, oldIndex);
+    XCTAssertEqual(newLayout.campaignIndex, newIndex);
+    XCTAssertEqual(newLayout.campaignIndex.beaconCount, expected.campaignIndex.beaconCount);
+    // the actions of a beacon come in the order of the new layout
+    for (NSUInteger i = 0; i < 300; i++) {
+        NSString *beacon = [self beaconForIndex:i];
+        for (SBTriggerType trigger = kSBTriggerEnter; trigger <= kSBTriggerEnterExit; trigger++) {
+            XCTAssertEqualObjects([self actionIdsInIndex:newLayout.campaignIndex forBeacon:beacon trigger:trigger],
+                                  [self actionIdsInIndex:expected.campaignIndex forBeacon:beacon trigger:trigger]);
+        }
+    }
+}
+
+#pragma mark - Benchmarks
+
+- (void)testPerformanceLayoutDiff {
+    SBMGetLayout *oldLayout = [self layoutWithActions:[self actionDictionariesWithCount:kSBLayoutActionCount]];
+    SBMGetLayout *newLayout = [self layoutWithActions:[self actionDictionariesWithCount:kSBLayoutActionCount]];
+    [self measureBlock:^{
+        XCTAssertTrue([SBLayoutDiff diffFromLayout:oldLayout toLayout:newLayout].isEmpty);
+    }];
+}
+
+- (void)testPerformanceDictionaryCompare {
+    SBMGetLayout *oldLayout = [self layoutWithActions:[self actionDictionariesWithCount:kSBLayoutActionCount]];
+    SBMGetLayout *newLayout = [self layoutWithActions:[self actionDictionariesWithCount:kSBLayoutActionCount]];
+    [self measureBlock:^{
+        XCTAssertTrue([oldLayout.toDictionary isEqualToDictionary:newLayout.toDictionary]);
+    }];
+}
+
+@end
@@ -0,0 +1,167 @@
+//
+//  SBLayoutParseTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+#import "SensorbergSDK.h"
+#import "SBResolver.h"
+#import "SBInternalEvents.h"
+#import "SBCampaignIndex.h"
+#import "SBTestURLProtocol.h"
+#import <tolo/Tolo.h>
+
+@interface SBLayoutParseTests : SBTestCase
+@property (nonatomic, strong) SBEventGetLayout *layoutEvent;
+@property (nonatomic) BOOL layoutEventOnMainThread;
+@end
+
+@implementation SBLayoutParseTests
+
+// a resolver response with `count` actions on up to 500 beacons
+- (NSData *)layoutDataWithActionCount:(NSUInteger)count {
+    srand48(42);
+    NSMutableArray *actions = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSMutableArray *beacons = [NSMutableArray new];
+        NSUInteger beaconCount = 1 + lrand48() % 3;
+        for (NSUInteger b = 0; b < beaconCount; b++) {
+            long beacon = lrand48() % 500;
+            [beacons addObject:[NSString stringWithFormat:@"73676723740000%02luffff0000ffff0003%05lu%05lu", (unsigned long)(beacon % 8), (unsigned long)(beacon / 100), (unsigned long)(beacon % 100)]];
+        }
+        [actions addObject:@{@"eid": [NSString stringWithFormat:@"%032lu", (unsigned long)i],
+                             @"trigger": @(1 + lrand48() % 3),
+                             @"beacons": beacons,
+                             @"type": @(kSBActionTypeText),
+                             @"suppressionTime": @(30),
+                             @"content": @{@"subject": @"Subject", @"body": @"Body", @"url": @"http://www.sensorberg.com"},
+                             @"timeframes": @[@{@"start": @"2016-01-01T00:00:00.000+0000"}]}];
+    }
+    NSDictionary *layout = @{@"accountProximityUUIDs": @[@"7367672374000000ffff0000ffff0003"],
+                             @"actions": actions};
+    return [NSJSONSerialization dataWithJSONObject:layout options:0 error:nil];
+}
+
+- (NSTimeInterval)medianParseTimeOfData:(NSData *)data runs:(NSUInteger)runs {
+    NSMutableArray *times = [NSMutableArray arrayWithCapacity:runs];
+    for (NSUInteger i = 0; i < runs; i++) {
+        @autoreleasepool {
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            SBMGetLayout *layout = [SBResolver layoutWithData:data parseError:nil modelError:nil];
+            [times addObject:@(CFAbsoluteTimeGetCurrent() - start)];
+            XCTAssertNotNil(layout);
+        }
+    }
+    [times sortUsingSelector:@selector(compare:)];
+    return [times[runs / 2] doubleValue];
+}
+
+SUBSCRIBE(SBEventGetLayout)
+{
+    self.layoutEvent = event;
+    self.layoutEventOnMainThread = [NSThread isMainThread];
+}
+
+- (void)test000ParsedLayoutIsIndexed {
+    NSError *parseError;
+    NSError *modelError;
+    SBMGetLayout *layout = [SBResolver layoutWithData:[self layoutDataWithActionCount:100] parseError:&parseError modelError:&modelError];
+    XCTAssertNil(parseError);
+    XCTAssertNil(modelError);
+    XCTAssertEqual(layout.actions.count, 100);
+    XCTAssertGreaterThan(layout.campaignIndex.beaconCount, 0);
+}
+
+- (void)test001InvalidDataReportsParseError {
+    NSError *parseError;
+    NSError *modelError;
+    SBMGetLayout *layout = [SBResolver layoutWithData:[@"{\"actions\": [" dataUsingEncoding:NSUTF8StringEncoding] parseError:&parseError modelError:&modelError];
+    XCTAssertNil(layout);
+    XCTAssertNotNil(parseError);
+    XCTAssertNil(modelError);
+}
+
+// the timing harness: median parse time per layout size, in the test log
+- (void)test002ParseTimePerLayoutSize {
+    for (NSNumber *size in @[@100, @1000, @10000]) {
+        NSData *data = [self layoutDataWithActionCount:size.unsignedIntegerValue];
+        NSTimeInterval time = [self medianParseTimeOfData:data runs:5];
+        NSLog(@"Layout parse: %5lu actions, %7lu bytes, %8.2f ms, %6.2f µs/action",
+              size.unsignedLongValue, (unsigned long)data.length, time * 1000., time * 1e6 / size.doubleValue);
+    }
+}
+
+- (void)test003MainThreadStaysResponsiveWhileParsing {
+    NSData *data = [self layoutDataWithActionCount:10000];
+    NSTimeInterval parseTime = [self medianParseTimeOfData:data runs:3];
+    
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        return data;
+    }];
+    [SBTestURLProtocol install];
+    SB_REGISTER();
+    SBResolver *resolver = [[SBResolver alloc] initWithApiKey:@"TestAPIKey"];
+    
+    // the longest the main run loop went without servicing a timer
+    __block CFAbsoluteTime lastTick = CFAbsoluteTimeGetCurrent();
+    __block CFAbsoluteTime longestStall = 0;
+    CFRunLoopTimerRef timer = CFRunLoopTimerCreateWithHandler(kCFAllocatorDefault, CFAbsoluteTimeGetCurrent(), 0.005, 0, 0, ^(CFRunLoopTimerRef t) {
+        CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+        longestStall = MAX(longestStall, now - lastTick);
+        lastTick = now;
+    });
+    CFRunLoopAddTimer(CFRunLoopGetMain(), timer, kCFRunLoopCommonModes);
+    
+    [resolver requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"layoutEvent != nil"] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    CFRunLoopTimerInvalidate(timer);
+    CFRelease(timer);
+    SB_UNREGISTER();
+    [SBTestURLProtocol uninstall];
+    
+    XCTAssertTrue(self.layoutEventOnMainThread);
+    XCTAssertNil(self.layoutEvent.error);
+    XCTAssertEqual(self.layoutEvent.layout.actions.count, 10000);
+    NSLog(@"Layout parse: %.2f ms, longest main thread stall %.2f ms", parseTime * 1000., longestStall * 1000.);
+    XCTAssertLessThan(longestStall, parseTime / 2);
+}
+
+#pragma mark - Benchmarks
+
+- (void)testPerformanceParse1000Actions {
+    NSData *data = [self layoutDataWithActionCount:1000];
+    [self measureBlock:^{
+        [SBResolver layoutWithData:data parseError:nil modelError:nil];
+    }];
+}
+
+- (void)testPerformanceParse10000Actions {
+    NSData *data = [self layoutDataWithActionCount:10000];
+    [self measureBlock:^{
+        [SBResolver layoutWithData:data parseError:nil modelError:nil];
+    }];
+}
+
+@end
@@ -7,10 +7,18 @@
 //
 
 #import "SBTestCase.h"
+#import "SensorbergSDK.h"
 #import "SBLocation.h"
 #import "SBInternalModels.h"
+#import "SBEvent.h"
+#import "SBSignalFilter.h"
+#import "SBSessionStore.h"
+#import "SBSettings.h"
 #import "NSString+SBUUID.h"
 #import <tolo/Tolo.h>
+#import <objc_geohash/GeoHash.h>
+
+#import <pthread.h>
 
 NSString * const kSBUnitTestRegionUUID0 = @"00000000-0000-0000-0000-000000000000";
 NSString * const kSBUnitTestRegionUUID1 = @"11111111-1111-1111-1111-111111111111";
@@ -28,23 +36,67 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
 
 @implementation SBUnitTestBeacon @end
 
+#pragma mark - Allocation counting
+
+// libmalloc calls this hook for every allocation (it is what malloc stack logging uses)
+typedef void (malloc_logger_t)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t num_hot_frames_to_skip);
+extern malloc_logger_t *malloc_logger;
+
+static malloc_logger_t *previousMallocLogger;
+static pthread_t countingThread;
+static NSUInteger allocationCount;
+
+static void SBCountingMallocLogger(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t num_hot_frames_to_skip) {
+    if ((type & 2) && pthread_equal(pthread_self(), countingThread)) { // MALLOC_LOG_TYPE_ALLOCATE
+        allocationCount++;
+    }
+    if (previousMallocLogger) {
+        previousMallocLogger(type, arg1, arg2, arg3, result, num_hot_frames_to_skip);
+    }
+}
+
+static NSUInteger SBCountAllocations(dispatch_block_t block) {
+    allocationCount = 0;
+    countingThread = pthread_self();
+    previousMallocLogger = malloc_logger;
+    malloc_logger = SBCountingMallocLogger;
+    @autoreleasepool {
+        block();
+    }
+    malloc_logger = previousMallocLogger;
+    return allocationCount;
+}
+
 @interface SBLocation (UnitTests)
 - (void)updateSessionsWithBeacons:(NSArray <CLBeacon *> *)beacons;
 - (void)checkRegionExit;
+- (void)startMonitoringForGeoRegion:(NSString *)region;
+- (void)updateGeoSessionsWithLocation:(CLLocation *)location;
 @end
 
 
 @interface SBLocationTests : SBTestCase
 @property (nonatomic, strong) SBLocation *sut;
 @property (nonatomic, strong) NSArray <CLBeacon *> *beacons;
+@property (nonatomic, strong) NSMutableArray <SBEventRangedBeacons *> *rangedBatches;
+@property (nonatomic) NSUInteger rangedBeaconCount;
+@property (nonatomic, strong) SBEventRangedBeacon *lastRangedBeacon;
+// the simulated clock of the sut
+@property (nonatomic) NSTimeInterval now;
+@property (nonatomic) NSUInteger exitCount;
+@property (nonatomic) NSUInteger enterCount;
+@property (nonatomic, copy) NSString *storePath;
+@property (nonatomic, strong) NSMutableArray <NSString *> *geoEnters;
+@property (nonatomic, strong) NSMutableArray <NSString *> *geoExits;
 @end
 
 @implementation SBLocationTests
 
 - (void)setUp {
     [super setUp];
-    self.sut = [SBLocation new];
-    [[Tolo sharedInstance] subscribe:self.sut];
+    self.storePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.table", [NSUUID UUID].UUIDString]];
+    self.now = 1000000;
+    [self launch];
     
     SBUnitTestBeacon *beacon0 = [SBUnitTestBeacon new];
     beacon0.proximityUUID = [[NSUUID alloc] initWithUUIDString:kSBUnitTestRegionUUID0];
@@ -67,12 +119,26 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
 
 - (void)tearDown {
     // Put teardown code here. This method is called after the invocation of each test method in the class.
-    [[Tolo sharedInstance] unsubscribe:self.sut];
+    [[SensorbergSDK eventBus] unsubscribe:self.sut];
     self.sut = nil;
     self.beacons = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:self.storePath error:nil];
     [super tearDown];
 }
 
+// a new SBLocation on the session table of the previous one, as after a relaunch
+- (void)launch {
+    if (self.sut) {
+        [[SensorbergSDK eventBus] unsubscribe:self.sut];
+    }
+    self.sut = [[SBLocation alloc] initWithSessionStore:[[SBSessionStore alloc] initWithPath:self.storePath]];
+    [[SensorbergSDK eventBus] subscribe:self.sut];
+    __weak SBLocationTests *weakSelf = self;
+    self.sut.clock = ^NSTimeInterval {
+        return weakSelf.now;
+    };
+}
+
 - (void)test000DidFindBeacons
 {
     NSString *proximityUUIDPrefix = [[NSString stripHyphensFromUUIDString:kSBUnitTestRegionUUID0] lowercaseString];
@@ -119,9 +185,10 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
 {
     NSDictionary *sessions = [self.sut currentSessions];
     SBMSession *beacon0Session = sessions[@"000000000000000000000000000000000000000000"];
-    beacon0Session.lastSeen = [[NSDate date] timeIntervalSince1970] - 120;
+    self.now += 120;
     [self.sut checkRegionExit];
-    beacon0Session.exit = [[NSDate date] timeIntervalSince1970] - 4;
+    XCTAssertEqual(beacon0Session.exit, self.now);
+    self.now += 4;
     [self.sut checkRegionExit];
     
     NSString *proximityUUID0Prefix = [[NSString stripHyphensFromUUIDString:kSBUnitTestRegionUUID0] lowercaseString];
@@ -141,8 +208,7 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
 - (void)test006CheckRegionExitWithRegionUUIDInRegionDispatchedTimeIntervalSince1970WithDisappearedBeaconButInvalidFunctionCall
 {
     NSDictionary *sessions = [self.sut currentSessions];
-    SBMSession *beacon0Session = sessions[@"000000000000000000000000000000000000000000"];
-    beacon0Session.lastSeen = [[NSDate date] timeIntervalSince1970] - 20;
+    self.now += 20;
     [self.sut checkRegionExit];
     
     NSString *proximityUUID0Prefix = [[NSString stripHyphensFromUUIDString:kSBUnitTestRegionUUID0] lowercaseString];
@@ -164,8 +230,7 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
 - (void)test007CheckRegionExitWithRegionUUIDInRegion
 {
     NSDictionary *sessions = [self.sut currentSessions];
-    SBMSession *beacon0Session = sessions[@"000000000000000000000000000000000000000000"];
-    beacon0Session.lastSeen = [NSDate date].timeIntervalSince1970 - 5;
+    self.now += 5;
     [self.sut checkRegionExit];
     
     NSString *proximityUUID0Prefix = [[NSString stripHyphensFromUUIDString:kSBUnitTestRegionUUID0] lowercaseString];
@@ -186,14 +251,12 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
 
 - (void)test008CheckRegionExitWithRegionUUIDInRegionWithNotInRegion
 {
-    NSTimeInterval now = [NSDate date].timeIntervalSince1970;
+    NSTimeInterval now = self.now;
     NSDictionary *sessions = [self.sut currentSessions];
     SBMSession *beacon0Session = sessions[@"000000000000000000000000000000000000000000"];
-    beacon0Session.lastSeen = now - 120;
     SBMSession *beacon1Session = sessions[@"111111111111111111111111111111110000100001"];
-    beacon1Session.lastSeen = now - 120;
     SBMSession *beacon2Session = sessions[@"222222222222222222222222222222220000200002"];
-    beacon2Session.lastSeen = now - 120;
+    self.now += 120;
     
     [self.sut checkRegionExit];
     
@@ -201,9 +264,7 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
     XCTAssert(beacon1Session.exit > now);
     XCTAssert(beacon2Session.exit > now);
     
-    beacon0Session.exit = beacon0Session.exit - 4.5f;
-    beacon1Session.exit = beacon1Session.exit - 4.5f;
-    beacon2Session.exit = beacon2Session.exit - 4.5f;
+    self.now += 4.5f;
     
     [self.sut checkRegionExit];
     
@@ -225,4 +286,323 @@ NSString * const kSBUnitTestRegionUUID3 = @"33333333-3333-3333-3333-333333333333
     }
 }
 
+SUBSCRIBE(SBEventRegionEnter)
+{
+    if (event.geohash) {
+        [self.geoEnters addObject:event.geohash];
+    } else {
+        self.enterCount++;
+    }
+}
+
+SUBSCRIBE(SBEventRegionExit)
+{
+    self.exitCount++;
+    if (event.geohash) {
+        [self.geoExits addObject:event.geohash];
+    }
+}
+
+- (void)test010SightingsPostponeTheExitWhichFiresOnce
+{
+    SB_REGISTER();
+    // ranged every 10 seconds for two minutes
+    for (NSUInteger i = 0; i < 12; i++) {
+        self.now += 10;
+        [self.sut updateSessionsWithBeacons:self.beacons];
+        [self.sut checkRegionExit];
+    }
+    XCTAssertEqual(self.exitCount, 0);
+    XCTAssertEqual([self.sut currentSessions].count, self.beacons.count);
+    // gone: nothing before the monitoring delay, then the exit after the ranging suppression, once
+    for (NSUInteger i = 0; i < 120; i++) {
+        self.now += 1;
+        [self.sut checkRegionExit];
+        if (i < 30) {
+            XCTAssertEqual(self.exitCount, 0);
+        }
+    }
+    XCTAssertEqual(self.exitCount, self.beacons.count);
+    XCTAssertEqual([self.sut currentSessions].count, 0);
+    // a new sighting opens a new session
+    [self.sut updateSessionsWithBeacons:@[self.beacons.firstObject]];
+    XCTAssertEqual([self.sut currentSessions].count, 1);
+    SB_UNREGISTER();
+}
+
+- (void)test011SightingDuringTheExitDelayKeepsTheSession
+{
+    SB_REGISTER();
+    SBMSession *session = [self.sut currentSessions][@"000000000000000000000000000000000000000000"];
+    self.now += 32;
+    [self.sut checkRegionExit];
+    XCTAssertGreaterThan(session.exit, 0);
+    [self.sut updateSessionsWithBeacons:@[self.beacons.firstObject]];
+    XCTAssertEqual(session.exit, 0);
+    self.now += 5;
+    [self.sut checkRegionExit];
+    // the other two are gone, beacon 0 was seen again
+    XCTAssertEqual(self.exitCount, 2);
+    XCTAssertEqualObjects([self.sut currentSessions].allKeys, @[@"000000000000000000000000000000000000000000"]);
+    SB_UNREGISTER();
+}
+
+- (void)test012SignalThresholdsGateSessions
+{
+    self.sut.signalFilter.type = SBSignalFilterNone;
+    self.sut.signalFilter.enterThreshold = -70;
+    self.sut.signalFilter.exitThreshold = -80;
+    SBUnitTestBeacon *beacon = [SBUnitTestBeacon new];
+    beacon.proximityUUID = [[NSUUID alloc] initWithUUIDString:kSBUnitTestRegionUUID0];
+    beacon.major = @(9);
+    beacon.minor = @(9);
+    beacon.proximity = CLProximityFar;
+    NSString *pid = [[SBMBeacon alloc] initWithCLBeacon:(CLBeacon *)beacon].fullUUID;
+    // too weak to enter
+    beacon.rssi = -85;
+    [self.sut updateSessionsWithBeacons:@[(CLBeacon *)beacon]];
+    XCTAssertNil([self.sut currentSessions][pid]);
+    beacon.rssi = -65;
+    [self.sut updateSessionsWithBeacons:@[(CLBeacon *)beacon]];
+    SBMSession *session = [self.sut currentSessions][pid];
+    XCTAssertEqual(session.lastSeen, self.now);
+    // between the thresholds the session stays open
+    self.now += 10;
+    beacon.rssi = -75;
+    [self.sut updateSessionsWithBeacons:@[(CLBeacon *)beacon]];
+    XCTAssertEqual(session.lastSeen, self.now);
+    // below the exit threshold it is as if the beacon was gone
+    self.now += 10;
+    beacon.rssi = -85;
+    [self.sut updateSessionsWithBeacons:@[(CLBeacon *)beacon]];
+    XCTAssertEqual(session.lastSeen, self.now - 10);
+}
+
+- (void)test016WeakBeaconsDontKeepFilterState
+{
+    self.sut.signalFilter.type = SBSignalFilterNone;
+    self.sut.signalFilter.enterThreshold = -70;
+    // the beacons of setUp, with a session
+    NSUInteger withSessions = self.sut.signalFilter.count;
+    for (NSUInteger minor = 100; minor < 300; minor++) {
+        SBUnitTestBeacon *beacon = [SBUnitTestBeacon new];
+        beacon.proximityUUID = [[NSUUID alloc] initWithUUIDString:kSBUnitTestRegionUUID0];
+        beacon.major = @(9);
+        beacon.minor = @(minor);
+        beacon.proximity = CLProximityFar;
+        beacon.rssi = -85;
+        [self.sut updateSessionsWithBeacons:@[(CLBeacon *)beacon]];
+        self.now += 1;
+    }
+    XCTAssertEqual(self.sut.currentSessions.count, withSessions);
+    // the ones ranged within the last two monitoring delays at most
+    NSTimeInterval monitoringDelay = [SBSettings sharedManager].settings.monitoringDelay;
+    XCTAssertLessThanOrEqual(self.sut.signalFilter.count, withSessions + 2 * (NSUInteger)monitoringDelay + 1);
+    XCTAssertGreaterThan(self.sut.signalFilter.count, withSessions);
+}
+
+- (void)test013RangedBeaconCarriesTheFilteredValues
+{
+    self.sut.publishesRangedBeacon = YES;
+    SBUnitTestBeacon *beacon = (SBUnitTestBeacon *)self.beacons.firstObject;
+    beacon.proximity = CLProximityNear;
+    SB_REGISTER();
+    beacon.rssi = -59;
+    [self.sut updateSessionsWithBeacons:@[(CLBeacon *)beacon]];
+    XCTAssertEqual(self.lastRangedBeacon.filteredRssi, -59);
+    XCTAssertEqual(self.lastRangedBeacon.filteredProximity, CLProximityNear);
+    XCTAssertEqualWithAccuracy(self.lastRangedBeacon.filteredAccuracy, 1, 0.001);
+    // a reflection is rejected
+    self.now += 1;
+    beacon.rssi = -90;
+    [self.sut updateSessionsWithBeacons:@[(CLBeacon *)beacon]];
+    XCTAssertEqual(self.lastRangedBeacon.rssi, -90);
+    XCTAssertEqual(self.lastRangedBeacon.filteredRssi, -59);
+    SB_UNREGISTER();
+}
+
+#pragma mark - Batched ranging events
+
+SUBSCRIBE(SBEventRangedBeacons)
+{
+    [self.rangedBatches addObject:event];
+}
+
+SUBSCRIBE(SBEventRangedBeacon)
+{
+    self.rangedBeaconCount++;
+    self.lastRangedBeacon = event;
+}
+
+- (void)test014GeoRegionsEnterAndExitThroughTheSessions
+{
+    self.geoEnters = [NSMutableArray new];
+    self.geoExits = [NSMutableArray new];
+    CLLocation *alexanderplatz = [[CLLocation alloc] initWithLatitude:52.5219 longitude:13.4132];
+    CLLocation *marienplatz = [[CLLocation alloc] initWithLatitude:48.1374 longitude:11.5755];
+    NSString *berlin = [GeoHash hashForLatitude:alexanderplatz.coordinate.latitude longitude:alexanderplatz.coordinate.longitude length:4];
+    NSString *square = [GeoHash hashForLatitude:alexanderplatz.coordinate.latitude longitude:alexanderplatz.coordinate.longitude length:7];
+    [self.sut startMonitoringForGeoRegion:berlin];
+    [self.sut startMonitoringForGeoRegion:square];
+    NSString *munich = [GeoHash hashForLatitude:marienplatz.coordinate.latitude longitude:marienplatz.coordinate.longitude length:5];
+    [self.sut startMonitoringForGeoRegion:munich];
+    SB_REGISTER();
+    // nested regions are entered together, the largest first, and only once
+    [self.sut updateGeoSessionsWithLocation:alexanderplatz];
+    [self.sut updateGeoSessionsWithLocation:alexanderplatz];
+    XCTAssertEqualObjects(self.geoEnters, (@[berlin, square]));
+    XCTAssertNotNil([self.sut currentSessions][square]);
+    // a few streets away: still in the city, out of the square, the exit waits for the ranging suppression
+    CLLocation *eastSideGallery = [[CLLocation alloc] initWithLatitude:52.5076 longitude:13.4422];
+    [self.sut updateGeoSessionsWithLocation:eastSideGallery];
+    XCTAssertEqual(self.geoExits.count, 0);
+    XCTAssertGreaterThan([(SBMSession *)[self.sut currentSessions][square] exit], 0);
+    self.now += 10;
+    [self.sut checkRegionExit];
+    XCTAssertEqualObjects(self.geoExits, @[square]);
+    XCTAssertNil([self.sut currentSessions][square]);
+    XCTAssertNotNil([self.sut currentSessions][berlin]);
+    // a fix far away, then back before the suppression ran out: the city session is kept
+    self.now += 10;
+    [self.sut updateGeoSessionsWithLocation:marienplatz];
+    self.now += 1;
+    [self.sut updateGeoSessionsWithLocation:alexanderplatz];
+    self.now += 10;
+    [self.sut checkRegionExit];
+    XCTAssertEqualObjects(self.geoExits, (@[square, munich]));
+    XCTAssertEqualObjects(self.geoEnters, (@[berlin, square, munich, square]));
+    XCTAssertNotNil([self.sut currentSessions][berlin]);
+    SB_UNREGISTER();
+}
+
+- (void)test015RelaunchCarriesOnWithTheSessions
+{
+    SB_REGISTER();
+    self.now += 10;
+    [self.sut updateSessionsWithBeacons:self.beacons];
+    [self launch];
+    XCTAssertEqual([self.sut currentSessions].count, self.beacons.count);
+    // still in range: no second enter
+    [self.sut updateSessionsWithBeacons:self.beacons];
+    XCTAssertEqual(self.enterCount, 0);
+    // then gone: the restored sessions exit once, and leave the table
+    self.now += 60;
+    [self.sut checkRegionExit];
+    [self launch];
+    self.now += 10;
+    [self.sut checkRegionExit];
+    XCTAssertEqual(self.exitCount, self.beacons.count);
+    XCTAssertEqual([self.sut currentSessions].count, 0);
+    XCTAssertEqual([[SBSessionStore alloc] initWithPath:self.storePath].count, 0);
+    // a beacon seen after the exit is entered again
+    [self.sut updateSessionsWithBeacons:@[self.beacons.firstObject]];
+    XCTAssertEqual(self.enterCount, 1);
+    SB_UNREGISTER();
+}
+
+- (void)test017RemovedSessionsAreNotRestored
+{
+    SB_REGISTER();
+    XCTAssertEqual([self.sut currentSessions].count, self.beacons.count);
+    [self.sut removeAllSessions];
+    XCTAssertEqual([self.sut currentSessions].count, 0);
+    XCTAssertEqual(self.exitCount, 0);
+    [self launch];
+    XCTAssertEqual([self.sut currentSessions].count, 0);
+    XCTAssertEqual([[SBSessionStore alloc] initWithPath:self.storePath].count, 0);
+    // the beacons are entered again
+    [self.sut updateSessionsWithBeacons:self.beacons];
+    XCTAssertEqual(self.enterCount, self.beacons.count);
+    SB_UNREGISTER();
+}
+
+- (void)test009RangingIsBatchedWithLastValueWins
+{
+    for (SBUnitTestBeacon *beacon in self.beacons) {
+        beacon.proximity = CLProximityNear;
+    }
+    self.sut.batchInterval = 0.05;
+    self.rangedBatches = [NSMutableArray new];
+    SB_REGISTER();
+    //
+    for (NSInteger rssi = -80; rssi <= -60; rssi += 10) {
+        for (SBUnitTestBeacon *beacon in self.beacons) {
+            beacon.rssi = rssi;
+        }
+        [self.sut updateSessionsWithBeacons:self.beacons];
+    }
+    XCTAssertEqual(self.rangedBatches.count, 0);
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"rangedBatches.@count == 1"] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    //
+    SBEventRangedBeacons *batch = self.rangedBatches.firstObject;
+    XCTAssertEqual(batch.beacons.count, self.beacons.count);
+    for (NSUInteger i = 0; i < self.beacons.count; i++) {
+        // first seen first, with the latest values
+        XCTAssertEqualObjects(batch.beacons[i].beacon, [[SBMBeacon alloc] initWithCLBeacon:self.beacons[i]]);
+        XCTAssertEqual(batch.beacons[i].rssi, -60);
+    }
+    // the per beacon events are opt-in
+    XCTAssertEqual(self.rangedBeaconCount, 0);
+    self.sut.publishesRangedBeacon = YES;
+    [self.sut updateSessionsWithBeacons:self.beacons];
+    XCTAssertEqual(self.rangedBeaconCount, self.beacons.count);
+    SB_UNREGISTER();
+}
+
+#pragma mark - Benchmarks
+
+- (void)testRangingCallbackAllocations
+{
+    NSUInteger const iterations = 100;
+    // what the ranging callback did per beacon before: string identity, keyed by fullUUID
+    NSMutableDictionary *stringSessions = [NSMutableDictionary new];
+    for (CLBeacon *beacon in self.beacons) {
+        stringSessions[[[SBMBeacon alloc] initWithCLBeacon:beacon].fullUUID] = [SBMSession new];
+    }
+    NSUInteger stringAllocations = SBCountAllocations(^{
+        for (NSUInteger i = 0; i < iterations; i++) {
+            for (CLBeacon *beacon in self.beacons) {
+                NSString *uuid = [[NSString stripHyphensFromUUIDString:beacon.proximityUUID.UUIDString] lowercaseString];
+                NSString *fullUUID = [NSString stringWithFormat:@"%@%@%@", uuid,
+                                      [NSString stringWithFormat:@"%0*d",5,beacon.major.intValue],
+                                      [NSString stringWithFormat:@"%0*d",5,beacon.minor.intValue]];
+                XCTAssertNotNil(stringSessions[fullUUID]);
+            }
+        }
+    });
+    // the same with the packed identity
+    NSMutableDictionary *beaconSessions = [NSMutableDictionary new];
+    for (CLBeacon *beacon in self.beacons) {
+        beaconSessions[[[SBMBeacon alloc] initWithCLBeacon:beacon]] = [SBMSession new];
+    }
+    NSUInteger beaconAllocations = SBCountAllocations(^{
+        for (NSUInteger i = 0; i < iterations; i++) {
+            for (CLBeacon *beacon in self.beacons) {
+                XCTAssertNotNil(beaconSessions[[[SBMBeacon alloc] initWithCLBeacon:beacon]]);
+            }
+        }
+    });
+    // the whole callback, including the published events
+    NSUInteger callbackAllocations = SBCountAllocations(^{
+        for (NSUInteger i = 0; i < iterations; i++) {
+            [self.sut updateSessionsWithBeacons:self.beacons];
+        }
+    });
+    //
+    double perBeacon = iterations * self.beacons.count;
+    NSLog(@"Allocations per ranged beacon: string identity %.1f, packed identity %.1f, full ranging callback %.1f",
+          stringAllocations / perBeacon, beaconAllocations / perBeacon, callbackAllocations / perBeacon);
+    XCTAssertLessThan(beaconAllocations, stringAllocations);
+}
+
+- (void)testPerformanceRangingCallback
+{
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 1000; i++) {
+            [self.sut updateSessionsWithBeacons:self.beacons];
+        }
+    }];
+}
+
 @end
@@ -153,4 +153,39 @@
     XCTAssertFalse([sbBeacon isEqual:@(9999)]);
 }
 
+- (void)test012HashMatchesEquality
+{
+    SBMBeacon *sbBeacon = [[SBMBeacon alloc] initWithString:self.sutFullUUID];
+    SBMBeacon *targetBeacon = [[SBMBeacon alloc] initWithString:[self.sutFullUUID uppercaseString]];
+    XCTAssert([sbBeacon isEqual:targetBeacon]);
+    XCTAssertEqual(sbBeacon.hash, targetBeacon.hash);
+    XCTAssertEqualObjects(targetBeacon.fullUUID, self.sutFullUUID);
+    
+    targetBeacon.minor = 748;
+    XCTAssertFalse([sbBeacon isEqual:targetBeacon]);
+    XCTAssertEqualObjects(targetBeacon.fullUUID, @"7367672374000000ffff0000ffff00030000200748");
+}
+
+- (void)test013CopyCanBeUsedAsDictionaryKey
+{
+    SBMBeacon *sbBeacon = [[SBMBeacon alloc] initWithString:self.sutFullUUID];
+    SBMBeacon *copy = [sbBeacon copy];
+    XCTAssert([sbBeacon isEqual:copy]);
+    
+    NSDictionary *sessions = @{sbBeacon : @"session"};
+    XCTAssertEqualObjects(sessions[[[SBMBeacon alloc] initWithString:self.sutFullUUID]], @"session");
+    
+    copy.major = 3;
+    XCTAssertEqualObjects(sbBeacon.fullUUID, self.sutFullUUID);
+    XCTAssertNil(sessions[copy]);
+}
+
+- (void)test014InitWithNonHexString
+{
+    SBMBeacon *sbBeacon = [[SBMBeacon alloc] initWithString:@"zz67672374000000ffff0000ffff00030000200747"];
+    XCTAssertEqualObjects(sbBeacon.uuid, @"zz67672374000000ffff0000ffff0003");
+    XCTAssertEqualObjects(sbBeacon.fullUUID, @"zz67672374000000ffff0000ffff00030000200747");
+    XCTAssert([sbBeacon isEqual:[[SBMBeacon alloc] initWithString:@"zz67672374000000ffff0000ffff00030000200747"]]);
+}
+
 @end
@@ -25,6 +25,8 @@
 
 #import "SBTestCase.h"
 
+#import "SensorbergSDK.h"
+
 #import <tolo/Tolo.h>
 #import "SBManager.h"
 #import "SBSettings.h"
@@ -157,14 +159,14 @@ SUBSCRIBE(SBEventReportHistory)
     [self.sut requestBluetoothAuthorization];
     SBBluetoothStatus bleState = [self.sut bluetoothAuthorization];
 #pragma clang diagnostic pop
-    [[Tolo sharedInstance] subscribe:self.sut];
+    [[SensorbergSDK eventBus] subscribe:self.sut];
     [self.sut setApiKey:self.defaultAPIKey delegate:self];
 }
 
 - (void)tearDown {
-    [[Tolo sharedInstance] unsubscribe:self.sut];
+    [[SensorbergSDK eventBus] unsubscribe:self.sut];
     [self.sut resetSharedClient];
-    UNREGISTER();
+    SB_UNREGISTER();
     [super tearDown];
 }
 
@@ -258,7 +260,7 @@ SUBSCRIBE(SBEventReachabilityEvent)
 {
     [self.expectations setObject:[self expectationWithDescription:@"testResetSharedClientInBackgroundThread"]
                           forKey:@"testResetSharedClientInBackgroundThread"];
-    REGISTER();
+    SB_REGISTER();
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
         [self.sut resetSharedClient];
     });
@@ -266,21 +268,21 @@ SUBSCRIBE(SBEventReachabilityEvent)
     [self waitForExpectationsWithTimeout:1 handler:nil];
     SBEventResetManager *event = [self.events objectForKey:@"testResetSharedClientInBackgroundThread"];
     XCTAssert(event);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 -(void)test002Ping
 {
     [self.expectations setObject:[self expectationWithDescription:@"test002Ping"]
                           forKey:@"test002Ping"];
-    REGISTER();
+    SB_REGISTER();
     [self.sut setApiKey:nil delegate:nil];
     [self.sut requestResolverStatus];
     [self waitForExpectationsWithTimeout:6 handler:nil];
     SBEventReachabilityEvent *event = [self.events objectForKey:@"test002Ping"];
     XCTAssert(event);
     XCTAssertNil(event.error);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 -(void)test003LatencyWithError
@@ -288,12 +290,12 @@ SUBSCRIBE(SBEventReachabilityEvent)
     SBEventPing *event = [SBEventPing new];
     event.error = nil;
     event.latency = 1.0f;
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     event = [SBEventPing new];
     event.error = [NSError new];
     event.latency = -1.0f;
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     XCTAssert([self.sut resolverLatency] == 1.0f);
 }
@@ -302,7 +304,7 @@ SUBSCRIBE(SBEventReachabilityEvent)
 {
     [self.expectations setObject:[self expectationWithDescription:@"testSetResolverApiKeyDelegateInBackgroundThread"]
                           forKey:@"testSetResolverApiKeyDelegateInBackgroundThread"];
-    REGISTER();
+    SB_REGISTER();
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
         [self.sut setApiKey:self.defaultAPIKey delegate:nil];
     });
@@ -310,7 +312,7 @@ SUBSCRIBE(SBEventReachabilityEvent)
     [self waitForExpectationsWithTimeout:4 handler:nil];
     SBEventGetLayout *event = [self.events objectForKey:@"testSetResolverApiKeyDelegateInBackgroundThread"];
     XCTAssert(event);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 - (void)test007StartMonitoringWithLayout
@@ -318,7 +320,7 @@ SUBSCRIBE(SBEventReachabilityEvent)
     SBFakeManager *manager = [SBFakeManager new];
     SBEventGetLayout *event = [SBEventGetLayout new];
     event.layout = [[SBMGetLayout alloc] initWithDictionary:self.defaultLayoutDict error:nil];
-    PUBLISH(event);
+    SB_PUBLISH(event);
     [manager startMonitoring];
     XCTAssert(manager.UUIDs.count >= event.layout.accountProximityUUIDs.count);
 }
@@ -326,25 +328,25 @@ SUBSCRIBE(SBEventReachabilityEvent)
 - (void)atest008StartMonitoringWithNullLayout
 {
     SBFakeManager *manager = [SBFakeManager new];
-    [[Tolo sharedInstance] subscribe:manager];
+    [[SensorbergSDK eventBus] subscribe:manager];
     [manager startMonitoring];
     XCTAssertTrue(manager.UUIDs.count == [SBSettings sharedManager].settings.defaultBeaconRegions.allKeys.count);
     
-    [[Tolo sharedInstance] unsubscribe:manager];
+    [[SensorbergSDK eventBus] unsubscribe:manager];
 }
 
 - (void)test009OnSBEventGetLayoutWithError
 {
     SBFakeManager *manager = [SBFakeManager new];
-    [[Tolo sharedInstance] subscribe:manager];
+    [[SensorbergSDK eventBus] subscribe:manager];
     
     SBEventGetLayout *event = [SBEventGetLayout new];
     event.layout = [[SBMGetLayout alloc] initWithDictionary:self.defaultLayoutDict error:nil];
     event.error = [[NSError alloc] initWithDomain:@"XCTTestExpectedError" code:100 userInfo:nil];
-    PUBLISH(event);
+    SB_PUBLISH(event);
     XCTAssertFalse(manager.UUIDs.count >= [SBSettings sharedManager].settings.defaultBeaconRegions.allKeys.count);
     
-    [[Tolo sharedInstance] unsubscribe:manager];
+    [[SensorbergSDK eventBus] unsubscribe:manager];
 }
 
 - (void)test010OnSBEventGetLayoutWithDelay
@@ -352,8 +354,8 @@ SUBSCRIBE(SBEventReachabilityEvent)
     [self.expectations setObject:[self expectationWithDescription:@"testOnSBEventGetLayoutWithDelay"]
                           forKey:@"testOnSBEventGetLayoutWithDelay"];
     SBFakeManager *manager = [SBFakeManager new];
-    [[Tolo sharedInstance] subscribe:manager];
-    REGISTER();
+    [[SensorbergSDK eventBus] subscribe:manager];
+    SB_REGISTER();
     SBEventGetLayout *layoutEvent = [SBEventGetLayout new];
     layoutEvent.layout = [[SBMGetLayout alloc] initWithDictionary:self.defaultLayoutDict error:nil];
     layoutEvent.error = [[NSError alloc] initWithDomain:@"XCTTestExpectedError" code:100 userInfo:nil];
@@ -367,8 +369,8 @@ SUBSCRIBE(SBEventReachabilityEvent)
     [self waitForExpectationsWithTimeout:1 handler:nil];
     SBEventResetManager *event = [self.events objectForKey:@"testOnSBEventGetLayoutWithDelay"];
     XCTAssert(event);
-    [[Tolo sharedInstance] unsubscribe:manager];
-    UNREGISTER();
+    [[SensorbergSDK eventBus] unsubscribe:manager];
+    SB_UNREGISTER();
 }
 
 - (void)test011OnSBEventPostLayoutWithError
@@ -376,7 +378,7 @@ SUBSCRIBE(SBEventReachabilityEvent)
     [keychain removeItemForKey:kPostLayout];
     SBEventPostLayout *event = [SBEventPostLayout new];
     event.error = [[NSError alloc] initWithDomain:@"XCTTestExpectedError" code:100 userInfo:nil];
-    PUBLISH(event);
+    SB_PUBLISH(event);
     XCTAssertNil([keychain stringForKey:kPostLayout]);
 }
 
@@ -384,7 +386,7 @@ SUBSCRIBE(SBEventReachabilityEvent)
 {
     [keychain removeItemForKey:kPostLayout];
     SBEventPostLayout *event = [SBEventPostLayout new];
-    PUBLISH(event);
+    SB_PUBLISH(event);
     XCTAssert([keychain stringForKey:kPostLayout]);
 }
 
@@ -392,131 +394,131 @@ SUBSCRIBE(SBEventReachabilityEvent)
 {
     [self.expectations setObject:[self expectationWithDescription:@"testSetIDFAValue"]
                           forKey:@"testSetIDFAValue"];
-    REGISTER();
+    SB_REGISTER();
     [self.sut setIDFAValue:@"KindOfIDFAString"];
     [self waitForExpectationsWithTimeout:2 handler:nil];
     SBEventUpdateHeaders *event = [self.events objectForKey:@"testSetIDFAValue"];
     XCTAssert(event);
     XCTAssert([keychain stringForKey:kIDFA]);
-    UNREGISTER();
+    SB_UNREGISTER();
     
 }
 
 - (void)test014SetIDFAValueWithZeroLength
 {
     [keychain removeItemForKey:kIDFA];
-    REGISTER();
+    SB_REGISTER();
     [self.sut setIDFAValue:@""];
     XCTAssertNil([keychain stringForKey:kIDFA]);
-    UNREGISTER();
+    SB_UNREGISTER();
     
 }
 
 - (void)test015SetIDFAValueWithNSNullInstance
 {
     [keychain removeItemForKey:kIDFA];
-    REGISTER();
+    SB_REGISTER();
     [self.sut setIDFAValue:(NSString *)[NSNull null]];
     XCTAssertNil([keychain stringForKey:kIDFA]);
-    UNREGISTER();
+    SB_UNREGISTER();
     
 }
 
 - (void)test016SetIDFAValueWithWrongClassInstance
 {
     [keychain removeItemForKey:kIDFA];
-    REGISTER();
+    SB_REGISTER();
     [self.sut setIDFAValue:(NSString *)@(0)];
     XCTAssertNil([keychain stringForKey:kIDFA]);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 - (void)test017ReportConversion
 {
-    REGISTER();
+    SB_REGISTER();
     [self.sut reportConversion:kSBConversionUnavailable forCampaignAction:@"testReportConversion"];
     SBEventReportConversion *event = [self.events objectForKey:@"testReportConversion"];
     XCTAssert(event);
     XCTAssert(event.conversionType == kSBConversionUnavailable);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 - (void)test018ReportConversionWithZeroLength
 {
-    REGISTER();
+    SB_REGISTER();
     [self.sut reportConversion:kSBConversionUnavailable forCampaignAction:@""];
     SBEventReportConversion *event = [self.events objectForKey:@"testReportConversion"];
     XCTAssertNil(event);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 - (void)test019ReportConversionWithNSNullInstance
 {
-    REGISTER();
+    SB_REGISTER();
     [self.sut reportConversion:kSBConversionUnavailable forCampaignAction:(NSString *)[NSNull null]];
     SBEventReportConversion *event = [self.events objectForKey:@"testReportConversion"];
     XCTAssertNil(event);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 - (void)test020ReportConversionWithWrongClassInstance
 {
-    REGISTER();
+    SB_REGISTER();
     [self.sut reportConversion:kSBConversionUnavailable forCampaignAction:(NSString *)@(1982)];
     SBEventReportConversion *event = [self.events objectForKey:@"testReportConversion"];
     XCTAssertNil(event);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 - (void)atest021OnSBEventRegionExit
 {
-    REGISTER();
+    SB_REGISTER();
     [self.expectations setObject:[self expectationWithDescription:@"testOnSBEventRegionExit"]
                           forKey:@"testOnSBEventRegionExit"];
     SBEventRegionExit *exitEvent = [SBEventRegionExit new];
     SBMGetLayout *layout = [[SBMGetLayout alloc] initWithDictionary:self.defaultLayoutDict error:nil];
     exitEvent.beacon = [layout.actions[0] beacons][0];
-    PUBLISH(exitEvent);
+    SB_PUBLISH(exitEvent);
     [self waitForExpectationsWithTimeout:10 handler:nil];
     SBEventPerformAction *event = [self.events objectForKey:@"testOnSBEventRegionExit"];
     XCTAssert(event);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 - (void)test022OnSBEventRangedBeacon
 {
     SBFakeManager *manager = [SBFakeManager new];
-    [[Tolo sharedInstance] subscribe:manager];
+    [[SensorbergSDK eventBus] subscribe:manager];
     manager.expectation = [self expectationWithDescription:@"test022OnSBEventRangedBeacon"];
-    REGISTER();
+    SB_REGISTER();
     SBEventRangedBeacon *rangeEvent = [SBEventRangedBeacon new];
-    PUBLISH(rangeEvent);
+    SB_PUBLISH(rangeEvent);
     [self waitForExpectationsWithTimeout:1 handler:nil];
     //SBEventPostLayout event should not be fired.
     XCTAssert(manager.expectedRangedBeaconEvent);
-    [[Tolo sharedInstance] unsubscribe:manager];
-    UNREGISTER();
+    [[SensorbergSDK eventBus] unsubscribe:manager];
+    SB_UNREGISTER();
 }
 
 
 - (void)test023OnSBEventReportHistoryNoForce
 {
     SBFakeManager *manager = [SBFakeManager new];
-    [[Tolo sharedInstance] subscribe:manager];
-    REGISTER();
+    [[SensorbergSDK eventBus] subscribe:manager];
+    SB_REGISTER();
     SBEventGetLayout *layoutEvent = [SBEventGetLayout new];
     layoutEvent.layout = [[SBMGetLayout alloc] initWithDictionary:self.defaultLayoutDict error:nil];
-    PUBLISH(layoutEvent);
+    SB_PUBLISH(layoutEvent);
     
     SBEventReportHistory *reportHistoryEvent = [SBEventReportHistory new];
     reportHistoryEvent.forced = NO;
-    PUBLISH(reportHistoryEvent);
+    SB_PUBLISH(reportHistoryEvent);
     SBEventPostLayout *event = [self.events objectForKey:@"test023OnSBEventReportHistoryNoForce"];
     
     //SBEventPostLayout event should not be fired.
     XCTAssertNil(event);
-    [[Tolo sharedInstance] unsubscribe:manager];
-    UNREGISTER();
+    [[SensorbergSDK eventBus] unsubscribe:manager];
+    SB_UNREGISTER();
 }
 
 @end
@@ -0,0 +1,233 @@
+//
+//  SBPostLayoutUploadTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+
+#import "SensorbergSDK.h"
+
+#import "SBResolver.h"
+#import "SBSettings.h"
+#import "SBInternalEvents.h"
+#import "SBPostLayoutChunker.h"
+#import "SBTestURLProtocol.h"
+#import "SBUtility.h"
+
+#import <tolo/Tolo.h>
+
+@interface SBPostLayoutUploadTests : SBTestCase
+@property (nonatomic, strong) SBResolver *sut;
+@property (nonatomic, strong) NSMutableArray <SBEventPostLayout *> *postEvents;
+@property (nonatomic, strong) XCTestExpectation *postLayoutExpectation;
+@property (nonatomic) NSUInteger expectedPostEvents;
+@end
+
+@implementation SBPostLayoutUploadTests
+
+- (void)setUp {
+    [super setUp];
+    self.continueAfterFailure = NO;
+    self.sut = [[SBResolver alloc] initWithApiKey:@"TestAPIKey"];
+    self.postEvents = [NSMutableArray new];
+    [[SensorbergSDK eventBus] subscribe:self.sut];
+    SB_REGISTER();
+    [SBTestURLProtocol install];
+}
+
+- (void)tearDown {
+    [SBTestURLProtocol uninstall];
+    SB_UNREGISTER();
+    [[SensorbergSDK eventBus] unsubscribe:self.sut];
+    SBMSettings *defaultSettings = [SBMSettings new];
+    [SBSettings sharedManager].settings.postChunkRecordCount = defaultSettings.postChunkRecordCount;
+    [SBSettings sharedManager].settings.postChunkByteCount = defaultSettings.postChunkByteCount;
+    self.sut = nil;
+    self.postEvents = nil;
+    self.postLayoutExpectation = nil;
+    [super tearDown];
+}
+
+// the chunk body is written in UTC, toDictionary uses the local time zone: compare the instants
+static id SBNormalizedDates(id object) {
+    if ([object isKindOfClass:[NSArray class]]) {
+        NSMutableArray *normalized = [NSMutableArray new];
+        for (id element in object) {
+            [normalized addObject:SBNormalizedDates(element)];
+        }
+        return normalized;
+    }
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *normalized = [NSMutableDictionary new];
+        for (NSString *key in object) {
+            id value = object[key];
+            NSDate *date = nil;
+            if ([value isKindOfClass:[NSString class]] && ([key isEqualToString:@"dt"] || [key isEqualToString:@"deviceTimestamp"])) {
+                date = [dateFormatter dateFromString:value];
+            }
+            normalized[key] = date ? : SBNormalizedDates(value);
+        }
+        return normalized;
+    }
+    return object;
+}
+
+- (SBMPostLayout *)postLayoutWithEventCount:(NSUInteger)count {
+    NSMutableArray *events = [NSMutableArray new];
+    // whole seconds, so both encodings represent the same instant
+    NSDate *now = [NSDate dateWithTimeIntervalSince1970:floor([NSDate date].timeIntervalSince1970)];
+    for (NSUInteger i = 0; i < count; i++) {
+        SBMMonitorEvent *event = [SBMMonitorEvent new];
+        event.pid = [NSString stringWithFormat:@"7367672374000000ffff0000ffff0003%010lu", (unsigned long)i];
+        event.dt = now;
+        event.trigger = kSBTriggerEnter;
+        [events addObject:event];
+    }
+    SBMPostLayout *postData = [SBMPostLayout new];
+    postData.deviceTimestamp = now;
+    postData.events = (NSArray <SBMMonitorEvent> *)events;
+    postData.actions = (NSArray <SBMReportAction> *)@[];
+    postData.conversions = (NSArray <SBMReportConversion> *)@[];
+    return postData;
+}
+
+- (NSArray *)chunksForPostLayout:(SBMPostLayout *)postData maxRecords:(NSUInteger)maxRecords maxBytes:(NSUInteger)maxBytes {
+    SBPostLayoutChunker *chunker = [[SBPostLayoutChunker alloc] initWithPostLayout:postData maxRecords:maxRecords maxBytes:maxBytes];
+    NSMutableArray *chunks = [NSMutableArray new];
+    SBPostLayoutChunk *chunk;
+    while ((chunk = [chunker nextChunk])) {
+        [chunks addObject:chunk];
+    }
+    return chunks;
+}
+
+SUBSCRIBE(SBEventPostLayout) {
+    [self.postEvents addObject:event];
+    if (self.postEvents.count == self.expectedPostEvents) {
+        [self.postLayoutExpectation fulfill];
+    }
+}
+
+#pragma mark - Chunking
+
+- (void)test000ChunksByRecordCount {
+    NSArray <SBPostLayoutChunk *> *chunks = [self chunksForPostLayout:[self postLayoutWithEventCount:25] maxRecords:10 maxBytes:0];
+    XCTAssertEqual(chunks.count, 3);
+    XCTAssertEqual(chunks[0].postData.events.count, 10);
+    XCTAssertEqual(chunks[2].postData.events.count, 5);
+    
+    NSDictionary *body = [NSJSONSerialization JSONObjectWithData:chunks[2].body options:0 error:nil];
+    XCTAssertEqual([body[@"events"] count], 5);
+    XCTAssertEqual([body[@"actions"] count], 0);
+    XCTAssertNotNil(body[@"deviceTimestamp"]);
+}
+
+- (void)test001ChunksByByteCount {
+    SBMPostLayout *postData = [self postLayoutWithEventCount:25];
+    NSArray <SBPostLayoutChunk *> *chunks = [self chunksForPostLayout:postData maxRecords:0 maxBytes:1024];
+    XCTAssert(chunks.count > 1);
+    
+    NSUInteger records = 0;
+    for (SBPostLayoutChunk *chunk in chunks) {
+        XCTAssert(chunk.body.length <= 1024);
+        NSDictionary *body = [NSJSONSerialization JSONObjectWithData:chunk.body options:0 error:nil];
+        XCTAssertEqual([body[@"events"] count], chunk.postData.events.count);
+        records += chunk.postData.events.count;
+    }
+    XCTAssertEqual(records, 25);
+}
+
+- (void)test002UnlimitedChunkMatchesPostLayoutDictionary {
+    SBMPostLayout *postData = [self postLayoutWithEventCount:25];
+    NSArray <SBPostLayoutChunk *> *chunks = [self chunksForPostLayout:postData maxRecords:0 maxBytes:0];
+    XCTAssertEqual(chunks.count, 1);
+    
+    NSDictionary *body = [NSJSONSerialization JSONObjectWithData:chunks[0].body options:0 error:nil];
+    XCTAssertNotNil(body);
+    XCTAssertEqualObjects(SBNormalizedDates(body), SBNormalizedDates([postData toDictionary]));
+}
+
+#pragma mark - Upload
+
+- (void)test003FailedChunkIsNotAcknowledged {
+    [SBSettings sharedManager].settings.postChunkRecordCount = 10;
+    [SBSettings sharedManager].settings.postChunkByteCount = 0;
+    
+    __block NSUInteger requests = 0;
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        requests++;
+        if (requests == 2) {
+            *statusCode = 500;
+        }
+        return nil;
+    }];
+    
+    SBMPostLayout *postData = [self postLayoutWithEventCount:25];
+    self.expectedPostEvents = 3;
+    self.postLayoutExpectation = [self expectationWithDescription:@"Wait for the chunks"];
+    [self.sut postLayout:postData];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    NSMutableSet *acknowledged = [NSMutableSet new];
+    NSMutableSet *failed = [NSMutableSet new];
+    for (SBEventPostLayout *event in self.postEvents) {
+        [(event.error ? failed : acknowledged) addObjectsFromArray:event.postData.events];
+    }
+    XCTAssertEqual(acknowledged.count, 15);
+    XCTAssertEqual(failed.count, 10);
+    
+    // the next report resumes with what was not acknowledged
+    NSMutableArray *remaining = [postData.events mutableCopy];
+    [remaining removeObjectsInArray:acknowledged.allObjects];
+    postData.events = (NSArray <SBMMonitorEvent> *)remaining;
+    
+    [self.postEvents removeAllObjects];
+    self.expectedPostEvents = 1;
+    self.postLayoutExpectation = [self expectationWithDescription:@"Wait for the retry"];
+    [self.sut postLayout:postData];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    XCTAssertNil(self.postEvents.firstObject.error);
+    XCTAssertEqualObjects([NSSet setWithArray:self.postEvents.firstObject.postData.events], failed);
+}
+
+- (void)test004PostWhileUploadingIsIgnored {
+    [SBSettings sharedManager].settings.postChunkRecordCount = 10;
+    
+    __block NSUInteger requests = 0;
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        requests++;
+        return nil;
+    }];
+    
+    self.expectedPostEvents = 2;
+    self.postLayoutExpectation = [self expectationWithDescription:@"Wait for the chunks"];
+    [self.sut postLayout:[self postLayoutWithEventCount:20]];
+    [self.sut postLayout:[self postLayoutWithEventCount:20]];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    
+    XCTAssertEqual(requests, 2);
+}
+
+@end
@@ -0,0 +1,157 @@
+//
+//  SBRegionSchedulerTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+#import "SBRegionScheduler.h"
+#import "SBRegionVenueSimulator.h"
+
+@interface SBRegionSchedulerTests : SBTestCase
+@property (nonatomic, strong) SBRegionScheduler *sut;
+@end
+
+@implementation SBRegionSchedulerTests
+
+- (void)setUp {
+    [super setUp];
+    self.sut = [[SBRegionScheduler alloc] initWithCapacity:4];
+    self.sut.rotatingSlots = 1;
+}
+
+- (void)tearDown {
+    self.sut = nil;
+    [super tearDown];
+}
+
+- (NSString *)uuid:(NSUInteger)index {
+    return [NSString stringWithFormat:@"7367672374%022lx", (unsigned long)index];
+}
+
+- (NSString *)beacon:(NSUInteger)minor ofUUID:(NSUInteger)index {
+    return [NSString stringWithFormat:@"%@%05lu%05lu", [self uuid:index], (unsigned long)1, (unsigned long)minor];
+}
+
+- (NSArray *)uuids:(NSUInteger)count {
+    NSMutableArray *uuids = [NSMutableArray new];
+    for (NSUInteger i = 0; i < count; i++) {
+        [uuids addObject:[self uuid:i]];
+    }
+    return uuids;
+}
+
+- (void)testFewCandidatesAreAllMonitored {
+    NSArray *candidates = [self uuids:3];
+    [self.sut setCandidates:candidates campaignCounts:@{} now:0];
+    XCTAssertEqualObjects([self.sut regionsAt:0], candidates);
+}
+
+- (void)testSelectionStaysWithinCapacityAndPrefersCampaigns {
+    NSArray *candidates = [self uuids:10];
+    [self.sut setCandidates:candidates campaignCounts:@{candidates[7]: @8, candidates[9]: @3} now:0];
+    NSArray *regions = [self.sut regionsAt:0];
+    XCTAssertEqual(regions.count, 4);
+    // by score, then in candidate order; the last slot rotates
+    XCTAssertEqualObjects([regions subarrayWithRange:NSMakeRange(0, 3)], (@[candidates[7], candidates[9], candidates[0]]));
+    // the same until the rotation is due
+    XCTAssertEqualObjects([self.sut regionsAt:60], regions);
+    XCTAssertFalse([self.sut isSelectionDueAt:60]);
+    XCTAssertTrue([self.sut isSelectionDueAt:self.sut.rotationInterval]);
+}
+
+- (void)testRotationReachesEveryCandidate {
+    NSArray *candidates = [self uuids:10];
+    [self.sut setCandidates:candidates campaignCounts:@{} now:0];
+    NSMutableSet *seen = [NSMutableSet new];
+    for (NSUInteger turn = 0; turn < 10; turn++) {
+        NSArray *regions = [self.sut regionsAt:turn * self.sut.rotationInterval];
+        XCTAssertLessThanOrEqual(regions.count, self.sut.capacity);
+        [seen addObjectsFromArray:regions];
+    }
+    XCTAssertEqual(seen.count, candidates.count);
+}
+
+- (void)testSightingsPinARegion {
+    NSArray *candidates = [self uuids:10];
+    [self.sut setCandidates:candidates campaignCounts:@{} now:0];
+    [self.sut recordSightingOfBeacon:[self beacon:1 ofUUID:8] now:0];
+    for (NSUInteger turn = 0; turn < 5; turn++) {
+        XCTAssertTrue([[self.sut regionsAt:turn * self.sut.rotationInterval] containsObject:candidates[8]]);
+    }
+    // seen near here: still ahead of the others once the sighting has faded
+    self.sut.currentGeohash = @"u33dbfc";
+    [self.sut recordSightingOfBeacon:[self beacon:1 ofUUID:5] now:0];
+    XCTAssertGreaterThan([self.sut scoreOfRegion:candidates[5] now:48 * 3600], [self.sut scoreOfRegion:candidates[4] now:48 * 3600]);
+    self.sut.currentGeohash = @"u281zh7";
+    XCTAssertEqualWithAccuracy([self.sut scoreOfRegion:candidates[5] now:48 * 3600], [self.sut scoreOfRegion:candidates[4] now:48 * 3600], 0.001);
+}
+
+- (void)testProximityUUIDReplacesItsBeacons {
+    NSArray *candidates = @[[self beacon:1 ofUUID:0], [self beacon:2 ofUUID:0], [self beacon:1 ofUUID:1],
+                            [self uuid:0], [self uuid:2], [self uuid:3], [self uuid:4]];
+    [self.sut setCandidates:candidates campaignCounts:@{[self uuid:0]: @4, [self beacon:1 ofUUID:1]: @2} now:0];
+    NSArray *regions = [self.sut regionsAt:0];
+    XCTAssertEqual(regions.count, 4);
+    XCTAssertTrue([regions containsObject:[self uuid:0]]);
+    XCTAssertFalse([regions containsObject:[self beacon:1 ofUUID:0]]);
+    XCTAssertFalse([regions containsObject:[self beacon:2 ofUUID:0]]);
+    XCTAssertTrue([regions containsObject:[self beacon:1 ofUUID:1]]);
+}
+
+- (void)testUnchangedCandidatesKeepTheSelection {
+    NSArray *candidates = [self uuids:10];
+    [self.sut setCandidates:candidates campaignCounts:@{} now:0];
+    [self.sut regionsAt:0];
+    [self.sut setCandidates:[candidates copy] campaignCounts:@{} now:10];
+    XCTAssertFalse([self.sut isSelectionDueAt:10]);
+    [self.sut setCandidates:[candidates subarrayWithRange:NSMakeRange(1, 9)] campaignCounts:@{} now:10];
+    XCTAssertTrue([self.sut isSelectionDueAt:10]);
+}
+
+#pragma mark - Venue simulation
+
+- (void)testVenueCoverageAgainstTruncation {
+    SBRegionVenueSimulator *venue = [[SBRegionVenueSimulator alloc] initWithSeed:2016 proximityUUIDs:40 beaconsPerUUID:3];
+    NSUInteger const minutes = 7 * 24 * 60;
+    // what monitoringBeaconRegions did with that many beacons: the first 20 proximity UUIDs
+    NSArray *truncated = [venue.proximityUUIDs subarrayWithRange:NSMakeRange(0, 20)];
+    double baseline = [venue coverageWithScheduler:nil staticRegions:truncated minutes:minutes];
+    SBRegionScheduler *scheduler = [[SBRegionScheduler alloc] initWithCapacity:20];
+    double scheduled = [venue coverageWithScheduler:scheduler staticRegions:nil minutes:minutes];
+    // repeatable
+    SBRegionScheduler *again = [[SBRegionScheduler alloc] initWithCapacity:20];
+    XCTAssertEqual([venue coverageWithScheduler:again staticRegions:nil minutes:minutes], scheduled);
+    NSLog(@"Region coverage over a week, 40 proximity UUIDs with 3 beacons each: truncated %.1f%%, scheduled %.1f%%",
+          baseline * 100, scheduled * 100);
+    XCTAssertGreaterThan(scheduled, baseline);
+}
+
+- (void)testPerformanceVenueSimulation {
+    SBRegionVenueSimulator *venue = [[SBRegionVenueSimulator alloc] initWithSeed:2016 proximityUUIDs:40 beaconsPerUUID:3];
+    [self measureBlock:^{
+        [venue coverageWithScheduler:[[SBRegionScheduler alloc] initWithCapacity:20] staticRegions:nil minutes:24 * 60];
+    }];
+}
+
+@end
@@ -0,0 +1,61 @@
+//
+//  SBRegionVenueSimulator.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class SBRegionScheduler;
+
+/**
+ *  A synthetic venue to score region scheduling offline, Foundation only.
+ *
+ *  Proximity UUIDs are spread over a few sites (each with its geohash), their beacons over the zones of the site.
+ *  A visitor spends a few hours per site, moving zone every few minutes, with travel in between.
+ *  Everything derives from the seed, so runs are repeatable and comparable.
+ */
+@interface SBRegionVenueSimulator : NSObject
+
+- (instancetype)initWithSeed:(uint64_t)seed proximityUUIDs:(NSUInteger)uuidCount beaconsPerUUID:(NSUInteger)beaconCount;
+
+/**
+ *  Beacon regions, then proximity UUID regions, as SBManager lists them
+ */
+@property (nonatomic, readonly) NSArray <NSString *> *candidates;
+
+@property (nonatomic, readonly) NSArray <NSString *> *proximityUUIDs;
+
+@property (nonatomic, readonly) NSDictionary <NSString *, NSNumber *> *campaignCounts;
+
+/**
+ *  Share of the beacon minutes in range that were in a monitored region, weighted by the campaigns of the beacon.
+ *  Only monitored beacons are reported to the scheduler as sightings, like on a device.
+ *
+ *  @param scheduler     picks the regions every minute, nil to monitor `staticRegions` throughout
+ *  @param staticRegions regions monitored without a scheduler
+ *  @param minutes       length of the simulation
+ */
+- (double)coverageWithScheduler:(SBRegionScheduler *)scheduler staticRegions:(NSArray <NSString *> *)staticRegions minutes:(NSUInteger)minutes;
+
+@end
@@ -0,0 +1,142 @@
+//
+//  SBRegionVenueSimulator.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBRegionVenueSimulator.h"
+
+#import "SBRegionScheduler.h"
+
+static NSUInteger const kSBVenueSites = 4;
+static NSUInteger const kSBVenueZonesPerSite = 12;
+
+// xorshift64*, the same sequence on every platform
+static uint64_t SBVenueRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static NSUInteger SBVenueRandomBelow(uint64_t *state, NSUInteger bound) {
+    return (NSUInteger)(SBVenueRandom(state) % bound);
+}
+
+@interface SBRegionVenueSimulator () {
+    uint64_t seed;
+    NSArray <NSString *> *geohashes;
+    // zone (site * kSBVenueZonesPerSite + zone) -> beacons in range there
+    NSArray <NSArray <NSString *> *> *zones;
+}
+
+@end
+
+@implementation SBRegionVenueSimulator
+
+- (instancetype)initWithSeed:(uint64_t)value proximityUUIDs:(NSUInteger)uuidCount beaconsPerUUID:(NSUInteger)beaconCount
+{
+    self = [super init];
+    if (self) {
+        seed = value ?: 1;
+        uint64_t state = seed;
+        geohashes = @[@"u33dbfc", @"u33dc0r", @"u281zh7", @"u0yjjd6"];
+        NSMutableArray *zoneBeacons = [NSMutableArray new];
+        for (NSUInteger zone = 0; zone < kSBVenueSites * kSBVenueZonesPerSite; zone++) {
+            [zoneBeacons addObject:[NSMutableArray new]];
+        }
+        NSMutableArray *beacons = [NSMutableArray new];
+        NSMutableArray *uuids = [NSMutableArray new];
+        NSMutableDictionary *counts = [NSMutableDictionary new];
+        for (NSUInteger u = 0; u < uuidCount; u++) {
+            NSString *uuid = [NSString stringWithFormat:@"7367672374%022lx", (unsigned long)u];
+            [uuids addObject:uuid];
+            NSUInteger site = u % kSBVenueSites;
+            NSUInteger uuidCampaigns = 0;
+            for (NSUInteger b = 0; b < beaconCount; b++) {
+                NSString *beacon = [NSString stringWithFormat:@"%@%05lu%05lu", uuid, (unsigned long)u, (unsigned long)b];
+                [beacons addObject:beacon];
+                NSUInteger zone = site * kSBVenueZonesPerSite + SBVenueRandomBelow(&state, kSBVenueZonesPerSite);
+                [zoneBeacons[zone] addObject:beacon];
+                NSUInteger campaigns = 1 + SBVenueRandomBelow(&state, 4);
+                counts[beacon] = @(campaigns);
+                uuidCampaigns += campaigns;
+            }
+            counts[uuid] = @(uuidCampaigns);
+        }
+        _candidates = [beacons arrayByAddingObjectsFromArray:uuids];
+        _proximityUUIDs = [uuids copy];
+        _campaignCounts = [counts copy];
+        zones = [zoneBeacons copy];
+    }
+    return self;
+}
+
+- (double)coverageWithScheduler:(SBRegionScheduler *)scheduler staticRegions:(NSArray<NSString *> *)staticRegions minutes:(NSUInteger)minutes {
+    // the visitor's path depends on the seed only, every run sees the same
+    uint64_t state = seed ^ 0x9E3779B97F4A7C15ULL;
+    [scheduler setCandidates:self.candidates campaignCounts:self.campaignCounts now:0];
+    NSSet *monitored = [NSSet setWithArray:staticRegions ?: @[]];
+    //
+    double inRange = 0;
+    double covered = 0;
+    NSInteger site = -1;
+    NSUInteger zone = 0;
+    NSUInteger stay = 0;
+    for (NSUInteger minute = 0; minute < minutes; minute++) {
+        NSTimeInterval now = minute * 60.;
+        if (stay == 0) {
+            if (site >= 0) {
+                // travelling, out of range of everything
+                site = -1;
+                stay = 20 + SBVenueRandomBelow(&state, 40);
+            } else {
+                // mostly the first site, the others now and then
+                site = SBVenueRandomBelow(&state, 10) < 5 ? 0 : 1 + (NSInteger)SBVenueRandomBelow(&state, kSBVenueSites - 1);
+                stay = 60 + SBVenueRandomBelow(&state, 180);
+            }
+        }
+        stay--;
+        if (site >= 0 && (minute % 5 == 0 || stay == 0)) {
+            zone = site * kSBVenueZonesPerSite + SBVenueRandomBelow(&state, kSBVenueZonesPerSite);
+        }
+        if (scheduler) {
+            scheduler.currentGeohash = site >= 0 ? geohashes[site] : nil;
+            monitored = [NSSet setWithArray:[scheduler regionsAt:now]];
+        }
+        if (site < 0) {
+            continue;
+        }
+        for (NSString *beacon in zones[zone]) {
+            double weight = self.campaignCounts[beacon].doubleValue;
+            inRange += weight;
+            if ([monitored containsObject:beacon] || [monitored containsObject:[beacon substringToIndex:32]]) {
+                covered += weight;
+                [scheduler recordSightingOfBeacon:beacon now:now];
+            }
+        }
+    }
+    return inRange > 0 ? covered / inRange : 1;
+}
+
+@end
@@ -24,8 +24,10 @@
 //
 
 #import "SBTestCase.h"
+#import "SensorbergSDK.h"
 #import "SBResolver.h"
 #import "SBInternalEvents.h"
+#import "SBTestURLProtocol.h"
 #import <tolo/Tolo.h>
 
 FOUNDATION_EXPORT NSString *const kSBIdentifier;
@@ -39,6 +41,8 @@ FOUNDATION_EXPORT NSString *const kSBIdentifier;
 @property (nonatomic, strong) SBResolver *sut;
 @property (nonatomic, strong) SBEvent *event;
 @property (nonatomic, strong) XCTestExpectation *postLayoutExpectation;
+@property (nonatomic) NSUInteger layoutEventCount;
+@property (nonatomic, strong) NSMutableArray <SBEventPerformAction *> *performedActions;
 @end
 
 @implementation SBResolverTests
@@ -46,12 +50,12 @@ FOUNDATION_EXPORT NSString *const kSBIdentifier;
 - (void)setUp {
     [super setUp];
     self.sut = [[SBResolver alloc] initWithApiKey:@"TestAPIKey"];
-    [[Tolo sharedInstance] subscribe:self.sut];
+    [[SensorbergSDK eventBus] subscribe:self.sut];
 }
 
 - (void)tearDown {
     
-    [[Tolo sharedInstance] unsubscribe:self.sut];
+    [[SensorbergSDK eventBus] unsubscribe:self.sut];
     self.sut = nil;
     self.postLayoutExpectation = nil;
     self.event = nil;
@@ -68,7 +72,7 @@ FOUNDATION_EXPORT NSString *const kSBIdentifier;
 - (void)test001TargetAttributes {
     SBEventUpdateTargetAttributes *event = [SBEventUpdateTargetAttributes new];
     event.targetAttributes = @{@"b" : @"100", @"a" : @(0), @"z" : @[@"array", @"value"]};
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSString *tartgetAttributesString = [self.sut currentTargetAttributeString];
     // check also sort order : alpabetical acending 
@@ -77,7 +81,7 @@ FOUNDATION_EXPORT NSString *const kSBIdentifier;
 
 - (void)test002ClearTargetAttributes {
     SBEventUpdateTargetAttributes *event = [SBEventUpdateTargetAttributes new];
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSString *tartgetAttributesString = [self.sut currentTargetAttributeString];
     XCTAssertNil(tartgetAttributesString);
@@ -86,7 +90,7 @@ FOUNDATION_EXPORT NSString *const kSBIdentifier;
 - (void)test003EmptyTargetAttributes {
     SBEventUpdateTargetAttributes *event = [SBEventUpdateTargetAttributes new];
     event.targetAttributes = @{};
-    PUBLISH(event);
+    SB_PUBLISH(event);
     
     NSString *tartgetAttributesString = [self.sut currentTargetAttributeString];
     XCTAssertTrue(!tartgetAttributesString.length);
@@ -95,11 +99,17 @@ FOUNDATION_EXPORT NSString *const kSBIdentifier;
 SUBSCRIBE(SBEventGetLayout)
 {
     self.event = event;
+    self.layoutEventCount++;
+}
+
+SUBSCRIBE(SBEventPerformAction)
+{
+    [self.performedActions addObject:event];
 }
 
 - (void)test000PublishSBEventGetLayoutWithBeaconTriggerError
 {
-    REGISTER();
+    SB_REGISTER();
     self.sut = [[SBResolver alloc] initWithApiKey:@"TestAPIKey"];
     SBMBeacon *defaultBeacon = [[SBMBeacon alloc] initWithString:@"7367672374000000ffff0000ffff00030000200747"];
     [self.sut publishSBEventGetLayoutWithBeacon:defaultBeacon trigger:1 error:nil];
@@ -107,7 +117,7 @@ SUBSCRIBE(SBEventGetLayout)
     XCTAssert([event.beacon isEqual:defaultBeacon]);
     XCTAssert(event.trigger == 1);
     XCTAssertNil(event.error);
-    UNREGISTER();
+    SB_UNREGISTER();
 }
 
 SUBSCRIBE(SBEventPostLayout)
@@ -116,4 +126,51 @@ SUBSCRIBE(SBEventPostLayout)
     [self.postLayoutExpectation fulfill];
 }
 
+- (void)test004IdenticalLayoutRequestsShareOneFetch
+{
+    NSString *eid = [[NSUUID UUID].UUIDString stringByReplacingOccurrencesOfString:@"-" withString:@""];
+    NSString *enterBeacon = @"7367672374000000ffff0000ffff00030000200747";
+    NSString *otherBeacon = @"7367672374000000ffff0000ffff00030000200748";
+    NSDictionary *layout = @{@"accountProximityUUIDs": @[@"7367672374000000ffff0000ffff0003"],
+                             @"actions": @[@{@"eid": eid,
+                                             @"trigger": @(kSBTriggerEnter),
+                                             @"beacons": @[enterBeacon, otherBeacon],
+                                             @"type": @(kSBActionTypeText),
+                                             @"content": @{@"subject": @"Subject", @"body": @"Body", @"url": @"http://www.sensorberg.com"}}]};
+    NSData *layoutData = [NSJSONSerialization dataWithJSONObject:layout options:0 error:nil];
+    __block NSUInteger requests = 0;
+    [SBTestURLProtocol setResponseHandler:^NSData *(NSURLRequest *request, NSData *body, NSInteger *statusCode) {
+        requests++;
+        return layoutData;
+    }];
+    [SBTestURLProtocol install];
+    SB_REGISTER();
+    self.performedActions = [NSMutableArray new];
+    
+    SBMBeacon *beacon = [[SBMBeacon alloc] initWithString:enterBeacon];
+    SBMBeacon *other = [[SBMBeacon alloc] initWithString:otherBeacon];
+    [self.sut requestLayoutForBeacon:beacon trigger:kSBTriggerEnter useCache:YES];
+    [self.sut requestLayoutForBeacon:other trigger:kSBTriggerEnter useCache:YES];
+    [self.sut requestLayoutForBeacon:beacon trigger:kSBTriggerExit useCache:YES];
+    [self.sut requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:YES];
+    // the cache mode only matters when the fetch fails, it's the same request
+    [self.sut requestLayoutForBeacon:nil trigger:kSBTriggerNone useCache:NO];
+    
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        return self.layoutEventCount == 1;
+    }] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:4 handler:nil];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:.5]];
+    SB_UNREGISTER();
+    [SBTestURLProtocol uninstall];
+    
+    XCTAssertEqual(requests, 1);
+    XCTAssertEqual(self.layoutEventCount, 1);
+    XCTAssertEqual(self.sut.layoutRequestCount, 5);
+    XCTAssertEqual(self.sut.coalescedLayoutRequestCount, 4);
+    // every waiting enter got its own campaign check against the shared layout
+    XCTAssertEqual(self.performedActions.count, 2);
+    XCTAssertEqualObjects([self.performedActions valueForKeyPath:@"campaign.eid"], (@[eid, eid]));
+}
+
 @end
@@ -0,0 +1,190 @@
+//
+//  SBSessionStoreTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "SBTestCase.h"
+
+#import "SBSessionStore.h"
+#import "SBInternalModels.h"
+
+// a header and 64 byte records
+static unsigned long long const kSBSessionStoreRecordOffset = 64;
+static unsigned long long const kSBSessionStoreRecordLength = 64;
+
+@interface SBSessionStoreTests : SBTestCase
+@property (nonatomic, copy) NSString *path;
+@end
+
+@implementation SBSessionStoreTests
+
+- (void)setUp {
+    [super setUp];
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.table", [NSUUID UUID].UUIDString]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    self.path = nil;
+    [super tearDown];
+}
+
+- (SBMBeacon *)beaconWithIndex:(NSUInteger)index {
+    return [[SBMBeacon alloc] initWithString:[NSString stringWithFormat:@"7367672374000000ffff0000ffff0003%05lu%05lu", (unsigned long)index / 1000, (unsigned long)index % 1000]];
+}
+
+- (SBMSession *)sessionForKey:(id)key lastSeen:(NSTimeInterval)lastSeen {
+    SBMSession *session = [[SBMSession alloc] initWithUUID:[key isKindOfClass:[SBMBeacon class]] ? [key fullUUID] : key];
+    session.enter = [NSDate dateWithTimeIntervalSince1970:lastSeen - 60];
+    session.lastSeen = lastSeen;
+    return session;
+}
+
+- (unsigned long long)fileLength {
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:self.path error:nil] fileSize];
+}
+
+- (void)test000SessionsAreRestored {
+    SBSessionStore *store = [[SBSessionStore alloc] initWithPath:self.path];
+    XCTAssertEqual(store.restoredSessions.count, 0);
+    SBMSession *beaconSession = [self sessionForKey:[self beaconWithIndex:1] lastSeen:1000];
+    beaconSession.exit = 1010;
+    [store setSession:beaconSession forKey:[self beaconWithIndex:1]];
+    [store setSession:[self sessionForKey:@"u33dc1" lastSeen:2000] forKey:@"u33dc1"];
+    store = nil;
+    
+    NSDictionary *sessions = [[SBSessionStore alloc] initWithPath:self.path].restoredSessions;
+    XCTAssertEqual(sessions.count, 2);
+    SBMSession *restored = sessions[[self beaconWithIndex:1]];
+    XCTAssertEqualObjects(restored.pid, [self beaconWithIndex:1].fullUUID);
+    XCTAssertEqualObjects(restored.enter, beaconSession.enter);
+    XCTAssertEqual(restored.lastSeen, 1000);
+    XCTAssertEqual(restored.exit, 1010);
+    XCTAssertEqualObjects([sessions[@"u33dc1"] pid], @"u33dc1");
+    XCTAssertEqual([sessions[@"u33dc1"] exit], 0);
+}
+
+- (void)test001SightingsAreWrittenAtTheLastSeenResolution {
+    SBSessionStore *store = [[SBSessionStore alloc] initWithPath:self.path];
+    id key = [self beaconWithIndex:1];
+    SBMSession *session = [self sessionForKey:key lastSeen:1000];
+    [store setSession:session forKey:key];
+    session.lastSeen = 1004;
+    [store setSession:session forKey:key];
+    XCTAssertEqual([[[SBSessionStore alloc] initWithPath:self.path].restoredSessions[key] lastSeen], 1000);
+    session.lastSeen = 1005;
+    [store setSession:session forKey:key];
+    XCTAssertEqual([[[SBSessionStore alloc] initWithPath:self.path].restoredSessions[key] lastSeen], 1005);
+    // the exit mark is always written
+    session.lastSeen = 1006;
+    session.exit = 1006;
+    [store setSession:session forKey:key];
+    XCTAssertEqual([[[SBSessionStore alloc] initWithPath:self.path].restoredSessions[key] exit], 1006);
+}
+
+- (void)test002RemovedSessionsFreeTheirRecords {
+    SBSessionStore *store = [[SBSessionStore alloc] initWithPath:self.path];
+    for (NSUInteger i = 0; i < 200; i++) {
+        [store setSession:[self sessionForKey:[self beaconWithIndex:i] lastSeen:1000 + i] forKey:[self beaconWithIndex:i]];
+    }
+    unsigned long long length = [self fileLength];
+    XCTAssertEqual(length, kSBSessionStoreRecordOffset + 256 * kSBSessionStoreRecordLength);
+    for (NSUInteger i = 0; i < 150; i++) {
+        [store removeSessionForKey:[self beaconWithIndex:i]];
+    }
+    // the freed records are reused, the table doesn't grow
+    for (NSUInteger i = 200; i < 300; i++) {
+        [store setSession:[self sessionForKey:[self beaconWithIndex:i] lastSeen:1000 + i] forKey:[self beaconWithIndex:i]];
+    }
+    XCTAssertEqual(store.count, 150);
+    XCTAssertEqual([self fileLength], length);
+    
+    NSDictionary *sessions = [[SBSessionStore alloc] initWithPath:self.path].restoredSessions;
+    XCTAssertEqual(sessions.count, 150);
+    XCTAssertNil(sessions[[self beaconWithIndex:0]]);
+    XCTAssertEqual([sessions[[self beaconWithIndex:299]] lastSeen], 1299);
+    
+    [store removeAllSessions];
+    XCTAssertEqual([[SBSessionStore alloc] initWithPath:self.path].restoredSessions.count, 0);
+}
+
+- (void)test003KilledMidSessionKeepsTheSessions {
+    SBSessionStore *store = [[SBSessionStore alloc] initWithPath:self.path];
+    id key = [self beaconWithIndex:1];
+    SBMSession *session = [self sessionForKey:key lastSeen:1000];
+    [store setSession:session forKey:key];
+    session.lastSeen = 1030;
+    [store setSession:session forKey:key];
+    // killed: no flush, no unmap, nothing closed; what is in the mapping belongs to the kernel and outlives the process
+    CFBridgingRetain(store);
+    store = nil;
+    
+    SBSessionStore *relaunched = [[SBSessionStore alloc] initWithPath:self.path];
+    XCTAssertEqual(relaunched.restoredSessions.count, 1);
+    XCTAssertEqual([relaunched.restoredSessions[key] lastSeen], 1030);
+}
+
+- (void)test004TornRecordIsDropped {
+    SBSessionStore *store = [[SBSessionStore alloc] initWithPath:self.path];
+    for (NSUInteger i = 0; i < 3; i++) {
+        [store setSession:[self sessionForKey:[self beaconWithIndex:i] lastSeen:1000] forKey:[self beaconWithIndex:i]];
+    }
+    [store synchronize];
+    store = nil;
+    // half of the second record written: its lastSeen is garbage
+    NSFileHandle *handle = [NSFileHandle fileHandleForUpdatingAtPath:self.path];
+    [handle seekToFileOffset:kSBSessionStoreRecordOffset + kSBSessionStoreRecordLength + 40];
+    [handle writeData:[@"#" dataUsingEncoding:NSUTF8StringEncoding]];
+    [handle closeFile];
+    
+    store = [[SBSessionStore alloc] initWithPath:self.path];
+    XCTAssertEqual(store.restoredSessions.count, 2);
+    XCTAssertNil(store.restoredSessions[[self beaconWithIndex:1]]);
+    // and its record is free again
+    [store setSession:[self sessionForKey:[self beaconWithIndex:5] lastSeen:1000] forKey:[self beaconWithIndex:5]];
+    XCTAssertEqual([[SBSessionStore alloc] initWithPath:self.path].restoredSessions.count, 3);
+}
+
+- (void)test005UnreadableTableStartsEmpty {
+    [[@"not a session table, not at all, certainly not one of version 1" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:self.path atomically:YES];
+    SBSessionStore *store = [[SBSessionStore alloc] initWithPath:self.path];
+    XCTAssertEqual(store.restoredSessions.count, 0);
+    [store setSession:[self sessionForKey:@"u33dc1" lastSeen:1000] forKey:@"u33dc1"];
+    XCTAssertEqual([[SBSessionStore alloc] initWithPath:self.path].restoredSessions.count, 1);
+}
+
+#pragma mark - Benchmarks
+
+- (void)testPerformanceRestore {
+    SBSessionStore *store = [[SBSessionStore alloc] initWithPath:self.path];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [store setSession:[self sessionForKey:[self beaconWithIndex:i] lastSeen:1000] forKey:[self beaconWithIndex:i]];
+    }
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 100; i++) {
+            XCTAssertEqual([[SBSessionStore alloc] initWithPath:self.path].restoredSessions.count, 100);
+        }
+    }];
+}
+
+@end
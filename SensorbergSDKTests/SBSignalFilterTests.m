@@ -0,0 +1,226 @@
+//
+//  SBSignalFilterTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+#import "SBSignalFilter.h"
+#import "SBModel.h"
+
+// a walk past beacons: the distance changes slowly, the rssi is noisy with the odd reflection and dropout
+static NSUInteger const kSBTraceBeacons = 50;
+static NSUInteger const kSBTraceSeconds = 600;
+
+@interface SBSignalFilterTests : SBTestCase
+@property (nonatomic, strong) SBSignalFilter *sut;
+@end
+
+@implementation SBSignalFilterTests
+
+- (void)setUp {
+    [super setUp];
+    self.sut = [SBSignalFilter new];
+}
+
+- (void)tearDown {
+    self.sut = nil;
+    [super tearDown];
+}
+
+- (SBMBeacon *)beaconWithMinor:(NSUInteger)minor {
+    return [[SBMBeacon alloc] initWithString:[NSString stringWithFormat:@"73676723740000000000000000000000%05lu%05lu", (unsigned long)1, (unsigned long)minor]];
+}
+
+- (void)feed:(NSInteger)rssi slot:(NSUInteger)slot now:(NSTimeInterval)now {
+    [self.sut updateSlots:&slot rssi:&rssi count:1 now:now];
+}
+
+- (void)testFirstMeasurementIsTheEstimate {
+    NSUInteger slot = [self.sut slotForBeacon:[self beaconWithMinor:1]];
+    XCTAssertEqual([self.sut rssiOfSlot:slot], 0);
+    XCTAssertEqual([self.sut proximityOfSlot:slot], CLProximityUnknown);
+    XCTAssertEqual([self.sut accuracyOfSlot:slot], -1);
+    // not measured
+    [self feed:0 slot:slot now:0];
+    XCTAssertEqual([self.sut rssiOfSlot:slot], 0);
+    [self feed:-59 slot:slot now:1];
+    XCTAssertEqual([self.sut rssiOfSlot:slot], -59);
+    XCTAssertEqual([self.sut proximityOfSlot:slot], CLProximityNear);
+    XCTAssertEqualWithAccuracy([self.sut accuracyOfSlot:slot], 1, 0.001);
+}
+
+- (void)testOutliersAreRejectedUnlessTheyPersist {
+    NSUInteger slot = [self.sut slotForBeacon:[self beaconWithMinor:1]];
+    [self feed:-70 slot:slot now:0];
+    [self feed:-95 slot:slot now:1];
+    [self feed:-95 slot:slot now:2];
+    XCTAssertEqual([self.sut rssiOfSlot:slot], -70);
+    // the third one in a row is taken
+    [self feed:-95 slot:slot now:3];
+    XCTAssertLessThan([self.sut rssiOfSlot:slot], -70);
+}
+
+- (void)testEWMAMovesBySmoothing {
+    self.sut.type = SBSignalFilterEWMA;
+    self.sut.smoothing = 0.5;
+    NSUInteger slot = [self.sut slotForBeacon:[self beaconWithMinor:1]];
+    [self feed:-70 slot:slot now:0];
+    [self feed:-60 slot:slot now:1];
+    XCTAssertEqualWithAccuracy([self.sut rssiOfSlot:slot], -65, 0.001);
+    self.sut.type = SBSignalFilterNone;
+    [self feed:-80 slot:slot now:2];
+    XCTAssertEqualWithAccuracy([self.sut rssiOfSlot:slot], -80, 0.001);
+}
+
+- (void)testProximityChangesOnlyPastTheHysteresis {
+    self.sut.type = SBSignalFilterNone;
+    NSUInteger slot = [self.sut slotForBeacon:[self beaconWithMinor:1]];
+    [self feed:-74 slot:slot now:0];
+    XCTAssertEqual([self.sut proximityOfSlot:slot], CLProximityNear);
+    // within 3 dBm of the near threshold
+    [self feed:-77 slot:slot now:1];
+    XCTAssertEqual([self.sut proximityOfSlot:slot], CLProximityNear);
+    [self feed:-79 slot:slot now:2];
+    XCTAssertEqual([self.sut proximityOfSlot:slot], CLProximityFar);
+    [self feed:-73 slot:slot now:3];
+    XCTAssertEqual([self.sut proximityOfSlot:slot], CLProximityFar);
+    [self feed:-71 slot:slot now:4];
+    XCTAssertEqual([self.sut proximityOfSlot:slot], CLProximityNear);
+}
+
+- (void)testRemovedBeaconsFreeTheirSlot {
+    SBMBeacon *first = [self beaconWithMinor:1];
+    NSUInteger slot = [self.sut slotForBeacon:first];
+    XCTAssertEqual([self.sut slotForBeacon:first], slot);
+    [self feed:-60 slot:slot now:0];
+    [self.sut removeBeacon:first];
+    XCTAssertEqual(self.sut.count, 0);
+    // reused, and starting over
+    NSUInteger reused = [self.sut slotForBeacon:[self beaconWithMinor:2]];
+    XCTAssertEqual(reused, slot);
+    XCTAssertEqual([self.sut rssiOfSlot:reused], 0);
+    // growing keeps the state
+    [self feed:-60 slot:reused now:0];
+    for (NSUInteger minor = 3; minor < 100; minor++) {
+        [self.sut slotForBeacon:[self beaconWithMinor:minor]];
+    }
+    XCTAssertEqual([self.sut rssiOfSlot:reused], -60);
+}
+
+- (void)testUnseenBeaconsAreRemoved {
+    SBMBeacon *seen = [self beaconWithMinor:1];
+    SBMBeacon *kept = [self beaconWithMinor:2];
+    SBMBeacon *gone = [self beaconWithMinor:3];
+    NSUInteger slots[] = {[self.sut slotForBeacon:seen], [self.sut slotForBeacon:kept], [self.sut slotForBeacon:gone]};
+    NSInteger rssi[] = {-60, -60, -60};
+    [self.sut updateSlots:slots rssi:rssi count:3 now:0];
+    // a callback without a measurement counts as seen
+    rssi[0] = 0;
+    [self.sut updateSlots:slots rssi:rssi count:1 now:20];
+    [self.sut removeBeaconsUnseenSince:10 passingTest:^BOOL(SBMBeacon *beacon) {
+        return ![beacon isEqual:kept];
+    }];
+    XCTAssertEqual(self.sut.count, 2);
+    XCTAssertEqual([self.sut slotForBeacon:seen], slots[0]);
+    XCTAssertEqual([self.sut slotForBeacon:kept], slots[1]);
+    XCTAssertEqual([self.sut rssiOfSlot:slots[1]], -60);
+    // the slot of the other one is free again
+    XCTAssertEqual([self.sut slotForBeacon:[self beaconWithMinor:4]], slots[2]);
+}
+
+#pragma mark - Replay
+
+/**
+ *  A generated trace, deterministic: rssi[second * kSBTraceBeacons + beacon], 0 for a dropout.
+ *  Each beacon drifts between -55 and -90 dBm with ±6 dBm noise, 3% reflections 20 dBm off and 5% dropouts.
+ */
+- (NSData *)trace {
+    NSMutableData *data = [NSMutableData dataWithLength:kSBTraceBeacons * kSBTraceSeconds * sizeof(NSInteger)];
+    NSInteger *rssi = data.mutableBytes;
+    srand48(17);
+    for (NSUInteger second = 0; second < kSBTraceSeconds; second++) {
+        for (NSUInteger beacon = 0; beacon < kSBTraceBeacons; beacon++) {
+            double level = -72.5 + 17.5 * sin((second + beacon * 37) / 60.);
+            double noise = (drand48() - 0.5) * 12;
+            double draw = drand48();
+            NSInteger value = (NSInteger)lround(level + noise + (draw < 0.03 ? -20 : 0));
+            rssi[second * kSBTraceBeacons + beacon] = draw > 0.95 ? 0 : value;
+        }
+    }
+    return data;
+}
+
+// proximity changes over the trace, and the time the filtering took
+- (NSUInteger)replay:(NSData *)trace type:(SBSignalFilterType)type time:(NSTimeInterval *)time {
+    SBSignalFilter *filter = [SBSignalFilter new];
+    filter.type = type;
+    NSUInteger slots[kSBTraceBeacons];
+    CLProximity last[kSBTraceBeacons];
+    for (NSUInteger beacon = 0; beacon < kSBTraceBeacons; beacon++) {
+        slots[beacon] = [filter slotForBeacon:[self beaconWithMinor:beacon]];
+        last[beacon] = CLProximityUnknown;
+    }
+    const NSInteger *rssi = trace.bytes;
+    NSUInteger changes = 0;
+    NSTimeInterval filtering = 0;
+    for (NSUInteger second = 0; second < kSBTraceSeconds; second++) {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [filter updateSlots:slots rssi:rssi + second * kSBTraceBeacons count:kSBTraceBeacons now:second];
+        filtering += CFAbsoluteTimeGetCurrent() - start;
+        for (NSUInteger beacon = 0; beacon < kSBTraceBeacons; beacon++) {
+            CLProximity proximity = [filter proximityOfSlot:slots[beacon]];
+            if (last[beacon] != CLProximityUnknown && proximity != last[beacon]) {
+                changes++;
+            }
+            last[beacon] = proximity;
+        }
+    }
+    if (time) {
+        *time = filtering;
+    }
+    return changes;
+}
+
+- (void)testReplayFlapsLessThanRawValues {
+    NSData *trace = [self trace];
+    self.sut = nil;
+    NSTimeInterval rawTime, ewmaTime, kalmanTime;
+    NSUInteger raw = [self replay:trace type:SBSignalFilterNone time:&rawTime];
+    NSUInteger ewma = [self replay:trace type:SBSignalFilterEWMA time:&ewmaTime];
+    NSUInteger kalman = [self replay:trace type:SBSignalFilterKalman time:&kalmanTime];
+    NSLog(@"Signal filter replay, %lu beacons for %lu callbacks: proximity changes raw %lu, EWMA %lu, Kalman %lu; filtering %.2fms, %.2fms, %.2fms",
+          (unsigned long)kSBTraceBeacons, (unsigned long)kSBTraceSeconds, (unsigned long)raw, (unsigned long)ewma, (unsigned long)kalman,
+          rawTime * 1000, ewmaTime * 1000, kalmanTime * 1000);
+    XCTAssertLessThan(ewma, raw);
+    XCTAssertLessThan(kalman, raw);
+}
+
+- (void)testPerformanceReplayKalman {
+    NSData *trace = [self trace];
+    [self measureBlock:^{
+        [self replay:trace type:SBSignalFilterKalman time:NULL];
+    }];
+}
+
+@end
@@ -0,0 +1,56 @@
+//
+//  SBTestURLProtocol.h
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Local HTTP stand-in. Answers every request with the handler's response instead of going to the network.
+ *  Add it to `[SBHTTPRequestManager sharedManager].sessionConfiguration.protocolClasses`.
+ */
+@interface SBTestURLProtocol : NSURLProtocol
+
+/**
+ *  The handler gets the request and its body, returns the response body and sets the status code (default 200).
+ *  Called on a background thread.
+ */
++ (void)setResponseHandler:(NSData *(^)(NSURLRequest *request, NSData *body, NSInteger *statusCode))handler;
+
+/**
+ *  Extra header fields sent with every response (e.g. ETag), nil for none
+ */
++ (void)setResponseHeaderFields:(NSDictionary <NSString *, NSString *> *)headerFields;
+
+/**
+ *  Installs the stand-in on the shared request manager
+ */
++ (void)install;
+
+/**
+ *  Restores the shared request manager's configuration and drops the handler and header fields
+ */
++ (void)uninstall;
+
+@end
@@ -0,0 +1,115 @@
+//
+//  SBTestURLProtocol.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestURLProtocol.h"
+
+#import "SBHTTPRequestManager.h"
+
+static NSData *(^responseHandler)(NSURLRequest *request, NSData *body, NSInteger *statusCode);
+static NSDictionary *responseHeaderFields;
+
+@implementation SBTestURLProtocol
+
++ (void)setResponseHandler:(NSData *(^)(NSURLRequest *, NSData *, NSInteger *))handler {
+    @synchronized (self) {
+        responseHandler = [handler copy];
+    }
+}
+
++ (void)setResponseHeaderFields:(NSDictionary<NSString *,NSString *> *)headerFields {
+    @synchronized (self) {
+        responseHeaderFields = [headerFields copy];
+    }
+}
+
++ (void)install {
+    SBHTTPRequestManager *manager = [SBHTTPRequestManager sharedManager];
+    NSURLSessionConfiguration *configuration = [manager.sessionConfiguration copy];
+    configuration.protocolClasses = [@[self] arrayByAddingObjectsFromArray:configuration.protocolClasses ? : @[]];
+    manager.sessionConfiguration = configuration;
+}
+
++ (void)uninstall {
+    [SBHTTPRequestManager sharedManager].sessionConfiguration = [NSURLSessionConfiguration defaultSessionConfiguration];
+    [self setResponseHandler:nil];
+    [self setResponseHeaderFields:nil];
+}
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+    @synchronized (self) {
+        return responseHandler != nil;
+    }
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+    return request;
+}
+
+- (void)startLoading {
+    NSData *(^handler)(NSURLRequest *, NSData *, NSInteger *);
+    @synchronized ([self class]) {
+        handler = responseHandler;
+    }
+    //
+    NSData *body = self.request.HTTPBody;
+    if (!body && self.request.HTTPBodyStream) {
+        // NSURLSession hands the body over as a stream
+        NSMutableData *streamed = [NSMutableData new];
+        NSInputStream *stream = self.request.HTTPBodyStream;
+        [stream open];
+        uint8_t buffer[4096];
+        NSInteger read;
+        while ((read = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+            [streamed appendBytes:buffer length:(NSUInteger)read];
+        }
+        [stream close];
+        body = streamed;
+    }
+    //
+    NSInteger statusCode = 200;
+    NSData *responseData = handler ? handler(self.request, body, &statusCode) : nil;
+    // read after the handler ran, so it can change them per response
+    NSMutableDictionary *headerFields = [NSMutableDictionary dictionaryWithObject:@"application/json" forKey:@"Content-Type"];
+    @synchronized ([self class]) {
+        [headerFields addEntriesFromDictionary:responseHeaderFields ? : @{}];
+    }
+    //
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                              statusCode:statusCode
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:headerFields];
+    [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    if (responseData.length) {
+        [self.client URLProtocol:self didLoadData:responseData];
+    }
+    [self.client URLProtocolDidFinishLoading:self];
+}
+
+- (void)stopLoading {
+    //
+}
+
+@end
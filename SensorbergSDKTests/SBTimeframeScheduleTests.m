@@ -0,0 +1,200 @@
+//
+//  SBTimeframeScheduleTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "SBTestCase.h"
+#import "SBTimeframeSchedule.h"
+#import "SBInternalModels.h"
+
+static NSUInteger const kSBTimeframeBenchmarkActions = 50;
+static NSUInteger const kSBTimeframeBenchmarkTimeframes = 300;
+
+@interface SBTimeframeScheduleTests : SBTestCase
+@end
+
+@implementation SBTimeframeScheduleTests
+
+- (SBMTimeframe *)timeframeFrom:(NSTimeInterval)start to:(NSTimeInterval)end {
+    SBMTimeframe *timeframe = [SBMTimeframe new];
+    timeframe.start = isnan(start) ? nil : [NSDate dateWithTimeIntervalSince1970:start];
+    timeframe.end = isnan(end) ? nil : [NSDate dateWithTimeIntervalSince1970:end];
+    return timeframe;
+}
+
+// what campaignIsInTimeframes: used to do, with the NSDates
+- (BOOL)dates:(NSArray <SBMTimeframe *> *)timeframes contain:(NSDate *)date {
+    for (SBMTimeframe *timeframe in timeframes) {
+        if ((!timeframe.start || [date compare:timeframe.start] != NSOrderedAscending) &&
+            (!timeframe.end || [date compare:timeframe.end] == NSOrderedAscending)) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (void)testOverlappingTimeframesAreMerged {
+    SBTimeframeSchedule *schedule = [[SBTimeframeSchedule alloc] initWithTimeframes:@[[self timeframeFrom:300 to:400],
+                                                                                      [self timeframeFrom:100 to:200],
+                                                                                      [self timeframeFrom:150 to:250],
+                                                                                      [self timeframeFrom:250 to:260],
+                                                                                      // ends before it starts
+                                                                                      [self timeframeFrom:600 to:500]]];
+    XCTAssertEqual(schedule.count, 2);
+    XCTAssertFalse([schedule containsTime:99999]);
+    XCTAssertTrue([schedule containsTime:100000]);
+    XCTAssertTrue([schedule containsTime:259999]);
+    XCTAssertFalse([schedule containsTime:260000]);
+    XCTAssertTrue([schedule containsTime:350000]);
+    XCTAssertFalse([schedule containsTime:550000]);
+    //
+    XCTAssertEqual([schedule nextTransitionAfter:0], 100000);
+    XCTAssertEqual([schedule nextTransitionAfter:100000], 260000);
+    XCTAssertEqual([schedule nextTransitionAfter:270000], 300000);
+    XCTAssertEqual([schedule nextTransitionAfter:300000], 400000);
+    XCTAssertEqual([schedule nextTransitionAfter:400000], kSBTimeframeNever);
+}
+
+- (void)testOpenEndedTimeframes {
+    SBTimeframeSchedule *schedule = [[SBTimeframeSchedule alloc] initWithTimeframes:@[[self timeframeFrom:NAN to:100],
+                                                                                      [self timeframeFrom:200 to:NAN]]];
+    XCTAssertTrue([schedule containsTime:INT64_MIN]);
+    XCTAssertFalse([schedule containsTime:150000]);
+    XCTAssertTrue([schedule containsTime:INT64_MAX - 1]);
+    XCTAssertEqual([schedule nextTransitionAfter:0], 100000);
+    XCTAssertEqual([schedule nextTransitionAfter:200000], kSBTimeframeNever);
+    //
+    XCTAssertTrue([[[SBTimeframeSchedule alloc] initWithTimeframes:@[[self timeframeFrom:NAN to:NAN]]] containsTime:0]);
+    XCTAssertFalse([[[SBTimeframeSchedule alloc] initWithTimeframes:@[]] containsTime:0]);
+}
+
+- (void)testScheduleMatchesTheDates {
+    srand48(2016);
+    for (NSUInteger round = 0; round < 50; round++) {
+        NSMutableArray *timeframes = [NSMutableArray new];
+        for (NSUInteger i = 0; i < 20; i++) {
+            NSTimeInterval start = 1467331200 + floor(drand48() * 100000);
+            [timeframes addObject:[self timeframeFrom:drand48() < 0.05 ? NAN : start to:drand48() < 0.05 ? NAN : start + floor(drand48() * 10000) - 1000]];
+        }
+        SBTimeframeSchedule *schedule = [[SBTimeframeSchedule alloc] initWithTimeframes:timeframes];
+        for (NSUInteger i = 0; i < 200; i++) {
+            NSDate *date = [NSDate dateWithTimeIntervalSince1970:1467331200 - 10000 + floor(drand48() * 130000)];
+            int64_t time = SBTimeframeTimeFromDate(date);
+            BOOL inside = [self dates:timeframes contain:date];
+            XCTAssertEqual([schedule containsTime:time], inside);
+            // nothing changes before the next transition, and something does at it
+            int64_t next = [schedule nextTransitionAfter:time];
+            if (next != kSBTimeframeNever) {
+                XCTAssertEqual([schedule containsTime:next - 1], inside);
+                XCTAssertNotEqual([schedule containsTime:next], inside);
+            }
+        }
+    }
+}
+
+- (void)testLayoutNextTransitionIsTheEarliestOfItsActions {
+    SBMGetLayout *layout = [SBMGetLayout new];
+    SBMAction *always = [SBMAction new];
+    SBMAction *morning = [SBMAction new];
+    morning.timeframes = (NSArray <SBMTimeframe> *)@[[self timeframeFrom:1000 to:2000]];
+    SBMAction *evening = [SBMAction new];
+    evening.timeframes = (NSArray <SBMTimeframe> *)@[[self timeframeFrom:1500 to:NAN]];
+    layout.actions = (NSArray <SBMAction> *)@[always, morning, evening];
+    //
+    XCTAssertEqualObjects([layout nextTimeframeTransitionAfter:[NSDate dateWithTimeIntervalSince1970:0]], [NSDate dateWithTimeIntervalSince1970:1000]);
+    XCTAssertEqualObjects([layout nextTimeframeTransitionAfter:[NSDate dateWithTimeIntervalSince1970:999]], [NSDate dateWithTimeIntervalSince1970:1000]);
+    XCTAssertEqualObjects([layout nextTimeframeTransitionAfter:[NSDate dateWithTimeIntervalSince1970:1000]], [NSDate dateWithTimeIntervalSince1970:1500]);
+    XCTAssertEqualObjects([layout nextTimeframeTransitionAfter:[NSDate dateWithTimeIntervalSince1970:1600]], [NSDate dateWithTimeIntervalSince1970:2000]);
+    XCTAssertNil([layout nextTimeframeTransitionAfter:[NSDate dateWithTimeIntervalSince1970:2000]]);
+    // new actions, new transitions
+    layout.actions = (NSArray <SBMAction> *)@[always, morning];
+    XCTAssertEqualObjects([layout nextTimeframeTransitionAfter:[NSDate dateWithTimeIntervalSince1970:1000]], [NSDate dateWithTimeIntervalSince1970:2000]);
+}
+
+#pragma mark - Benchmarks
+
+// actions with hundreds of weekly slots each, evaluated for every action of a trigger
+- (NSArray <NSArray <SBMTimeframe *> *> *)benchmarkTimeframes {
+    NSMutableArray *actions = [NSMutableArray arrayWithCapacity:kSBTimeframeBenchmarkActions];
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    for (NSUInteger a = 0; a < kSBTimeframeBenchmarkActions; a++) {
+        NSMutableArray *timeframes = [NSMutableArray arrayWithCapacity:kSBTimeframeBenchmarkTimeframes];
+        for (NSUInteger i = 0; i < kSBTimeframeBenchmarkTimeframes; i++) {
+            // two hours every week, around now
+            NSTimeInterval start = now + ((NSInteger)i - (NSInteger)kSBTimeframeBenchmarkTimeframes / 2) * 604800 + a * 3600;
+            [timeframes addObject:[self timeframeFrom:start to:start + 7200]];
+        }
+        [actions addObject:timeframes];
+    }
+    return actions;
+}
+
+- (void)testTimeframeChecksDatesVersusSchedule {
+    NSArray <NSArray <SBMTimeframe *> *> *actions = [self benchmarkTimeframes];
+    NSMutableArray <SBTimeframeSchedule *> *schedules = [NSMutableArray new];
+    for (NSArray *timeframes in actions) {
+        [schedules addObject:[[SBTimeframeSchedule alloc] initWithTimeframes:timeframes]];
+    }
+    NSUInteger const triggers = 1000;
+    NSUInteger datesInside = 0;
+    NSUInteger scheduleInside = 0;
+    //
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < triggers; i++) {
+        @autoreleasepool {
+            for (NSArray *timeframes in actions) {
+                datesInside += [self dates:timeframes contain:[NSDate date]];
+            }
+        }
+    }
+    NSTimeInterval datesTime = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < triggers; i++) {
+        int64_t now = SBTimeframeTimeFromDate([NSDate date]);
+        for (SBTimeframeSchedule *schedule in schedules) {
+            scheduleInside += [schedule containsTime:now];
+        }
+    }
+    NSTimeInterval scheduleTime = CFAbsoluteTimeGetCurrent() - start;
+    XCTAssertEqual(datesInside, scheduleInside);
+    NSLog(@"Timeframes, %lu triggers of %lu actions with %lu timeframes: dates %.3fs, schedule %.4fs (%.0fx)",
+          (unsigned long)triggers, (unsigned long)kSBTimeframeBenchmarkActions, (unsigned long)kSBTimeframeBenchmarkTimeframes,
+          datesTime, scheduleTime, datesTime / scheduleTime);
+}
+
+- (void)testPerformanceTimeframeSchedule {
+    NSMutableArray <SBTimeframeSchedule *> *schedules = [NSMutableArray new];
+    for (NSArray *timeframes in [self benchmarkTimeframes]) {
+        [schedules addObject:[[SBTimeframeSchedule alloc] initWithTimeframes:timeframes]];
+    }
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            int64_t now = SBTimeframeTimeFromDate([NSDate date]);
+            for (SBTimeframeSchedule *schedule in schedules) {
+                [schedule containsTime:now];
+            }
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,150 @@
+//
+//  SBTimerWheelTests.m
+//  SensorbergSDK
+//
+//  Copyright (c) 2014-2016 Sensorberg GmbH. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "SBTestCase.h"
+#import "SBTimerWheel.h"
+
+static NSUInteger const kSBTimerWheelBenchmarkSessions = 10000;
+
+@interface SBTimerWheelTests : SBTestCase
+@property (nonatomic, strong) SBTimerWheel *sut;
+@end
+
+@implementation SBTimerWheelTests
+
+- (void)setUp {
+    [super setUp];
+    self.sut = [[SBTimerWheel alloc] initWithTickDuration:1 slotCount:8 now:100];
+}
+
+- (void)tearDown {
+    self.sut = nil;
+    [super tearDown];
+}
+
+- (void)testKeysExpireOnceInDeadlineOrder {
+    [self.sut scheduleKey:@"b" deadline:105.5];
+    [self.sut scheduleKey:@"a" deadline:103];
+    [self.sut scheduleKey:@"c" deadline:140];
+    XCTAssertEqual(self.sut.count, 3);
+    // not before the tick of the deadline is over
+    XCTAssertEqualObjects([self.sut advanceTo:103.9], @[]);
+    XCTAssertEqualObjects([self.sut advanceTo:110], (@[@"a", @"b"]));
+    XCTAssertEqualObjects([self.sut advanceTo:111], @[]);
+    XCTAssertEqual(self.sut.count, 1);
+    // several turns of the wheel later
+    XCTAssertEqualObjects([self.sut advanceTo:139], @[]);
+    XCTAssertEqualObjects([self.sut advanceTo:141], @[@"c"]);
+    XCTAssertEqual(self.sut.count, 0);
+}
+
+- (void)testReschedulingMovesTheDeadlineBothWays {
+    [self.sut scheduleKey:@"a" deadline:103];
+    [self.sut scheduleKey:@"a" deadline:120];
+    XCTAssertEqual([self.sut deadlineForKey:@"a"], 120);
+    XCTAssertEqualObjects([self.sut advanceTo:115], @[]);
+    [self.sut scheduleKey:@"a" deadline:116];
+    XCTAssertEqualObjects([self.sut advanceTo:117], @[@"a"]);
+    XCTAssertEqual([self.sut deadlineForKey:@"a"], 0);
+}
+
+- (void)testCancelledAndPastKeys {
+    [self.sut scheduleKey:@"a" deadline:103];
+    [self.sut cancelKey:@"a"];
+    XCTAssertEqualObjects([self.sut advanceTo:110], @[]);
+    // already due when scheduled: the next advance
+    [self.sut scheduleKey:@"b" deadline:50];
+    XCTAssertEqualObjects([self.sut advanceTo:110], @[]);
+    XCTAssertEqualObjects([self.sut advanceTo:111], @[@"b"]);
+}
+
+- (void)testLongGapVisitsEverySlotOnce {
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self.sut scheduleKey:@(i) deadline:101 + i];
+    }
+    NSArray *expired = [self.sut advanceTo:10000];
+    XCTAssertEqual(expired.count, 100);
+    XCTAssertEqualObjects(expired.firstObject, @0);
+    XCTAssertEqualObjects(expired.lastObject, @99);
+}
+
+#pragma mark - Benchmarks
+
+// 10k concurrent sessions, a ranging callback per second seeing a tenth of them, for ten minutes
+- (NSTimeInterval)simulateSessionsWithWheel:(BOOL)wheel {
+    NSTimeInterval const monitoringDelay = 30;
+    NSTimeInterval now = 1000000;
+    NSMutableDictionary <NSNumber *, NSNumber *> *lastSeen = [NSMutableDictionary new];
+    SBTimerWheel *expiry = [[SBTimerWheel alloc] initWithTickDuration:1 slotCount:64 now:now];
+    for (NSUInteger i = 0; i < kSBTimerWheelBenchmarkSessions; i++) {
+        lastSeen[@(i)] = @(now);
+        [expiry scheduleKey:@(i) deadline:now + monitoringDelay];
+    }
+    NSUInteger seenPerCallback = kSBTimerWheelBenchmarkSessions / 10;
+    NSUInteger expired = 0;
+    //
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    @autoreleasepool {
+        for (NSUInteger second = 1; second <= 600; second++) {
+            now += 1;
+            for (NSUInteger i = 0; i < seenPerCallback; i++) {
+                NSNumber *key = @((second * seenPerCallback + i) % kSBTimerWheelBenchmarkSessions);
+                if (wheel) {
+                    [expiry scheduleKey:key deadline:now + monitoringDelay];
+                } else {
+                    lastSeen[key] = @(now);
+                }
+            }
+            if (wheel) {
+                expired += [expiry advanceTo:now].count;
+            } else {
+                // what checkRegionExit did: every session, every callback
+                for (NSNumber *key in lastSeen.allKeys) {
+                    if (lastSeen[key].doubleValue + monitoringDelay <= now) {
+                        expired++;
+                    }
+                }
+            }
+        }
+    }
+    XCTAssertEqual(expired, 0);
+    return CFAbsoluteTimeGetCurrent() - start;
+}
+
+- (void)testSessionExpiryScanVersusWheel {
+    NSTimeInterval scan = [self simulateSessionsWithWheel:NO];
+    NSTimeInterval wheel = [self simulateSessionsWithWheel:YES];
+    NSLog(@"Session expiry, %lu sessions for 600 callbacks: scan %.3fs, timer wheel %.3fs (%.1fx)",
+          (unsigned long)kSBTimerWheelBenchmarkSessions, scan, wheel, scan / wheel);
+}
+
+- (void)testPerformanceSessionExpiryWheel {
+    [self measureBlock:^{
+        [self simulateSessionsWithWheel:YES];
+    }];
+}
+
+@end
@@ -65,4 +65,33 @@
     XCTAssert(agent.app.length);
 }
 
+- (void)testCRC32 {
+    const char *check = "123456789";
+    XCTAssertEqual(SBCRC32((const uint8_t *)check, strlen(check)), 0xcbf43926u);
+    XCTAssertEqual(SBCRC32(NULL, 0), 0u);
+}
+
+- (void)testDeferredWriteCoalescesChanges {
+    dispatch_queue_t queue = dispatch_queue_create("com.sensorberg.sdk.tests.write", DISPATCH_QUEUE_SERIAL);
+    __block NSUInteger writes = 0;
+    SBDeferredWrite *deferredWrite = [[SBDeferredWrite alloc] initWithQueue:queue delay:60 write:^{
+        writes++;
+    }];
+    [deferredWrite flush];
+    XCTAssertEqual(writes, 0);
+    for (NSUInteger i = 0; i < 10; i++) {
+        [deferredWrite schedule];
+    }
+    [deferredWrite flush];
+    XCTAssertEqual(writes, 1);
+    // nothing pending after the flush
+    [deferredWrite flush];
+    XCTAssertEqual(writes, 1);
+    [deferredWrite schedule];
+    XCTAssertTrue([deferredWrite cancel]);
+    XCTAssertFalse([deferredWrite cancel]);
+    [deferredWrite flush];
+    XCTAssertEqual(writes, 1);
+}
+
 @end
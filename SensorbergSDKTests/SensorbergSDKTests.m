@@ -60,7 +60,7 @@ static int const kRequestTimeout = 4;
 
 - (void)tearDown {
     // Put teardown code here. This method is called after the invocation of each test method in the class.
-    UNREGISTER();
+    SB_UNREGISTER();
     [super tearDown];
 }
 
@@ -71,7 +71,7 @@ static int const kRequestTimeout = 4;
 }
 
 - (void)test001ThatTheLayoutIsNotNull {
-    PUBLISH([SBEventLocationAuthorization new]);
+    SB_PUBLISH([SBEventLocationAuthorization new]);
     [[SBManager sharedManager] startMonitoring];
     
     testThatTheLayoutIsNotNullExpectation = [self expectationWithDescription:@"testThatTheLayoutIsNotNullExpectation"];
@@ -83,7 +83,7 @@ static int const kRequestTimeout = 4;
         enter.rssi = -50;
         enter.proximity = CLProximityNear;
         enter.accuracy = kCLLocationAccuracyBest;
-        PUBLISH(enter);
+        SB_PUBLISH(enter);
     });
     //
     
@@ -110,14 +110,14 @@ static int const kRequestTimeout = 4;
         event.layout = layout;
         event.beacon = beacon;
         event.trigger = kSBTriggerEnter;
-//        PUBLISH(event);
+//        SB_PUBLISH(event);
         //
         SBEventRegionEnter *enter = [SBEventRegionEnter new];
         enter.beacon = beacon;
         enter.rssi = -50;
         enter.proximity = CLProximityNear;
         enter.accuracy = kCLLocationAccuracyBest;
-        PUBLISH(enter);
+        SB_PUBLISH(enter);
         //
         XCTAssertNil(error,@"Error loading JSON %@.json",kTestAPIKey);
         //